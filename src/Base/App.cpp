@@ -498,6 +498,8 @@ int App::Impl::exec()
     }
         
     isDoingInitialization_ = false;
+
+    pluginManager->activateDeferredPluginsForCommandLine(argc, argv);
     
     if(!ext->optionManager().parseCommandLine1(argc, argv)){
         doQuit = true;
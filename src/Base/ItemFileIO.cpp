@@ -7,12 +7,61 @@
 #include <cnoid/UTF8>
 #include <cnoid/stdx/filesystem>
 #include <fmt/format.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <sstream>
 #include "gettext.h"
 
 using namespace std;
 using namespace cnoid;
 namespace filesystem = cnoid::stdx::filesystem;
 
+namespace {
+
+struct ParsingJob : public Referenced
+{
+    enum State { Queued, Running, Done, Canceled };
+    ItemFileIOPtr fileIO;
+    string filename;
+    State state;
+    ReferencedPtr result;
+    string messages;
+
+    ParsingJob() : state(Queued) { }
+};
+typedef ref_ptr<ParsingJob> ParsingJobPtr;
+
+class ConcurrentParser
+{
+public:
+    int depth;
+    bool isStopping;
+    mutex jobMutex;
+    condition_variable jobCondition;
+    deque<ParsingJobPtr> queue;
+    map<pair<ItemFileIO*, string>, ParsingJobPtr> jobMap;
+    vector<thread> workers;
+    int numParsedFiles;
+
+    ConcurrentParser();
+    bool request(ItemFileIO* fileIO, const string& filename);
+    ParsingJobPtr take(ItemFileIO* fileIO, const string& filename);
+    void work();
+    void finish();
+};
+
+ConcurrentParser concurrentParser;
+
+string getNormalizedPath(const string& filename)
+{
+    return filesystem::lexically_normal(filesystem::path(fromUTF8(filename))).generic_string();
+}
+
+}
+
 namespace cnoid {
 
 class ItemFileIO::Impl
@@ -35,6 +84,8 @@ public:
     std::ostream* os;
     MessageView* mv;
     std::string errorMessage;
+    ReferencedPtr concurrentParsingResult;
+    bool isConcurrentParsingResultAvailable;
     std::time_t lastSelectedTimeInLoadDialog;
     std::time_t lastSelectedTimeInSaveDialog;
 
@@ -48,6 +99,11 @@ public:
         Item* item, std::string filename,
         Item* parentItem, bool doAddition, Item* nextItem, const Mapping* options);
     bool saveItem(Item* item, std::string filename, const Mapping* options);
+
+    static ReferencedPtr parseFileConcurrently(
+        ItemFileIO* fileIO, const std::string& filename, std::ostream& os){
+        return fileIO->parseFileConcurrently(filename, os);
+    }
 };
 
 }
@@ -68,6 +124,7 @@ ItemFileIO::Impl::Impl(ItemFileIO* self, const std::string& format, int api)
     isItemNameUpdateInSavingEnabled = true;
     currentInvocationType = Direct;
     parentItem = nullptr;
+    isConcurrentParsingResultAvailable = false;
     mv = MessageView::instance();
     os = &mv->cout(true);
     lastSelectedTimeInLoadDialog = 0;
@@ -107,6 +164,7 @@ ItemFileIO::Impl::Impl(ItemFileIO* self, const Impl& org)
 {
     currentInvocationType = Direct;
     parentItem = nullptr;
+    isConcurrentParsingResultAvailable = false;
     mv = MessageView::instance();
     os = &mv->cout(true);
 }
@@ -392,9 +450,23 @@ bool ItemFileIO::Impl::loadItem
     mv->flush();
 
     actuallyLoadedItem = item;
+
+    if(api & ItemFileIO::ConcurrentParsing){
+        if(auto job = concurrentParser.take(self, filename)){
+            if(!job->messages.empty()){
+                *os << job->messages;
+            }
+            concurrentParsingResult = job->result;
+            isConcurrentParsingResultAvailable = true;
+        }
+    }
+    
     bool loaded = self->load(item, filename);
     mv->flush();
 
+    concurrentParsingResult.reset();
+    isConcurrentParsingResultAvailable = false;
+
     if(!loaded){
         mv->put(_(" -> failed.\n"), MessageView::Highlight);
     } else {
@@ -438,6 +510,178 @@ bool ItemFileIO::load(Item* item, const std::string& filename)
 }
 
 
+ReferencedPtr ItemFileIO::parseFileConcurrently(const std::string& /* filename */, std::ostream& /* os */)
+{
+    return nullptr;
+}
+
+
+bool ItemFileIO::findConcurrentParsingResult(ReferencedPtr& out_result)
+{
+    if(impl->isConcurrentParsingResultAvailable){
+        out_result = impl->concurrentParsingResult;
+        return true;
+    }
+    return false;
+}
+
+
+void ItemFileIO::beginConcurrentParsing()
+{
+    lock_guard<mutex> lock(concurrentParser.jobMutex);
+    if(concurrentParser.depth == 0){
+        concurrentParser.numParsedFiles = 0;
+    }
+    ++concurrentParser.depth;
+}
+
+
+bool ItemFileIO::requestConcurrentParsing(ItemFileIO* fileIO, const std::string& filename)
+{
+    if(!fileIO || !(fileIO->api() & ConcurrentParsing) || filename.empty()){
+        return false;
+    }
+    return concurrentParser.request(fileIO, filename);
+}
+
+
+void ItemFileIO::endConcurrentParsing()
+{
+    {
+        lock_guard<mutex> lock(concurrentParser.jobMutex);
+        if(concurrentParser.depth == 0 || --concurrentParser.depth > 0){
+            return;
+        }
+    }
+    concurrentParser.finish();
+}
+
+
+int ItemFileIO::numConcurrentlyParsedFiles()
+{
+    lock_guard<mutex> lock(concurrentParser.jobMutex);
+    return concurrentParser.numParsedFiles;
+}
+
+
+ConcurrentParser::ConcurrentParser()
+{
+    depth = 0;
+    isStopping = false;
+    numParsedFiles = 0;
+}
+
+
+bool ConcurrentParser::request(ItemFileIO* fileIO, const string& filename)
+{
+    {
+        lock_guard<mutex> lock(jobMutex);
+        if(depth == 0){
+            return false;
+        }
+        auto key = make_pair(fileIO, getNormalizedPath(filename));
+        if(jobMap.find(key) != jobMap.end()){
+            return true;
+        }
+        ParsingJobPtr job = new ParsingJob;
+        job->fileIO = fileIO;
+        job->filename = filename;
+        jobMap[key] = job;
+        queue.push_back(job);
+
+        int maxNumWorkers = std::max(1, static_cast<int>(thread::hardware_concurrency()));
+        if(static_cast<int>(workers.size()) < maxNumWorkers &&
+           static_cast<int>(workers.size()) < static_cast<int>(jobMap.size())){
+            workers.emplace_back([this](){ work(); });
+        }
+    }
+    jobCondition.notify_all();
+    return true;
+}
+
+
+void ConcurrentParser::work()
+{
+    unique_lock<mutex> lock(jobMutex);
+    while(true){
+        jobCondition.wait(lock, [this](){ return isStopping || !queue.empty(); });
+        if(queue.empty()){
+            break;
+        }
+        ParsingJobPtr job = queue.front();
+        queue.pop_front();
+        if(job->state != ParsingJob::Queued){
+            continue;
+        }
+        job->state = ParsingJob::Running;
+        lock.unlock();
+
+        ostringstream os;
+        ReferencedPtr result;
+        try {
+            result = ItemFileIO::Impl::parseFileConcurrently(job->fileIO, job->filename, os);
+        }
+        catch(const std::exception& ex){
+            os << ex.what() << endl;
+        }
+
+        lock.lock();
+        job->result = result;
+        job->messages = os.str();
+        job->state = ParsingJob::Done;
+        ++numParsedFiles;
+        jobCondition.notify_all();
+    }
+}
+
+
+/**
+   A job that has not been started yet is canceled so that the file is parsed by the
+   ordinary load function in the calling thread instead of waiting for a worker.
+*/
+ParsingJobPtr ConcurrentParser::take(ItemFileIO* fileIO, const string& filename)
+{
+    unique_lock<mutex> lock(jobMutex);
+    if(jobMap.empty()){
+        return nullptr;
+    }
+    auto p = jobMap.find(make_pair(fileIO, getNormalizedPath(filename)));
+    if(p == jobMap.end()){
+        return nullptr;
+    }
+    ParsingJobPtr job = p->second;
+    jobMap.erase(p);
+    if(job->state == ParsingJob::Queued){
+        job->state = ParsingJob::Canceled;
+        return nullptr;
+    }
+    jobCondition.wait(lock, [&job](){ return job->state == ParsingJob::Done; });
+    return job;
+}
+
+
+void ConcurrentParser::finish()
+{
+    vector<thread> workersToJoin;
+    {
+        lock_guard<mutex> lock(jobMutex);
+        isStopping = true;
+        for(auto& job : queue){
+            job->state = ParsingJob::Canceled;
+        }
+        queue.clear();
+        workersToJoin.swap(workers);
+    }
+    jobCondition.notify_all();
+    for(auto& worker : workersToJoin){
+        worker.join();
+    }
+    lock_guard<mutex> lock(jobMutex);
+    jobMap.clear();
+    isStopping = false;
+}
+
+
 Item* ItemFileIO::createItem()
 {
     return nullptr;
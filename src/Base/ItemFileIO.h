@@ -26,6 +26,7 @@ public:
         OptionPanelForLoading = 1 << 2,
         Save = 1 << 3,
         OptionPanelForSaving = 1 << 4,
+        ConcurrentParsing = 1 << 5
     };
     enum InterfaceLevel { Standard, Conversion, Internal };
     enum InvocationType { Direct, Dialog, DragAndDrop };
@@ -117,6 +118,18 @@ public:
 
     static std::vector<std::string> separateExtensions(const std::string& multiExtString);
 
+    /**
+       The following functions are used to parse the files of items in worker threads
+       before the items are loaded. The file is parsed by the parseFileConcurrently
+       function of the file IO that has the ConcurrentParsing API, and the result is
+       used when an item is loaded with the same file IO and file. The results of the
+       requests are kept until the outermost endConcurrentParsing call.
+    */
+    static void beginConcurrentParsing();
+    static bool requestConcurrentParsing(ItemFileIO* fileIO, const std::string& filename);
+    static void endConcurrentParsing();
+    static int numConcurrentlyParsedFiles();
+
 protected:
     ItemFileIO(const std::string& format, int api);
     ItemFileIO(const ItemFileIO& org);
@@ -141,6 +154,22 @@ protected:
 
     // Save API
     virtual bool save(Item* item, const std::string& filename);
+
+    // ConcurrentParsing API
+    /**
+       This function is called in a worker thread. It must not access any items and
+       GUI objects, and it must not use the non-thread-safe members of the file IO.
+       \return The parsed data, or nullptr if the file cannot be parsed.
+    */
+    virtual ReferencedPtr parseFileConcurrently(const std::string& filename, std::ostream& os);
+
+    /**
+       This function can be used in the load function to get the data returned by the
+       parseFileConcurrently function.
+       \return true if the file has been parsed concurrently. The result is null when the
+       parsing failed.
+    */
+    bool findConcurrentParsingResult(ReferencedPtr& out_result);
     
     std::ostream& os();
     void putWarning(const std::string& message);
@@ -787,27 +787,10 @@ ItemFileIO* ItemManager::findFileIO(const std::type_info& type, const std::strin
 }
 
 
-ItemFileIO* ItemManager::Impl::findMatchedFileIO
-(const type_info& type, const string& filename, const string& format, int ioTypeFlag)
+static ItemFileIO* findMatchedFileIOOfClass
+(ClassInfo* classInfo, const string& filename, const string& format, int ioTypeFlag)
 {
     ItemFileIO* targetFileIO = nullptr;
-    
-    auto p = itemClassIdToInfoMap.find(itemClassRegistry->getClassId(type));
-    if(p == itemClassIdToInfoMap.end()){
-        if(filename.empty()){
-            messageView->putln(
-                fmt::format(_("There is no file I/O processor registered for the \"{0}\" type."), type.name()),
-                MessageView::Error);
-        } else {
-            messageView->putln(
-                fmt::format(_("\"{0}\" cannot be accessed because there is no file I/O processor registered for the \"{1}\" type."),
-                            filename, type.name()),
-                MessageView::Error);
-        }
-        return targetFileIO;;
-    }
-    
-    ClassInfoPtr& classInfo = p->second;
     auto& fileIOs = classInfo->fileIOs;
 
     if(!format.empty() || filename.empty()){
@@ -840,6 +823,32 @@ ItemFileIO* ItemManager::Impl::findMatchedFileIO
         }
     }
 
+    return targetFileIO;
+}
+
+
+ItemFileIO* ItemManager::Impl::findMatchedFileIO
+(const type_info& type, const string& filename, const string& format, int ioTypeFlag)
+{
+    ItemFileIO* targetFileIO = nullptr;
+    
+    auto p = itemClassIdToInfoMap.find(itemClassRegistry->getClassId(type));
+    if(p == itemClassIdToInfoMap.end()){
+        if(filename.empty()){
+            messageView->putln(
+                fmt::format(_("There is no file I/O processor registered for the \"{0}\" type."), type.name()),
+                MessageView::Error);
+        } else {
+            messageView->putln(
+                fmt::format(_("\"{0}\" cannot be accessed because there is no file I/O processor registered for the \"{1}\" type."),
+                            filename, type.name()),
+                MessageView::Error);
+        }
+        return targetFileIO;;
+    }
+    
+    targetFileIO = findMatchedFileIOOfClass(p->second, filename, format, ioTypeFlag);
+
     if(!targetFileIO){
         if(format.empty()){
             messageView->putln(
@@ -857,6 +866,59 @@ ItemFileIO* ItemManager::Impl::findMatchedFileIO
 }
 
 
+/**
+   This function does not output any message when the file IO is not found.
+*/
+ItemFileIO* ItemManager::findFileIOForLoading
+(const std::string& moduleName, const std::string& className, const std::string& filename, const std::string& format)
+{
+    auto p = moduleNameToItemManagerImplMap.find(moduleName);
+    if(p == moduleNameToItemManagerImplMap.end()){
+        if(auto alias = PluginManager::instance()->guessActualPluginName(moduleName)){
+            p = moduleNameToItemManagerImplMap.find(alias);
+        }
+    }
+    if(p != moduleNameToItemManagerImplMap.end()){
+        auto& itemClassNameToInfoMap = p->second->itemClassNameToInfoMap;
+        auto q = itemClassNameToInfoMap.find(className);
+        if(q != itemClassNameToInfoMap.end()){
+            return findMatchedFileIOOfClass(q->second, filename, format, ItemFileIO::Load);
+        }
+    }
+    return nullptr;
+}
+
+
+std::vector<std::string> ItemManager::getItemClassNames(const std::string& moduleName)
+{
+    vector<string> classNames;
+    auto p = moduleNameToItemManagerImplMap.find(moduleName);
+    if(p != moduleNameToItemManagerImplMap.end()){
+        for(auto& kv : p->second->itemClassNameToInfoMap){
+            classNames.push_back(kv.first);
+        }
+    }
+    return classNames;
+}
+
+
+std::vector<std::string> ItemManager::getFileExtensionsForLoading(const std::string& moduleName)
+{
+    set<string> extensions;
+    auto p = moduleNameToItemManagerImplMap.find(moduleName);
+    if(p != moduleNameToItemManagerImplMap.end()){
+        for(auto& fileIO : p->second->registeredFileIOs){
+            if(fileIO->hasApi(ItemFileIO::Load)){
+                for(auto& ext : fileIO->extensionsForLoading()){
+                    extensions.insert(ext);
+                }
+            }
+        }
+    }
+    return vector<string>(extensions.begin(), extensions.end());
+}
+
+
 namespace {
 
 // The following adapter class is defined to use existing loaders and savers
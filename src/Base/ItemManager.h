@@ -169,6 +169,13 @@ public:
     static std::vector<ItemFileIO*> getFileIOs(
         const Item* item, std::function<bool(ItemFileIO* fileIO)> pred, bool includeSuperClassIos = false);
     static ItemFileIO* findFileIO(const std::type_info& type, const std::string& format);
+    static ItemFileIO* findFileIOForLoading(
+        const std::string& moduleName, const std::string& className,
+        const std::string& filename, const std::string& format = std::string());
+
+    // The following functions return the item types and file types registered by a module
+    static std::vector<std::string> getItemClassNames(const std::string& moduleName);
+    static std::vector<std::string> getFileExtensionsForLoading(const std::string& moduleName);
 
     template <class ItemType>
     ItemManager& addLoader(
@@ -3,12 +3,16 @@
 #include "RootItem.h"
 #include "SubProjectItem.h"
 #include "ItemManager.h"
+#include "ItemFileIO.h"
 #include "MessageView.h"
 #include "Archive.h"
 #include <cnoid/YAMLReader>
 #include <cnoid/YAMLWriter>
+#include <cnoid/FilePathVariableProcessor>
 #include <list>
 #include <set>
+#include <algorithm>
+#include <chrono>
 #include <fmt/format.h>
 #include "gettext.h"
 
@@ -27,6 +31,15 @@ public:
     int numRestoredItems;
     const std::set<std::string>* pOptionalPlugins;
     bool isTemporaryItemSaveEnabled;
+    bool isConcurrentFileParsingEnabled;
+    bool isItemLoadTimeReportEnabled;
+
+    struct ItemLoadTime {
+        string className;
+        string itemName;
+        double time;
+    };
+    vector<ItemLoadTime> itemLoadTimes;
 
     Impl();
     ArchivePtr store(Archive& parentArchive, Item* item);
@@ -36,6 +49,8 @@ public:
     bool checkSubTreeTemporality(Item* item);
     void storeAddons(Archive& archive, Item* item);
     ItemList<> restore(Archive& archive, Item* parentItem, const std::set<std::string>& optionalPlugins);
+    void requestConcurrentFileParsingIter(Archive& archive);
+    void putItemLoadTimeReport(double totalTime);
     void restoreItemIter(Archive& archive, Item* parentItem, ItemList<>& io_topLevelItems, int level);
     ItemPtr restoreItem(
         Archive& archive, Item* parentItem, string& itemName, string& classame,
@@ -57,7 +72,8 @@ ItemTreeArchiver::ItemTreeArchiver()
 ItemTreeArchiver::Impl::Impl()
     : mv(MessageView::instance())
 {
-
+    isConcurrentFileParsingEnabled = false;
+    isItemLoadTimeReportEnabled = false;
 }
 
 
@@ -303,6 +319,30 @@ ItemList<> ItemTreeArchiver::restore(Archive* archive, Item* parentItem, const s
 }
 
 
+void ItemTreeArchiver::setConcurrentFileParsingEnabled(bool on)
+{
+    impl->isConcurrentFileParsingEnabled = on;
+}
+
+
+bool ItemTreeArchiver::isConcurrentFileParsingEnabled() const
+{
+    return impl->isConcurrentFileParsingEnabled;
+}
+
+
+void ItemTreeArchiver::setItemLoadTimeReportEnabled(bool on)
+{
+    impl->isItemLoadTimeReportEnabled = on;
+}
+
+
+bool ItemTreeArchiver::isItemLoadTimeReportEnabled() const
+{
+    return impl->isItemLoadTimeReportEnabled;
+}
+
+
 ItemList<> ItemTreeArchiver::Impl::restore
 (Archive& archive, Item* parentItem, const std::set<std::string>& optionalPlugins)
 {
@@ -310,6 +350,18 @@ ItemList<> ItemTreeArchiver::Impl::restore
     numRestoredItems = 0;
     pOptionalPlugins = &optionalPlugins;
     ItemList<> topLevelItems;
+    itemLoadTimes.clear();
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    if(isConcurrentFileParsingEnabled){
+        ItemFileIO::beginConcurrentParsing();
+        try {
+            requestConcurrentFileParsingIter(archive);
+        } catch (const ValueNode::Exception&){
+            // The error is reported again in the restoration below
+        }
+    }
 
     archive.setCurrentParentItem(nullptr);
     try {
@@ -319,10 +371,84 @@ ItemList<> ItemTreeArchiver::Impl::restore
     }
     archive.setCurrentParentItem(nullptr);
 
+    if(isConcurrentFileParsingEnabled){
+        ItemFileIO::endConcurrentParsing();
+    }
+
+    if(isItemLoadTimeReportEnabled){
+        putItemLoadTimeReport(
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+    }
+
     return topLevelItems;
 }
 
 
+/**
+   This function traverses the archive in the same way as restoreItemIter and requests the
+   concurrent parsing of the item files that can be parsed without accessing the items.
+*/
+void ItemTreeArchiver::Impl::requestConcurrentFileParsingIter(Archive& archive)
+{
+    if(!archive.get({ "is_sub_item", "isSubItem" }, false)){
+        string pluginName, className;
+        if(archive.read("plugin", pluginName) && archive.read("class", className)){
+            ValueNode* dataNode = archive.find("data");
+            if(dataNode->isValid() && dataNode->isMapping()){
+                Archive* dataArchive = static_cast<Archive*>(dataNode->toMapping());
+                dataArchive->inheritSharedInfoFrom(archive);
+                string file;
+                if(dataArchive->read({ "file", "filename", "modelFile" }, file)){
+                    if(auto processor = dataArchive->filePathVariableProcessor()){
+                        file = processor->expand(file, true);
+                        if(!file.empty()){
+                            string format;
+                            dataArchive->read("format", format);
+                            auto fileIO = ItemManager::findFileIOForLoading(pluginName, className, file, format);
+                            if(fileIO && fileIO->hasApi(ItemFileIO::ConcurrentParsing)){
+                                ItemFileIO::requestConcurrentParsing(fileIO, file);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    ListingPtr children = archive.findListing("children");
+    if(children->isValid()){
+        for(int i=0; i < children->size(); ++i){
+            if(auto childArchive = dynamic_cast<Archive*>(children->at(i)->toMapping())){
+                childArchive->inheritSharedInfoFrom(archive);
+                requestConcurrentFileParsingIter(*childArchive);
+            }
+        }
+    }
+}
+
+
+void ItemTreeArchiver::Impl::putItemLoadTimeReport(double totalTime)
+{
+    std::stable_sort(
+        itemLoadTimes.begin(), itemLoadTimes.end(),
+        [](const ItemLoadTime& t1, const ItemLoadTime& t2){ return t1.time > t2.time; });
+
+    mv->putln(_("Item load time report:"));
+    double restorationTime = 0.0;
+    for(auto& t : itemLoadTimes){
+        mv->putln(format(_(" {0:9.3f} ms  {1} \"{2}\""), t.time * 1000.0, t.className, t.itemName));
+        restorationTime += t.time;
+    }
+    mv->putln(
+        format(_(" Total: {0:.3f} ms ({1:.3f} ms in restoring {2} items)"),
+               totalTime * 1000.0, restorationTime * 1000.0, itemLoadTimes.size()));
+    if(isConcurrentFileParsingEnabled){
+        mv->putln(
+            format(_(" {0} files were parsed concurrently."), ItemFileIO::numConcurrentlyParsedFiles()));
+    }
+}
+
+
 void ItemTreeArchiver::Impl::restoreItemIter
 (Archive& archive, Item* parentItem, ItemList<>& io_topLevelItems, int level)
 {
@@ -450,7 +576,14 @@ ItemPtr ItemTreeArchiver::Impl::restoreItem
                 Archive* dataArchive = static_cast<Archive*>(dataNode->toMapping());
                 dataArchive->inheritSharedInfoFrom(archive);
                 dataArchive->setCurrentParentItem(parentItem);
-                if(!item->restore(*dataArchive)){
+                auto startTime = std::chrono::steady_clock::now();
+                bool restored = item->restore(*dataArchive);
+                if(isItemLoadTimeReportEnabled){
+                    itemLoadTimes.push_back(
+                        { className, itemName,
+                          std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() });
+                }
+                if(!restored){
                     item.reset();
                 } else {
                     restoreAddons(archive, item);
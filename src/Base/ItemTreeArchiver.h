@@ -25,6 +25,18 @@ public:
     */
     ItemList<> restore(Archive* archive, Item* parentItem, const std::set<std::string>& optionalPlugins);
 
+    /**
+       When this is enabled, the files of the items whose file IOs support the concurrent
+       parsing are parsed in worker threads before the item tree is restored, and the
+       items are then restored in the order of the archive using the parsed data.
+    */
+    void setConcurrentFileParsingEnabled(bool on);
+    bool isConcurrentFileParsingEnabled() const;
+
+    //! The restoration time of each item is output to the message view when this is enabled.
+    void setItemLoadTimeReportEnabled(bool on);
+    bool isItemLoadTimeReportEnabled() const;
+
     int numArchivedItems() const;
     int numRestoredItems() const;
 
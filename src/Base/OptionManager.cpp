@@ -131,6 +131,18 @@ OptionManager& OptionManager::addOption(const char* name, const program_options:
 }
 
 
+std::vector<std::string> OptionManager::optionNames()
+{
+    vector<string> names;
+    if(info){
+        for(auto& option : info->options.options()){
+            names.push_back(option->long_name());
+        }
+    }
+    return names;
+}
+
+
 /*
 OptionManager& OptionManager::addPositionalOption(const char* name, int maxCount)
 {
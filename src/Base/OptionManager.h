@@ -27,6 +27,9 @@ public:
     SignalProxy<void(std::vector<std::string>& inputFiles)> sigInputFileOptionsParsed(int phase = 0);
     SignalProxy<void(boost::program_options::variables_map& variables)> sigOptionsParsed(int phase = 0);
 
+    //! The long names of the options that have been added so far
+    static std::vector<std::string> optionNames();
+
     bool parseCommandLine1(int argc, char *argv[]);
     void parseCommandLine2();
 
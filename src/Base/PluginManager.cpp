@@ -6,6 +6,8 @@
 #include "AppConfig.h"
 #include "MainWindow.h"
 #include "Action.h"
+#include "ItemManager.h"
+#include "OptionManager.h"
 #include <cnoid/MessageOut>
 #include <cnoid/ValueTree>
 #include <cnoid/ExecutablePath>
@@ -21,6 +23,9 @@
 #include <map>
 #include <set>
 #include <list>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
 #include <fmt/format.h>
 
 #ifdef Q_OS_WIN32
@@ -72,6 +77,11 @@ struct PluginInfo
     Action* aboutMenuItem;
     DescriptionDialog* aboutDialog;
     string lastErrorMessage;
+    bool isDeferred;
+    bool isLoadingTimeReported;
+    double loadingTime;
+    double activationTime;
+    MappingPtr manifest;
 
     PluginInfo(){
         plugin = nullptr;
@@ -80,9 +90,24 @@ struct PluginInfo
         doReloading = false;
         aboutMenuItem = nullptr;
         aboutDialog = nullptr;
+        isDeferred = false;
+        isLoadingTimeReported = false;
+        loadingTime = 0.0;
+        activationTime = 0.0;
     }
 };
 
+double getElapsedTime(const std::chrono::steady_clock::time_point& startTime)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+bool checkEnvironmentVariable(const char* name)
+{
+    auto value = getenv(name);
+    return value && (strcmp(value, "0") != 0);
+}
+
 }
 
 namespace cnoid {
@@ -95,6 +120,8 @@ public:
 
     bool isStartupLoadingDisabled;
     bool isNamingConventionCheckDisabled;
+    bool isLazyActivationMode;
+    bool isLoadingTimeReportEnabled;
 
     MessageOut* mout;
     MainMenu* mainMenu;
@@ -121,6 +148,15 @@ public:
     LazyCaller unloadPluginsLater;
     LazyCaller reloadPluginsLater;
 
+    MappingPtr config;
+    set<string> eagerPluginNames;
+    map<string, MappingPtr> pathToManifestMap;
+    PluginMap nameToDeferredPluginInfoMap;
+    PluginMap itemClassToDeferredPluginInfoMap;
+    PluginMap optionToDeferredPluginInfoMap;
+    multimap<string, PluginInfoPtr> extensionToDeferredPluginInfoMap;
+    bool isManifestModified;
+
     void addPluginPath(const std::string& path);
     void loadPlugins(bool doActivation);
     void scanPluginFiles(const std::string& pathString, bool isUTF8, bool isRecursive);
@@ -136,6 +172,16 @@ public:
     const char* guessActualPluginName(const std::string& name);
     void onAboutDialogTriggered(PluginInfoPtr info);
     void showDialogToLoadPlugin();
+    void putLoadingTimeReport();
+    void readManifest();
+    void deferPluginIfManifested(PluginInfoPtr info);
+    void updateManifest(PluginInfoPtr info, const vector<string>& orgOptionNames);
+    void writeManifest();
+    PluginInfoPtr findDeferredPlugin(const std::string& name);
+    void undeferPlugin(PluginInfoPtr info);
+    bool undeferRequisitesOfLoadedPlugins();
+    bool activateDeferredPlugin(PluginInfoPtr info);
+    void activateDeferredPluginsForCommandLine(int argc, char* argv[]);
 };
 
 }
@@ -186,11 +232,21 @@ PluginManager::Impl::Impl()
     info->name = "Base";
     nameToPluginInfoMap.insert(make_pair(string("Base"), info));
 
-    auto config = AppConfig::archive()->openMapping("PluginManager");
+    config = AppConfig::archive()->openMapping("PluginManager");
     
     // The following options are used for debug and can only be specified in the config file.
     isStartupLoadingDisabled = config->get("disable_startup_loading", false);
     isNamingConventionCheckDisabled = config->get("disable_naming_convention_check", false);
+
+    isLazyActivationMode =
+        config->get("lazy_activation", false) || checkEnvironmentVariable("CNOID_LAZY_PLUGIN_ACTIVATION");
+    isLoadingTimeReportEnabled =
+        config->get("report_loading_time", false) || checkEnvironmentVariable("CNOID_REPORT_PLUGIN_LOADING_TIME");
+    isManifestModified = false;
+
+    if(isLazyActivationMode){
+        readManifest();
+    }
 }
 
 
@@ -311,6 +367,9 @@ void PluginManager::Impl::scanPluginFiles(const std::string& pathString, bool is
                     info->pathString = pathStringUtf8;
                     allPluginInfos.push_back(info);
                     pathToPluginInfoMap[info->pathString] = info;
+                    if(isLazyActivationMode){
+                        deferPluginIfManifested(info);
+                    }
                 }
             }
         }
@@ -324,7 +383,8 @@ void PluginManager::Impl::loadScannedPluginFiles(bool doActivation)
         int numLoaded = 0;
         int numNotLoaded = 0;
         for(size_t i=0; i < allPluginInfos.size(); ++i){
-            if(allPluginInfos[i]->status == PluginManager::NOT_LOADED){
+            auto& info = allPluginInfos[i];
+            if(info->status == PluginManager::NOT_LOADED && !info->isDeferred){
                 if(loadPlugin(i)){
                     ++numLoaded;
                 } else {
@@ -332,6 +392,9 @@ void PluginManager::Impl::loadScannedPluginFiles(bool doActivation)
                 }
             }
         }
+        if(undeferRequisitesOfLoadedPlugins()){
+            continue;
+        }
         if(numLoaded == 0 || numNotLoaded == 0){
             break;
         }
@@ -381,6 +444,13 @@ void PluginManager::Impl::loadScannedPluginFiles(bool doActivation)
             break;
         }
     }
+
+    if(isLoadingTimeReportEnabled){
+        putLoadingTimeReport();
+    }
+    if(isManifestModified){
+        writeManifest();
+    }
 }
 
 
@@ -405,6 +475,8 @@ bool PluginManager::Impl::loadPlugin(int index)
             mout->put(fmt::format(_("Detecting plugin file \"{}\".\n"), info->pathString));
         }
 
+        auto startTime = std::chrono::steady_clock::now();
+        
         info->dll.setFileName(info->pathString.c_str());
 
         /*
@@ -475,6 +547,8 @@ bool PluginManager::Impl::loadPlugin(int index)
             }
         }
 
+        info->loadingTime = getElapsedTime(startTime);
+
         PluginMap::iterator p = nameToPluginInfoMap.find(info->name);
         if(p == nameToPluginInfoMap.end()){
             nameToPluginInfoMap.insert(make_pair(info->name, info));
@@ -543,8 +617,16 @@ bool PluginManager::Impl::activatePlugin(int index)
         if(requisitesActive){
 
             info->areAllRequisitiesResolved = true;
+
+            vector<string> orgOptionNames;
+            if(isLazyActivationMode){
+                orgOptionNames = OptionManager::optionNames();
+            }
+            auto startTime = std::chrono::steady_clock::now();
+            bool initialized = info->plugin->initialize();
+            info->activationTime = getElapsedTime(startTime);
                 
-            if(!info->plugin->initialize()){
+            if(!initialized){
                 info->status = PluginManager::INVALID;
                 errorMessage = _("The plugin object cannot be intialized.");
 
@@ -583,6 +665,10 @@ bool PluginManager::Impl::activatePlugin(int index)
                         make_pair(info->plugin->oldName(i), info->name));
                 }
                 
+                if(isLazyActivationMode){
+                    updateManifest(info, orgOptionNames);
+                }
+                
                 mout->put(fmt::format(_("{}-plugin has been activated.\n"), info->name));
             }
         }
@@ -761,7 +847,7 @@ void PluginManager::Impl::clearUnusedPlugins()
 
     for(size_t i=0; i < oldList.size(); ++i){
         PluginInfoPtr& info = oldList[i];
-        if(info->status == PluginManager::ACTIVE){
+        if(info->status == PluginManager::ACTIVE || info->isDeferred){
             allPluginInfos.push_back(info);
         } else {
             pathToPluginInfoMap.erase(info->pathString);
@@ -788,6 +874,24 @@ const std::string& PluginManager::pluginName(int index) const
 }
 
 
+double PluginManager::pluginLoadingTime(int index) const
+{
+    return impl->allPluginInfos[index]->loadingTime;
+}
+
+
+double PluginManager::pluginActivationTime(int index) const
+{
+    return impl->allPluginInfos[index]->activationTime;
+}
+
+
+bool PluginManager::isPluginDeferred(int index) const
+{
+    return impl->allPluginInfos[index]->isDeferred;
+}
+
+
 int PluginManager::pluginStatus(int index) const
 {
     return impl->allPluginInfos[index]->status;
@@ -839,6 +943,14 @@ const char* PluginManager::Impl::guessActualPluginName(const std::string& name)
         }
     }
 
+    if(isLazyActivationMode){
+        if(auto info = findDeferredPlugin(name)){
+            if(activateDeferredPlugin(info)){
+                return info->name.c_str();
+            }
+        }
+    }
+
     return nullptr;
 }
 
@@ -901,3 +1013,341 @@ void PluginManager::Impl::showDialogToLoadPlugin()
         loadScannedPluginFiles(true);
     }
 }
+
+
+void PluginManager::Impl::putLoadingTimeReport()
+{
+    vector<PluginInfoPtr> infos;
+    for(auto& info : allPluginInfos){
+        if(info->status == PluginManager::ACTIVE && !info->isLoadingTimeReported){
+            infos.push_back(info);
+            info->isLoadingTimeReported = true;
+        }
+    }
+    if(infos.empty()){
+        return;
+    }
+    std::stable_sort(
+        infos.begin(), infos.end(),
+        [](const PluginInfoPtr& info1, const PluginInfoPtr& info2){
+            return (info1->loadingTime + info1->activationTime) > (info2->loadingTime + info2->activationTime); });
+
+    double totalLoadingTime = 0.0;
+    double totalActivationTime = 0.0;
+    mout->put(_("Plugin loading time (load + activation):\n"));
+    for(auto& info : infos){
+        mout->put(
+            format(_(" {0:8.1f} ms = {1:8.1f} ms + {2:8.1f} ms  {3}\n"),
+                   (info->loadingTime + info->activationTime) * 1000.0,
+                   info->loadingTime * 1000.0, info->activationTime * 1000.0, info->name));
+        totalLoadingTime += info->loadingTime;
+        totalActivationTime += info->activationTime;
+    }
+    mout->put(
+        format(_(" {0:8.1f} ms = {1:8.1f} ms + {2:8.1f} ms  Total of {3} plugin(s)\n"),
+               (totalLoadingTime + totalActivationTime) * 1000.0,
+               totalLoadingTime * 1000.0, totalActivationTime * 1000.0, infos.size()));
+
+    if(!nameToDeferredPluginInfoMap.empty()){
+        set<PluginInfoPtr> deferred;
+        for(auto& kv : nameToDeferredPluginInfoMap){
+            deferred.insert(kv.second);
+        }
+        mout->put(format(_(" {0} plugin(s) are deferred by the lazy activation mode.\n"), deferred.size()));
+    }
+}
+
+
+bool PluginManager::isLazyActivationMode() const
+{
+    return impl->isLazyActivationMode;
+}
+
+
+void PluginManager::Impl::readManifest()
+{
+    auto manifestList = config->findListing("manifest");
+    if(manifestList->isValid()){
+        for(auto& node : *manifestList){
+            if(auto manifest = node->toMapping()){
+                string path;
+                if(manifest->read("path", path)){
+                    pathToManifestMap[path] = manifest;
+                }
+            }
+        }
+    }
+
+    auto eagerPlugins = config->findListing("eager_plugins");
+    if(eagerPlugins->isValid()){
+        for(auto& node : *eagerPlugins){
+            eagerPluginNames.insert(node->toString());
+        }
+    }
+}
+
+
+/*
+  The time is written to the manifest as a decimal integer string because a floating point
+  number is written with only six significant digits.
+*/
+static int64_t getFileTime(const std::string& pathString)
+{
+    stdx::error_code ec;
+    filesystem::path path(fromUTF8(pathString));
+    if(!filesystem::exists(path, ec)){
+        return 0;
+    }
+    return static_cast<int64_t>(filesystem::last_write_time_to_time_t(path));
+}
+
+
+/**
+   The plugin is deferred when its manifest is valid for the current plugin file.
+   Otherwise the plugin is loaded at startup and its manifest is recorded.
+*/
+void PluginManager::Impl::deferPluginIfManifested(PluginInfoPtr info)
+{
+    auto p = pathToManifestMap.find(info->pathString);
+    if(p == pathToManifestMap.end()){
+        return;
+    }
+    auto& manifest = p->second;
+    string name;
+    if(!manifest->read("name", name) || eagerPluginNames.find(name) != eagerPluginNames.end()){
+        return;
+    }
+    string fileTime;
+    if(!manifest->read("file_time", fileTime)){
+        return;
+    }
+    int64_t time = std::strtoll(fileTime.c_str(), nullptr, 10);
+    if(time <= 0 || time != getFileTime(info->pathString)){
+        return;
+    }
+
+    info->isDeferred = true;
+    info->name = name;
+    info->manifest = manifest;
+
+    nameToDeferredPluginInfoMap[name] = info;
+    auto oldNames = manifest->findListing("old_names");
+    if(oldNames->isValid()){
+        for(auto& node : *oldNames){
+            nameToDeferredPluginInfoMap.insert(make_pair(node->toString(), info));
+        }
+    }
+    auto itemClasses = manifest->findListing("item_classes");
+    if(itemClasses->isValid()){
+        for(auto& node : *itemClasses){
+            itemClassToDeferredPluginInfoMap.insert(make_pair(node->toString(), info));
+        }
+    }
+    auto extensions = manifest->findListing("file_extensions");
+    if(extensions->isValid()){
+        for(auto& node : *extensions){
+            extensionToDeferredPluginInfoMap.insert(make_pair(node->toString(), info));
+        }
+    }
+    auto options = manifest->findListing("options");
+    if(options->isValid()){
+        for(auto& node : *options){
+            optionToDeferredPluginInfoMap.insert(make_pair(node->toString(), info));
+        }
+    }
+}
+
+
+void PluginManager::Impl::updateManifest(PluginInfoPtr info, const vector<string>& orgOptionNames)
+{
+    MappingPtr manifest = new Mapping;
+    manifest->write("path", info->pathString, DOUBLE_QUOTED);
+    manifest->write("file_time", std::to_string(getFileTime(info->pathString)));
+    manifest->write("name", info->name);
+
+    auto plugin = info->plugin;
+    int numOldNames = plugin->numOldNames();
+    if(numOldNames > 0){
+        auto oldNames = manifest->createFlowStyleListing("old_names");
+        for(int i=0; i < numOldNames; ++i){
+            oldNames->append(plugin->oldName(i));
+        }
+    }
+    if(!info->requisites.empty()){
+        auto requisites = manifest->createFlowStyleListing("requisites");
+        for(auto& requisite : info->requisites){
+            requisites->append(requisite);
+        }
+    }
+    auto classNames = ItemManager::getItemClassNames(info->name);
+    if(!classNames.empty()){
+        auto itemClasses = manifest->createFlowStyleListing("item_classes");
+        for(auto& className : classNames){
+            itemClasses->append(className);
+        }
+    }
+    auto extensionList = ItemManager::getFileExtensionsForLoading(info->name);
+    if(!extensionList.empty()){
+        auto extensions = manifest->createFlowStyleListing("file_extensions");
+        for(auto& extension : extensionList){
+            extensions->append(extension);
+        }
+    }
+    set<string> orgOptionNameSet(orgOptionNames.begin(), orgOptionNames.end());
+    ListingPtr options;
+    for(auto& option : OptionManager::optionNames()){
+        if(orgOptionNameSet.find(option) == orgOptionNameSet.end()){
+            if(!options){
+                options = manifest->createFlowStyleListing("options");
+            }
+            options->append(option);
+        }
+    }
+
+    pathToManifestMap[info->pathString] = manifest;
+    isManifestModified = true;
+}
+
+
+void PluginManager::Impl::writeManifest()
+{
+    auto manifestList = config->createListing("manifest");
+    for(auto& kv : pathToManifestMap){
+        manifestList->append(kv.second);
+    }
+    isManifestModified = false;
+}
+
+
+PluginInfoPtr PluginManager::Impl::findDeferredPlugin(const std::string& name)
+{
+    auto p = nameToDeferredPluginInfoMap.find(name);
+    if(p != nameToDeferredPluginInfoMap.end()){
+        return p->second;
+    }
+    return nullptr;
+}
+
+
+void PluginManager::Impl::undeferPlugin(PluginInfoPtr info)
+{
+    if(!info->isDeferred){
+        return;
+    }
+    info->isDeferred = false;
+
+    auto eraseFrom = [&info](auto& infoMap){
+        auto it = infoMap.begin();
+        while(it != infoMap.end()){
+            if(it->second == info){
+                it = infoMap.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    };
+    eraseFrom(nameToDeferredPluginInfoMap);
+    eraseFrom(itemClassToDeferredPluginInfoMap);
+    eraseFrom(optionToDeferredPluginInfoMap);
+    eraseFrom(extensionToDeferredPluginInfoMap);
+
+    auto requisites = info->manifest->findListing("requisites");
+    if(requisites->isValid()){
+        for(auto& node : *requisites){
+            if(auto requisite = findDeferredPlugin(node->toString())){
+                undeferPlugin(requisite);
+            }
+        }
+    }
+}
+
+
+bool PluginManager::Impl::undeferRequisitesOfLoadedPlugins()
+{
+    if(nameToDeferredPluginInfoMap.empty()){
+        return false;
+    }
+    bool undeferred = false;
+    for(auto& info : allPluginInfos){
+        if(info->status == PluginManager::LOADED){
+            for(auto& requisite : info->requisites){
+                if(auto deferred = findDeferredPlugin(requisite)){
+                    undeferPlugin(deferred);
+                    undeferred = true;
+                }
+            }
+        }
+    }
+    return undeferred;
+}
+
+
+bool PluginManager::activateDeferredPlugin(const std::string& name)
+{
+    if(auto info = impl->findDeferredPlugin(name)){
+        return impl->activateDeferredPlugin(info);
+    }
+    return false;
+}
+
+
+bool PluginManager::activateDeferredPluginForItemClass(const std::string& className)
+{
+    auto p = impl->itemClassToDeferredPluginInfoMap.find(className);
+    if(p != impl->itemClassToDeferredPluginInfoMap.end()){
+        return impl->activateDeferredPlugin(p->second);
+    }
+    return false;
+}
+
+
+bool PluginManager::Impl::activateDeferredPlugin(PluginInfoPtr info)
+{
+    undeferPlugin(info);
+    loadScannedPluginFiles(true);
+    return (info->status == PluginManager::ACTIVE);
+}
+
+
+void PluginManager::activateDeferredPluginsForCommandLine(int argc, char* argv[])
+{
+    if(impl->isLazyActivationMode){
+        impl->activateDeferredPluginsForCommandLine(argc, argv);
+    }
+}
+
+
+/**
+   The plugins that provide the command line options or the file types of the input files
+   must be activated before the command line is parsed.
+*/
+void PluginManager::Impl::activateDeferredPluginsForCommandLine(int argc, char* argv[])
+{
+    set<PluginInfoPtr> infos;
+    
+    for(int i=1; i < argc; ++i){
+        string arg(argv[i]);
+        if(arg.size() > 2 && arg[0] == '-' && arg[1] == '-'){
+            auto option = arg.substr(2, arg.find('=') - 2);
+            auto p = optionToDeferredPluginInfoMap.find(option);
+            if(p != optionToDeferredPluginInfoMap.end()){
+                infos.insert(p->second);
+            }
+        } else if(!arg.empty() && arg[0] != '-'){
+            string extension = filesystem::path(arg).extension().string();
+            if(extension.size() >= 2){
+                auto range = extensionToDeferredPluginInfoMap.equal_range(extension.substr(1));
+                for(auto p = range.first; p != range.second; ++p){
+                    infos.insert(p->second);
+                }
+            }
+        }
+    }
+
+    if(!infos.empty()){
+        for(auto& info : infos){
+            undeferPlugin(info);
+        }
+        loadScannedPluginFiles(true);
+    }
+}
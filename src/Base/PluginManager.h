@@ -38,6 +38,23 @@ public:
     enum PluginStatus { NOT_LOADED, LOADED, ACTIVE, FINALIZED, UNLOADED, INVALID, CONFLICT };
     int pluginStatus(int index) const;
 	
+    //! The time in seconds taken to load the plugin file
+    double pluginLoadingTime(int index) const;
+    //! The time in seconds taken to initialize the plugin
+    double pluginActivationTime(int index) const;
+
+    /**
+       In the lazy activation mode, the plugins recorded in the plugin manifest are not loaded
+       at startup. The manifest is cached in the application config and it records the item
+       types, file types and command line options provided by each plugin. A deferred plugin
+       is activated when the project or the user first needs one of the types provided by it.
+    */
+    bool isLazyActivationMode() const;
+    bool isPluginDeferred(int index) const;
+    bool activateDeferredPlugin(const std::string& name);
+    bool activateDeferredPluginForItemClass(const std::string& className);
+    void activateDeferredPluginsForCommandLine(int argc, char* argv[]);
+
     Plugin* findPlugin(const std::string& name);
     const std::string& getErrorMessage(const std::string& name);
     const char* guessActualPluginName(const std::string& name);
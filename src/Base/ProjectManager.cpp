@@ -23,6 +23,7 @@
 #include <QMessageBox>
 #include <string>
 #include <vector>
+#include <cstdlib>
 #include <fmt/format.h>
 #include "gettext.h"
 
@@ -37,6 +38,8 @@ bool defaultLayoutInclusionMode = true;
 bool isLayoutInclusionMode = true;
 bool isTemporaryItemSaveCheckAvailable = true;
 int projectBeingLoadedCounter = 0;
+bool isConcurrentItemFileParsingEnabled = true;
+bool isItemLoadTimeReportEnabled = false;
 MainWindow* mainWindow = nullptr;
 MessageView* mv = nullptr;
 
@@ -173,8 +176,13 @@ ProjectManager::Impl::Impl(ProjectManager* self, ExtensionManager* ext)
     saveDialog = nullptr;
     isMainInstance = true;
 
+    if(getenv("CNOID_DISABLE_CONCURRENT_ITEM_LOADING")){
+        isConcurrentItemFileParsingEnabled = false;
+    }
+
     OptionManager& om = ext->optionManager();
     om.addOption("project", boost::program_options::value<vector<string>>(), "load a project file");
+    om.addOption("report-item-load-time", "output the load time of each item in loading a project");
     om.sigInputFileOptionsParsed().connect(
         [this](std::vector<std::string>& inputFiles){ onInputFileOptionsParsed(inputFiles); });
     om.sigOptionsParsed().connect(
@@ -492,6 +500,8 @@ ItemList<> ProjectManager::Impl::loadProject
             }
             
             itemTreeArchiver.reset();
+            itemTreeArchiver.setConcurrentFileParsingEnabled(isConcurrentItemFileParsingEnabled);
+            itemTreeArchiver.setItemLoadTimeReportEnabled(isItemLoadTimeReportEnabled);
             Archive* items = archive->findSubArchive("items");
             if(items->isValid()){
                 items->inheritSharedInfoFrom(*archive);
@@ -763,6 +773,9 @@ bool ProjectManager::overwriteCurrentProject()
     
 void ProjectManager::Impl::onProjectOptionsParsed(boost::program_options::variables_map& v)
 {
+    if(v.count("report-item-load-time")){
+        isItemLoadTimeReportEnabled = true;
+    }
     if(v.count("project")){
         vector<string> projectFileNames = v["project"].as<vector<string>>();
         for(size_t i=0; i < projectFileNames.size(); ++i){
@@ -4,12 +4,14 @@
 #include "RootItem.h"
 #include "MessageView.h"
 #include <cnoid/ValueTree>
+#include <cnoid/ZipArchiver>
 #include <cnoid/FileUtil>
 #include <cnoid/UTF8>
 #include <cnoid/Config>
 #include <fmt/format.h>
 #include <zip.h>
 #include <map>
+#include <set>
 #include <deque>
 #include <algorithm>
 #include <regex>
@@ -52,6 +54,15 @@ public:
     vector<fs::path> refDirPaths;
     string unpackingDir;
 
+    /*
+      When this is true, only the files of the items are copied into the packing directory
+      because they may be overwritten in saving the project. The other files are archived
+      from the source files directly in creating the zip file of the project pack.
+    */
+    bool isDirectArchivingEnabled;
+    set<fs::path> itemFilePaths; // unified format paths
+    vector<pair<string, string>> directlyArchivedFiles; // Pairs of the entry path and the source path
+
     Impl(ProjectPacker* self);
     fs::path getUnifiedFormatPath(const std::string& pathString, bool& out_isAbsolute);
     bool packProjectToZipFile(const std::string& filename, const std::string& projectName);
@@ -61,7 +72,6 @@ public:
     void updatePackingItmes(Item* item);
     std::string getRelocatedFilePath(const std::string& pathString);
     bool createProjectZipFile(const string& zipFilename);
-    bool addDirectoryToZip(zip_t * zip, fs::path dirPath, const fs::path& zipTopDirPath);
     bool unpackProject(const std::string& projectPackFile);
     bool extractFiles(
         zip_t* zip, const string& zipFilename, const fs::path&  zipFilePath, const fs::path& topDirPath);
@@ -81,6 +91,7 @@ ProjectPacker::Impl::Impl(ProjectPacker* self)
     : self(self)
 {
     topItemForPacking = nullptr;
+    isDirectArchivingEnabled = false;
     
     mout = MessageOut::master();
     self->mout_ = mout;
@@ -162,7 +173,9 @@ bool ProjectPacker::packProjectToZipFile(const std::string& filename, const std:
 bool ProjectPacker::Impl::packProjectToZipFile(const std::string& filename, const std::string& projectName)
 {
     auto directory = filename + ".tmp";
+    isDirectArchivingEnabled = true;
     bool packed = packProjectToDirectory(directory, projectName);
+    isDirectArchivingEnabled = false;
     if(packed){
         packed = createProjectZipFile(filename);
         stdx::error_code ec;        
@@ -194,6 +207,8 @@ bool ProjectPacker::Impl::packProjectToDirectory(const std::string& packingDirec
     rootNode.isShared = false;
     rootNode.isNecessary = false;
     allPaths.clear();
+    itemFilePaths.clear();
+    directlyArchivedFiles.clear();
     
     checkFileDependency(topItem);
 
@@ -304,12 +319,19 @@ bool ProjectPacker::Impl::packProjectToDirectory(const std::string& packingDirec
             continue; // Ignore an invalid path
         }
         auto destDirPath = (packingDirPath / *relDirPath).lexically_normal();
+        bool isItemFile = itemFilePaths.find(path) != itemFilePaths.end();
 
 #ifdef _WIN32
         // Restore the original drive symbol in Windows
         static regex re("^\\\\([A-Za-z])");
         path = regex_replace(path.string(), re, "$1:");
 #endif
+        if(isDirectArchivingEnabled && !isItemFile){
+            directlyArchivedFiles.emplace_back(
+                toUTF8((*relDirPath / path.filename()).lexically_normal().generic_string()),
+                toUTF8(path.string()));
+            continue;
+        }
         if(fs::is_directory(path)){
             destDirPath /= path.filename();
         }
@@ -368,6 +390,11 @@ void ProjectPacker::Impl::checkFileDependency(Item* item)
 
     self->getItemDependentFiles(item, itemDependentFiles);
 
+    if(!item->filePath().empty()){
+        bool isAbsolute;
+        itemFilePaths.insert(getUnifiedFormatPath(item->filePath(), isAbsolute));
+    }
+
     for(auto file : itemDependentFiles){
         bool isAbsolute;
         fs::path ufPath = getUnifiedFormatPath(file, isAbsolute);
@@ -493,104 +520,20 @@ Item* ProjectPacker::getPackingItem(Item* item)
 
 bool ProjectPacker::Impl::createProjectZipFile(const string& zipFilename)
 {
-    fs::path zipFilePath(fromUTF8(zipFilename));
-
-    stdx::error_code ec;
-    if(fs::exists(zipFilePath)){
-        fs::remove(zipFilePath, ec);
-        if(ec){
-            mout->putErrorln(
-                format(_("The project pack file \"{0}\" already exists and cannot be removed: {1}."),
-                       zipFilename, toUTF8(ec.message())));
-            return false;
-        }
+    ZipArchiver archiver;
+    for(auto& file : directlyArchivedFiles){
+        archiver.addExternalSource(file.first, file.second);
     }
-        
-    int errorp;
-    zip_t* zip = zip_open(toUTF8(zipFilePath.make_preferred().string()).c_str(), ZIP_CREATE, &errorp);
-    if(!zip){
-        zip_error_t error;
-        zip_error_init_with_code(&error, errorp);
-        mout->putErrorln(
-            format(_("Failed to create the project pack file \"{0}\": {1}"),
-                   zipFilename, zip_error_strerror(&error)));
-        return false;
-    }
-
-    fs::path zipTopDirPath(zipFilePath.stem());
-    bool zipped = addDirectoryToZip(zip, packingDirPath, zipTopDirPath);
-    zip_close(zip);
-
+    bool zipped = archiver.createZipFile(zipFilename, toUTF8(packingDirPath.generic_string()));
     if(!zipped){
-        if(fs::exists(zipFilePath)){
-            fs::remove(zipFilePath, ec);
-        }
+        mout->putErrorln(archiver.errorMessage());
         mout->putErrorln(
             format(_("Failed to create the project pack file \"{0}\"."), zipFilename));
     }
-
     return zipped;
 }
 
 
-bool ProjectPacker::Impl::addDirectoryToZip(zip_t* zip, fs::path dirPath, const fs::path& zipTopDirPath)
-{
-    auto relDirPath = getRelativePath(dirPath, packingDirPath);
-    if(!relDirPath){
-        return false;
-    }
-    fs::path localDirPath = (zipTopDirPath / *relDirPath).lexically_normal();
-    string localDirStr = toUTF8(localDirPath.generic_string());
-    int index = zip_dir_add(zip, localDirStr.c_str(), ZIP_FL_ENC_UTF_8);
-    if(index < 0){
-        mout->putErrorln(
-            format(_("Failed to add directory \"{0}\" to the project pack: {1}"),
-                   localDirStr, zip_strerror(zip)));
-        return false;
-    }
-
-    for(const fs::directory_entry& entry : fs::directory_iterator(dirPath)){
-        auto entryPath = entry.path();
-        if(fs::is_directory(entryPath)){
-            if(!addDirectoryToZip(zip, entryPath, zipTopDirPath)){
-                return false;
-            }
-        } else {
-            auto localPath = zipTopDirPath / *getRelativePath(entryPath, packingDirPath);
-            auto localPathStr = toUTF8(localPath.generic_string());
-            auto sourcePath = toUTF8(entryPath.make_preferred().string());
-            zip_source_t* source = zip_source_file(zip, sourcePath.c_str(), 0, 0);
-            if(!source){
-                mout->putErrorln(
-                    format(_("Failed to add file \"{0}\" to the project pack: {1}"),
-                           localPathStr, zip_strerror(zip)));
-                return false;
-            }
-            int index = zip_file_add(zip, localPathStr.c_str(), source, ZIP_FL_ENC_UTF_8);
-            if(index < 0){
-                zip_source_free(source);
-                mout->putErrorln(
-                    format(_("Failed to add file \"{0}\" to the project pack: {1}"),
-                           localPathStr, zip_strerror(zip)));
-                return false;
-            }
-            // The deflate compression is applied by default. The following code is not necessary.
-            /*
-            if(zip_set_file_compression(zip, index, ZIP_CM_DEFLATE, 0) < 0){
-                zip_source_free(source);
-                mout->putErrorln(
-                    format(_("Failed to compress file \"{0}\" in the project pack: {1}"),
-                           localPathStr, zip_strerror(zip)));
-                return false;
-            }
-            */
-        }
-    }
-
-    return true;
-}
-
-
 bool ProjectPacker::unpackProject(const std::string& projectPackFile)
 {
     return impl->unpackProject(projectPackFile);
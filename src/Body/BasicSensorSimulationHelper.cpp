@@ -157,6 +157,33 @@ void BasicSensorSimulationHelper::Impl::initialize
 }
 
 
+void BasicSensorSimulationHelper::storeState(std::vector<double>& io_state) const
+{
+    for(auto& s : impl->kfStates){
+        for(int i=0; i < 3; ++i){
+            io_state.push_back(s.x[i](0));
+            io_state.push_back(s.x[i](1));
+        }
+    }
+}
+
+
+bool BasicSensorSimulationHelper::restoreState(const double*& io_pos, const double* end)
+{
+    auto& kfStates = impl->kfStates;
+    if(end - io_pos < static_cast<std::ptrdiff_t>(kfStates.size() * 6)){
+        return false;
+    }
+    for(auto& s : kfStates){
+        for(int i=0; i < 3; ++i){
+            s.x[i](0) = *io_pos++;
+            s.x[i](1) = *io_pos++;
+        }
+    }
+    return true;
+}
+
+
 void BasicSensorSimulationHelper::updateGyroAndAccelerationSensors()
 {
     // update angular velocity
@@ -34,6 +34,14 @@ public:
 
     void updateGyroAndAccelerationSensors();
 
+    /**
+       The filter states used in the old acceleration sensor calculation mode are appended
+       to the array, and they are restored from the array position that is advanced by the
+       number of the read elements.
+    */
+    void storeState(std::vector<double>& io_state) const;
+    bool restoreState(const double*& io_pos, const double* end);
+
 private:
     bool isActive_;
     DeviceList<ForceSensor> forceSensors_;
@@ -17,9 +17,11 @@
 #include <fmt/format.h>
 #include <random>
 #include <unordered_map>
+#include <algorithm>
 #include <limits>
 #include <fstream>
 #include <iomanip>
+#include <sstream>
 #include <iostream>
 
 using namespace std;
@@ -56,6 +58,12 @@ static const bool ENABLE_TRUE_FRICTION_CONE =
 static const bool SKIP_REDUNDANT_ACCEL_CALC = true;
 static const bool ASSUME_SYMMETRIC_MATRIX = false;
 
+// The LCP matrix is computed and solved as a block sparse matrix when the ratio of the elements
+// in the coupled blocks is less than the following threshold. See updateLcpMatrixSparsity().
+// The threshold can be checked with the cnoid-constraint-force-solver-benchmark program.
+static const bool ENABLE_SPARSE_LCP_MATRIX = (true && !usePivotingLCP);
+static const double DEFAULT_MAX_FILL_RATIO_OF_SPARSE_LCP_MATRIX = 0.3;
+
 static const int DEFAULT_MAX_NUM_GAUSS_SEIDEL_ITERATION = 25;
 
 //static const int DEFAULT_NUM_GAUSS_SEIDEL_ITERATION_BLOCK = 10;
@@ -67,6 +75,8 @@ static const double DEFAULT_GAUSS_SEIDEL_ERROR_CRITERION = 1.0e-3;
 static const double THRESH_TO_SWITCH_REL_ERROR = 1.0e-8;
 //static const double THRESH_TO_SWITCH_REL_ERROR = numeric_limits<double>::epsilon();
 
+// The solution of the previous step is used as the initial solution of the current step
+// by matching the current constraint points with the previous ones.
 static const bool USE_PREVIOUS_LCP_SOLUTION = true;
 
 static const bool ENABLE_CONTACT_DEPTH_CORRECTION = true;
@@ -156,6 +166,16 @@ public:
         int globalFrictionIndex;
         int numFrictionVectors;
         Vector3 frictionVector[4][2];
+        unsigned long long featureId; // Collision::id of the contact point
+    };
+
+    // The constraint force of a constraint point solved in the previous step
+    struct CachedConstraintForce
+    {
+        Vector3 localPoint; // in the link[0] frame
+        Vector3 localFrictionForce; // applied to link[1] in the link[0] frame
+        double normalForce;
+        unsigned long long featureId;
     };
 
     class ContactMaterialEx : public ContactMaterial
@@ -182,12 +202,22 @@ public:
     class LinkPair
     {
     public:
+        LinkPair() : forceCacheSolveCount(-1) { }
         virtual ~LinkPair() { }
         bool isBelongingToSameSubBody;
         DyLink* link[2];
         vector<ConstraintPoint> constraintPoints;
         ContactMaterialExPtr contactMaterial;
         bool isNonContactConstraint;
+
+        /*
+          The link pair objects are kept while the simulation is running, so the forces
+          of the constraint points are cached in them and used as the initial solution
+          of the next step. The cache is only valid when the count is the previous one.
+        */
+        vector<CachedConstraintForce> forceCache;
+        int forceCacheSolveCount;
+        IdPair<GeometryHandle> geometryPair; // only for the contact link pairs
     };
 
     unordered_map<IdPair<GeometryHandle>, LinkPair> geometryPairToLinkPairMap;
@@ -237,6 +267,33 @@ public:
     // Mlcp * solution + b   _|_  solution
     MatrixX Mlcp;
 
+    /*
+      Block sparse structure of Mlcp. The constraint vectors of a constrained link pair form a block,
+      and the blocks of two link pairs are coupled only when the pairs share a non-static sub body.
+      The elements of the other blocks are zero, so they are neither computed nor accessed in the
+      sparse mode. Note that the elements in the dense storage of Mlcp are not cleared in the mode.
+    */
+    struct LcpBlock
+    {
+        int normalIndex;
+        int numNormals;
+        int frictionIndex; // index in Mlcp, which is offset by the number of the normal vectors
+        int numFrictions;
+    };
+    struct LcpColumnSpan
+    {
+        int begin;
+        int size;
+    };
+    bool isLcpMatrixSparse;
+    double maxFillRatioOfSparseLcpMatrix;
+    vector<LcpBlock> lcpBlocks;
+    vector<vector<int>> coupledLinkPairIndices; // sorted indices including the pair itself
+    vector<pair<DySubBody*, int>> subBodyToLinkPairIndexPairs;
+    vector<int> lcpRowToLinkPairIndex;
+    vector<int> lcpColumnSpanOffsets;
+    vector<LcpColumnSpan> lcpColumnSpans; // column spans of the coupled blocks of each link pair
+
     // constant acceleration term when no external force is applied
     VectorX an0;
     VectorX at0;
@@ -266,6 +323,10 @@ public:
     int numGaussSeidelTotalCalls;
     int numGaussSeidelTotalLoopsMax;
 
+    int solveCount;
+    vector<char> forceCacheUsageFlags;
+    ConstraintForceSolver::GaussSeidelStatistics gaussSeidelStatistics;
+
     Impl(DyWorldBase& world);
     ~Impl();
     void clearBodies();
@@ -286,7 +347,16 @@ public:
     void set2dConstraintPoints(const Constrain2dLinkPairPtr& linkPair);
     void putContactPoints();
     void solveImpactConstraints();
+    void setInitialSolutionWithForceCache();
+    void applyCachedConstraintForce(
+        const CachedConstraintForce& cache, const Matrix3& R0, ConstraintPoint& constraint);
+    void updateForceCache();
+    void storeState(std::vector<double>& io_state) const;
+    void storeForceCache(const LinkPair& linkPair, std::vector<double>& io_state) const;
+    bool restoreState(const double*& io_pos, const double* end);
+    bool restoreForceCache(LinkPair* linkPair, const double*& io_pos, const double* end);
     void initMatrices();
+    void updateLcpMatrixSparsity();
     void setAccelCalcSkipInformation();
     void setDefaultAccelerationVector();
     void setAccelerationMatrix();
@@ -296,7 +366,11 @@ public:
     void calcAccelsABM(DySubBody* subBody, int constraintIndex);
     void calcAccelsMM(DySubBody* bodyData, int constraintIndex);
     void extractRelAccelsOfConstraintPoints(
-        Eigen::Block<MatrixX>& Kxn, Eigen::Block<MatrixX>& Kxt, int testForceIndex, int constraintIndex);
+        Eigen::Block<MatrixX>& Kxn, Eigen::Block<MatrixX>& Kxt,
+        int linkPairIndex, int testForceIndex, int constraintIndex);
+    void extractRelAccelsFromLinkPair(
+        Eigen::Block<MatrixX>& Kxn, Eigen::Block<MatrixX>& Kxt,
+        LinkPair& linkPair, int testForceIndex, int maxConstraintIndexToExtract);
     void extractRelAccelsFromLinkPairCase1(
         Eigen::Block<MatrixX>& Kxn, Eigen::Block<MatrixX>& Kxt,
         LinkPair& linkPair, int testForceIndex, int constraintIndex);
@@ -316,6 +390,7 @@ public:
     void solveMCPByProjectedGaussSeidelMainStep(const MatrixX& M, const VectorX& b, VectorX& x);
     void solveMCPByProjectedGaussSeidelInitial(
         const MatrixX& M, const VectorX& b, VectorX& x, const int numIteration);
+    double calcOffDiagonalRowProduct(const MatrixX& M, const VectorX& x, int row, int size) const;
     void checkLCPResult(MatrixX& M, VectorX& b, VectorX& x);
     void checkMCPResult(MatrixX& M, VectorX& b, VectorX& x);
 
@@ -386,6 +461,9 @@ ConstraintForceSolver::Impl::Impl(DyWorldBase& world)
 
     bodyIndexToCollisionDetectionModeMap.clear();
     is2Dmode = false;
+    solveCount = 0;
+    isLcpMatrixSparse = false;
+    maxFillRatioOfSparseLcpMatrix = DEFAULT_MAX_FILL_RATIO_OF_SPARSE_LCP_MATRIX;
 }
 
 
@@ -579,6 +657,8 @@ void ConstraintForceSolver::Impl::initialize(void)
     prevGlobalNumConstraintVectors = 0;
     prevGlobalNumFrictionVectors = 0;
     numUnconverged = 0;
+    solveCount = 0;
+    gaussSeidelStatistics = ConstraintForceSolver::GaussSeidelStatistics();
 
     if(ENABLE_RANDOM_STATIC_FRICTION_BASE){
         randomEngine.seed();
@@ -658,10 +738,17 @@ void ConstraintForceSolver::Impl::solve()
 
     bodyCollisionDetector.updatePositions();
 
+    ++solveCount;
     globalNumConstraintVectors = 0;
     globalNumFrictionVectors = 0;
     areThereImpacts = false;
 
+    auto& stats = gaussSeidelStatistics;
+    stats.numWarmStartedConstraints = 0;
+    stats.numIterations = 0;
+    stats.error = 0.0;
+    stats.isConverged = true;
+
     constrainedLinkPairs.clear();
 
     setConstraintPoints();
@@ -684,6 +771,8 @@ void ConstraintForceSolver::Impl::solve()
             initMatrices();
         }
 
+        updateLcpMatrixSparsity();
+
         if(areThereImpacts){
             solveImpactConstraints();
         }
@@ -711,7 +800,9 @@ void ConstraintForceSolver::Impl::solve()
 #ifdef USE_PIVOTING_LCP
         isConverged = callPathLCPSolver(Mlcp, b, solution);
 #else
-        if(!USE_PREVIOUS_LCP_SOLUTION || constraintsSizeChanged){
+        if(USE_PREVIOUS_LCP_SOLUTION){
+            setInitialSolutionWithForceCache();
+        } else {
             solution.setZero();
         }
         solveMCPByProjectedGaussSeidel(Mlcp, b, solution);
@@ -731,9 +822,15 @@ void ConstraintForceSolver::Impl::solve()
             }
 
             addConstraintForceToLinks();
+
+            if(USE_PREVIOUS_LCP_SOLUTION){
+                updateForceCache();
+            }
         }
     }
 
+    stats.numConstraints = globalNumConstraintVectors;
+
     prevGlobalNumConstraintVectors = globalNumConstraintVectors;
     prevGlobalNumFrictionVectors = globalNumFrictionVectors;
 }
@@ -769,6 +866,7 @@ void ConstraintForceSolver::Impl::extractConstraintPoints(const CollisionPair& c
         pLinkPair->constraintPoints.clear();
     } else {
         LinkPair& linkPair = geometryPairToLinkPairMap.insert(make_pair(idPair, LinkPair())).first->second;
+        linkPair.geometryPair = idPair;
         int material[2];
         
         for(int i=0; i < 2; ++i){
@@ -843,6 +941,7 @@ bool ConstraintForceSolver::Impl::setContactConstraintPoint(LinkPair& linkPair,
     contact.normalTowardInside[0] = -contact.normalTowardInside[1];
     contact.depth = collision.depth;
     contact.globalIndex = globalNumConstraintVectors++;
+    contact.featureId = collision.id;
 
     // check velocities
     Vector3 v[2];
@@ -1084,6 +1183,124 @@ void ConstraintForceSolver::Impl::solveImpactConstraints()
 }
 
 
+/**
+   The constraint points of the current step are matched with the cached ones of the previous
+   step, and the cached forces are set to the initial solution. The contact points are matched
+   by the nearest cached point in the link[0] frame, which is within the culling distance and
+   preferably has the same feature ID. The other constraint points are matched by their indices.
+*/
+void ConstraintForceSolver::Impl::setInitialSolutionWithForceCache()
+{
+    solution.setZero();
+
+    const int prevSolveCount = solveCount - 1;
+    int numWarmStartedConstraints = 0;
+    
+    for(auto& linkPair : constrainedLinkPairs){
+        auto& cache = linkPair->forceCache;
+        if(linkPair->forceCacheSolveCount != prevSolveCount || cache.empty()){
+            continue;
+        }
+        DyLink* link0 = linkPair->link[0];
+        const Matrix3& R0 = link0->R();
+        auto& constraintPoints = linkPair->constraintPoints;
+        const int numPoints = constraintPoints.size();
+        const int numCachedPoints = cache.size();
+
+        if(linkPair->isNonContactConstraint){
+            if(numPoints == numCachedPoints){
+                for(int i=0; i < numPoints; ++i){
+                    applyCachedConstraintForce(cache[i], R0, constraintPoints[i]);
+                }
+                numWarmStartedConstraints += numPoints;
+            }
+            continue;
+        }
+
+        const double distanceThresh = linkPair->contactMaterial->cullingDistance;
+        const double squaredDistanceThresh = distanceThresh * distanceThresh;
+        forceCacheUsageFlags.assign(numCachedPoints, false);
+        
+        for(auto& contact : constraintPoints){
+            const Vector3 localPoint = R0.transpose() * (contact.point - link0->p());
+            int matchedIndex = -1;
+            double minSquaredDistance = squaredDistanceThresh;
+            bool isSameFeatureMatched = false;
+            for(int i=0; i < numCachedPoints; ++i){
+                if(forceCacheUsageFlags[i]){
+                    continue;
+                }
+                const double d2 = (cache[i].localPoint - localPoint).squaredNorm();
+                if(d2 < squaredDistanceThresh){
+                    const bool isSameFeature = (cache[i].featureId == contact.featureId);
+                    if((isSameFeature && !isSameFeatureMatched) ||
+                       (isSameFeature == isSameFeatureMatched && d2 < minSquaredDistance)){
+                        matchedIndex = i;
+                        minSquaredDistance = d2;
+                        isSameFeatureMatched = isSameFeature;
+                    }
+                }
+            }
+            if(matchedIndex >= 0){
+                forceCacheUsageFlags[matchedIndex] = true;
+                applyCachedConstraintForce(cache[matchedIndex], R0, contact);
+                ++numWarmStartedConstraints;
+            }
+        }
+    }
+
+    gaussSeidelStatistics.numWarmStartedConstraints = numWarmStartedConstraints;
+}
+
+
+void ConstraintForceSolver::Impl::applyCachedConstraintForce
+(const CachedConstraintForce& cache, const Matrix3& R0, ConstraintPoint& constraint)
+{
+    solution(constraint.globalIndex) = cache.normalForce;
+
+    if(constraint.numFrictionVectors > 0){
+        const Vector3 frictionForce = R0 * cache.localFrictionForce;
+        const int offset = globalNumConstraintVectors + constraint.globalFrictionIndex;
+        for(int i=0; i < constraint.numFrictionVectors; ++i){
+            double f = frictionForce.dot(constraint.frictionVector[i][1]);
+            if(!STATIC_FRICTION_BY_TWO_CONSTRAINTS && f < 0.0){
+                f = 0.0;
+            }
+            solution(offset + i) = f;
+        }
+    }
+}
+
+
+void ConstraintForceSolver::Impl::updateForceCache()
+{
+    for(auto& linkPair : constrainedLinkPairs){
+        DyLink* link0 = linkPair->link[0];
+        const Matrix3 R0t = link0->R().transpose();
+        auto& constraintPoints = linkPair->constraintPoints;
+        const int numPoints = constraintPoints.size();
+        auto& cache = linkPair->forceCache;
+        cache.resize(numPoints);
+        
+        for(int i=0; i < numPoints; ++i){
+            auto& constraint = constraintPoints[i];
+            auto& cached = cache[i];
+            cached.localPoint.noalias() = R0t * (constraint.point - link0->p());
+            cached.normalForce = solution(constraint.globalIndex);
+            Vector3 frictionForce = Vector3::Zero();
+            for(int j=0; j < constraint.numFrictionVectors; ++j){
+                frictionForce +=
+                    solution(globalNumConstraintVectors + constraint.globalFrictionIndex + j) *
+                    constraint.frictionVector[j][1];
+            }
+            cached.localFrictionForce.noalias() = R0t * frictionForce;
+            cached.featureId = linkPair->isNonContactConstraint ? 0 : constraint.featureId;
+        }
+        linkPair->forceCacheSolveCount = solveCount;
+    }
+}
+
+
 void ConstraintForceSolver::Impl::initMatrices()
 {
     const int n = globalNumConstraintVectors;
@@ -1114,6 +1331,137 @@ void ConstraintForceSolver::Impl::initMatrices()
 }
 
 
+/**
+   This function makes the block sparse structure of the LCP matrix from the current constraints
+   and decides whether the sparse mode is used or not by the ratio of the elements in the coupled
+   blocks. In scenes with many independent objects, most of the blocks are not coupled, and the
+   computational costs of both the matrix construction and the Gauss-Seidel iterations can be
+   reduced to the number of the coupled elements.
+*/
+void ConstraintForceSolver::Impl::updateLcpMatrixSparsity()
+{
+    auto& stats = gaussSeidelStatistics;
+    isLcpMatrixSparse = false;
+    stats.matrixFillRatio = 1.0;
+    stats.isSparseMatrixUsed = false;
+
+    // The debug outputs access all the elements of the matrix
+    if(!ENABLE_SPARSE_LCP_MATRIX || CFS_DEBUG_VERBOSE || CFS_DEBUG_LCPCHECK){
+        return;
+    }
+
+    const int n = globalNumConstraintVectors;
+    const int size = n + globalNumFrictionVectors;
+    const int numLinkPairs = constrainedLinkPairs.size();
+
+    lcpBlocks.resize(numLinkPairs);
+    subBodyToLinkPairIndexPairs.clear();
+
+    for(int i=0; i < numLinkPairs; ++i){
+        LinkPair* linkPair = constrainedLinkPairs[i];
+        auto& constraintPoints = linkPair->constraintPoints;
+        LcpBlock& block = lcpBlocks[i];
+        block.normalIndex = constraintPoints.front().globalIndex;
+        block.numNormals = constraintPoints.size();
+        block.numFrictions = 0;
+        for(auto& constraint : constraintPoints){
+            block.numFrictions += constraint.numFrictionVectors;
+        }
+        block.frictionIndex = (block.numFrictions > 0) ? (n + constraintPoints.front().globalFrictionIndex) : n;
+
+        for(int j=0; j < 2; ++j){
+            auto subBody = linkPair->link[j]->subBody();
+            if(!subBody->isStatic()){
+                subBodyToLinkPairIndexPairs.emplace_back(subBody, i);
+            }
+        }
+    }
+
+    // The link pairs sharing a sub body are coupled with each other
+    coupledLinkPairIndices.resize(numLinkPairs);
+    for(int i=0; i < numLinkPairs; ++i){
+        coupledLinkPairIndices[i].assign(1, i);
+    }
+    std::sort(subBodyToLinkPairIndexPairs.begin(), subBodyToLinkPairIndexPairs.end());
+    const int numEntries = subBodyToLinkPairIndexPairs.size();
+    int groupTop = 0;
+    while(groupTop < numEntries){
+        auto subBody = subBodyToLinkPairIndexPairs[groupTop].first;
+        int groupEnd = groupTop + 1;
+        while(groupEnd < numEntries && subBodyToLinkPairIndexPairs[groupEnd].first == subBody){
+            ++groupEnd;
+        }
+        for(int i = groupTop; i < groupEnd; ++i){
+            auto& indices = coupledLinkPairIndices[subBodyToLinkPairIndexPairs[i].second];
+            for(int j = groupTop; j < groupEnd; ++j){
+                indices.push_back(subBodyToLinkPairIndexPairs[j].second);
+            }
+        }
+        groupTop = groupEnd;
+    }
+
+    double numCoupledElements = 0.0;
+    for(int i=0; i < numLinkPairs; ++i){
+        auto& indices = coupledLinkPairIndices[i];
+        std::sort(indices.begin(), indices.end());
+        indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+        int numCoupledColumns = 0;
+        for(auto& index : indices){
+            numCoupledColumns += lcpBlocks[index].numNormals + lcpBlocks[index].numFrictions;
+        }
+        numCoupledElements += static_cast<double>(lcpBlocks[i].numNormals + lcpBlocks[i].numFrictions) * numCoupledColumns;
+    }
+
+    stats.matrixFillRatio = numCoupledElements / (static_cast<double>(size) * size);
+    if(stats.matrixFillRatio > maxFillRatioOfSparseLcpMatrix){
+        return;
+    }
+
+    /*
+      The coupled columns of each link pair are stored as spans, where the adjacent spans are
+      merged into one span. The indices of the link pairs are sorted in the order of the constraint
+      vector indices, so the spans are also sorted.
+    */
+    lcpColumnSpans.clear();
+    lcpColumnSpanOffsets.resize(numLinkPairs + 1);
+    for(int i=0; i < numLinkPairs; ++i){
+        const int offset = lcpColumnSpans.size();
+        lcpColumnSpanOffsets[i] = offset;
+        auto addSpan = [&](int begin, int spanSize){
+            if(spanSize > 0){
+                if(static_cast<int>(lcpColumnSpans.size()) > offset){
+                    auto& last = lcpColumnSpans.back();
+                    if(last.begin + last.size == begin){
+                        last.size += spanSize;
+                        return;
+                    }
+                }
+                lcpColumnSpans.push_back(LcpColumnSpan{ begin, spanSize });
+            }
+        };
+        auto& indices = coupledLinkPairIndices[i];
+        for(auto& index : indices){
+            addSpan(lcpBlocks[index].normalIndex, lcpBlocks[index].numNormals);
+        }
+        for(auto& index : indices){
+            addSpan(lcpBlocks[index].frictionIndex, lcpBlocks[index].numFrictions);
+        }
+    }
+    lcpColumnSpanOffsets[numLinkPairs] = lcpColumnSpans.size();
+
+    lcpRowToLinkPairIndex.resize(size);
+    for(int i=0; i < numLinkPairs; ++i){
+        LcpBlock& block = lcpBlocks[i];
+        std::fill_n(lcpRowToLinkPairIndex.begin() + block.normalIndex, block.numNormals, i);
+        std::fill_n(lcpRowToLinkPairIndex.begin() + block.frictionIndex, block.numFrictions, i);
+    }
+
+    isLcpMatrixSparse = true;
+    stats.isSparseMatrixUsed = true;
+    ++stats.numSparseMatrixSteps;
+}
+
+
 void ConstraintForceSolver::Impl::setAccelCalcSkipInformation()
 {
     // clear skip check numbers
@@ -1240,7 +1588,7 @@ void ConstraintForceSolver::Impl::setAccelerationMatrix()
                     }
                 }
             }
-            extractRelAccelsOfConstraintPoints(Knn, Knt, constraintIndex, constraintIndex);
+            extractRelAccelsOfConstraintPoints(Knn, Knt, i, constraintIndex, constraintIndex);
 
             // apply test friction force
             for(int l=0; l < constraint.numFrictionVectors; ++l){
@@ -1267,7 +1615,7 @@ void ConstraintForceSolver::Impl::setAccelerationMatrix()
                         }
                     }
                 }
-                extractRelAccelsOfConstraintPoints(Ktn, Ktt, constraint.globalFrictionIndex + l, constraintIndex);
+                extractRelAccelsOfConstraintPoints(Ktn, Ktt, i, constraint.globalFrictionIndex + l, constraintIndex);
             }
 
             linkPair.link[0]->subBody()->isTestForceBeingApplied = false;
@@ -1419,26 +1767,41 @@ void ConstraintForceSolver::Impl::calcAccelsMM(DySubBody* subBody, int constrain
 
 
 void ConstraintForceSolver::Impl::extractRelAccelsOfConstraintPoints
-(Eigen::Block<MatrixX>& Kxn, Eigen::Block<MatrixX>& Kxt, int testForceIndex, int constraintIndex)
+(Eigen::Block<MatrixX>& Kxn, Eigen::Block<MatrixX>& Kxt, int linkPairIndex, int testForceIndex, int constraintIndex)
 {
     int maxConstraintIndexToExtract = ASSUME_SYMMETRIC_MATRIX ? constraintIndex : globalNumConstraintVectors;
 
-    for(size_t i=0; i < constrainedLinkPairs.size(); ++i){
-        LinkPair& linkPair = *constrainedLinkPairs[i];
-        auto subBody0 = linkPair.link[0]->subBody();
-        auto subBody1 = linkPair.link[1]->subBody();
-        if(subBody0->isTestForceBeingApplied){
-            if(subBody1->isTestForceBeingApplied){
-                extractRelAccelsFromLinkPairCase1(Kxn, Kxt, linkPair, testForceIndex, maxConstraintIndexToExtract);
-            } else {
-                extractRelAccelsFromLinkPairCase2(Kxn, Kxt, linkPair, 0, 1, testForceIndex, maxConstraintIndexToExtract);
-            }
+    if(isLcpMatrixSparse){
+        for(auto& index : coupledLinkPairIndices[linkPairIndex]){
+            extractRelAccelsFromLinkPair(
+                Kxn, Kxt, *constrainedLinkPairs[index], testForceIndex, maxConstraintIndexToExtract);
+        }
+    } else {
+        for(size_t i=0; i < constrainedLinkPairs.size(); ++i){
+            extractRelAccelsFromLinkPair(
+                Kxn, Kxt, *constrainedLinkPairs[i], testForceIndex, maxConstraintIndexToExtract);
+        }
+    }
+}
+
+
+void ConstraintForceSolver::Impl::extractRelAccelsFromLinkPair
+(Eigen::Block<MatrixX>& Kxn, Eigen::Block<MatrixX>& Kxt,
+ LinkPair& linkPair, int testForceIndex, int maxConstraintIndexToExtract)
+{
+    auto subBody0 = linkPair.link[0]->subBody();
+    auto subBody1 = linkPair.link[1]->subBody();
+    if(subBody0->isTestForceBeingApplied){
+        if(subBody1->isTestForceBeingApplied){
+            extractRelAccelsFromLinkPairCase1(Kxn, Kxt, linkPair, testForceIndex, maxConstraintIndexToExtract);
         } else {
-            if(subBody1->isTestForceBeingApplied){
-                extractRelAccelsFromLinkPairCase2(Kxn, Kxt, linkPair, 1, 0, testForceIndex, maxConstraintIndexToExtract);
-            } else {
-                extractRelAccelsFromLinkPairCase3(Kxn, Kxt, linkPair, testForceIndex, maxConstraintIndexToExtract);
-            }
+            extractRelAccelsFromLinkPairCase2(Kxn, Kxt, linkPair, 0, 1, testForceIndex, maxConstraintIndexToExtract);
+        }
+    } else {
+        if(subBody1->isTestForceBeingApplied){
+            extractRelAccelsFromLinkPairCase2(Kxn, Kxt, linkPair, 1, 0, testForceIndex, maxConstraintIndexToExtract);
+        } else {
+            extractRelAccelsFromLinkPairCase3(Kxn, Kxt, linkPair, testForceIndex, maxConstraintIndexToExtract);
         }
     }
 }
@@ -1782,6 +2145,19 @@ void ConstraintForceSolver::Impl::solveMCPByProjectedGaussSeidel(const MatrixX&
         }
     }
 
+    auto& stats = gaussSeidelStatistics;
+    stats.numIterations = numGaussSeidelInitialIteration + loopBlockSize * i;
+    stats.error = error;
+    stats.isConverged = (error < gaussSeidelErrorCriterion);
+    ++stats.numSolvedSteps;
+    stats.totalNumIterations += stats.numIterations;
+    if(stats.numIterations > stats.maxNumIterations){
+        stats.maxNumIterations = stats.numIterations;
+    }
+    if(!stats.isConverged){
+        ++stats.numUnconvergedSteps;
+    }
+
     if(CFS_MCP_DEBUG){
 
         if(i == numBlockLoops){
@@ -1809,10 +2185,7 @@ void ConstraintForceSolver::Impl::solveMCPByProjectedGaussSeidelMainStep(const M
         if(M(j,j) == numeric_limits<double>::max()){
             xx=0.0;
         } else {
-            double sum = -M(j, j) * x(j);
-            for(int k=0; k < size; ++k){
-                sum += M(j, k) * x(k);
-            }
+            double sum = calcOffDiagonalRowProduct(M, x, j, size);
             xx = (-b(j) - sum) / M(j, j);
         }
         if(xx < 0.0){
@@ -1828,10 +2201,7 @@ void ConstraintForceSolver::Impl::solveMCPByProjectedGaussSeidelMainStep(const M
         if(M(j,j) == numeric_limits<double>::max()){
             x(j)=0.0;
         } else {
-            double sum = -M(j, j) * x(j);
-            for(int k=0; k < size; ++k){
-                sum += M(j, k) * x(k);
-            }
+            double sum = calcOffDiagonalRowProduct(M, x, j, size);
             x(j) = (-b(j) - sum) / M(j, j);
         }
     }
@@ -1846,10 +2216,7 @@ void ConstraintForceSolver::Impl::solveMCPByProjectedGaussSeidelMainStep(const M
             if(M(j,j) == numeric_limits<double>::max()) {
                 fx0 = 0.0;
             } else {
-                double sum = -M(j, j) * x(j);
-                for(int k=0; k < size; ++k){
-                    sum += M(j, k) * x(k);
-                }
+                double sum = calcOffDiagonalRowProduct(M, x, j, size);
                 fx0 = (-b(j) - sum) / M(j, j);
             }
             double& fx = x(j);
@@ -1860,10 +2227,7 @@ void ConstraintForceSolver::Impl::solveMCPByProjectedGaussSeidelMainStep(const M
             if(M(j,j) == numeric_limits<double>::max()) {
                 fy0=0.0;
             } else {
-                double sum = -M(j, j) * x(j);
-                for(int k=0; k < size; ++k){
-                    sum += M(j, k) * x(k);
-                }
+                double sum = calcOffDiagonalRowProduct(M, x, j, size);
                 fy0 = (-b(j) - sum) / M(j, j);
             }
             double& fy = x(j);
@@ -1891,10 +2255,7 @@ void ConstraintForceSolver::Impl::solveMCPByProjectedGaussSeidelMainStep(const M
             if(M(j,j) == numeric_limits<double>::max()) {
                 xx=0.0;
             } else {
-                double sum = -M(j, j) * x(j);
-                for(int k=0; k < size; ++k){
-                    sum += M(j, k) * x(k);
-                }
+                double sum = calcOffDiagonalRowProduct(M, x, j, size);
                 xx = (-b(j) - sum) / M(j, j);
             }
             
@@ -1930,10 +2291,7 @@ void ConstraintForceSolver::Impl::solveMCPByProjectedGaussSeidelInitial
             if(M(j,j)==numeric_limits<double>::max()){
                 xx=0.0;
             } else {
-                double sum = -M(j, j) * x(j);
-                for(int k=0; k < size; ++k){
-                    sum += M(j, k) * x(k);
-                }
+                double sum = calcOffDiagonalRowProduct(M, x, j, size);
                 xx = (-b(j) - sum) / M(j, j);
             }
             if(xx < 0.0){
@@ -1950,10 +2308,7 @@ void ConstraintForceSolver::Impl::solveMCPByProjectedGaussSeidelInitial
             if(M(j,j)==numeric_limits<double>::max()){
                 x(j) = 0.0;
             } else {
-                double sum = -M(j, j) * x(j);
-                for(int k=0; k < size; ++k){
-                    sum += M(j, k) * x(k);
-                }
+                double sum = calcOffDiagonalRowProduct(M, x, j, size);
                 x(j) = r * (-b(j) - sum) / M(j, j);
             }
             r += rstep;
@@ -1968,10 +2323,7 @@ void ConstraintForceSolver::Impl::solveMCPByProjectedGaussSeidelInitial
                 if(M(j,j)==numeric_limits<double>::max())
                     fx0 = 0.0;
                 else{
-                    double sum = -M(j, j) * x(j);
-                    for(int k=0; k < size; ++k){
-                        sum += M(j, k) * x(k);
-                    }
+                    double sum = calcOffDiagonalRowProduct(M, x, j, size);
                     fx0 = (-b(j) - sum) / M(j, j);
                 }
                 double& fx = x(j);
@@ -1982,10 +2334,7 @@ void ConstraintForceSolver::Impl::solveMCPByProjectedGaussSeidelInitial
                 if(M(j,j)==numeric_limits<double>::max())
                     fy0 = 0.0;
                 else{
-                    double sum = -M(j, j) * x(j);
-                    for(int k=0; k < size; ++k){
-                        sum += M(j, k) * x(k);
-                    }
+                    double sum = calcOffDiagonalRowProduct(M, x, j, size);
                     fy0 = (-b(j) - sum) / M(j, j);
                 }
                 double& fy = x(j);
@@ -2014,10 +2363,7 @@ void ConstraintForceSolver::Impl::solveMCPByProjectedGaussSeidelInitial
                 if(M(j,j)==numeric_limits<double>::max())
                     xx = 0.0;
                 else{
-                    double sum = -M(j, j) * x(j);
-                    for(int k=0; k < size; ++k){
-                        sum += M(j, k) * x(k);
-                    }
+                    double sum = calcOffDiagonalRowProduct(M, x, j, size);
                     xx = (-b(j) - sum) / M(j, j);
                 }
 
@@ -2040,6 +2386,36 @@ void ConstraintForceSolver::Impl::solveMCPByProjectedGaussSeidelInitial
 }
 
 
+/**
+   This function returns the sum of the products of the off-diagonal elements in a row of the LCP
+   matrix and the solution, which is used in the Gauss-Seidel iterations.
+*/
+double ConstraintForceSolver::Impl::calcOffDiagonalRowProduct
+(const MatrixX& M, const VectorX& x, int row, int size) const
+{
+    double sum = -M(row, row) * x(row);
+
+    if(!isLcpMatrixSparse){
+        for(int k=0; k < size; ++k){
+            sum += M(row, k) * x(k);
+        }
+    } else {
+        const int linkPairIndex = lcpRowToLinkPairIndex[row];
+        const int spanEnd = lcpColumnSpanOffsets[linkPairIndex + 1];
+        for(int i = lcpColumnSpanOffsets[linkPairIndex]; i < spanEnd; ++i){
+            const LcpColumnSpan& span = lcpColumnSpans[i];
+            const double* m = &M(row, span.begin);
+            const double* xs = &x(span.begin);
+            for(int k=0; k < span.size; ++k){
+                sum += m[k] * xs[k];
+            }
+        }
+    }
+
+    return sum;
+}
+
+
 void ConstraintForceSolver::Impl::checkLCPResult(MatrixX& M, VectorX& b, VectorX& x)
 {
     os << "check LCP result\n";
@@ -2297,6 +2673,24 @@ int ConstraintForceSolver::gaussSeidelMaxNumIterations()
 }
 
 
+void ConstraintForceSolver::setMaxSparseLcpMatrixFillRatio(double ratio)
+{
+    impl->maxFillRatioOfSparseLcpMatrix = ratio;
+}
+
+
+double ConstraintForceSolver::maxSparseLcpMatrixFillRatio() const
+{
+    return impl->maxFillRatioOfSparseLcpMatrix;
+}
+
+
+const ConstraintForceSolver::GaussSeidelStatistics& ConstraintForceSolver::gaussSeidelStatistics() const
+{
+    return impl->gaussSeidelStatistics;
+}
+
+
 void ConstraintForceSolver::setContactDepthCorrection(double depth, double velocityRatio)
 {
     impl->contactCorrectionDepth = depth;
@@ -2348,6 +2742,175 @@ void ConstraintForceSolver::clearExternalForces()
 }
 
 
+void ConstraintForceSolver::storeState(std::vector<double>& io_state) const
+{
+    impl->storeState(io_state);
+}
+
+
+void ConstraintForceSolver::Impl::storeState(std::vector<double>& io_state) const
+{
+    io_state.push_back(prevGlobalNumConstraintVectors);
+    io_state.push_back(prevGlobalNumFrictionVectors);
+    io_state.push_back(globalNumContactNormalVectors);
+    io_state.push_back(numUnconverged);
+
+    // Only the force caches used in the next step are stored
+    vector<const LinkPair*> cachedContactLinkPairs;
+    for(auto& kv : geometryPairToLinkPairMap){
+        if(kv.second.forceCacheSolveCount == solveCount){
+            cachedContactLinkPairs.push_back(&kv.second);
+        }
+    }
+    io_state.push_back(cachedContactLinkPairs.size());
+    for(auto& linkPair : cachedContactLinkPairs){
+        io_state.push_back(linkPair->geometryPair[0]);
+        io_state.push_back(linkPair->geometryPair[1]);
+        storeForceCache(*linkPair, io_state);
+    }
+    for(auto& linkPair : extraJointLinkPairs){
+        storeForceCache(*linkPair, io_state);
+    }
+    for(auto& linkPair : constrain2dLinkPairs){
+        storeForceCache(*linkPair, io_state);
+    }
+
+    if(ENABLE_RANDOM_STATIC_FRICTION_BASE){
+        std::ostringstream os;
+        os << randomEngine;
+        std::istringstream is(os.str());
+        std::mt19937::result_type word;
+        vector<double> words;
+        while(is >> word){
+            words.push_back(word);
+        }
+        io_state.push_back(words.size());
+        io_state.insert(io_state.end(), words.begin(), words.end());
+    }
+}
+
+
+void ConstraintForceSolver::Impl::storeForceCache(const LinkPair& linkPair, std::vector<double>& io_state) const
+{
+    if(linkPair.forceCacheSolveCount != solveCount){
+        io_state.push_back(0);
+        return;
+    }
+    io_state.push_back(linkPair.forceCache.size());
+    for(auto& cached : linkPair.forceCache){
+        io_state.insert(io_state.end(), cached.localPoint.data(), cached.localPoint.data() + 3);
+        io_state.insert(io_state.end(), cached.localFrictionForce.data(), cached.localFrictionForce.data() + 3);
+        io_state.push_back(cached.normalForce);
+        // The feature ID is split into the 32-bit values to store them without the loss of precision
+        io_state.push_back(cached.featureId & 0xffffffffULL);
+        io_state.push_back(cached.featureId >> 32);
+    }
+}
+
+
+bool ConstraintForceSolver::restoreState(const double*& io_pos, const double* end)
+{
+    return impl->restoreState(io_pos, end);
+}
+
+
+bool ConstraintForceSolver::Impl::restoreState(const double*& io_pos, const double* end)
+{
+    if(end - io_pos < 5){
+        return false;
+    }
+
+    // The matrices are resized for the restored constraint vectors as well as the previous step
+    globalNumConstraintVectors = io_pos[0];
+    globalNumFrictionVectors = io_pos[1];
+    globalNumContactNormalVectors = io_pos[2];
+    initMatrices();
+    prevGlobalNumConstraintVectors = globalNumConstraintVectors;
+    prevGlobalNumFrictionVectors = globalNumFrictionVectors;
+    numUnconverged = io_pos[3];
+    const int numCachedContactLinkPairs = io_pos[4];
+    io_pos += 5;
+
+    for(auto& kv : geometryPairToLinkPairMap){
+        kv.second.forceCacheSolveCount = -1;
+    }
+    for(int i=0; i < numCachedContactLinkPairs; ++i){
+        if(end - io_pos < 2){
+            return false;
+        }
+        IdPair<GeometryHandle> geometryPair(io_pos[0], io_pos[1]);
+        io_pos += 2;
+        LinkPair* linkPair = nullptr;
+        auto p = geometryPairToLinkPairMap.find(geometryPair);
+        if(p != geometryPairToLinkPairMap.end()){
+            linkPair = &p->second;
+        }
+        if(!restoreForceCache(linkPair, io_pos, end)){
+            return false;
+        }
+    }
+    for(auto& linkPair : extraJointLinkPairs){
+        if(!restoreForceCache(linkPair.get(), io_pos, end)){
+            return false;
+        }
+    }
+    for(auto& linkPair : constrain2dLinkPairs){
+        if(!restoreForceCache(linkPair.get(), io_pos, end)){
+            return false;
+        }
+    }
+
+    if(ENABLE_RANDOM_STATIC_FRICTION_BASE){
+        if(end - io_pos < 1 || end - io_pos < 1 + static_cast<int>(io_pos[0])){
+            return false;
+        }
+        const int numWords = *io_pos++;
+        std::ostringstream os;
+        for(int i=0; i < numWords; ++i){
+            os << static_cast<std::mt19937::result_type>(*io_pos++) << ' ';
+        }
+        std::istringstream is(os.str());
+        is >> randomEngine;
+    }
+
+    return true;
+}
+
+
+/**
+   \param linkPair The cache is skipped if the link pair is null.
+*/
+bool ConstraintForceSolver::Impl::restoreForceCache(LinkPair* linkPair, const double*& io_pos, const double* end)
+{
+    static const int numCacheElements = 9;
+    
+    if(end - io_pos < 1){
+        return false;
+    }
+    const int numCachedPoints = *io_pos++;
+    if(end - io_pos < numCachedPoints * numCacheElements){
+        return false;
+    }
+    if(linkPair){
+        auto& cache = linkPair->forceCache;
+        cache.resize(numCachedPoints);
+        for(int i=0; i < numCachedPoints; ++i){
+            auto& cached = cache[i];
+            const double* p = io_pos + i * numCacheElements;
+            cached.localPoint = Vector3::Map(p);
+            cached.localFrictionForce = Vector3::Map(p + 3);
+            cached.normalForce = p[6];
+            cached.featureId =
+                static_cast<unsigned long long>(p[7]) | (static_cast<unsigned long long>(p[8]) << 32);
+        }
+        linkPair->forceCacheSolveCount = (numCachedPoints > 0) ? solveCount : -1;
+    }
+    io_pos += numCachedPoints * numCacheElements;
+
+    return true;
+}
+
+
 shared_ptr<CollisionLinkPairList> ConstraintForceSolver::getCollisions()
 {
     return impl->getCollisions();
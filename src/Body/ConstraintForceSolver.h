@@ -2,6 +2,7 @@
 #define CNOID_BODY_CONSTRAINT_FORCE_SOLVER_H
 
 #include <cnoid/CollisionSeq>
+#include <vector>
 #include "exportdecl.h"
 
 namespace cnoid {
@@ -45,6 +46,42 @@ public:
     void setGaussSeidelMaxNumIterations(int n);
     int gaussSeidelMaxNumIterations();
 
+    /**
+       The LCP matrix is solved as a block sparse matrix when its fill ratio is not greater than
+       this value. The default value is 0.3. Set zero to always use the dense matrix.
+    */
+    void setMaxSparseLcpMatrixFillRatio(double ratio);
+    double maxSparseLcpMatrixFillRatio() const;
+
+    /**
+       The statistics of the Gauss-Seidel iterations. The values of the last step are updated
+       by the solve function, and the accumulated values are reset by the initialize function.
+       The error is the relative change of the solution in the last iteration, which is compared
+       with the error criterion to terminate the iterations. The fill ratio is the ratio of the
+       elements in the coupled blocks of the LCP matrix, and the matrix is solved as a block sparse
+       matrix when the ratio is small.
+    */
+    struct GaussSeidelStatistics
+    {
+        // Values of the last step
+        int numConstraints = 0;
+        int numWarmStartedConstraints = 0;
+        int numIterations = 0;
+        double error = 0.0;
+        bool isConverged = true;
+        double matrixFillRatio = 1.0;
+        bool isSparseMatrixUsed = false;
+
+        // Accumulated values
+        int numSolvedSteps = 0;
+        long long totalNumIterations = 0;
+        int maxNumIterations = 0;
+        int numUnconvergedSteps = 0;
+        int numSparseMatrixSteps = 0;
+    };
+    
+    const GaussSeidelStatistics& gaussSeidelStatistics() const;
+
     void setContactDepthCorrection(double depth, double velocityRatio);
     double contactCorrectionDepth();
     double contactCorrectionVelocityRatio();
@@ -59,6 +96,16 @@ public:
     void solve();
     void clearExternalForces();
 
+    /**
+       These functions store and restore the internal state carried over between the time steps,
+       which includes the constraint forces of the previous step used as the initial solution of
+       the iterative solver.
+       The state is appended to io_state, and the restore function advances io_pos by the number
+       of the read elements.
+    */
+    void storeState(std::vector<double>& io_state) const;
+    bool restoreState(const double*& io_pos, const double* end);
+
     std::shared_ptr<CollisionLinkPairList> getCollisions();
 
     // experimental functions
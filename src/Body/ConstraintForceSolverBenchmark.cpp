@@ -0,0 +1,275 @@
+/**
+   This program measures the computation time of ConstraintForceSolver in a scene with many
+   contacts, where stacks of boxes are placed on a grid on the floor. The same scene is simulated
+   with the dense LCP matrix and with the block sparse LCP matrix, and the fill ratio of the matrix
+   is reported so that the threshold of the fill ratio to use the sparse matrix can be checked.
+   Each simulation is run in a child process because the order of the contacts depends on the
+   memory addresses of the objects, which makes the results of the worlds simulated one after
+   another in the same process differ.
+*/
+
+#include "DyWorld.h"
+#include "DyBody.h"
+#include "ConstraintForceSolver.h"
+#include <cnoid/MeshGenerator>
+#include <cnoid/MaterialTable>
+#include <cnoid/SceneDrawables>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace cnoid;
+
+namespace {
+
+struct Result
+{
+    double time;
+    int numConstraints;
+    double matrixFillRatio;
+    int numSparseMatrixSteps;
+    int numSolvedSteps;
+    vector<Vector3> positions;
+};
+
+
+BodyPtr createBox(const Vector3& size, double mass, bool isFixed)
+{
+    BodyPtr body = new Body;
+    auto link = body->createLink();
+    link->setJointType(isFixed ? Link::FixedJoint : Link::FreeJoint);
+    link->setMass(mass);
+    Matrix3 I = Matrix3::Zero();
+    I(0, 0) = mass * (size.y() * size.y() + size.z() * size.z()) / 12.0;
+    I(1, 1) = mass * (size.x() * size.x() + size.z() * size.z()) / 12.0;
+    I(2, 2) = mass * (size.x() * size.x() + size.y() * size.y()) / 12.0;
+    link->setInertia(I);
+    MeshGenerator meshGenerator;
+    SgShapePtr shape = new SgShape;
+    shape->setMesh(meshGenerator.generateBox(size));
+    link->addShapeNode(shape);
+    body->setRootLink(link);
+    return body;
+}
+
+
+Result simulate(int gridSize, int stackHeight, int numSteps, double maxFillRatio)
+{
+    DyWorld<ConstraintForceSolver> world;
+    world.setTimeStep(0.001);
+    world.setGravityAcceleration(Vector3(0.0, 0.0, -9.80665));
+
+    DyBodyPtr floor = new DyBody;
+    floor->copyFrom(createBox(Vector3(20.0, 20.0, 0.1), 1.0, true));
+    floor->rootLink()->p() = Vector3(0.0, 0.0, -0.05);
+    world.addBody(floor);
+
+    const double boxSize = 0.1;
+    auto box = createBox(Vector3(boxSize, boxSize, boxSize), 1.0, false);
+    vector<DyBodyPtr> boxes;
+    for(int x=0; x < gridSize; ++x){
+        for(int y=0; y < gridSize; ++y){
+            for(int z=0; z < stackHeight; ++z){
+                DyBodyPtr body = new DyBody;
+                body->copyFrom(box);
+                // The small offsets make the contacts of the stacked boxes asymmetric
+                body->rootLink()->p() =
+                    Vector3(0.3 * x + 0.002 * z, 0.3 * y, boxSize / 2.0 + boxSize * z + 0.0005);
+                body->calcForwardKinematics();
+                world.addBody(body);
+                boxes.push_back(body);
+            }
+        }
+    }
+
+    auto& solver = world.constraintForceSolver;
+    MaterialTablePtr materialTable = new MaterialTable;
+    MaterialPtr material = new Material;
+    material->setName("Default");
+    material->setRoughness(0.5);
+    material->setViscosity(0.0);
+    materialTable->addMaterial(material);
+    solver.setMaterialTable(materialTable);
+    solver.setMaxSparseLcpMatrixFillRatio(maxFillRatio);
+    for(int i=0; i < world.numBodies(); ++i){
+        solver.setBodyCollisionDetectionMode(i, true, false);
+    }
+    world.initialize();
+
+    auto t0 = chrono::steady_clock::now();
+    for(int i=0; i < numSteps; ++i){
+        world.calcNextState();
+        solver.clearExternalForces();
+    }
+    auto t1 = chrono::steady_clock::now();
+
+    Result result;
+    result.time = chrono::duration<double>(t1 - t0).count();
+    auto& stats = solver.gaussSeidelStatistics();
+    result.numConstraints = stats.numConstraints;
+    result.matrixFillRatio = stats.matrixFillRatio;
+    result.numSparseMatrixSteps = stats.numSparseMatrixSteps;
+    result.numSolvedSteps = stats.numSolvedSteps;
+    for(auto& body : boxes){
+        result.positions.push_back(body->rootLink()->p());
+    }
+    return result;
+}
+
+
+bool writeAll(int fd, const void* data, size_t size)
+{
+    auto p = static_cast<const char*>(data);
+    while(size > 0){
+        auto n = write(fd, p, size);
+        if(n <= 0){
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+
+bool readAll(int fd, void* data, size_t size)
+{
+    auto p = static_cast<char*>(data);
+    while(size > 0){
+        auto n = read(fd, p, size);
+        if(n <= 0){
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+
+bool simulateInChildProcess(int gridSize, int stackHeight, int numSteps, double maxFillRatio, Result& out_result)
+{
+    int fds[2];
+    if(pipe(fds) != 0){
+        return false;
+    }
+    pid_t pid = fork();
+    if(pid < 0){
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if(pid == 0){
+        close(fds[0]);
+        auto result = simulate(gridSize, stackHeight, numSteps, maxFillRatio);
+        int numPositions = result.positions.size();
+        bool written =
+            writeAll(fds[1], &result.time, sizeof(result.time)) &&
+            writeAll(fds[1], &result.numConstraints, sizeof(result.numConstraints)) &&
+            writeAll(fds[1], &result.matrixFillRatio, sizeof(result.matrixFillRatio)) &&
+            writeAll(fds[1], &result.numSparseMatrixSteps, sizeof(result.numSparseMatrixSteps)) &&
+            writeAll(fds[1], &result.numSolvedSteps, sizeof(result.numSolvedSteps)) &&
+            writeAll(fds[1], &numPositions, sizeof(numPositions)) &&
+            writeAll(fds[1], result.positions.data(), sizeof(Vector3) * numPositions);
+        close(fds[1]);
+        _exit(written ? 0 : 1);
+    }
+
+    close(fds[1]);
+    int numPositions = 0;
+    bool received =
+        readAll(fds[0], &out_result.time, sizeof(out_result.time)) &&
+        readAll(fds[0], &out_result.numConstraints, sizeof(out_result.numConstraints)) &&
+        readAll(fds[0], &out_result.matrixFillRatio, sizeof(out_result.matrixFillRatio)) &&
+        readAll(fds[0], &out_result.numSparseMatrixSteps, sizeof(out_result.numSparseMatrixSteps)) &&
+        readAll(fds[0], &out_result.numSolvedSteps, sizeof(out_result.numSolvedSteps)) &&
+        readAll(fds[0], &numPositions, sizeof(numPositions));
+    if(received){
+        out_result.positions.resize(numPositions);
+        received = readAll(fds[0], out_result.positions.data(), sizeof(Vector3) * numPositions);
+    }
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+
+    return received && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+
+void printUsage()
+{
+    cout << "Usage: cnoid-constraint-force-solver-benchmark [--grid N ...] [--stack N] [--steps N] [--ratio R]" << endl;
+}
+
+}
+
+
+int main(int argc, char* argv[])
+{
+    vector<int> gridSizes;
+    int stackHeight = 3;
+    int numSteps = 500;
+    double maxFillRatio;
+    {
+        DyWorld<ConstraintForceSolver> world;
+        maxFillRatio = world.constraintForceSolver.maxSparseLcpMatrixFillRatio();
+    }
+
+    for(int i=1; i < argc; ++i){
+        string option(argv[i]);
+        if(i + 1 < argc && option == "--grid"){
+            while(i + 1 < argc && argv[i + 1][0] != '-'){
+                gridSizes.push_back(atoi(argv[++i]));
+            }
+        } else if(i + 1 < argc && option == "--stack"){
+            stackHeight = atoi(argv[++i]);
+        } else if(i + 1 < argc && option == "--steps"){
+            numSteps = atoi(argv[++i]);
+        } else if(i + 1 < argc && option == "--ratio"){
+            maxFillRatio = atof(argv[++i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if(gridSizes.empty()){
+        gridSizes = { 2, 4, 6 };
+    }
+    if(stackHeight < 1 || numSteps < 1){
+        printUsage();
+        return 1;
+    }
+
+    cout << "stack: " << stackHeight << ", steps: " << numSteps << ", max fill ratio: " << maxFillRatio << "\n"
+         << "grid, constraints, fill ratio, sparse steps, dense [s], sparse [s], max position difference" << endl;
+
+    for(auto gridSize : gridSizes){
+        if(gridSize < 1){
+            continue;
+        }
+        Result dense, sparse;
+        if(!simulateInChildProcess(gridSize, stackHeight, numSteps, 0.0, dense) ||
+           !simulateInChildProcess(gridSize, stackHeight, numSteps, maxFillRatio, sparse)){
+            cerr << "The simulation of the " << gridSize << "x" << gridSize << " grid failed." << endl;
+            return 1;
+        }
+        double maxDiff = 0.0;
+        for(size_t i=0; i < dense.positions.size(); ++i){
+            maxDiff = std::max(maxDiff, (dense.positions[i] - sparse.positions[i]).norm());
+        }
+        cout << gridSize << "x" << gridSize << ", "
+             << sparse.numConstraints << ", "
+             << sparse.matrixFillRatio << ", "
+             << sparse.numSparseMatrixSteps << "/" << sparse.numSolvedSteps << ", "
+             << dense.time << ", "
+             << sparse.time << ", "
+             << maxDiff << endl;
+    }
+
+    return 0;
+}
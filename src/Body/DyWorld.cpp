@@ -112,6 +112,118 @@ void DyWorldBase::calcNextState()
 }
 
 
+namespace {
+
+constexpr int NumLinkStateElements = 42;
+
+inline double* storeVector3(double* p, const Vector3& v)
+{
+    p[0] = v.x(); p[1] = v.y(); p[2] = v.z();
+    return p + 3;
+}
+
+inline const double* restoreVector3(const double* p, Vector3& out_v)
+{
+    out_v << p[0], p[1], p[2];
+    return p + 3;
+}
+
+}
+
+
+void DyWorldBase::storeState(std::vector<double>& out_state) const
+{
+    int numLinks = 0;
+    for(auto& body : bodies_){
+        numLinks += body->numLinks();
+    }
+    out_state.clear();
+    out_state.reserve(1 + numLinks * NumLinkStateElements);
+    out_state.push_back(currentTime_);
+    
+    for(auto& body : bodies_){
+        for(auto& link : body->links()){
+            size_t index = out_state.size();
+            out_state.resize(index + NumLinkStateElements);
+            double* p = &out_state[index];
+            Matrix3::Map(p) = link->R();
+            Vector3::Map(p + 9) = link->p();
+            p += 12;
+            *p++ = link->q();
+            *p++ = link->dq();
+            *p++ = link->ddq();
+            *p++ = link->u();
+            *p++ = link->q_target();
+            *p++ = link->dq_target();
+            p = storeVector3(p, link->v());
+            p = storeVector3(p, link->w());
+            p = storeVector3(p, link->dv());
+            p = storeVector3(p, link->dw());
+            p = storeVector3(p, link->vo());
+            p = storeVector3(p, link->dvo());
+            Vector6::Map(p) = link->F_ext();
+        }
+    }
+    for(auto& subBody : subBodies_){
+        subBody->forwardDynamics()->storeState(out_state);
+    }
+}
+
+
+bool DyWorldBase::restoreState(const std::vector<double>& state)
+{
+    const double* pos = state.data();
+    const double* end = pos + state.size();
+    if(!doRestoreState(pos, end) || pos != end){
+        return false;
+    }
+    refreshState();
+    return true;
+}
+
+
+bool DyWorldBase::doRestoreState(const double*& io_pos, const double* end)
+{
+    int numLinks = 0;
+    for(auto& body : bodies_){
+        numLinks += body->numLinks();
+    }
+    if(end - io_pos < 1 + numLinks * NumLinkStateElements){
+        return false;
+    }
+    currentTime_ = *io_pos++;
+
+    for(auto& body : bodies_){
+        for(auto& link : body->links()){
+            const double* p = io_pos;
+            link->R() = Matrix3::Map(p);
+            link->p() = Vector3::Map(p + 9);
+            p += 12;
+            link->q() = *p++;
+            link->dq() = *p++;
+            link->ddq() = *p++;
+            link->u() = *p++;
+            link->q_target() = *p++;
+            link->dq_target() = *p++;
+            p = restoreVector3(p, link->v());
+            p = restoreVector3(p, link->w());
+            p = restoreVector3(p, link->dv());
+            p = restoreVector3(p, link->dw());
+            p = restoreVector3(p, link->vo());
+            p = restoreVector3(p, link->dvo());
+            link->F_ext() = Vector6::Map(p);
+            io_pos += NumLinkStateElements;
+        }
+    }
+    for(auto& subBody : subBodies_){
+        if(!subBody->forwardDynamics()->restoreState(io_pos, end)){
+            return false;
+        }
+    }
+    return true;
+}
+
+
 void DyWorldBase::refreshState()
 {
     for(auto& subBody : subBodies_){
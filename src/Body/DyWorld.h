@@ -83,6 +83,20 @@ public:
     virtual void calcNextState();
 
     void refreshState();
+
+    /**
+       \brief store the dynamic state of the world into an array
+       \note The state consists of the current time, the link states and the internal states of
+       the forward dynamics computations. It can only be restored to the world that has the same
+       bodies as the world where the state is stored.
+    */
+    virtual void storeState(std::vector<double>& out_state) const;
+
+    /**
+       \brief restore the dynamic state stored by storeState()
+       \return false if the state does not match the bodies of the world
+    */
+    bool restoreState(const std::vector<double>& state);
         
     /**
        \brief get index of link pairs
@@ -123,6 +137,9 @@ private:
     std::vector<ExtraJointPtr> extraJoints_;
 
     void extractInternalBodies(Link* link);    
+
+protected:
+    virtual bool doRestoreState(const double*& io_pos, const double* end);
 };
 
 template <class TConstraintForceSolver> class DyWorld : public DyWorldBase
@@ -147,6 +164,16 @@ public:
         constraintForceSolver.solve();
         DyWorldBase::calcNextState();
     }
+
+    virtual void storeState(std::vector<double>& out_state) const override {
+        DyWorldBase::storeState(out_state);
+        constraintForceSolver.storeState(out_state);
+    }
+
+protected:
+    virtual bool doRestoreState(const double*& io_pos, const double* end) override {
+        return DyWorldBase::doRestoreState(io_pos, end) && constraintForceSolver.restoreState(io_pos, end);
+    }
 };
 
 };
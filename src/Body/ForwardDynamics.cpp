@@ -78,6 +78,18 @@ void ForwardDynamics::SE3exp
 }
 
 
+void ForwardDynamics::storeState(std::vector<double>& io_state) const
+{
+    sensorHelper.storeState(io_state);
+}
+
+
+bool ForwardDynamics::restoreState(const double*& io_pos, const double* end)
+{
+    return sensorHelper.restoreState(io_pos, end);
+}
+
+
 void ForwardDynamics::initializeSensors()
 {
     auto rootLink = subBody->rootLink();
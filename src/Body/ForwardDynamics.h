@@ -33,6 +33,15 @@ public:
     virtual void calcNextState() = 0;
     virtual void refreshState() = 0;
 
+    /**
+       These functions store and restore the internal state of the computation that is carried
+       over between the time steps. The link states are not included in the state.
+       The state is appended to io_state, and the restore function advances io_pos by the number
+       of the read elements.
+    */
+    virtual void storeState(std::vector<double>& io_state) const;
+    virtual bool restoreState(const double*& io_pos, const double* end);
+
 protected:
     virtual void initializeSensors();
 
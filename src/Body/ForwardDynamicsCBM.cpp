@@ -153,6 +153,52 @@ void ForwardDynamicsCBM::refreshState()
 }
 
 
+void ForwardDynamicsCBM::storeState(std::vector<double>& io_state) const
+{
+    ForwardDynamics::storeState(io_state);
+
+    // The previous values of the high gain mode joints are used to compute their velocities
+    if(given_rootDof){
+        io_state.insert(io_state.end(), pGivenPrev.data(), pGivenPrev.data() + 3);
+        io_state.insert(io_state.end(), RGivenPrev.data(), RGivenPrev.data() + 9);
+        io_state.insert(io_state.end(), voGivenPrev.data(), voGivenPrev.data() + 3);
+        io_state.insert(io_state.end(), wGivenPrev.data(), wGivenPrev.data() + 3);
+    }
+    io_state.insert(io_state.end(), qGivenPrev.data(), qGivenPrev.data() + qGivenPrev.size());
+    io_state.insert(io_state.end(), dqGivenPrev.data(), dqGivenPrev.data() + dqGivenPrev.size());
+}
+
+
+bool ForwardDynamicsCBM::restoreState(const double*& io_pos, const double* end)
+{
+    if(!ForwardDynamics::restoreState(io_pos, end)){
+        return false;
+    }
+    const int m = qGivenPrev.size();
+    if(end - io_pos < (given_rootDof ? 18 : 0) + m * 2){
+        return false;
+    }
+    if(given_rootDof){
+        pGivenPrev = Eigen::Map<const Vector3>(io_pos);
+        RGivenPrev = Eigen::Map<const Matrix3>(io_pos + 3);
+        voGivenPrev = Eigen::Map<const Vector3>(io_pos + 12);
+        wGivenPrev = Eigen::Map<const Vector3>(io_pos + 15);
+        io_pos += 18;
+    }
+    qGivenPrev = Eigen::Map<const VectorXd>(io_pos, m);
+    dqGivenPrev = Eigen::Map<const VectorXd>(io_pos + m, m);
+    io_pos += m * 2;
+
+    // The mass matrix computed at the end of each step is used in the next step
+    calcPositionAndVelocityFK();
+    if(!isNoUnknownAccelMode){
+        calcMassMatrix();
+    }
+    
+    return true;
+}
+
+
 void ForwardDynamicsCBM::calcNextState()
 {
     complementHighGainModeCommandValues();
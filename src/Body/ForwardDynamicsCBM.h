@@ -27,6 +27,8 @@ public:
     virtual void initialize();
     virtual void calcNextState();
     virtual void refreshState();
+    virtual void storeState(std::vector<double>& io_state) const;
+    virtual bool restoreState(const double*& io_pos, const double* end);
 
     void complementHighGainModeCommandValues();
 
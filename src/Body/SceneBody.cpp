@@ -76,6 +76,8 @@ public:
     SgGroupPtr multiplexSceneBodyGroup;
     std::vector<SceneBodyPtr> multiplexSceneBodies;
     std::vector<SceneBodyPtr> multiplexSceneBodyCache;
+    SgUpdateTransaction linkUpdateTransaction;
+    int linkUpdateAction;
     ScopedConnection existenceConnection;
 
     Impl(SceneBody* self);
@@ -402,6 +404,7 @@ SceneBody::Impl::Impl(SceneBody* self)
 {
     sceneLinkGroup = new SgGroup;
     lastEffectGroup = sceneLinkGroup;
+    linkUpdateAction = SgUpdate::Modified;
     self->addChild(sceneLinkGroup);
 }
 
@@ -477,10 +480,18 @@ void SceneBody::cloneShapes(CloneMap& cloneMap)
 
 void SceneBody::updateLinkPositions(SgUpdateRef update)
 {
+    if(update){
+        impl->linkUpdateAction = update->action();
+    }
+    
     // Main body
     impl->updateLinkPositions(body_, sceneLinks_, update);
 
     impl->updateMultiplexBodyPositions(update);
+
+    // The link updates are notified at once to avoid the redundant notifications
+    // of the upper nodes shared by the links
+    impl->linkUpdateTransaction.commit();
 }
 
 
@@ -492,7 +503,7 @@ void SceneBody::Impl::updateLinkPositions(Body* body, vector<SceneLinkPtr>& scen
         Link* link = body->link(i);
         sceneLink->setPosition(link->position());
         if(update){
-            sceneLink->notifyUpdate(*update);
+            linkUpdateTransaction.add(sceneLink, linkUpdateAction);
         }
     }
 }
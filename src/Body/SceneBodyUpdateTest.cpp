@@ -0,0 +1,114 @@
+/**
+   This program checks that the bounding boxes of a scene body follow the links moved by
+   SceneBody::updateLinkPositions in the way the scenes of the vision sensors are updated.
+   The renderers cull the groups whose cached bounding boxes are out of view, so a stale
+   bounding box would make a body moved into the view of a sensor disappear from its image.
+*/
+
+#include "SceneBody.h"
+#include "Body.h"
+#include "MeshGenerator.h"
+#include <cnoid/SceneDrawables>
+#include <iostream>
+
+using namespace std;
+using namespace cnoid;
+
+namespace {
+
+int numFailures = 0;
+
+void check(bool condition, const string& message)
+{
+    if(!condition){
+        cerr << "FAILED: " << message << endl;
+        ++numFailures;
+    }
+}
+
+
+Body* createBody()
+{
+    auto body = new Body;
+    auto root = body->createLink();
+    root->setName("ROOT");
+    root->setJointType(Link::FreeJoint);
+    body->setRootLink(root);
+    auto arm = body->createLink();
+    arm->setName("ARM");
+    arm->setJointType(Link::PrismaticJoint);
+    arm->setJointAxis(Vector3::UnitX());
+    arm->setJointId(0);
+    root->appendChild(arm);
+    body->updateLinkTree();
+
+    MeshGenerator meshGenerator;
+    for(auto& link : body->links()){
+        SgShapePtr shape = new SgShape;
+        shape->setMesh(meshGenerator.generateBox(Vector3(0.1, 0.1, 0.1)));
+        link->addShapeNode(shape);
+    }
+    body->calcForwardKinematics();
+    return body;
+}
+
+
+bool contains(const BoundingBox& bbox, const Vector3& p)
+{
+    return !bbox.empty() &&
+        (bbox.min().array() <= p.array()).all() && (p.array() <= bbox.max().array()).all();
+}
+
+}
+
+
+int main()
+{
+    BodyPtr body = createBody();
+
+    // The same structure as the scene of a vision sensor
+    SgGroupPtr root = new SgGroup;
+    SceneBodyPtr sceneBody = new SceneBody(body);
+    root->addChild(sceneBody);
+
+    auto rootLink = body->rootLink();
+    auto arm = body->link("ARM");
+    auto sceneArm = sceneBody->sceneLink(arm->index());
+
+    // The bounding boxes are cached by the culling of the first rendering
+    check(contains(root->boundingBox(), Vector3::Zero()), "initial bounding box");
+    check(contains(sceneArm->boundingBox(), Vector3::Zero()), "initial bounding box of the arm");
+
+    SgUpdate update;
+
+    // The whole body moves out of its initial bounding box
+    const Vector3 p1(5.0, 0.0, 0.0);
+    rootLink->p() = p1;
+    body->calcForwardKinematics();
+    sceneBody->updateLinkPositions(update);
+    check(contains(root->boundingBox(), p1), "bounding box after moving the body");
+    check(!contains(root->boundingBox(), Vector3::Zero()), "bounding box does not keep the old position");
+
+    // Only a child link moves and the root link stays
+    const Vector3 p2 = p1 + Vector3(2.0, 0.0, 0.0);
+    arm->q() = 2.0;
+    body->calcForwardKinematics();
+    sceneBody->updateLinkPositions(update);
+    check(contains(root->boundingBox(), p2), "bounding box after moving the child link");
+    check(contains(sceneArm->boundingBox(), p2), "bounding box of the moved child link");
+
+    // The bounding boxes are updated again by the next update
+    arm->q() = 0.0;
+    rootLink->p() = Vector3(0.0, 3.0, 0.0);
+    body->calcForwardKinematics();
+    sceneBody->updateLinkPositions(update);
+    check(contains(root->boundingBox(), Vector3(0.0, 3.0, 0.0)), "bounding box after the second move");
+    check(!contains(root->boundingBox(), p2), "bounding box does not keep the moved child link");
+
+    if(numFailures > 0){
+        cerr << numFailures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All checks passed." << endl;
+    return 0;
+}
@@ -62,6 +62,16 @@ public:
     LinkTraverse traverse;
 };
 
+
+class AISTSimulationState : public Referenced
+{
+public:
+    vector<double> worldState;
+    vector<int> supportFootIndices;
+};
+
+typedef ref_ptr<AISTSimulationState> AISTSimulationStatePtr;
+
 }
 
 
@@ -626,6 +636,39 @@ std::shared_ptr<CollisionLinkPairList> AISTSimulatorItem::getCollisions()
 }
 
 
+bool AISTSimulatorItem::storeSimulationState(ReferencedPtr& out_state)
+{
+    AISTSimulationStatePtr state = new AISTSimulationState;
+    impl->world.storeState(state->worldState);
+    for(auto& simBody : simulationBodies()){
+        if(auto walkBody = dynamic_cast<KinematicWalkBody*>(simBody)){
+            state->supportFootIndices.push_back(walkBody->supportFootIndex);
+        }
+    }
+    out_state = state;
+    return true;
+}
+
+
+bool AISTSimulatorItem::restoreSimulationState(Referenced* state)
+{
+    auto aistState = dynamic_cast<AISTSimulationState*>(state);
+    if(!aistState || !impl->world.restoreState(aistState->worldState)){
+        return false;
+    }
+    size_t index = 0;
+    for(auto& simBody : simulationBodies()){
+        if(auto walkBody = dynamic_cast<KinematicWalkBody*>(simBody)){
+            if(index < aistState->supportFootIndices.size()){
+                walkBody->supportFootIndex = aistState->supportFootIndices[index++];
+                walkBody->traverse.find(walkBody->legged->footLink(walkBody->supportFootIndex), true, true);
+            }
+        }
+    }
+    return true;
+}
+
+
 Vector3 AISTSimulatorItem::getGravity() const
 {
     return impl->gravity;
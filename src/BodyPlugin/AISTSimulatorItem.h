@@ -79,6 +79,8 @@ protected:
     virtual bool stepSimulation(const std::vector<SimulationBody*>& activeSimBodies) override;
     virtual void finalizeSimulation() override;
     virtual std::shared_ptr<CollisionLinkPairList> getCollisions() override;
+    virtual bool storeSimulationState(ReferencedPtr& out_state) override;
+    virtual bool restoreSimulationState(Referenced* state) override;
         
     virtual Item* doCloneItem(CloneMap* cloneMap) const override;
     virtual void doPutProperties(PutPropertyFunction& putProperty) override;
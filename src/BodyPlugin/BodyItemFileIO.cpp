@@ -158,7 +158,7 @@ void BodyItemFileIoBase::addTransformIntegrationCheck(QBoxLayout* box)
 
 
 BodyItemBodyFileIO::BodyItemBodyFileIO()
-    : BodyItemFileIoBase("CHOREONOID-BODY", Load | Save | Options | OptionPanelForSaving)
+    : BodyItemFileIoBase("CHOREONOID-BODY", Load | Save | Options | OptionPanelForSaving | ConcurrentParsing)
 {
     setCaption(_("Body"));
     setExtensionsForLoading({ "body", "yaml", "yml", "wrl" });
@@ -194,9 +194,18 @@ BodyLoader* BodyItemBodyFileIO::ensureBodyLoader()
 
 bool BodyItemBodyFileIO::load(BodyItem* item, const std::string& filename)
 {
-    BodyPtr newBody = new Body;
-    if(!ensureBodyLoader()->load(newBody, filename)){
-        return false;
+    BodyPtr newBody;
+    ReferencedPtr parsed;
+    if(findConcurrentParsingResult(parsed)){
+        newBody = dynamic_pointer_cast<Body>(parsed);
+        if(!newBody){
+            return false;
+        }
+    } else {
+        newBody = new Body;
+        if(!ensureBodyLoader()->load(newBody, filename)){
+            return false;
+        }
     }
     item->setBody(newBody);
     
@@ -209,6 +218,21 @@ bool BodyItemBodyFileIO::load(BodyItem* item, const std::string& filename)
 }
 
 
+/**
+   A loader is created for each call because the loader keeps the state of the loading.
+*/
+ReferencedPtr BodyItemBodyFileIO::parseFileConcurrently(const std::string& filename, std::ostream& os)
+{
+    BodyLoader loader;
+    loader.setMessageSink(os);
+    BodyPtr body = new Body;
+    if(!loader.load(body, filename)){
+        return nullptr;
+    }
+    return body;
+}
+
+
 StdBodyWriter* BodyItemBodyFileIO::ensureBodyWriter()
 {
     if(!bodyWriter_){
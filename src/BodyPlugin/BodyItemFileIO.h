@@ -45,6 +45,7 @@ protected:
     StdBodyWriter* ensureBodyWriter();
 
     virtual bool load(BodyItem* item, const std::string& filename) override;
+    virtual ReferencedPtr parseFileConcurrently(const std::string& filename, std::ostream& os) override;
     virtual void createOptionPanelForSaving() override;
     virtual void fetchOptionPanelForSaving() override;
     virtual bool save(BodyItem* item, const std::string& filename) override;
@@ -53,6 +53,7 @@
 #include "LeggedBodyBar.h"
 #include "KinematicsBar.h"
 #include "SimulationBar.h"
+#include "SimulationBatchRunner.h"
 #include "BodyMotionEngine.h"
 #include "OperableSceneBody.h"
 #include "HrpsysFileIO.h"
@@ -142,6 +143,7 @@ bool BodyPlugin::initialize()
     OperableSceneBody::initializeClass(this);
     
     SimulationBar::initialize(this);
+    SimulationBatchRunner::initializeClass(this);
     addToolBar(BodyBar::instance());
     addToolBar(LeggedBodyBar::instance());
     addToolBar(KinematicsBar::instance());
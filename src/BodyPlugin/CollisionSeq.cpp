@@ -4,13 +4,154 @@
 #include <cnoid/CollisionSeqItem>
 #include <cnoid/YAMLReader>
 #include <cnoid/YAMLWriter>
+#include <fmt/format.h>
+#include <fstream>
+#include <unordered_map>
+#include <cstring>
+#include <cmath>
 #include "gettext.h"
 
 using namespace std;
 using namespace cnoid;
+using fmt::format;
 
 namespace {
+
 static const string mdskey("CollisionPairLsit");
+
+const char BinaryFormatSignature[] = "CNOIDCOL";
+const int BinaryFormatVersion = 1;
+const int SignatureSize = 8;
+
+// The resolution of the quantized points in meters
+const double PointResolution = 1.0e-5;
+const double NormalScale = 32767.0;
+
+struct CorruptDataException { };
+
+class BinaryWriteBuf
+{
+public:
+    vector<char> data;
+
+    void writeOctets(const char* octets, int size){
+        data.insert(data.end(), octets, octets + size);
+    }
+    void writeShort(short value){
+        data.push_back(value & 0xff);
+        data.push_back((value >> 8) & 0xff);
+    }
+    void writeInt(int value){
+        for(int i=0; i < 4; ++i){
+            data.push_back((value >> (i * 8)) & 0xff);
+        }
+    }
+    void writeInt64(int64_t value){
+        for(int i=0; i < 8; ++i){
+            data.push_back((value >> (i * 8)) & 0xff);
+        }
+    }
+    void writeFloat(float value){
+        int32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeInt(bits);
+    }
+    void writeDouble(double value){
+        int64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeInt64(bits);
+    }
+    void writeString(const std::string& str){
+        writeShort(str.size());
+        writeOctets(str.data(), str.size());
+    }
+    void overwriteInt64(size_t pos, int64_t value){
+        for(int i=0; i < 8; ++i){
+            data[pos + i] = (value >> (i * 8)) & 0xff;
+        }
+    }
+};
+
+class BinaryReadBuf
+{
+public:
+    vector<char> data;
+    size_t pos;
+
+    BinaryReadBuf() : pos(0) { }
+
+    void ensureSize(size_t size){
+        if(pos + size > data.size()){
+            throw CorruptDataException();
+        }
+    }
+    uint64_t readUnsigned(int size){
+        ensureSize(size);
+        uint64_t value = 0;
+        for(int i=0; i < size; ++i){
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(data[pos++])) << (i * 8);
+        }
+        return value;
+    }
+    short readShort(){
+        return static_cast<short>(readUnsigned(2));
+    }
+    int readInt(){
+        return static_cast<int>(static_cast<uint32_t>(readUnsigned(4)));
+    }
+    int readCount(){
+        int count = readInt();
+        if(count < 0){
+            throw CorruptDataException();
+        }
+        return count;
+    }
+    int64_t readInt64(){
+        return static_cast<int64_t>(readUnsigned(8));
+    }
+    float readFloat(){
+        uint32_t bits = readUnsigned(4);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    double readDouble(){
+        uint64_t bits = readUnsigned(8);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    std::string readString(){
+        int size = static_cast<unsigned short>(readShort());
+        ensureSize(size);
+        std::string str(&data[pos], size);
+        pos += size;
+        return str;
+    }
+};
+
+bool isSameLinkPair(const CollisionLinkPair& pair1, const CollisionLinkPair& pair2)
+{
+    return pair1.link(0) == pair2.link(0) && pair1.link(1) == pair2.link(1);
+}
+
+bool hasSameCollisions(const CollisionLinkPair& pair1, const CollisionLinkPair& pair2)
+{
+    auto& collisions1 = pair1.collisions();
+    auto& collisions2 = pair2.collisions();
+    if(collisions1.size() != collisions2.size()){
+        return false;
+    }
+    for(size_t i=0; i < collisions1.size(); ++i){
+        auto& c1 = collisions1[i];
+        auto& c2 = collisions2[i];
+        if(c1.point != c2.point || c1.normal != c2.normal || c1.depth != c2.depth){
+            return false;
+        }
+    }
+    return true;
+}
+
 }
 
 CollisionSeq::CollisionSeq(CollisionSeqItem* collisionSeqItem)
@@ -185,3 +326,287 @@ bool CollisionSeq::doWriteSeq(YAMLWriter& writer, std::function<void()> addition
             writer.endListing();
         });
 }
+
+
+std::shared_ptr<CollisionLinkPairList> CollisionSeq::shareUnchangedLinkPairs
+(std::shared_ptr<CollisionLinkPairList> pairs, const std::shared_ptr<CollisionLinkPairList>& prevPairs)
+{
+    if(!pairs || !prevPairs){
+        return pairs;
+    }
+    
+    bool isFrameUnchanged = (pairs->size() == prevPairs->size());
+    
+    for(size_t i=0; i < pairs->size(); ++i){
+        auto& pair = (*pairs)[i];
+        std::shared_ptr<CollisionLinkPair>* prevPair = nullptr;
+        // The pairs are usually listed in the same order as the previous frame
+        if(i < prevPairs->size() && isSameLinkPair(*(*prevPairs)[i], *pair)){
+            prevPair = &(*prevPairs)[i];
+        } else {
+            isFrameUnchanged = false;
+            for(auto& pair0 : *prevPairs){
+                if(isSameLinkPair(*pair0, *pair)){
+                    prevPair = &pair0;
+                    break;
+                }
+            }
+        }
+        if(prevPair && hasSameCollisions(**prevPair, *pair)){
+            pair = *prevPair;
+        } else {
+            isFrameUnchanged = false;
+        }
+    }
+
+    return isFrameUnchanged ? prevPairs : pairs;
+}
+
+
+bool CollisionSeq::saveAsBinaryFormat(const std::string& filename, std::ostream& os)
+{
+    BinaryWriteBuf buf;
+    const int nFrames = numFrames();
+
+    // Intern the bodies and links
+    unordered_map<Body*, int> bodyIndexMap;
+    unordered_map<Link*, int> linkIndexMap;
+    vector<Body*> bodies;
+    vector<Link*> links;
+    for(int i=0; i < nFrames; ++i){
+        auto& pairs = frame(i)[0];
+        if(!pairs){
+            continue;
+        }
+        for(auto& pair : *pairs){
+            for(int j=0; j < 2; ++j){
+                auto link = pair->link(j);
+                if(linkIndexMap.emplace(link, links.size()).second){
+                    links.push_back(link);
+                    if(bodyIndexMap.emplace(link->body(), bodies.size()).second){
+                        bodies.push_back(link->body());
+                    }
+                }
+            }
+        }
+    }
+
+    buf.writeOctets(BinaryFormatSignature, SignatureSize);
+    buf.writeInt(BinaryFormatVersion);
+    buf.writeDouble(frameRate());
+    buf.writeInt(offsetTimeFrame());
+    buf.writeDouble(PointResolution);
+    buf.writeInt(bodies.size());
+    for(auto& body : bodies){
+        buf.writeString(body->name());
+    }
+    buf.writeInt(links.size());
+    for(auto& link : links){
+        buf.writeInt(bodyIndexMap[link->body()]);
+        buf.writeString(link->name());
+    }
+
+    // The frame index, whose elements are the offsets of the frame data from the data section
+    buf.writeInt(nFrames);
+    size_t indexPos = buf.data.size();
+    buf.data.resize(indexPos + nFrames * 8);
+    size_t dataSectionPos = buf.data.size();
+
+    CollisionLinkPairList* prevPairs = nullptr;
+    int64_t prevOffset = 0;
+    unordered_map<CollisionLinkPair*, int> prevPairIndexMap;
+    
+    for(int i=0; i < nFrames; ++i){
+        auto pairs = frame(i)[0].get();
+        if(i > 0 && pairs == prevPairs){
+            // The frame data is shared with the previous frame
+            buf.overwriteInt64(indexPos + i * 8, prevOffset);
+            continue;
+        }
+        int64_t offset = buf.data.size() - dataSectionPos;
+        buf.overwriteInt64(indexPos + i * 8, offset);
+
+        int numPairs = pairs ? pairs->size() : 0;
+        buf.writeInt(numPairs);
+        for(int j=0; j < numPairs; ++j){
+            auto& pair = (*pairs)[j];
+            buf.writeInt(linkIndexMap[pair->link(0)]);
+            buf.writeInt(linkIndexMap[pair->link(1)]);
+            auto p = prevPairIndexMap.find(pair.get());
+            if(p != prevPairIndexMap.end()){
+                // The pair is shared with the previous frame
+                buf.writeInt(p->second);
+                continue;
+            }
+            buf.writeInt(-1);
+            buf.writeInt(pair->numCollisions());
+            for(auto& collision : pair->collisions()){
+                for(int k=0; k < 3; ++k){
+                    buf.writeInt(static_cast<int>(std::round(collision.point[k] / PointResolution)));
+                }
+                for(int k=0; k < 3; ++k){
+                    buf.writeShort(static_cast<short>(std::round(collision.normal[k] * NormalScale)));
+                }
+                buf.writeFloat(collision.depth);
+            }
+        }
+
+        prevPairIndexMap.clear();
+        for(int j=0; j < numPairs; ++j){
+            prevPairIndexMap[(*pairs)[j].get()] = j;
+        }
+        prevPairs = pairs;
+        prevOffset = offset;
+    }
+
+    ofstream ofs(filename.c_str(), ios::out | ios::binary);
+    if(!ofs){
+        os << format(_("\"{0}\" cannot be opened."), filename) << endl;
+        return false;
+    }
+    ofs.write(buf.data.data(), buf.data.size());
+    if(ofs.fail()){
+        os << format(_("Collision data cannot be written to \"{0}\"."), filename) << endl;
+        return false;
+    }
+    
+    return true;
+}
+
+
+bool CollisionSeq::loadBinaryFormat(const std::string& filename, WorldItem* worldItem, std::ostream& os)
+{
+    ifstream ifs(filename.c_str(), ios::in | ios::binary);
+    if(!ifs){
+        os << format(_("\"{0}\" cannot be opened."), filename) << endl;
+        return false;
+    }
+    BinaryReadBuf buf;
+    buf.data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+
+    try {
+        buf.ensureSize(SignatureSize);
+        if(std::memcmp(buf.data.data(), BinaryFormatSignature, SignatureSize) != 0){
+            os << format(_("\"{0}\" is not a binary collision data file."), filename) << endl;
+            return false;
+        }
+        buf.pos += SignatureSize;
+        int version = buf.readInt();
+        if(version != BinaryFormatVersion){
+            os << format(_("Version {0} of the binary collision data format is not supported."), version) << endl;
+            return false;
+        }
+        double frameRate = buf.readDouble();
+        int offsetTimeFrame = buf.readInt();
+        double pointResolution = buf.readDouble();
+
+        int numBodies = buf.readCount();
+        vector<Body*> bodies(numBodies, nullptr);
+        for(int i=0; i < numBodies; ++i){
+            auto name = buf.readString();
+            if(worldItem){
+                if(auto bodyItem = worldItem->findChildItem<BodyItem>(name)){
+                    bodies[i] = bodyItem->body();
+                }
+            }
+        }
+        int numLinks = buf.readCount();
+        vector<Link*> links(numLinks, nullptr);
+        for(int i=0; i < numLinks; ++i){
+            int bodyIndex = buf.readInt();
+            auto name = buf.readString();
+            if(bodyIndex < 0 || bodyIndex >= numBodies){
+                throw CorruptDataException();
+            }
+            if(auto body = bodies[bodyIndex]){
+                links[i] = body->link(name);
+            }
+        }
+
+        int nFrames = buf.readCount();
+        buf.ensureSize(static_cast<size_t>(nFrames) * 8);
+        vector<int64_t> offsets(nFrames);
+        for(int i=0; i < nFrames; ++i){
+            offsets[i] = buf.readInt64();
+        }
+        size_t dataSectionPos = buf.pos;
+
+        setFrameRate(frameRate);
+        setDimension(nFrames, 1);
+        setOffsetTimeFrame(offsetTimeFrame);
+
+        std::shared_ptr<CollisionLinkPairList> prevPairs;
+        std::shared_ptr<CollisionLinkPairList> prevStoredPairs;
+        int64_t prevOffset = -1;
+        bool hasUnresolvedLinks = false;
+        
+        for(int i=0; i < nFrames; ++i){
+            Frame f = frame(i);
+            if(offsets[i] == prevOffset){
+                f[0] = prevPairs;
+                continue;
+            }
+            if(offsets[i] < 0 || offsets[i] > static_cast<int64_t>(buf.data.size() - dataSectionPos)){
+                throw CorruptDataException();
+            }
+            buf.pos = dataSectionPos + offsets[i];
+            
+            auto pairs = std::make_shared<CollisionLinkPairList>();
+            // All the pairs including the ones with unresolved links, which are referred to by the next frame
+            auto storedPairs = std::make_shared<CollisionLinkPairList>();
+            int numPairs = buf.readCount();
+            for(int j=0; j < numPairs; ++j){
+                int link0Index = buf.readInt();
+                int link1Index = buf.readInt();
+                int prevPairIndex = buf.readInt();
+                if(link0Index < 0 || link0Index >= numLinks || link1Index < 0 || link1Index >= numLinks){
+                    throw CorruptDataException();
+                }
+                std::shared_ptr<CollisionLinkPair> pair;
+                if(prevPairIndex >= 0){
+                    if(!prevStoredPairs || prevPairIndex >= static_cast<int>(prevStoredPairs->size())){
+                        throw CorruptDataException();
+                    }
+                    pair = (*prevStoredPairs)[prevPairIndex];
+                } else {
+                    pair = std::make_shared<CollisionLinkPair>();
+                    pair->setLinkPair(links[link0Index], links[link1Index]);
+                    int numCollisions = buf.readCount();
+                    auto& collisions = pair->collisions();
+                    collisions.resize(numCollisions);
+                    for(auto& collision : collisions){
+                        for(int k=0; k < 3; ++k){
+                            collision.point[k] = buf.readInt() * pointResolution;
+                        }
+                        for(int k=0; k < 3; ++k){
+                            collision.normal[k] = buf.readShort() / NormalScale;
+                        }
+                        collision.depth = buf.readFloat();
+                    }
+                }
+                storedPairs->push_back(pair);
+                if(pair->link(0) && pair->link(1)){
+                    pairs->push_back(pair);
+                } else {
+                    hasUnresolvedLinks = true;
+                }
+            }
+            f[0] = pairs;
+            prevPairs = pairs;
+            prevStoredPairs = storedPairs;
+            prevOffset = offsets[i];
+        }
+
+        if(hasUnresolvedLinks){
+            os << format(_("Some of the links in \"{0}\" are not found in the world and their collisions are ignored."),
+                         filename) << endl;
+        }
+    }
+    catch(const CorruptDataException&){
+        os << format(_("\"{0}\" is corrupt."), filename) << endl;
+        setNumFrames(0);
+        return false;
+    }
+
+    return true;
+}
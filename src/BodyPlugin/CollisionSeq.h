@@ -11,6 +11,7 @@ namespace cnoid {
 
 class YAMLWriter;
 class CollisionSeqItem;
+class WorldItem;
 
 typedef std::vector<std::shared_ptr<CollisionLinkPair>> CollisionLinkPairList;
 
@@ -29,6 +30,24 @@ public:
     void writeCollsionData(YAMLWriter& writer, std::shared_ptr<const CollisionLinkPairList> ptr);
     void readCollisionData(int nFrames, const Listing& values);
 
+    /**
+       The binary format stores the body and link names in a table and refers to the links by
+       the indices of the table. The points and normals are quantized into integers, and the
+       frames and link pairs shared with the previous frame are stored as references.
+       The links are resolved with the bodies in the world item when the data is loaded.
+    */
+    bool loadBinaryFormat(const std::string& filename, WorldItem* worldItem, std::ostream& os = nullout());
+    bool saveAsBinaryFormat(const std::string& filename, std::ostream& os = nullout());
+
+    /**
+       This function replaces the link pairs that have the same collisions as the pairs of the
+       previous frame with the pair objects of the previous frame so that the unchanged pairs
+       are shared between the frames. The list of the previous frame is returned when all the
+       pairs are unchanged.
+    */
+    static std::shared_ptr<CollisionLinkPairList> shareUnchangedLinkPairs(
+        std::shared_ptr<CollisionLinkPairList> pairs, const std::shared_ptr<CollisionLinkPairList>& prevPairs);
+
 protected:
     virtual bool doReadSeq(const Mapping* archive, std::ostream& os) override;
     virtual bool doWriteSeq(YAMLWriter& writer, std::function<void()> additionalPartCallback) override;
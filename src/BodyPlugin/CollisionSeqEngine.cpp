@@ -89,12 +89,17 @@ bool CollisionSeqEngine::Impl::onTimeChanged(double time)
                 const int frame = colSeq->frameOfTime(time);
                 isValid = (frame < numFrames);
                 const int clampedFrame = colSeq->clampFrameIndex(frame);
-                const CollisionSeq::Frame collisionPairs0 = colSeq->frame(clampedFrame);
+                auto& pairs = colSeq->frame(clampedFrame)[0];
                 CollisionLinkPairList& collisionPairs = worldItem->collisions();
-                collisionPairs.clear();
-                for(size_t i=0; i < collisionPairs0[0]->size(); i++){
-                    collisionPairs.push_back(collisionPairs0[0]->at(i));
+                /*
+                  The link pairs unchanged from the previous frame share the same objects
+                  in the sequence, so the scene update can be skipped when the pairs shown
+                  in the world are identical to the ones of the current frame.
+                */
+                if(collisionPairs == *pairs){
+                    return isValid;
                 }
+                collisionPairs = *pairs;
             }
         }
         dynamic_cast<SceneCollision*>(worldItem->getScene())->setDirty();
@@ -4,6 +4,7 @@
 */
 
 #include "CollisionSeqItem.h"
+#include "WorldItem.h"
 #include <cnoid/ItemManager>
 #include <cnoid/Archive>
 #include "gettext.h"
@@ -43,6 +44,22 @@ static bool saveAsStandardYamlFormat(CollisionSeqItem* item, const std::string&
 }
 
 
+static bool loadBinaryFormat(CollisionSeqItem* item, const std::string& filename, std::ostream& os, Item* parentItem)
+{
+    auto worldItem = item->findOwnerItem<WorldItem>();
+    if(!worldItem && parentItem){
+        worldItem = parentItem->findOwnerItem<WorldItem>(true);
+    }
+    return item->collisionSeq()->loadBinaryFormat(filename, worldItem, os);
+}
+
+
+static bool saveAsBinaryFormat(CollisionSeqItem* item, const std::string& filename, std::ostream& os)
+{
+    return item->collisionSeq()->saveAsBinaryFormat(filename, os);
+}
+
+
 void CollisionSeqItem::initislizeClass(ExtensionManager* ext)
 {
     static bool initialized = false;
@@ -54,6 +71,14 @@ void CollisionSeqItem::initislizeClass(ExtensionManager* ext)
     ItemManager& im = ext->itemManager();
 
     im.registerClass<CollisionSeqItem, AbstractMultiSeqItem>(N_("CollisionSeqItem"));
+    im.addLoaderAndSaver<CollisionSeqItem>(
+        _("Collision Data (Binary)"), "COLLISION-DATA-BINARY", "cols",
+        [](CollisionSeqItem* item, const std::string& filename, std::ostream& os, Item* parentItem){
+            return loadBinaryFormat(item, filename, os, parentItem);
+        },
+        [](CollisionSeqItem* item, const std::string& filename, std::ostream& os, Item* /* parentItem */){
+            return saveAsBinaryFormat(item, filename, os);
+        });
     im.addLoaderAndSaver<CollisionSeqItem>(
         _("Collision Data"), "COLLISION-DATA-YAML", "yaml",
         [](CollisionSeqItem* item, const std::string& filename, std::ostream& os, Item* /* parentItem */){
@@ -1,8 +1,10 @@
 #include "ControllerItem.h"
+#include "SimulationUpdateSchedule.h"
 #include <cnoid/ItemManager>
 #include <cnoid/ReferencedObjectSeqItem>
 #include <cnoid/PutPropertyFunction>
 #include <cnoid/Archive>
+#include <algorithm>
 #include "gettext.h"
 
 using namespace std;
@@ -18,6 +20,8 @@ void ControllerItem::initializeClass(ExtensionManager* ext)
 ControllerItem::ControllerItem()
 {
     isNoDelayMode_ = false;
+    updateRate_ = 0.0;
+    updatePhaseOffset_ = 0.0;
 }
 
 
@@ -26,6 +30,8 @@ ControllerItem::ControllerItem(const ControllerItem& org)
       optionString_(org.optionString_)
 {
     isNoDelayMode_ = org.isNoDelayMode_;
+    updateRate_ = org.updateRate_;
+    updatePhaseOffset_ = org.updatePhaseOffset_;
 }
 
 
@@ -75,12 +81,28 @@ void ControllerItem::setNoDelayMode(bool on)
 double ControllerItem::timeStep() const
 {
     if(auto item = simulatorItem_.lock()){
-        return item->worldTimeStep();
+        double dt = item->worldTimeStep();
+        if(updateRate_ > 0.0){
+            dt *= SimulationUpdateSchedule(updateRate_, updatePhaseOffset_, 1.0 / dt).interval();
+        }
+        return dt;
     }
     return 0.0;
 }
 
 
+void ControllerItem::setUpdateRate(double rate)
+{
+    updateRate_ = std::max(0.0, rate);
+}
+
+
+void ControllerItem::setUpdatePhaseOffset(double offset)
+{
+    updatePhaseOffset_ = std::max(0.0, offset);
+}
+
+
 bool ControllerItem::checkIfSubController(ControllerItem* /* controllerItem */) const
 {
     return false;
@@ -129,6 +151,18 @@ ReferencedObjectSeqItem* ControllerItem::createLogItem()
 }
 
 
+ReferencedPtr ControllerItem::storeControlState()
+{
+    return nullptr;
+}
+
+
+bool ControllerItem::restoreControlState(Referenced* /* state */)
+{
+    return true;
+}
+
+
 void ControllerItem::onOptionsChanged()
 {
 
@@ -138,6 +172,10 @@ void ControllerItem::onOptionsChanged()
 void ControllerItem::doPutProperties(PutPropertyFunction& putProperty)
 {
     putProperty(_("No delay mode"), isNoDelayMode_, changeProperty(isNoDelayMode_));
+    putProperty.min(0.0);
+    putProperty(_("Update rate [Hz]"), updateRate_, changeProperty(updateRate_));
+    putProperty(_("Update phase offset [s]"), updatePhaseOffset_, changeProperty(updatePhaseOffset_));
+    putProperty.reset();
 
     putProperty(_("Controller options"), optionString_,
                 [&](const string& options){
@@ -152,6 +190,10 @@ bool ControllerItem::store(Archive& archive)
 {
     archive.write("isNoDelayMode", isNoDelayMode_);
     archive.write("controllerOptions", optionString_, DOUBLE_QUOTED);
+    if(updateRate_ > 0.0){
+        archive.write("update_rate", updateRate_);
+        archive.write("update_phase_offset", updatePhaseOffset_);
+    }
     return true;
 }
 
@@ -163,5 +205,12 @@ bool ControllerItem::restore(const Archive& archive)
         archive.read("isImmediateMode", isNoDelayMode_); 
     }
     archive.read("controllerOptions", optionString_);
+    double value;
+    if(archive.read("update_rate", value)){
+        setUpdateRate(value);
+    }
+    if(archive.read("update_phase_offset", value)){
+        setUpdatePhaseOffset(value);
+    }
     return true;
 }
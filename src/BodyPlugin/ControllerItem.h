@@ -34,6 +34,17 @@ public:
 
     virtual double timeStep() const;
 
+    /**
+       The update rate [Hz] of the controller. The input, control and output functions are
+       called only at the frames corresponding to this rate, shifted by the phase offset [s],
+       and ControllerIO::timeStep returns the corresponding update period. Zero rate means that
+       the controller is updated at every time step of the simulation world.
+    */
+    double updateRate() const { return updateRate_; }
+    void setUpdateRate(double rate);
+    double updatePhaseOffset() const { return updatePhaseOffset_; }
+    void setUpdatePhaseOffset(double offset);
+
     virtual bool checkIfSubController(ControllerItem* controllerItem) const;
 
     /**
@@ -81,6 +92,16 @@ public:
     */
     virtual ReferencedObjectSeqItem* createLogItem();
 
+    /**
+       These functions are used to take a snapshot of the simulation and to restore it.
+       A controller that has an internal state should return the object containing the state
+       and restore the state from the object. The state of the controller that does not
+       override these functions is not restored.
+       \note These functions are called when the control functions are not being executed.
+    */
+    virtual ReferencedPtr storeControlState();
+    virtual bool restoreControlState(Referenced* state);
+
     [[deprecated("Use isNoDelayMode.")]]
     bool isImmediateMode() const { return isNoDelayMode(); }
     [[deprecated("Use setNoDelayMode.")]]
@@ -108,6 +129,8 @@ private:
     weak_ref_ptr<SimulatorItem> simulatorItem_;
     std::string optionString_;
     bool isNoDelayMode_;
+    double updateRate_;
+    double updatePhaseOffset_;
 
     friend class SimulatorItem;
     void setSimulatorItem(SimulatorItem* item);
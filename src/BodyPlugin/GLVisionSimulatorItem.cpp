@@ -1237,8 +1237,13 @@ void SensorRenderer::updateSensorScene(bool updateSensorForRenderingThread)
 
 void SensorScene::updateScene(double currentTime)
 {
+    /*
+      The update must be notified so that the bounding box caches of the moved links
+      are invalidated. Otherwise the culling of the renderer may skip the moved links.
+    */
+    SgUpdate update;
     for(auto& sceneBody : sceneBodies){
-        sceneBody->updateLinkPositions();
+        sceneBody->updateLinkPositions(update);
         sceneBody->updateSceneDevices(currentTime);
     }
 }
@@ -37,6 +37,59 @@ struct SharedInfo : public Referenced
 
 typedef ref_ptr<SharedInfo> SharedInfoPtr;
 
+/**
+   A list of the copies of a state variable between the links of two bodies.
+   The copies of the same state type are executed in a tight loop without branches.
+*/
+template<class ValueType>
+class StateCopyList
+{
+public:
+    void clear() { copies.clear(); }
+    void add(ValueType& dest, const ValueType& src) { copies.emplace_back(&dest, &src); }
+    void copy() const {
+        for(auto& c : copies){
+            *c.first = *c.second;
+        }
+    }
+    void accumulate() const {
+        for(auto& c : copies){
+            *c.first += *c.second;
+        }
+    }
+private:
+    vector<std::pair<ValueType*, const ValueType*>> copies;
+};
+
+/**
+   The copy plan of the link states compiled from the state types enabled for the input or output.
+   It consists of the lists of the copies for each state type.
+*/
+struct LinkStateCopyPlan
+{
+    StateCopyList<double> q;
+    StateCopyList<double> dq;
+    StateCopyList<double> ddq;
+    StateCopyList<double> u;
+    StateCopyList<Isometry3> T;
+    StateCopyList<Vector3> vw; // v and w
+    StateCopyList<Vector3> dvw; // dv and dw
+    StateCopyList<Vector6> F_ext;
+    vector<std::pair<Link*, const Link*>> contactStateLinks;
+
+    void clear(){
+        q.clear();
+        dq.clear();
+        ddq.clear();
+        u.clear();
+        T.clear();
+        vw.clear();
+        dvw.clear();
+        F_ext.clear();
+        contactStateLinks.clear();
+    }
+};
+
 class MySimpleControllerConfig : public SimpleControllerConfig
 {
 public:
@@ -75,8 +128,12 @@ public:
         vector<short> stateTypes;
     };
     vector<LinkOutputStateInfo> linkOutputStateInfos;
+
+    LinkStateCopyPlan inputCopyPlan;
+    LinkStateCopyPlan outputCopyPlan;
     
     bool isOldTargetVariableMode;
+    bool isOutputCopyPlanInOldTargetVariableMode;
 
     ConnectionSet outputDeviceStateConnections;
     vector<bool> outputDeviceStateChangeFlag;
@@ -118,6 +175,8 @@ public:
     void updateInputEnabledDevices();
     SimpleController* initialize(ControllerIO* io, SharedInfo* info);
     void updateIOStateTypes();
+    void compileInputCopyPlan();
+    void compileOutputCopyPlan();
     bool start();
     void input();
     void onInputDeviceStateChanged(int deviceIndex);
@@ -205,6 +264,7 @@ SimpleControllerItem::Impl::Impl(SimpleControllerItem* self)
     doCommonInitializationInConstructor();
     
     isOldTargetVariableMode = false;
+    isOutputCopyPlanInOldTargetVariableMode = isOldTargetVariableMode;
     doReloading = false;
     isSymbolExportEnabled = false;
 
@@ -234,6 +294,7 @@ SimpleControllerItem::Impl::Impl(SimpleControllerItem* self, const Impl& org)
     doCommonInitializationInConstructor();
     
     isOldTargetVariableMode = org.isOldTargetVariableMode;
+    isOutputCopyPlanInOldTargetVariableMode = isOldTargetVariableMode;
     doReloading = org.doReloading;
     isSymbolExportEnabled = org.isSymbolExportEnabled;
 }
@@ -503,6 +564,8 @@ void SimpleControllerItem::Impl::clearIoTargets()
     inputStateTypes.clear();
     outputLinkFlags.clear();
     linkOutputStateInfos.clear();
+    inputCopyPlan.clear();
+    outputCopyPlan.clear();
     subControllerItems.clear();
 }
 
@@ -616,6 +679,110 @@ void SimpleControllerItem::Impl::updateIOStateTypes()
             linkOutputStateInfos.push_back(info);
         }
     }
+
+    compileInputCopyPlan();
+    compileOutputCopyPlan();
+}
+
+
+void SimpleControllerItem::Impl::compileInputCopyPlan()
+{
+    auto& plan = inputCopyPlan;
+    plan.clear();
+    
+    int typeArrayIndex = 0;
+    for(size_t i=0; i < inputLinkIndices.size(); ++i){
+        const int linkIndex = inputLinkIndices[i];
+        Link* simLink = simulationBody->link(linkIndex);
+        Link* ioLink = ioBody->link(linkIndex);
+        const int n = inputStateTypes[typeArrayIndex++];
+        for(int j=0; j < n; ++j){
+            switch(inputStateTypes[typeArrayIndex++]){
+            case Link::JointDisplacement:
+                plan.q.add(ioLink->q(), simLink->q());
+                break;
+            case Link::JointVelocity:
+                plan.dq.add(ioLink->dq(), simLink->dq());
+                break;
+            case Link::JointAcceleration:
+                plan.ddq.add(ioLink->ddq(), simLink->ddq());
+                break;
+            case Link::JointEffort:
+                plan.u.add(ioLink->u(), simLink->u());
+                break;
+            case Link::LinkPosition:
+                plan.T.add(ioLink->T(), simLink->T());
+                break;
+            case Link::LinkTwist:
+                plan.vw.add(ioLink->v(), simLink->v());
+                plan.vw.add(ioLink->w(), simLink->w());
+                break;
+            case Link::LinkAcceleration:
+                plan.dvw.add(ioLink->dv(), simLink->dv());
+                plan.dvw.add(ioLink->dw(), simLink->dw());
+                break;
+            case Link::LinkExtWrench:
+                plan.F_ext.add(ioLink->F_ext(), simLink->F_ext());
+                break;
+            case Link::LinkContactState:
+                plan.contactStateLinks.emplace_back(ioLink, simLink);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+
+void SimpleControllerItem::Impl::compileOutputCopyPlan()
+{
+    auto& plan = outputCopyPlan;
+    plan.clear();
+    
+    for(size_t i=0; i < linkOutputStateInfos.size(); ++i){
+        const auto& info = linkOutputStateInfos[i];
+        const int index = info.linkIndex;
+        Link* ioLink = ioBody->link(index);
+        Link* simLink = simulationBody->link(index);
+
+        const auto& stateTypes = info.stateTypes;
+        for(size_t j=0; j < stateTypes.size(); ++j){
+            switch(stateTypes[j]){
+            case Link::JointDisplacement:
+                plan.q.add(simLink->q_target(), isOldTargetVariableMode ? ioLink->q() : ioLink->q_target());
+                break;
+            case Link::JointVelocity:
+            case Link::DeprecatedJointSurfaceVelocity:
+                plan.dq.add(simLink->dq_target(), isOldTargetVariableMode ? ioLink->dq() : ioLink->dq_target());
+                break;
+            case Link::JointAcceleration:
+                plan.ddq.add(simLink->ddq(), ioLink->ddq());
+                break;
+            case Link::JointEffort:
+                plan.u.add(simLink->u(), ioLink->u());
+                break;
+            case Link::LinkPosition:
+                plan.T.add(simLink->T(), ioLink->T());
+                break;
+            case Link::LinkTwist:
+                plan.vw.add(simLink->v(), ioLink->v());
+                plan.vw.add(simLink->w(), ioLink->w());
+                break;
+            case Link::LinkAcceleration:
+                plan.dvw.add(simLink->dv(), ioLink->dv());
+                plan.dvw.add(simLink->dw(), ioLink->dw());
+                break;
+            case Link::LinkExtWrench:
+                plan.F_ext.add(simLink->F_ext(), ioLink->F_ext());
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    isOutputCopyPlanInOldTargetVariableMode = isOldTargetVariableMode;
 }
 
 
@@ -853,46 +1020,22 @@ void SimpleControllerItem::input()
 
 void SimpleControllerItem::Impl::input()
 {
-    int typeArrayIndex = 0;
-    for(size_t i=0; i < inputLinkIndices.size(); ++i){
-        const int linkIndex = inputLinkIndices[i];
-        const Link* simLink = simulationBody->link(linkIndex);
-        Link* ioLink = ioBody->link(linkIndex);
-        const int n = inputStateTypes[typeArrayIndex++];
-        for(int j=0; j < n; ++j){
-            switch(inputStateTypes[typeArrayIndex++]){
-            case Link::JointDisplacement:
-                ioLink->q() = simLink->q();
-                break;
-            case Link::JointVelocity:
-                ioLink->dq() = simLink->dq();
-                break;
-            case Link::JointAcceleration:
-                ioLink->ddq() = simLink->ddq();
-                break;
-            case Link::JointEffort:
-                ioLink->u() = simLink->u();
-                break;
-            case Link::LinkPosition:
-                ioLink->T() = simLink->T();
-                break;
-            case Link::LinkTwist:
-                ioLink->v() = simLink->v();
-                ioLink->w() = simLink->w();
-                break;
-            case Link::LinkAcceleration:
-                ioLink->dv() = simLink->dv();
-                ioLink->dw() = simLink->dw();
-                break;
-            case Link::LinkExtWrench:
-                ioLink->F_ext() = simLink->F_ext();
-                break;
-            case Link::LinkContactState:
-                ioLink->contactPoints() = simLink->contactPoints();
-                break;
-            default:
-                break;
-            }
+    auto& plan = inputCopyPlan;
+    plan.q.copy();
+    plan.dq.copy();
+    plan.ddq.copy();
+    plan.u.copy();
+    plan.T.copy();
+    plan.vw.copy();
+    plan.dvw.copy();
+    plan.F_ext.copy();
+
+    for(auto& links : plan.contactStateLinks){
+        auto& ioContactPoints = links.first->contactPoints();
+        auto& simContactPoints = links.second->contactPoints();
+        // Links usually have no contact points, in which case the copy is skipped
+        if(!ioContactPoints.empty() || !simContactPoints.empty()){
+            ioContactPoints = simContactPoints;
         }
     }
 
@@ -950,66 +1093,20 @@ void SimpleControllerItem::output()
 
 void SimpleControllerItem::Impl::output()
 {
-    for(size_t i=0; i < linkOutputStateInfos.size(); ++i){
-
-        const auto& info = linkOutputStateInfos[i];
-        const int index = info.linkIndex;
-        const Link* ioLink = ioBody->link(index);
-        Link* simLink = simulationBody->link(index);
-
-        const auto& stateTypes = info.stateTypes;
-        for(size_t j=0; j < stateTypes.size(); ++j){
-            switch(stateTypes[j]){
-
-            case Link::JointDisplacement:
-                if(isOldTargetVariableMode){
-                    simLink->q_target() = ioLink->q();
-                } else {
-                    simLink->q_target() = ioLink->q_target();
-                }
-                break;
-
-            case Link::JointVelocity:
-            case Link::DeprecatedJointSurfaceVelocity:
-                if(isOldTargetVariableMode){
-                    simLink->dq_target() = ioLink->dq();
-                } else {
-                    simLink->dq_target() = ioLink->dq_target();
-                }
-                break;
-
-            case Link::JointAcceleration:
-                simLink->ddq() = ioLink->ddq();
-                break;
-
-            case Link::JointEffort:
-                simLink->u() = ioLink->u();
-                break;
-
-            case Link::LinkPosition:
-                simLink->T() = ioLink->T();
-                break;
-
-            case Link::LinkTwist:
-                simLink->v() = ioLink->v();
-                simLink->w() = ioLink->w();
-                break;
-
-            case Link::LinkAcceleration:
-                simLink->dv() = ioLink->dv();
-                simLink->dw() = ioLink->dw();
-                break;
-                
-            case Link::LinkExtWrench:
-                simLink->F_ext() += ioLink->F_ext();
-                break;
-
-            default:
-                break;
-            }
-        }
+    if(isOldTargetVariableMode != isOutputCopyPlanInOldTargetVariableMode){
+        compileOutputCopyPlan();
     }
 
+    auto& plan = outputCopyPlan;
+    plan.q.copy();
+    plan.dq.copy();
+    plan.ddq.copy();
+    plan.u.copy();
+    plan.T.copy();
+    plan.vw.copy();
+    plan.dvw.copy();
+    plan.F_ext.accumulate();
+
     const DeviceList<>& devices = simulationBody->devices();
     const DeviceList<>& ioDevices = ioBody->devices();
     for(size_t i=0; i < outputDeviceStateChangeFlag.size(); ++i){
@@ -79,6 +79,9 @@ SimulationBar::SimulationBar()
     stopButton->sigClicked().connect([&](){ onStopSimulationClicked(); });
     stopButton->installEventFilter(this);
     isStopConfirmationEnabled = false;
+
+    deadlineMissLabel = addLabel("");
+    deadlineMissLabel->setVisible(false);
 }
 
 
@@ -201,6 +204,15 @@ void SimulationBar::startSimulation(SimulatorItem* simulator, bool doReset)
         
     } else {
         sigSimulationAboutToStart_(simulator);
+        if(simulator->realtimeSyncMode() == SimulatorItem::PreciseRealtimeSync){
+            deadlineMissConnection =
+                simulator->sigDeadlineMissStatisticsUpdated().connect(
+                    [this, simulator](){ updateDeadlineMissLabel(simulator); });
+            deadlineMissLabel->setVisible(true);
+        } else {
+            deadlineMissConnection.disconnect();
+            deadlineMissLabel->setVisible(false);
+        }
         simulator->startSimulation(doReset);
         pauseToggle->blockSignals(true);
         pauseToggle->setChecked(false);
@@ -209,6 +221,32 @@ void SimulationBar::startSimulation(SimulatorItem* simulator, bool doReset)
 }
 
 
+void SimulationBar::updateDeadlineMissLabel(SimulatorItem* simulator)
+{
+    typedef SimulatorItem::DeadlineMissStatistics Statistics;
+    auto stats = simulator->deadlineMissStatistics();
+
+    deadlineMissLabel->setText(format(_("Deadline misses: {0}"), stats.numMisses).c_str());
+
+    string histogram =
+        format(_("Deadline misses of {0}: {1} in {2} frames"),
+               simulator->displayName(), stats.numMisses, stats.numFrames);
+    double lowerBound = 0.0;
+    for(int i=0; i < Statistics::NumHistogramBins; ++i){
+        if(i < Statistics::NumHistogramBins - 1){
+            double upperBound = Statistics::HistogramBinUpperBounds[i];
+            histogram += format(_("\n{0} - {1} [ms]: {2}"),
+                                lowerBound * 1000.0, upperBound * 1000.0, stats.histogram[i]);
+            lowerBound = upperBound;
+        } else {
+            histogram += format(_("\n{0} - [ms]: {1}"), lowerBound * 1000.0, stats.histogram[i]);
+        }
+    }
+    histogram += format(_("\nMax lateness: {0:.3f} [ms]"), stats.maxLateness * 1000.0);
+    deadlineMissLabel->setToolTip(histogram.c_str());
+}
+
+
 bool SimulationBar::eventFilter(QObject* obj, QEvent* event)
 {
     if(obj == stopButton && event->type() == QEvent::MouseButtonPress){
@@ -46,9 +46,12 @@ private:
     void onStopSimulationClicked();
     void onPauseSimulationClicked();
     void pauseSimulation(SimulatorItem* simulator);
+    void updateDeadlineMissLabel(SimulatorItem* simulator);
 
     ToolButton* pauseToggle;
     ToolButton* stopButton;
+    QLabel* deadlineMissLabel;
+    ScopedConnection deadlineMissConnection;
     Signal<void(SimulatorItem*)> sigSimulationAboutToStart_;
     MenuManager menuManager;
     bool isStopConfirmationEnabled;
@@ -0,0 +1,758 @@
+#include "SimulationBatchRunner.h"
+#include "WorldItem.h"
+#include "SimulatorItem.h"
+#include "BodyItem.h"
+#include <cnoid/ExtensionManager>
+#include <cnoid/OptionManager>
+#include <cnoid/RootItem>
+#include <cnoid/ProjectManager>
+#include <cnoid/Archive>
+#include <cnoid/CloneMap>
+#include <cnoid/MessageView>
+#include <cnoid/LazyCaller>
+#include <cnoid/App>
+#include <cnoid/YAMLReader>
+#include <cnoid/YAMLWriter>
+#include <cnoid/EigenArchive>
+#include <cnoid/EigenUtil>
+#include <cnoid/UTF8>
+#include <cnoid/stdx/filesystem>
+#include <fmt/format.h>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <memory>
+#include "gettext.h"
+
+using namespace std;
+using namespace cnoid;
+using fmt::format;
+namespace filesystem = cnoid::stdx::filesystem;
+
+namespace {
+
+unique_ptr<SimulationBatchRunner> commandLineRunner;
+
+struct RunInfo
+{
+    enum Status { Waiting, Running, Completed, Stopped, Failed };
+
+    string name;
+    MappingPtr overrides;
+    WorldItemPtr worldItem;
+    SimulatorItemPtr simulatorItem;
+    ScopedConnection connection;
+    Status status;
+    bool isFinalizationPending;
+    std::chrono::steady_clock::time_point startTime;
+    double wallTime;
+    double simulationTime;
+    int numFrames;
+    string errorMessage;
+    MappingPtr finalState;
+
+    RunInfo() : status(Waiting), isFinalizationPending(false), wallTime(0.0), simulationTime(0.0), numFrames(0) { }
+};
+
+const char* statusLabel(RunInfo::Status status)
+{
+    switch(status){
+    case RunInfo::Waiting:   return "waiting";
+    case RunInfo::Running:   return "running";
+    case RunInfo::Completed: return "completed";
+    case RunInfo::Stopped:   return "stopped";
+    case RunInfo::Failed:    return "failed";
+    }
+    return "unknown";
+}
+
+
+string quoteCsvField(const string& field)
+{
+    string quoted("\"");
+    for(auto c : field){
+        if(c == '"'){
+            quoted += '"';
+        }
+        quoted += c;
+    }
+    quoted += '"';
+    return quoted;
+}
+
+}
+
+namespace cnoid {
+
+class SimulationBatchRunner::Impl
+{
+public:
+    WorldItemPtr worldItem;
+    string worldPath;
+    string simulatorPath;
+    double timeLength;
+    bool isTimeLengthSpecified;
+    int maxConcurrency;
+    bool isRecordingEnabled;
+    filesystem::path outputDirectory;
+    bool isExitOnCompletionEnabled;
+    vector<unique_ptr<RunInfo>> runs;
+    int nextRunIndex;
+    int numActiveRuns;
+    int numFinishedRuns;
+    int numFailedRuns;
+    // The index of the run that drives the ongoing time of the time bar
+    int timeBarSyncRunIndex;
+    bool isRunning;
+    std::chrono::steady_clock::time_point startTime;
+    LazyCaller finalizeFinishedRunsLater;
+    Signal<void()> sigFinished;
+    MessageView* mv;
+
+    Impl();
+    ~Impl();
+    bool readSweepSpec(const Mapping* spec, const string& baseDirectory);
+    void addRun(const string& name, MappingPtr overrides);
+    bool start();
+    void launchRuns();
+    bool launchRun(int runIndex);
+    bool applyOverrides(RunInfo& run);
+    void onRunFinished(int runIndex, bool isForced);
+    void finalizeFinishedRuns();
+    void finalizeRun(int runIndex);
+    void failRun(RunInfo& run, const string& message);
+    void recordFinalState(RunInfo& run);
+    void writeRunLog(RunInfo& run);
+    void writeSummary();
+    void finish();
+};
+
+}
+
+
+static void onSigOptionsParsed(boost::program_options::variables_map& v)
+{
+    if(v.count("simulation-sweep")){
+        bool isNoWindowMode = v.count("no-window");
+        commandLineRunner.reset(new SimulationBatchRunner);
+        commandLineRunner->setExitOnCompletionEnabled(isNoWindowMode);
+        if(!commandLineRunner->loadSweepSpec(v["simulation-sweep"].as<string>()) ||
+           !commandLineRunner->start()){
+            if(isNoWindowMode){
+                App::exit(1);
+            }
+        }
+    }
+}
+
+
+void SimulationBatchRunner::initializeClass(ExtensionManager* ext)
+{
+    ext->optionManager()
+        .addOption("simulation-sweep", boost::program_options::value<string>(),
+                   "run the simulations specified in a sweep specification file")
+        .sigOptionsParsed(1).connect(onSigOptionsParsed);
+}
+
+
+SimulationBatchRunner::SimulationBatchRunner()
+{
+    impl = new Impl;
+}
+
+
+SimulationBatchRunner::Impl::Impl()
+{
+    timeLength = 0.0;
+    isTimeLengthSpecified = false;
+    maxConcurrency = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    isRecordingEnabled = false;
+    outputDirectory = filesystem::current_path();
+    isExitOnCompletionEnabled = false;
+    nextRunIndex = 0;
+    numActiveRuns = 0;
+    numFinishedRuns = 0;
+    numFailedRuns = 0;
+    timeBarSyncRunIndex = -1;
+    isRunning = false;
+    finalizeFinishedRunsLater.setFunction([this](){ finalizeFinishedRuns(); });
+    mv = MessageView::instance();
+}
+
+
+SimulationBatchRunner::~SimulationBatchRunner()
+{
+    stop();
+    delete impl;
+}
+
+
+/**
+   The pending finalization is cancelled by the destructor of the lazy caller, and the
+   connections to the simulator items are disconnected before the clones are removed.
+*/
+SimulationBatchRunner::Impl::~Impl()
+{
+    finalizeFinishedRunsLater.cancel();
+    for(auto& run : runs){
+        run->connection.disconnect();
+        if(run->worldItem){
+            run->worldItem->removeFromParentItem();
+        }
+    }
+}
+
+
+bool SimulationBatchRunner::loadSweepSpec(const std::string& filename)
+{
+    YAMLReader reader;
+    try {
+        reader.load(filename);
+        if(reader.numDocuments() == 0){
+            impl->mv->putln(format(_("Sweep specification file \"{0}\" is empty."), filename),
+                            MessageView::Error);
+            return false;
+        }
+        auto baseDirectory = filesystem::path(fromUTF8(filename)).parent_path();
+        return readSweepSpec(reader.document()->toMapping(), toUTF8(baseDirectory.string()));
+    }
+    catch(const ValueNode::Exception& ex){
+        impl->mv->putln(format(_("Sweep specification file \"{0}\" cannot be loaded: {1}"),
+                               filename, ex.message()),
+                        MessageView::Error);
+    }
+    return false;
+}
+
+
+bool SimulationBatchRunner::readSweepSpec(const Mapping* spec, const std::string& baseDirectory)
+{
+    try {
+        return impl->readSweepSpec(spec, baseDirectory);
+    }
+    catch(const ValueNode::Exception& ex){
+        impl->mv->putln(format(_("Invalid sweep specification: {0}"), ex.message()), MessageView::Error);
+    }
+    return false;
+}
+
+
+bool SimulationBatchRunner::Impl::readSweepSpec(const Mapping* spec, const string& baseDirectory)
+{
+    if(isRunning){
+        return false;
+    }
+
+    runs.clear();
+
+    spec->read("world", worldPath);
+    spec->read("simulator", simulatorPath);
+    isTimeLengthSpecified = spec->read("time_length", timeLength);
+    int n;
+    if(spec->read("max_concurrency", n)){
+        maxConcurrency = std::max(1, n);
+    }
+    spec->read("recording", isRecordingEnabled);
+    spec->read("exit_on_completion", isExitOnCompletionEnabled);
+
+    filesystem::path baseDir(fromUTF8(baseDirectory));
+    outputDirectory = baseDir;
+    string directory;
+    if(spec->read("output_directory", directory)){
+        filesystem::path path(fromUTF8(directory));
+        outputDirectory = path.is_absolute() ? path : baseDir / path;
+    }
+
+    vector<pair<string, MappingPtr>> baseRuns;
+    auto runNodes = spec->findListing("runs");
+    if(runNodes->isValid()){
+        for(int i=0; i < runNodes->size(); ++i){
+            auto runNode = runNodes->at(i)->toMapping();
+            string name = runNode->get("name", format("run{0}", i).c_str());
+            MappingPtr overrides;
+            auto overridesNode = runNode->findMapping("overrides");
+            if(overridesNode->isValid()){
+                overrides = overridesNode->cloneMapping();
+            } else {
+                overrides = new Mapping;
+            }
+            baseRuns.emplace_back(name, overrides);
+        }
+    }
+    if(baseRuns.empty()){
+        baseRuns.emplace_back("run", new Mapping);
+    }
+
+    struct GridAxis {
+        string itemPath;
+        string key;
+        ListingPtr values;
+    };
+    vector<GridAxis> axes;
+    auto gridNodes = spec->findListing("grid");
+    if(gridNodes->isValid()){
+        for(int i=0; i < gridNodes->size(); ++i){
+            auto axisNode = gridNodes->at(i)->toMapping();
+            GridAxis axis;
+            axis.itemPath = axisNode->get("item", "");
+            if(!axisNode->read("key", axis.key)){
+                axisNode->throwException(_("The key of the grid axis is not specified"));
+            }
+            axis.values = axisNode->findListing("values");
+            if(!axis.values->isValid() || axis.values->size() == 0){
+                axisNode->throwException(_("The values of the grid axis are not specified"));
+            }
+            axes.push_back(axis);
+        }
+    }
+
+    for(auto& baseRun : baseRuns){
+        if(axes.empty()){
+            addRun(baseRun.first, baseRun.second);
+            continue;
+        }
+        vector<int> indices(axes.size(), 0);
+        while(true){
+            MappingPtr overrides = baseRun.second->cloneMapping();
+            string name = baseRun.first;
+            for(size_t i=0; i < axes.size(); ++i){
+                auto& axis = axes[i];
+                overrides->openMapping(axis.itemPath)->insert(
+                    axis.key, axis.values->at(indices[i])->clone());
+                name += format("_{0}", indices[i]);
+            }
+            addRun(name, overrides);
+
+            // Advance the indices to the next combination
+            size_t i = 0;
+            while(i < axes.size()){
+                if(++indices[i] < axes[i].values->size()){
+                    break;
+                }
+                indices[i++] = 0;
+            }
+            if(i == axes.size()){
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+void SimulationBatchRunner::Impl::addRun(const string& name, MappingPtr overrides)
+{
+    auto run = new RunInfo;
+    run->name = name;
+    run->overrides = overrides;
+    runs.emplace_back(run);
+}
+
+
+void SimulationBatchRunner::setWorldItem(WorldItem* worldItem)
+{
+    impl->worldItem = worldItem;
+}
+
+
+void SimulationBatchRunner::setMaxConcurrency(int n)
+{
+    impl->maxConcurrency = std::max(1, n);
+}
+
+
+void SimulationBatchRunner::setOutputDirectory(const std::string& directory)
+{
+    impl->outputDirectory = fromUTF8(directory);
+}
+
+
+void SimulationBatchRunner::setExitOnCompletionEnabled(bool on)
+{
+    impl->isExitOnCompletionEnabled = on;
+}
+
+
+bool SimulationBatchRunner::start()
+{
+    return impl->start();
+}
+
+
+bool SimulationBatchRunner::Impl::start()
+{
+    if(isRunning){
+        return false;
+    }
+
+    if(!worldItem){
+        auto rootItem = RootItem::instance();
+        if(worldPath.empty()){
+            worldItem = rootItem->findItem<WorldItem>();
+        } else {
+            worldItem = rootItem->findItem<WorldItem>(worldPath);
+        }
+        if(!worldItem){
+            mv->putln(_("The world item to run the simulation sweep is not found."), MessageView::Error);
+            return false;
+        }
+    }
+    if(!worldItem->parentItem()){
+        mv->putln(format(_("World item \"{0}\" is not in the project item tree."), worldItem->displayName()),
+                  MessageView::Error);
+        return false;
+    }
+    if(runs.empty()){
+        addRun("run", new Mapping);
+    }
+
+    stdx::error_code ec;
+    filesystem::create_directories(outputDirectory, ec);
+    if(ec){
+        mv->putln(format(_("Output directory \"{0}\" cannot be created: {1}"),
+                         toUTF8(outputDirectory.string()), ec.message()),
+                  MessageView::Error);
+        return false;
+    }
+
+    for(auto& run : runs){
+        run->status = RunInfo::Waiting;
+        run->isFinalizationPending = false;
+        run->errorMessage.clear();
+        run->finalState.reset();
+    }
+    nextRunIndex = 0;
+    numActiveRuns = 0;
+    numFinishedRuns = 0;
+    numFailedRuns = 0;
+    timeBarSyncRunIndex = -1;
+    isRunning = true;
+    startTime = std::chrono::steady_clock::now();
+
+    mv->putln(format(_("Simulation sweep of {0} runs on \"{1}\" has been started with the concurrency of {2}."),
+                     runs.size(), worldItem->displayName(), maxConcurrency));
+
+    launchRuns();
+
+    return true;
+}
+
+
+void SimulationBatchRunner::Impl::launchRuns()
+{
+    while(isRunning && numActiveRuns < maxConcurrency && nextRunIndex < static_cast<int>(runs.size())){
+        if(launchRun(nextRunIndex++)){
+            ++numActiveRuns;
+        }
+    }
+    if(isRunning && numActiveRuns == 0 && nextRunIndex >= static_cast<int>(runs.size())){
+        finish();
+    }
+}
+
+
+/**
+   Each run is executed by the simulation thread of its own simulator item, so the
+   concurrency of the runs is bounded by limiting the number of the active clones.
+*/
+bool SimulationBatchRunner::Impl::launchRun(int runIndex)
+{
+    auto& run = *runs[runIndex];
+    CloneMap cloneMap;
+    run.worldItem = dynamic_cast<WorldItem*>(worldItem->cloneSubTree(cloneMap));
+    if(!run.worldItem){
+        failRun(run, _("The world item cannot be cloned."));
+        return false;
+    }
+    run.worldItem->setName(format("{0}-{1}", worldItem->name(), run.name));
+    worldItem->parentItem()->addChildItem(run.worldItem);
+
+    if(!applyOverrides(run)){
+        return false;
+    }
+
+    if(simulatorPath.empty()){
+        run.simulatorItem = run.worldItem->findItem<SimulatorItem>();
+    } else {
+        run.simulatorItem = run.worldItem->findItem<SimulatorItem>(simulatorPath);
+    }
+    if(!run.simulatorItem){
+        failRun(run, _("The simulator item is not found."));
+        return false;
+    }
+
+    auto simulator = run.simulatorItem;
+    if(isTimeLengthSpecified){
+        simulator->setTimeRangeMode(SimulatorItem::SpecifiedTime);
+        simulator->setTimeLength(timeLength);
+    }
+    simulator->setRealtimeSyncMode(SimulatorItem::NonRealtimeSync);
+    if(!isRecordingEnabled){
+        simulator->setRecordingMode(SimulatorItem::NoRecording);
+    }
+    // Only one of the concurrent runs drives the time bar
+    bool doSyncTimeBar = (timeBarSyncRunIndex < 0);
+    simulator->setTimeBarSyncEnabled(doSyncTimeBar);
+
+    run.connection = simulator->sigSimulationFinished().connect(
+        [this, runIndex](bool isForced){ onRunFinished(runIndex, isForced); });
+
+    run.status = RunInfo::Running;
+    run.startTime = std::chrono::steady_clock::now();
+
+    if(!simulator->startSimulation(true)){
+        run.connection.disconnect();
+        failRun(run, _("The simulation cannot be started."));
+        return false;
+    }
+    if(doSyncTimeBar){
+        timeBarSyncRunIndex = runIndex;
+    }
+
+    return true;
+}
+
+
+bool SimulationBatchRunner::Impl::applyOverrides(RunInfo& run)
+{
+    auto projectFile = ProjectManager::instance()->currentProjectFile();
+
+    for(auto& kv : *run.overrides){
+        auto& path = kv.first;
+        Item* item = path.empty() ? run.worldItem.get() : run.worldItem->findItem(path);
+        if(!item){
+            failRun(run, format(_("Item \"{0}\" to overwrite is not found."), path));
+            return false;
+        }
+        auto values = kv.second->toMapping();
+        ArchivePtr archive = new Archive;
+        archive->initSharedInfo(projectFile, false);
+        if(!item->store(*archive)){
+            failRun(run, format(_("The properties of item \"{0}\" cannot be stored."), path));
+            return false;
+        }
+        for(auto& value : *values){
+            archive->insert(value.first, value.second->clone());
+        }
+        if(!item->restore(*archive)){
+            failRun(run, format(_("The properties of item \"{0}\" cannot be overwritten."), path));
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void SimulationBatchRunner::Impl::onRunFinished(int runIndex, bool isForced)
+{
+    auto& run = *runs[runIndex];
+    if(run.status != RunInfo::Running){
+        return;
+    }
+    run.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - run.startTime).count();
+    run.simulationTime = run.simulatorItem->simulationTime();
+    run.numFrames = run.simulatorItem->simulationFrame();
+    run.status = isForced ? RunInfo::Stopped : RunInfo::Completed;
+    run.connection.disconnect();
+
+    // The clone must not be removed in the handler of the simulator item in it
+    run.isFinalizationPending = true;
+    finalizeFinishedRunsLater();
+}
+
+
+void SimulationBatchRunner::Impl::finalizeFinishedRuns()
+{
+    for(size_t i=0; i < runs.size(); ++i){
+        if(runs[i]->isFinalizationPending){
+            finalizeRun(i);
+        }
+    }
+}
+
+
+void SimulationBatchRunner::Impl::finalizeRun(int runIndex)
+{
+    auto& run = *runs[runIndex];
+    run.isFinalizationPending = false;
+    if(runIndex == timeBarSyncRunIndex){
+        timeBarSyncRunIndex = -1;
+    }
+    recordFinalState(run);
+    writeRunLog(run);
+    if(run.worldItem){
+        run.worldItem->removeFromParentItem();
+    }
+    run.simulatorItem.reset();
+    run.worldItem.reset();
+
+    ++numFinishedRuns;
+    --numActiveRuns;
+
+    mv->putln(format(_("Simulation sweep: run \"{0}\" {1} ({2} / {3})."),
+                     run.name, statusLabel(run.status), numFinishedRuns, runs.size()));
+
+    launchRuns();
+}
+
+
+void SimulationBatchRunner::Impl::failRun(RunInfo& run, const string& message)
+{
+    run.status = RunInfo::Failed;
+    run.errorMessage = message;
+    writeRunLog(run);
+    if(run.worldItem){
+        run.worldItem->removeFromParentItem();
+    }
+    run.simulatorItem.reset();
+    run.worldItem.reset();
+
+    ++numFinishedRuns;
+    ++numFailedRuns;
+
+    mv->putln(format(_("Simulation sweep: run \"{0}\" failed: {1}"), run.name, message),
+              MessageView::Error);
+}
+
+
+void SimulationBatchRunner::Impl::recordFinalState(RunInfo& run)
+{
+    if(!run.worldItem){
+        return;
+    }
+    run.finalState = new Mapping;
+    auto bodies = run.finalState->createListing("bodies");
+    for(auto& bodyItem : run.worldItem->descendantItems<BodyItem>()){
+        auto body = bodyItem->body();
+        MappingPtr node = new Mapping;
+        node->write("name", bodyItem->name(), DOUBLE_QUOTED);
+        auto rootLink = body->rootLink();
+        write(*node, "root_position", Vector3(rootLink->translation()));
+        write(*node, "root_rpy", degree(rpyFromRot(rootLink->rotation())));
+        int numJoints = body->numJoints();
+        if(numJoints > 0){
+            auto& qlist = *node->createFlowStyleListing("joint_positions");
+            for(int i=0; i < numJoints; ++i){
+                auto joint = body->joint(i);
+                qlist.append(joint->isRevoluteJoint() ? degree(joint->q()) : joint->q(), 10, numJoints);
+            }
+        }
+        bodies->append(node);
+    }
+}
+
+
+void SimulationBatchRunner::Impl::writeRunLog(RunInfo& run)
+{
+    MappingPtr log = new Mapping;
+    log->write("name", run.name, DOUBLE_QUOTED);
+    log->write("status", statusLabel(run.status));
+    if(!run.errorMessage.empty()){
+        log->write("error", run.errorMessage, DOUBLE_QUOTED);
+    }
+    if(!run.overrides->empty()){
+        log->insert("overrides", run.overrides->cloneMapping());
+    }
+    if(run.status != RunInfo::Failed){
+        log->write("simulation_time", run.simulationTime);
+        log->write("frames", run.numFrames);
+        log->write("wall_time", run.wallTime);
+        if(run.wallTime > 0.0){
+            log->write("realtime_factor", run.simulationTime / run.wallTime);
+        }
+    }
+    if(run.finalState){
+        log->insert("bodies", run.finalState->get("bodies").clone());
+    }
+
+    auto filename = toUTF8((outputDirectory / fromUTF8(run.name + ".yaml")).string());
+    YAMLWriter writer(filename);
+    if(!writer.isFileOpen()){
+        mv->putln(format(_("Log file \"{0}\" cannot be written."), filename), MessageView::Error);
+        return;
+    }
+    writer.setKeyOrderPreservationMode(true);
+    writer.putNode(log);
+}
+
+
+void SimulationBatchRunner::Impl::writeSummary()
+{
+    auto filename = outputDirectory / "summary.csv";
+    std::ofstream ofs(filename.string());
+    if(!ofs){
+        mv->putln(format(_("Summary file \"{0}\" cannot be written."), toUTF8(filename.string())),
+                  MessageView::Error);
+        return;
+    }
+    ofs << "name,status,simulation_time,frames,wall_time,realtime_factor\n";
+    for(auto& run : runs){
+        double factor = run->wallTime > 0.0 ? run->simulationTime / run->wallTime : 0.0;
+        ofs << format("{0},{1},{2},{3},{4},{5}\n",
+                      quoteCsvField(run->name), statusLabel(run->status), run->simulationTime, run->numFrames,
+                      run->wallTime, factor);
+    }
+}
+
+
+void SimulationBatchRunner::Impl::finish()
+{
+    isRunning = false;
+    writeSummary();
+
+    double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    mv->putln(format(_("Simulation sweep has been finished: {0} of {1} runs succeeded in {2:.3f} [s]."),
+                     numFinishedRuns - numFailedRuns, runs.size(), wallTime),
+              numFailedRuns > 0 ? MessageView::Warning : MessageView::Normal);
+
+    sigFinished();
+
+    if(isExitOnCompletionEnabled){
+        App::exit(numFailedRuns > 0 ? 1 : 0);
+    }
+}
+
+
+void SimulationBatchRunner::stop()
+{
+    if(!impl->isRunning){
+        return;
+    }
+    impl->nextRunIndex = impl->runs.size();
+    for(auto& run : impl->runs){
+        if(run->status == RunInfo::Running && run->simulatorItem){
+            run->simulatorItem->stopSimulation(true);
+        }
+    }
+}
+
+
+bool SimulationBatchRunner::isRunning() const
+{
+    return impl->isRunning;
+}
+
+
+int SimulationBatchRunner::numRuns() const
+{
+    return impl->runs.size();
+}
+
+
+int SimulationBatchRunner::numFinishedRuns() const
+{
+    return impl->numFinishedRuns;
+}
+
+
+int SimulationBatchRunner::numFailedRuns() const
+{
+    return impl->numFailedRuns;
+}
+
+
+SignalProxy<void()> SimulationBatchRunner::sigFinished()
+{
+    return impl->sigFinished;
+}
@@ -0,0 +1,78 @@
+#ifndef CNOID_BODY_PLUGIN_SIMULATION_BATCH_RUNNER_H
+#define CNOID_BODY_PLUGIN_SIMULATION_BATCH_RUNNER_H
+
+#include <cnoid/Signal>
+#include <string>
+#include "exportdecl.h"
+
+namespace cnoid {
+
+class ExtensionManager;
+class WorldItem;
+class Mapping;
+
+/**
+   This class runs the simulations of the variants of a world in the current project.
+   The world item sub tree is cloned for each run and the properties of the items in
+   the clone are overwritten with the values given in a sweep specification. The runs
+   are executed concurrently up to the maximum number of concurrent runs, and the log
+   of each run and the summary of all the runs are output to the output directory.
+
+   The sweep specification is a YAML file in the following format:
+
+   world: World                   # Path of the world item (optional)
+   simulator: AISTSimulator       # Path of the simulator item in the world (optional)
+   time_length: 10.0              # Simulation time of each run (optional)
+   max_concurrency: 4             # Default is the number of hardware threads
+   recording: false               # Whether the simulation results are recorded
+   output_directory: sweep        # Relative to the directory of the specification file
+   exit_on_completion: true       # Default is true in the no-window mode
+   runs:
+     - name: low_friction
+       overrides:
+         AISTSimulator: { dynamicFriction: 0.3 }
+         PA10/PA10Controller: { controllerOptions: "kp=300" }
+   grid:
+     - item: PA10
+       key: initialRootPosition
+       values: [ [ 0, 0, 0 ], [ 0, 0, 0.1 ] ]
+
+   The keys of the overrides are the item paths in the world, and the values are the
+   elements of the item archive written by the store function of the item. When the grid
+   is given, each run is combined with all the combinations of the grid values.
+*/
+class CNOID_EXPORT SimulationBatchRunner
+{
+public:
+    static void initializeClass(ExtensionManager* ext);
+
+    SimulationBatchRunner();
+    ~SimulationBatchRunner();
+
+    bool loadSweepSpec(const std::string& filename);
+    bool readSweepSpec(const Mapping* spec, const std::string& baseDirectory);
+
+    void setWorldItem(WorldItem* worldItem);
+    void setMaxConcurrency(int n);
+    void setOutputDirectory(const std::string& directory);
+    void setExitOnCompletionEnabled(bool on);
+
+    bool start();
+    void stop();
+    bool isRunning() const;
+
+    int numRuns() const;
+    int numFinishedRuns() const;
+    int numFailedRuns() const;
+
+    SignalProxy<void()> sigFinished();
+
+    class Impl;
+
+private:
+    Impl* impl;
+};
+
+}
+
+#endif
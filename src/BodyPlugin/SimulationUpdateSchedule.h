@@ -0,0 +1,53 @@
+#ifndef CNOID_BODY_PLUGIN_SIMULATION_UPDATE_SCHEDULE_H
+#define CNOID_BODY_PLUGIN_SIMULATION_UPDATE_SCHEDULE_H
+
+#include <string>
+#include <algorithm>
+#include <cmath>
+
+namespace cnoid {
+
+/**
+   The update timing of a sub simulator item or a controller updated at a lower rate than
+   the simulation world. The rate is rounded to the frame interval of the world, and the item
+   is updated at the frames where frame % interval == phase.
+*/
+class SimulationUpdateSchedule
+{
+public:
+    SimulationUpdateSchedule(double rate, double phaseOffset, double worldFrameRate)
+    {
+        interval_ = std::max(1L, std::lround(worldFrameRate / rate));
+        phase_ = std::lround(phaseOffset * worldFrameRate) % interval_;
+        isUpdateFrame_ = false;
+        numUpdates_ = 0;
+    }
+
+    const std::string& name() const { return name_; }
+    void setName(const std::string& name) { name_ = name; }
+    int interval() const { return interval_; }
+    int phase() const { return phase_; }
+
+    void update(int frame){
+        isUpdateFrame_ = (frame % interval_ == phase_);
+        if(isUpdateFrame_){
+            ++numUpdates_;
+        }
+    }
+
+    //! This is true if the item is updated in the current frame
+    bool isUpdateFrame() const { return isUpdateFrame_; }
+
+    int numUpdates() const { return numUpdates_; }
+
+private:
+    std::string name_;
+    int interval_;
+    int phase_;
+    bool isUpdateFrame_;
+    int numUpdates_;
+};
+
+}
+
+#endif
@@ -0,0 +1,84 @@
+/**
+   This program checks the frames at which SimulatorItem calls the functions of the items
+   that have a lower update rate than the simulation world.
+*/
+
+#include "SimulationUpdateSchedule.h"
+#include <vector>
+#include <iostream>
+
+using namespace std;
+using namespace cnoid;
+
+namespace {
+
+int numFailures = 0;
+
+void check(bool condition, const string& message)
+{
+    if(!condition){
+        cerr << "FAILED: " << message << endl;
+        ++numFailures;
+    }
+}
+
+
+/*
+  Steps the frames in the same way as SimulatorItem::Impl::stepSimulationMain and
+  returns the frames at which the scheduled function is called.
+*/
+vector<int> runFrames(SimulationUpdateSchedule& schedule, int numFrames)
+{
+    vector<int> calledFrames;
+    for(int frame = 0; frame < numFrames; ++frame){
+        schedule.update(frame);
+        if(schedule.isUpdateFrame()){
+            calledFrames.push_back(frame);
+        }
+    }
+    return calledFrames;
+}
+
+
+void checkCalledFrames(double rate, double phaseOffset, double worldFrameRate, int expectedInterval, int expectedPhase)
+{
+    const int numFrames = 1000;
+    string label = "rate " + to_string(rate) + ", phase offset " + to_string(phaseOffset);
+
+    SimulationUpdateSchedule schedule(rate, phaseOffset, worldFrameRate);
+    check(schedule.interval() == expectedInterval, label + ": interval " + to_string(schedule.interval()));
+    check(schedule.phase() == expectedPhase, label + ": phase " + to_string(schedule.phase()));
+
+    auto calledFrames = runFrames(schedule, numFrames);
+    vector<int> expectedFrames;
+    for(int frame = expectedPhase; frame < numFrames; frame += expectedInterval){
+        expectedFrames.push_back(frame);
+    }
+    check(calledFrames == expectedFrames, label + ": called frames");
+    check(schedule.numUpdates() == static_cast<int>(expectedFrames.size()), label + ": number of updates");
+}
+
+}
+
+
+int main()
+{
+    // 100 Hz in the 1 kHz world is called at every 10th frame at its phase
+    checkCalledFrames(100.0, 0.0, 1000.0, 10, 0);
+    checkCalledFrames(100.0, 0.003, 1000.0, 10, 3);
+    checkCalledFrames(100.0, 0.013, 1000.0, 10, 3);
+
+    // The rate that does not divide the world frame rate is rounded to the nearest interval
+    checkCalledFrames(300.0, 0.0, 1000.0, 3, 0);
+    checkCalledFrames(30.0, 0.01, 1000.0, 33, 10);
+
+    // The rate higher than the world frame rate is called at every frame
+    checkCalledFrames(2000.0, 0.0, 1000.0, 1, 0);
+
+    if(numFailures > 0){
+        cerr << numFailures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All checks passed." << endl;
+    return 0;
+}
@@ -9,6 +9,7 @@
 #include "WorldLogFileItem.h"
 #include "CollisionSeqItem.h"
 #include "CollisionSeqEngine.h"
+#include "SimulationUpdateSchedule.h"
 #include <cnoid/ExtensionManager>
 #include <cnoid/ItemManager>
 #include <cnoid/MenuManager>
@@ -38,9 +39,21 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <sstream>
 #include <set>
+#include <algorithm>
 #include <deque>
 #include <fmt/format.h>
+#ifdef __linux__
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstring>
+#endif
 #include "gettext.h"
 
 using namespace std;
@@ -51,9 +64,85 @@ namespace {
 
 enum { RESOLUTION_TIMESTEP, RESOLUTION_FRAMERATE, RESOLUTION_TIMEBAR, N_TEMPORARL_RESOLUTION_TYPES };
 
-const char* realtimeSyncModeSymbols[] = { "off", "compensatory", "conservative" };
+const char* realtimeSyncModeSymbols[] = { "off", "compensatory", "conservative", "precise" };
 static const char* timeRangeModeSymbols[] = { "unlimited", "specified", "timebar" };
 
+/*
+  The last part of the wait for a frame deadline is done by the busy wait
+  to absorb the wakeup latency of the sleep.
+*/
+constexpr int64_t spinWaitMargin = 200000; // [ns]
+
+int64_t getMonotonicTime()
+{
+#ifdef __linux__
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+void waitUntil(int64_t deadline)
+{
+    const int64_t sleepDeadline = deadline - spinWaitMargin;
+    if(getMonotonicTime() < sleepDeadline){
+#ifdef __linux__
+        timespec ts;
+        ts.tv_sec = sleepDeadline / 1000000000;
+        ts.tv_nsec = sleepDeadline % 1000000000;
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR){ }
+#else
+        std::this_thread::sleep_until(
+            std::chrono::steady_clock::time_point(std::chrono::nanoseconds(sleepDeadline)));
+#endif
+    }
+    while(getMonotonicTime() < deadline){ }
+}
+
+
+string getCpuListString(const vector<int>& cpus)
+{
+    string s;
+    for(size_t i=0; i < cpus.size(); ++i){
+        if(i > 0){
+            s += ",";
+        }
+        s += std::to_string(cpus[i]);
+    }
+    return s;
+}
+
+
+bool parseCpuListString(const string& s, vector<int>& out_cpus)
+{
+    vector<int> cpus;
+    std::istringstream is(s);
+    string token;
+    while(std::getline(is, token, ',')){
+        auto p = token.find_first_not_of(" \t");
+        if(p == string::npos){
+            continue;
+        }
+        size_t n;
+        int cpu;
+        try {
+            cpu = std::stoi(token.substr(p), &n);
+        } catch(...){
+            return false;
+        }
+        if(cpu < 0 || token.find_first_not_of(" \t", p + n) != string::npos){
+            return false;
+        }
+        cpus.push_back(cpu);
+    }
+    out_cpus = cpus;
+    return true;
+}
+
 typedef map<weak_ref_ptr<BodyItem>, SimulationBodyPtr> BodyItemToSimBodyMap;
 
 struct FunctionSet
@@ -61,6 +150,7 @@ struct FunctionSet
     struct FunctionInfo {
         int id;
         std::function<void()> function;
+        SimulationUpdateSchedule* schedule; // nullptr if the function is called at every frame
     };
     vector<FunctionInfo> functions;
     std::mutex mutex;
@@ -89,7 +179,10 @@ struct FunctionSet
         }
         const size_t n = functions.size();
         for(size_t i=0; i < n; ++i){
-            functions[i].function();
+            auto& info = functions[i];
+            if(!info.schedule || info.schedule->isUpdateFrame()){
+                info.function();
+            }
         }
     }
 
@@ -113,6 +206,7 @@ public:
     bool isControlRequested;
     bool isControlFinished;
     bool isControlToBeContinued;
+    SimulationUpdateSchedule* updateSchedule; // nullptr if the controller is updated at every frame
 
     std::mutex logMutex;
     ReferencedPtr lastLogFrameObject;
@@ -140,17 +234,28 @@ public:
     bool isLogEnabled() const;
     virtual void outputLogFrame(Referenced* logFrame) override;
     void flushLog();
+    void truncateLog(int frame);
 
     virtual bool isNoDelayMode() const override;
     virtual bool setNoDelayMode(bool on) override;
     virtual bool isSimulationFromInitialState() const override;
 
+    bool isUpdateFrame() const { return !updateSchedule || updateSchedule->isUpdateFrame(); }
     bool waitForControlInThreadToFinish();
     void concurrentControlLoop();    
 };
 
 typedef ref_ptr<ControllerInfo> ControllerInfoPtr;
 
+template<class SeqType>
+void truncateSeq(SeqType& seq, int frame)
+{
+    const int numFrames = std::max(0, frame - seq.offsetTimeFrame());
+    if(numFrames < seq.numFrames()){
+        seq.setNumFrames(numFrames);
+    }
+}
+
 class SimulationLogEngine : public TimeSyncItemEngine
 {
 public:
@@ -202,6 +307,15 @@ public:
     vector<bool> deviceStateChangeFlag;
     unique_ptr<MultiDeviceStateSeq> deviceStateBuf;
 
+    /*
+      The device states released from the buffers and records are reused for the
+      subsequent states of the same devices instead of cloning new states. The states
+      are released in the order of the buffering, so only the front of each pool is
+      checked.
+    */
+    vector<deque<DeviceStatePtr>> deviceStatePools;
+    bool isDeviceStatePoolEnabled;
+
     // For the direct output without recording mode
     unique_ptr<BodyMotionEngineCore> bodyMotionEngine;
     unique_ptr<BodyPositionSeq> lastPositionBuf;
@@ -227,9 +341,11 @@ public:
     void initializeRecordItems();
     void bufferRecords();
     void bufferBodyPosition(Body* body, BodyPositionSeqFrameBlock& block);
+    DeviceState* getPooledDeviceState(int deviceIndex, Device* device);
     void flushRecords();
     void flushRecordsToBodyMotionItems();
     void flushRecordsToLastStateBuffers();
+    void truncateRecords(int frame);
     void updateFrontendBodyStatelWithLastRecords(double time);
     void flushRecordsToWorldLogFile(int bufferFrame);
 };
@@ -264,6 +380,12 @@ public:
     FunctionSet preDynamicsFunctions;
     FunctionSet midDynamicsFunctions;
     FunctionSet postDynamicsFunctions;
+
+    vector<unique_ptr<SimulationUpdateSchedule>> updateSchedules;
+    // Schedules of the items that failed to start. They are kept until the simulation is cleared
+    // because the functions added by the items may refer to them.
+    vector<unique_ptr<SimulationUpdateSchedule>> retiredUpdateSchedules;
+    SimulationUpdateSchedule* scheduleOfFunctionsToAdd;
     
     vector<SimulationBody::Impl*> simBodyImplsToNotifyRecords;
     ItemList<SubSimulatorItem> subSimulatorItems;
@@ -276,10 +398,15 @@ public:
 
     shared_ptr<CollisionSeq> collisionSeq;
     deque<shared_ptr<CollisionLinkPairList>> collisionPairsBuf;
+    shared_ptr<CollisionLinkPairList> lastCollisionPairs;
 
     Selection recordingMode;
     Selection timeRangeMode;
     Selection realtimeSyncMode;
+    int realtimeThreadPriority;
+    vector<int> realtimeCpus;
+    bool isRealtimeMemoryLockEnabled;
+    bool isMemoryLocked;
     double timeLength;
     int maxFrame;
     int ringBufferSize;
@@ -297,6 +424,8 @@ public:
     bool isCollisionDataRecordingEnabled;
     bool doRecordCollisionData;
     bool isSceneViewEditModeBlockedDuringSimulation;
+    bool isTimeBarSyncEnabled;
+    bool isTimeBarSyncActive;
 
     string controllerOptionString_;
 
@@ -315,6 +444,19 @@ public:
     Signal<void()> sigSimulationResumed;
     Signal<void(bool isForced)> sigSimulationFinished;
 
+    double snapshotInterval;
+    int maxNumSnapshots;
+    int snapshotIntervalFrames;
+    int snapshotSessionId;
+    deque<SimulationSnapshotPtr> snapshots;
+    mutable std::mutex snapshotMutex;
+    std::atomic<bool> isSimulationLoopPaused;
+
+    mutable std::mutex deadlineMissMutex;
+    SimulatorItem::DeadlineMissStatistics deadlineMissStatistics;
+    std::atomic<bool> isDeadlineMissNotificationPending;
+    Signal<void()> sigDeadlineMissStatisticsUpdated;
+
     WorldLogFileItemPtr worldLogFileItem;
     int nextLogFrame;
     double nextLogTime;
@@ -353,6 +495,8 @@ public:
     ~Impl();
     void findTargetItems(Item* item, bool isUnderBodyItem, ItemList<Item>& out_targetItems);
     void clearSimulation();
+    SimulationUpdateSchedule* createUpdateSchedule(Item* item, double rate, double phaseOffset);
+    void retireUpdateSchedule(SimulationUpdateSchedule* schedule);
     void setSimulatorItemToControllerItem(ControllerItem* controllerItem);
     void resetSimulatorItemForControllerItem(ControllerItem* controllerItem);
     bool startSimulation(bool doReset);
@@ -361,6 +505,18 @@ public:
     void onSimulationLoopStarted();
     void updateSimBodyLists();
     bool stepSimulationMain();
+    void runPreciseRealtimeSyncLoop(int& frame, double& elapsedTime, bool& isOnPause, QElapsedTimer& timer);
+    void applyRealtimeThreadAttributes(int threadIndex);
+    void lockMemory();
+    void unlockMemory();
+    void resetDeadlineMissStatistics();
+    void updateDeadlineMissStatistics(double lateness);
+    SimulationSnapshotPtr createSnapshot();
+    void addSnapshot(SimulationSnapshot* snapshot);
+    SimulationSnapshot* takeSnapshot();
+    bool waitForSimulationLoopToPause();
+    bool restoreSnapshot(SimulationSnapshot* snapshot);
+    void truncateRecords(int frame);
     void bufferRecords();
     void bufferCollisionRecords();
     void startFlushTimer();
@@ -385,6 +541,18 @@ public:
     SimulationLogEngine* getOrCreateLogEngine();
 };
 
+
+class SimulationSnapshot::Impl
+{
+public:
+    int sessionId;
+    int frame;
+    double time;
+    ReferencedPtr simulatorState;
+    vector<vector<DeviceStatePtr>> deviceStates;
+    vector<ReferencedPtr> controllerStates;
+};
+
 }
 
 namespace {
@@ -512,10 +680,14 @@ ControllerInfo::ControllerInfo(ControllerItem* controller, SimulationBody::Impl*
       simBodyImpl(simBodyImpl),
       body_(simBodyImpl->body_),
       simImpl(simBodyImpl->simImpl),
+      isControlToBeContinued(true),
+      updateSchedule(nullptr),
       isLogEnabled_(false),
       isSimulationFromInitialState_(simImpl->isSimulationFromInitialState)
 {
     if(controller){
+        updateSchedule = simImpl->createUpdateSchedule(
+            controller, controller->updateRate(), controller->updatePhaseOffset());
         // ControllerInfo cannot directly set a simulator item to the controller item
         // because ControllerItem::setSimulatorItem is a private function.
         simImpl->setSimulatorItemToControllerItem(controller);
@@ -553,6 +725,9 @@ std::ostream& ControllerInfo::os() const
 
 double ControllerInfo::timeStep() const
 {
+    if(updateSchedule){
+        return updateSchedule->interval() * simImpl->worldTimeStep_;
+    }
     return simImpl->worldTimeStep_;
 }
     
@@ -661,6 +836,22 @@ void ControllerInfo::flushLog()
 }
 
 
+//! The log frames before the frame are kept. The log must have been flushed before calling this function.
+void ControllerInfo::truncateLog(int frame)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+
+    truncateSeq(*log, frame);
+    logBuf->clear();
+    logBufFrameOffset = log->numFrames();
+    if(log->empty()){
+        lastLogFrameObject.reset();
+    } else {
+        lastLogFrameObject = log->back();
+    }
+}
+
+
 bool ControllerInfo::isNoDelayMode() const
 {
     return controller->isNoDelayMode();
@@ -896,6 +1087,8 @@ void SimulationBody::Impl::initializeRecordBuffers()
     deviceStateChangeFlag.clear();
     deviceStateChangeFlag.resize(numDevices, true); // set all the bits to store the initial states
     deviceStateBuf.reset();
+    deviceStatePools.clear();
+    isDeviceStatePoolEnabled = false;
     
     deviceStateEngine.reset();
     lastDeviceStateBuf.reset();
@@ -910,6 +1103,13 @@ void SimulationBody::Impl::initializeRecordBuffers()
 
         // This buf always has the first element to keep unchanged states
         deviceStateBuf->setDimension(1, numDevices); 
+
+        // The states are never released when all the frames are recorded
+        if(!simImpl->isRecordingEnabled || simImpl->ringBufferSize < std::numeric_limits<int>::max()){
+            deviceStatePools.resize(numDevices);
+            isDeviceStatePoolEnabled = true;
+        }
+        
         for(size_t i=0; i < devices.size(); ++i){
             deviceStateConnections.add(
                 devices[i]->sigStateChanged().connect(
@@ -1032,7 +1232,11 @@ void SimulationBody::Impl::bufferRecords()
         const DeviceList<>& devices = body_->devices();
         for(size_t i=0; i < devices.size(); ++i){
             if(deviceStateChangeFlag[i]){
-                currentFrame[i] = devices[i]->cloneState();
+                if(isDeviceStatePoolEnabled){
+                    currentFrame[i] = getPooledDeviceState(i, devices[i]);
+                } else {
+                    currentFrame[i] = devices[i]->cloneState();
+                }
                 deviceStateChangeFlag[i] = false;
             } else {
                 currentFrame[i] = prevFrame[i];
@@ -1054,6 +1258,25 @@ void SimulationBody::Impl::bufferBodyPosition(Body* body, BodyPositionSeqFrameBl
 }
 
 
+DeviceState* SimulationBody::Impl::getPooledDeviceState(int deviceIndex, Device* device)
+{
+    auto& pool = deviceStatePools[deviceIndex];
+
+    // The state only referenced by the pool is not used by any buffers and records
+    if(!pool.empty() && pool.front().use_count() == 1){
+        DeviceStatePtr state = pool.front();
+        pool.pop_front();
+        state->copyStateFrom(*device);
+        pool.push_back(state);
+        return state;
+    }
+
+    DeviceState* state = device->cloneState();
+    pool.push_back(state);
+    return state;
+}
+
+
 void SimulationBody::flushRecords()
 {
     impl->flushRecords();
@@ -1085,14 +1308,15 @@ void SimulationBody::Impl::flushRecordsToBodyMotionItems()
     bool offsetChanged = false;
 
     for(int i=0; i < currentPositionBufIndex; ++i){
+        auto& srcFrame = positionBuf->frame(i);
         if(positionRecord->numFrames() < ringBufferSize){
-            positionRecord->append();
+            positionRecord->append() = srcFrame;
         } else {
             positionRecord->rotate();
+            // The storage of the frame released from the ring buffer is reused by the buffer
+            std::swap(positionRecord->back(), srcFrame);
             offsetChanged = true;
         }
-        auto& srcFrame = positionBuf->frame(i);
-        positionRecord->back() = srcFrame;
     }
 
     if(deviceStateBuf){
@@ -1143,6 +1367,18 @@ void SimulationBody::Impl::flushRecordsToLastStateBuffers()
 }
 
 
+//! The records before the frame are kept. The records must have been flushed before calling this function.
+void SimulationBody::Impl::truncateRecords(int frame)
+{
+    if(positionRecord){
+        truncateSeq(*positionRecord, frame);
+    }
+    if(deviceStateRecord){
+        truncateSeq(*deviceStateRecord, frame);
+    }
+}
+
+
 // This function is called in the no-recording mode.
 void SimulationBody::Impl::updateFrontendBodyStatelWithLastRecords(double time)
 {
@@ -1222,6 +1458,9 @@ SimulatorItem::Impl::Impl(SimulatorItem* self)
     worldFrameRate = 1.0;
     worldTimeStep_ = 1.0;
     frameAtLastBufferWriting = 0;
+    scheduleOfFunctionsToAdd = nullptr;
+    isTimeBarSyncEnabled = true;
+    isTimeBarSyncActive = false;
     flushTimer.sigTimeout().connect([&](){ flushRecords(); });
 
     recordingMode.setSymbol(FullRecording, N_("full"));
@@ -1237,7 +1476,19 @@ SimulatorItem::Impl::Impl(SimulatorItem* self)
     realtimeSyncMode.setSymbol(NonRealtimeSync, N_("Off"));
     realtimeSyncMode.setSymbol(CompensatoryRealtimeSync, N_("On (Compensatory)"));
     realtimeSyncMode.setSymbol(ConservativeRealtimeSync, N_("On (Conservative)"));
+    realtimeSyncMode.setSymbol(PreciseRealtimeSync, N_("On (Precise)"));
     realtimeSyncMode.select(CompensatoryRealtimeSync);
+    realtimeThreadPriority = 0;
+    isRealtimeMemoryLockEnabled = false;
+    isMemoryLocked = false;
+    resetDeadlineMissStatistics();
+    isDeadlineMissNotificationPending = false;
+
+    snapshotInterval = 0.0;
+    maxNumSnapshots = 10;
+    snapshotIntervalFrames = 0;
+    snapshotSessionId = 0;
+    isSimulationLoopPaused = false;
 
     timeLength = 180.0; // 3 min.
     useControllerThreadsProperty = true;
@@ -1270,6 +1521,11 @@ SimulatorItem::Impl::Impl(SimulatorItem* self, const Impl& org)
     recordingMode = org.recordingMode;
     timeRangeMode = org.timeRangeMode;
     realtimeSyncMode = org.realtimeSyncMode;
+    realtimeThreadPriority = org.realtimeThreadPriority;
+    realtimeCpus = org.realtimeCpus;
+    isRealtimeMemoryLockEnabled = org.isRealtimeMemoryLockEnabled;
+    snapshotInterval = org.snapshotInterval;
+    maxNumSnapshots = org.maxNumSnapshots;
 
     timeLength = org.timeLength;
     useControllerThreadsProperty = org.useControllerThreadsProperty;
@@ -1391,12 +1647,247 @@ void SimulatorItem::setRealtimeSyncMode(int mode)
 }
 
 
+int SimulatorItem::realtimeSyncMode() const
+{
+    return impl->realtimeSyncMode.which();
+}
+
+
+void SimulatorItem::setTimeBarSyncEnabled(bool on)
+{
+    impl->isTimeBarSyncEnabled = on;
+}
+
+
+bool SimulatorItem::isTimeBarSyncEnabled() const
+{
+    return impl->isTimeBarSyncEnabled;
+}
+
+
 void SimulatorItem::setRealtimeSyncMode(bool on)
 {
     impl->realtimeSyncMode.select(on ? CompensatoryRealtimeSync : NonRealtimeSync);
 }
 
 
+void SimulatorItem::setRealtimeThreadPriority(int priority)
+{
+    impl->realtimeThreadPriority = std::max(0, priority);
+}
+
+
+int SimulatorItem::realtimeThreadPriority() const
+{
+    return impl->realtimeThreadPriority;
+}
+
+
+void SimulatorItem::setRealtimeCpus(const std::vector<int>& cpus)
+{
+    impl->realtimeCpus = cpus;
+}
+
+
+const std::vector<int>& SimulatorItem::realtimeCpus() const
+{
+    return impl->realtimeCpus;
+}
+
+
+void SimulatorItem::setRealtimeMemoryLockEnabled(bool on)
+{
+    impl->isRealtimeMemoryLockEnabled = on;
+}
+
+
+bool SimulatorItem::isRealtimeMemoryLockEnabled() const
+{
+    return impl->isRealtimeMemoryLockEnabled;
+}
+
+
+const double SimulatorItem::DeadlineMissStatistics::HistogramBinUpperBounds[] = {
+    0.0001, 0.0005, 0.001, 0.005, 0.01
+};
+
+
+SimulatorItem::DeadlineMissStatistics SimulatorItem::deadlineMissStatistics() const
+{
+    std::lock_guard<std::mutex> lock(impl->deadlineMissMutex);
+    return impl->deadlineMissStatistics;
+}
+
+
+SignalProxy<void()> SimulatorItem::sigDeadlineMissStatisticsUpdated()
+{
+    return impl->sigDeadlineMissStatisticsUpdated;
+}
+
+
+SimulationSnapshot::SimulationSnapshot()
+{
+    impl = new Impl;
+    impl->sessionId = 0;
+    impl->frame = 0;
+    impl->time = 0.0;
+}
+
+
+SimulationSnapshot::~SimulationSnapshot()
+{
+    delete impl;
+}
+
+
+int SimulationSnapshot::frame() const
+{
+    return impl->frame;
+}
+
+
+double SimulationSnapshot::time() const
+{
+    return impl->time;
+}
+
+
+void SimulatorItem::setSnapshotInterval(double interval)
+{
+    impl->snapshotInterval = std::max(0.0, interval);
+}
+
+
+double SimulatorItem::snapshotInterval() const
+{
+    return impl->snapshotInterval;
+}
+
+
+void SimulatorItem::setMaxNumSnapshots(int n)
+{
+    impl->maxNumSnapshots = std::max(1, n);
+}
+
+
+int SimulatorItem::maxNumSnapshots() const
+{
+    return impl->maxNumSnapshots;
+}
+
+
+std::vector<SimulationSnapshotPtr> SimulatorItem::snapshots() const
+{
+    std::lock_guard<std::mutex> lock(impl->snapshotMutex);
+    return std::vector<SimulationSnapshotPtr>(impl->snapshots.begin(), impl->snapshots.end());
+}
+
+
+void SimulatorItem::clearSnapshots()
+{
+    std::lock_guard<std::mutex> lock(impl->snapshotMutex);
+    impl->snapshots.clear();
+}
+
+
+SimulationSnapshot* SimulatorItem::takeSnapshot()
+{
+    return impl->takeSnapshot();
+}
+
+
+SimulationSnapshot* SimulatorItem::Impl::takeSnapshot()
+{
+    if(!waitForSimulationLoopToPause()){
+        mv->putln(format(_("A snapshot of {0} can only be taken while the simulation is paused."),
+                         self->displayName()),
+                  MessageView::Error);
+        return nullptr;
+    }
+    auto snapshot = createSnapshot();
+    if(!snapshot){
+        mv->putln(format(_("The simulation state of {0} cannot be stored."), self->displayName()),
+                  MessageView::Error);
+        return nullptr;
+    }
+    addSnapshot(snapshot);
+    return snapshot;
+}
+
+
+bool SimulatorItem::restoreSnapshot(SimulationSnapshot* snapshot)
+{
+    return impl->restoreSnapshot(snapshot);
+}
+
+
+bool SimulatorItem::Impl::restoreSnapshot(SimulationSnapshot* snapshot)
+{
+    if(!waitForSimulationLoopToPause()){
+        mv->putln(format(_("A snapshot of {0} can only be restored while the simulation is paused."),
+                         self->displayName()),
+                  MessageView::Error);
+        return false;
+    }
+    auto snapshotImpl = snapshot->impl;
+    if(snapshotImpl->sessionId != snapshotSessionId){
+        mv->putln(format(_("The snapshot at {0:.3f} [s] was not taken in the current simulation of {1}."),
+                         snapshotImpl->time, self->displayName()),
+                  MessageView::Error);
+        return false;
+    }
+
+    // The buffered records must be moved to the record items before truncating them
+    flushRecords();
+
+    if(!self->restoreSimulationState(snapshotImpl->simulatorState)){
+        mv->putln(format(_("The simulation state of {0} cannot be restored."), self->displayName()),
+                  MessageView::Error);
+        return false;
+    }
+
+    const int numBodies = std::min(activeSimBodies.size(), snapshotImpl->deviceStates.size());
+    for(int i=0; i < numBodies; ++i){
+        auto& devices = activeSimBodies[i]->body()->devices();
+        auto& states = snapshotImpl->deviceStates[i];
+        const int numDevices = std::min(devices.size(), states.size());
+        for(int j=0; j < numDevices; ++j){
+            auto device = devices[j];
+            device->copyStateFrom(*states[j]);
+            device->notifyStateChange();
+        }
+    }
+
+    const int numControllers = std::min(activeControllerInfos.size(), snapshotImpl->controllerStates.size());
+    for(int i=0; i < numControllers; ++i){
+        auto& controller = activeControllerInfos[i]->controller;
+        if(!controller->restoreControlState(snapshotImpl->controllerStates[i])){
+            mv->putln(format(_("The state of {0} cannot be restored."), controller->displayName()),
+                      MessageView::Warning);
+        }
+    }
+
+    currentFrame = snapshotImpl->frame;
+    currentTime_ = snapshotImpl->time;
+
+    truncateRecords(currentFrame);
+
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        while(!snapshots.empty() && snapshots.back()->frame() > currentFrame){
+            snapshots.pop_back();
+        }
+    }
+
+    logEngine->updateOngoingTime(currentTime_);
+
+    mv->notify(format(_("The simulation of {0} has been restored to {1:.3f} [s]."),
+                      self->displayName(), currentTime_));
+
+    return true;
+}
+
+
 void SimulatorItem::setDeviceStateOutputEnabled(bool on)
 {
     impl->isDeviceStateOutputEnabled = on;
@@ -1520,6 +2011,7 @@ int FunctionSet::add(std::function<void()>& func)
     
     FunctionInfo info;
     info.function = func;
+    info.schedule = simImpl->scheduleOfFunctionsToAdd;
     while(true){
         if(registerdIds.insert(idCounter).second){
             break;
@@ -1590,6 +2082,10 @@ void SimulatorItem::Impl::clearSimulation()
     subSimulatorItems.clear();
     activeControllerInfos.clear();
 
+    updateSchedules.clear();
+    retiredUpdateSchedules.clear();
+    scheduleOfFunctionsToAdd = nullptr;
+
     hasControllers = false;
 
     sigLogFlushRequested.disconnectAllSlots();
@@ -1604,6 +2100,50 @@ void SimulatorItem::clearSimulation()
 }
 
 
+/**
+   \return nullptr if the item is updated at every frame
+*/
+SimulationUpdateSchedule* SimulatorItem::Impl::createUpdateSchedule(Item* item, double rate, double phaseOffset)
+{
+    if(rate <= 0.0){
+        return nullptr;
+    }
+
+    unique_ptr<SimulationUpdateSchedule> schedule(
+        new SimulationUpdateSchedule(rate, phaseOffset, worldFrameRate));
+    double actualRate = worldFrameRate / schedule->interval();
+    if(fabs(actualRate - rate) > 1.0e-6 * rate){
+        mv->putln(format(_("The update rate of {0} is adjusted from {1} [Hz] to {2} [Hz] "
+                           "to fit the frame rate of the simulation world."),
+                         item->displayName(), rate, actualRate),
+                  MessageView::Warning);
+    }
+    if(schedule->interval() == 1){
+        return nullptr;
+    }
+
+    schedule->setName(item->displayName());
+    updateSchedules.push_back(std::move(schedule));
+    return updateSchedules.back().get();
+}
+
+
+/**
+   The schedule is no longer updated, so the functions that refer to it are never called,
+   but it is kept alive until the simulation is cleared.
+*/
+void SimulatorItem::Impl::retireUpdateSchedule(SimulationUpdateSchedule* schedule)
+{
+    auto p = std::find_if(
+        updateSchedules.begin(), updateSchedules.end(),
+        [schedule](const unique_ptr<SimulationUpdateSchedule>& s){ return s.get() == schedule; });
+    if(p != updateSchedules.end()){
+        retiredUpdateSchedules.push_back(std::move(*p));
+        updateSchedules.erase(p);
+    }
+}
+
+
 SimulationBody* SimulatorItem::createSimulationBody(Body* orgBody, CloneMap& cloneMap)
 {
     return nullptr;
@@ -1793,12 +2333,17 @@ bool SimulatorItem::Impl::initializeSimulation(bool doReset)
         bool initialized = false;
         if(item->isEnabled()){
             mv->putln(format(_("SubSimulatorItem \"{}\" has been detected."), item->displayName()));
+            // The functions added in the initialization are called at the update rate of the item
+            scheduleOfFunctionsToAdd =
+                createUpdateSchedule(item, item->updateRate(), item->updatePhaseOffset());
             if(item->initializeSimulation(self)){
                 initialized = true;
             } else {
+                retireUpdateSchedule(scheduleOfFunctionsToAdd);
                 mv->putln(format(_("The initialization of \"{}\" failed."), item->displayName()),
                           MessageView::Warning);
             }
+            scheduleOfFunctionsToAdd = nullptr;
         } else {
             mv->putln(format(_("SubSimulatorItem \"{}\" is disabled."), item->displayName()));
         }
@@ -1828,6 +2373,7 @@ bool SimulatorItem::Impl::initializeSimulation(bool doReset)
     doRecordCollisionData = (isRecordingEnabled && isCollisionDataRecordingEnabled);
     if(doRecordCollisionData){
         collisionPairsBuf.clear();
+        lastCollisionPairs.reset();
         string collisionSeqName = self->name() + "-collisions";
         auto collisionSeqItem = worldItem->findChildItem<CollisionSeqItem>(collisionSeqName);
         if(collisionSeqItem){
@@ -1877,6 +2423,7 @@ bool SimulatorItem::Impl::initializeSimulation(bool doReset)
                 activeControllerInfos.push_back(info);
                 ++iter;
             } else {
+                retireUpdateSchedule(info->updateSchedule);
                 iter = controllerInfos.erase(iter);
             }
         }
@@ -1900,14 +2447,43 @@ bool SimulatorItem::Impl::initializeSimulation(bool doReset)
     stopRequested = false;
     pauseRequested = false;
 
+    resetDeadlineMissStatistics();
+    sigDeadlineMissStatisticsUpdated();
+
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        snapshots.clear();
+    }
+    ++snapshotSessionId;
+    snapshotIntervalFrames = 0;
+    if(snapshotInterval > 0.0){
+        snapshotIntervalFrames = std::max(1L, lround(snapshotInterval / worldTimeStep_));
+    }
+    isSimulationLoopPaused = false;
+
+    const bool isPreciseRealtimeSync = (currentRealtimeSyncMode == PreciseRealtimeSync);
+    if(isPreciseRealtimeSync && isRealtimeMemoryLockEnabled){
+        lockMemory();
+    }
+
     useControllerThreads = useControllerThreadsProperty;
     if(useControllerThreads){
+        int threadIndex = 1;
         for(auto& info : activeControllerInfos){
             info->isExitingControlLoopRequested = false;
             info->isControlRequested = false;
             info->isControlFinished = false;
-            info->isControlToBeContinued = false;
-            info->controlThread = std::thread([info](){ info->concurrentControlLoop(); });
+            info->isControlToBeContinued = true;
+            if(isPreciseRealtimeSync){
+                info->controlThread = std::thread(
+                    [this, info, threadIndex](){
+                        applyRealtimeThreadAttributes(threadIndex);
+                        info->concurrentControlLoop();
+                    });
+                ++threadIndex;
+            } else {
+                info->controlThread = std::thread([info](){ info->concurrentControlLoop(); });
+            }
         }
     }
 
@@ -1948,7 +2524,10 @@ bool SimulatorItem::Impl::initializeSimulation(bool doReset)
         }
     }
 
-    logEngine->startOngoingTimeUpdate(0.0);
+    isTimeBarSyncActive = isTimeBarSyncEnabled;
+    if(isTimeBarSyncActive){
+        logEngine->startOngoingTimeUpdate(0.0);
+    }
     flushRecords();
     start();
     startFlushTimer();
@@ -2053,12 +2632,16 @@ void SimulatorItem::Impl::run()
                     elapsedTime += timer.elapsed();
                     isOnPause = true;
                     sigSimulationPaused();
+                    isSimulationLoopPaused = true;
                 }
                 QThread::msleep(50);
             } else {
                 if(isOnPause){
                     timer.start();
                     isOnPause = false;
+                    isSimulationLoopPaused = false;
+                    // The current frame may have been changed by restoring a snapshot
+                    frame = currentFrame;
                     sigSimulationResumed();
                 }
                 if(!stepSimulationMain() || stopRequested || frame++ >= maxFrame){
@@ -2066,6 +2649,8 @@ void SimulatorItem::Impl::run()
                 }
             }
         }
+    } else if(currentRealtimeSyncMode == PreciseRealtimeSync){
+        runPreciseRealtimeSyncLoop(frame, elapsedTime, isOnPause, timer);
     } else {
         const double dt = worldTimeStep_;
         const double compensationRatio = (dt > 0.1) ? 0.1 : dt;
@@ -2080,12 +2665,16 @@ void SimulatorItem::Impl::run()
                     elapsedTime += timer.elapsed();
                     isOnPause = true;
                     sigSimulationPaused();
+                    isSimulationLoopPaused = true;
                 }
                 QThread::msleep(50);
             } else {
                 if(isOnPause){
                     timer.start();
                     isOnPause = false;
+                    isSimulationLoopPaused = false;
+                    // The current frame may have been changed by restoring a snapshot
+                    frame = currentFrame;
                     sigSimulationResumed();
                 }
                 if(!stepSimulationMain() || stopRequested || frame >= maxFrame){
@@ -2136,6 +2725,10 @@ void SimulatorItem::Impl::run()
         }
     }
 
+    if(isMemoryLocked){
+        unlockMemory();
+    }
+
     if(!isWaitingForSimulationToStop){
         callLater([&](){ onSimulationLoopStopped(isForcedToStopSimulation); });
     }
@@ -2144,6 +2737,246 @@ void SimulatorItem::Impl::run()
 }
 
 
+void SimulatorItem::Impl::runPreciseRealtimeSyncLoop
+(int& frame, double& elapsedTime, bool& isOnPause, QElapsedTimer& timer)
+{
+    applyRealtimeThreadAttributes(0);
+
+    const int64_t dt = llround(worldTimeStep_ * 1.0e9);
+    int64_t deadline = getMonotonicTime() + dt;
+
+    while(true){
+        if(pauseRequested){
+            if(stopRequested){
+                break;
+            }
+            if(!isOnPause){
+                elapsedTime += timer.elapsed();
+                isOnPause = true;
+                sigSimulationPaused();
+                isSimulationLoopPaused = true;
+            }
+            QThread::msleep(50);
+        } else {
+            if(isOnPause){
+                timer.start();
+                isOnPause = false;
+                isSimulationLoopPaused = false;
+                // The current frame may have been changed by restoring a snapshot
+                frame = currentFrame;
+                sigSimulationResumed();
+                deadline = getMonotonicTime() + dt;
+            }
+            if(!stepSimulationMain() || stopRequested || frame >= maxFrame){
+                break;
+            }
+            const int64_t now = getMonotonicTime();
+            const int64_t lateness = now - deadline;
+            if(lateness > 0){
+                // The following frames are not rushed to catch up with the missed deadline
+                deadline = now;
+            } else {
+                waitUntil(deadline);
+            }
+            updateDeadlineMissStatistics(lateness * 1.0e-9);
+            deadline += dt;
+            ++frame;
+        }
+    }
+}
+
+
+void SimulatorItem::Impl::applyRealtimeThreadAttributes(int threadIndex)
+{
+    const int cpu = realtimeCpus.empty() ? -1 : realtimeCpus[threadIndex % realtimeCpus.size()];
+    if(realtimeThreadPriority <= 0 && cpu < 0){
+        return;
+    }
+
+    string message;
+
+#ifdef __linux__
+    const pthread_t thread = pthread_self();
+    if(realtimeThreadPriority > 0){
+        sched_param param;
+        param.sched_priority =
+            std::min(realtimeThreadPriority, sched_get_priority_max(SCHED_FIFO));
+        int result = pthread_setschedparam(thread, SCHED_FIFO, &param);
+        if(result != 0){
+            message = format(_("The realtime priority {0} cannot be set to a simulation thread: {1}"),
+                             param.sched_priority, strerror(result));
+        }
+    }
+    if(cpu >= 0){
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpu, &cpuSet);
+        int result = pthread_setaffinity_np(thread, sizeof(cpuSet), &cpuSet);
+        if(result != 0){
+            if(!message.empty()){
+                message += "\n";
+            }
+            message += format(_("A simulation thread cannot be bound to CPU {0}: {1}"),
+                              cpu, strerror(result));
+        }
+    }
+#else
+    message = _("The realtime thread priority and the CPU affinity are not supported on this platform.");
+#endif
+
+    if(!message.empty()){
+        callLater([this, message](){ mv->putln(message, MessageView::Warning); });
+    }
+}
+
+
+void SimulatorItem::Impl::lockMemory()
+{
+#ifdef __linux__
+    if(mlockall(MCL_CURRENT | MCL_FUTURE) == 0){
+        isMemoryLocked = true;
+    } else {
+        mv->putln(format(_("The memory of the process cannot be locked: {0}"), strerror(errno)),
+                  MessageView::Warning);
+    }
+#else
+    mv->putln(_("The memory lock is not supported on this platform."), MessageView::Warning);
+#endif
+}
+
+
+void SimulatorItem::Impl::unlockMemory()
+{
+#ifdef __linux__
+    munlockall();
+#endif
+    isMemoryLocked = false;
+}
+
+
+void SimulatorItem::Impl::resetDeadlineMissStatistics()
+{
+    std::lock_guard<std::mutex> lock(deadlineMissMutex);
+    auto& stats = deadlineMissStatistics;
+    stats.numFrames = 0;
+    stats.numMisses = 0;
+    stats.maxLateness = 0.0;
+    std::fill(std::begin(stats.histogram), std::end(stats.histogram), 0);
+}
+
+
+void SimulatorItem::Impl::updateDeadlineMissStatistics(double lateness)
+{
+    {
+        std::lock_guard<std::mutex> lock(deadlineMissMutex);
+        auto& stats = deadlineMissStatistics;
+        ++stats.numFrames;
+        if(lateness <= 0.0){
+            return;
+        }
+        ++stats.numMisses;
+        if(lateness > stats.maxLateness){
+            stats.maxLateness = lateness;
+        }
+        constexpr int n = SimulatorItem::DeadlineMissStatistics::NumHistogramBins;
+        int bin = 0;
+        while(bin < n - 1 && lateness > SimulatorItem::DeadlineMissStatistics::HistogramBinUpperBounds[bin]){
+            ++bin;
+        }
+        ++stats.histogram[bin];
+    }
+
+    // The notifications are merged until the main thread processes the pending one
+    if(!isDeadlineMissNotificationPending.exchange(true)){
+        callLater([this](){
+            isDeadlineMissNotificationPending = false;
+            sigDeadlineMissStatisticsUpdated();
+        });
+    }
+}
+
+
+SimulationSnapshotPtr SimulatorItem::Impl::createSnapshot()
+{
+    SimulationSnapshotPtr snapshot = new SimulationSnapshot;
+    auto snapshotImpl = snapshot->impl;
+
+    if(!self->storeSimulationState(snapshotImpl->simulatorState)){
+        return nullptr;
+    }
+    
+    snapshotImpl->sessionId = snapshotSessionId;
+    snapshotImpl->frame = currentFrame;
+    snapshotImpl->time = currentTime_;
+
+    snapshotImpl->deviceStates.resize(activeSimBodies.size());
+    for(size_t i=0; i < activeSimBodies.size(); ++i){
+        auto& states = snapshotImpl->deviceStates[i];
+        for(auto& device : activeSimBodies[i]->body()->devices()){
+            states.push_back(device->cloneState());
+        }
+    }
+
+    snapshotImpl->controllerStates.reserve(activeControllerInfos.size());
+    for(auto& info : activeControllerInfos){
+        snapshotImpl->controllerStates.push_back(info->controller->storeControlState());
+    }
+
+    return snapshot;
+}
+
+
+void SimulatorItem::Impl::addSnapshot(SimulationSnapshot* snapshot)
+{
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    snapshots.push_back(snapshot);
+    while(static_cast<int>(snapshots.size()) > maxNumSnapshots){
+        snapshots.pop_front();
+    }
+}
+
+
+/**
+   The simulation loop may still be processing the current frame just after the pause is
+   requested, so this function waits for the loop to enter the pause state.
+*/
+bool SimulatorItem::Impl::waitForSimulationLoopToPause()
+{
+    if(!isDoingSimulationLoop || !pauseRequested){
+        return false;
+    }
+    while(!isSimulationLoopPaused){
+        if(!isDoingSimulationLoop){
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+
+//! The records before the frame are kept.
+void SimulatorItem::Impl::truncateRecords(int frame)
+{
+    recordBufMutex.lock();
+
+    for(auto& simBody : activeSimBodies){
+        simBody->impl->truncateRecords(frame);
+    }
+    if(doRecordCollisionData){
+        truncateSeq(*collisionSeq, frame);
+        lastCollisionPairs.reset();
+    }
+    frameAtLastBufferWriting = std::max(0, frame - 1);
+
+    recordBufMutex.unlock();
+
+    for(auto& info : loggedControllerInfos){
+        info->truncateLog(frame);
+    }
+}
+
+
 bool SimulatorItem::Impl::stepSimulationMain()
 {
     // Recored the positions at the beginning of the current frame
@@ -2151,13 +2984,23 @@ bool SimulatorItem::Impl::stepSimulationMain()
 
     bool doContinue = !doStopSimulationWhenNoActiveControllers;
 
+    for(auto& schedule : updateSchedules){
+        schedule->update(currentFrame);
+    }
+
     preDynamicsFunctions.call();
 
     if(!useControllerThreads){
         for(auto& info : activeControllerInfos){
+            if(!info->isUpdateFrame()){
+                // Keep the result of the last update
+                doContinue |= info->isControlToBeContinued;
+                continue;
+            }
             auto& controller = info->controller;
             controller->input();
-            doContinue |= controller->control();
+            info->isControlToBeContinued = controller->control();
+            doContinue |= info->isControlToBeContinued;
             if(controller->isNoDelayMode()){
                 controller->output();
             }
@@ -2165,6 +3008,10 @@ bool SimulatorItem::Impl::stepSimulationMain()
     } else {
         bool hasNoDelayModeControllers = false;
         for(auto& info : activeControllerInfos){
+            if(!info->isUpdateFrame()){
+                doContinue |= info->isControlToBeContinued;
+                continue;
+            }
             auto& controller = info->controller;
             if(controller->isNoDelayMode()){
                 hasNoDelayModeControllers = true;
@@ -2180,7 +3027,7 @@ bool SimulatorItem::Impl::stepSimulationMain()
             // Todo: Process the controller that finishes control earlier first to
             // reduce the total elapsed time before finishing all the output functions.
             for(auto& info : activeControllerInfos){
-                if(info->controller->isNoDelayMode()){
+                if(info->isUpdateFrame() && info->controller->isNoDelayMode()){
                     if(info->waitForControlInThreadToFinish()){
                         doContinue = true;
                     }
@@ -2200,7 +3047,7 @@ bool SimulatorItem::Impl::stepSimulationMain()
     
     if(useControllerThreads){
         for(auto& info : activeControllerInfos){
-            if(!info->controller->isNoDelayMode()){
+            if(info->isUpdateFrame() && !info->controller->isNoDelayMode()){
                 if(info->waitForControlInThreadToFinish()){
                     doContinue = true;
                 }
@@ -2211,7 +3058,7 @@ bool SimulatorItem::Impl::stepSimulationMain()
     postDynamicsFunctions.call();
 
     for(auto& info : activeControllerInfos){
-        if(!info->controller->isNoDelayMode()){
+        if(info->isUpdateFrame() && !info->controller->isNoDelayMode()){
             info->controller->output();
         }
     }
@@ -2219,6 +3066,19 @@ bool SimulatorItem::Impl::stepSimulationMain()
     ++currentFrame;
     currentTime_ = currentFrame / worldFrameRate;
 
+    if(snapshotIntervalFrames > 0 && currentFrame % snapshotIntervalFrames == 0){
+        if(auto snapshot = createSnapshot()){
+            addSnapshot(snapshot);
+        } else {
+            snapshotIntervalFrames = 0;
+            callLater([this](){
+                    mv->putln(format(_("The simulation state of {0} cannot be stored, "
+                                       "so the periodic snapshots are disabled."),
+                                     self->displayName()),
+                              MessageView::Warning); });
+        }
+    }
+
     return doContinue;
 }
 
@@ -2283,8 +3143,10 @@ void SimulatorItem::Impl::bufferRecords()
 
 void SimulatorItem::Impl::bufferCollisionRecords()
 {
+    // The link pairs unchanged from the previous frame are shared to reduce the memory usage
+    lastCollisionPairs = CollisionSeq::shareUnchangedLinkPairs(self->getCollisions(), lastCollisionPairs);
     recordBufMutex.lock();
-    collisionPairsBuf.push_back(self->getCollisions());
+    collisionPairsBuf.push_back(lastCollisionPairs);
     recordBufMutex.unlock();
 }
 
@@ -2396,7 +3258,9 @@ void SimulatorItem::restartSimulation()
 void SimulatorItem::Impl::restartSimulation()
 {
     if(pauseRequested){
-        logEngine->startOngoingTimeUpdate();
+        if(isTimeBarSyncActive){
+            logEngine->startOngoingTimeUpdate();
+        }
         pauseRequested = false;
         startFlushTimer();
     }
@@ -2465,6 +3329,15 @@ void SimulatorItem::Impl::onSimulationLoopStopped(bool isForced)
         mv->putln(format(_("Computation time is {0} [s], computation time / simulation time = {1}."),
                          actualSimulationTime, (actualSimulationTime / finishTime)));
     }
+    if(currentRealtimeSyncMode == PreciseRealtimeSync){
+        auto stats = self->deadlineMissStatistics();
+        mv->putln(format(_("Deadline misses: {0} in {1} frames, max lateness {2:.3f} [ms]."),
+                         stats.numMisses, stats.numFrames, stats.maxLateness * 1000.0));
+    }
+    for(auto& schedule : updateSchedules){
+        mv->putln(format(_("{0} has been updated {1} times at {2} [Hz]."),
+                         schedule->name(), schedule->numUpdates(), worldFrameRate / schedule->interval()));
+    }
 
     clearSimulation();
 
@@ -2699,6 +3572,18 @@ bool SimulatorItem::Impl::onAllLinkPositionOutputModeChanged(bool on)
 }
 
 
+bool SimulatorItem::storeSimulationState(ReferencedPtr& /* out_state */)
+{
+    return false;
+}
+
+
+bool SimulatorItem::restoreSimulationState(Referenced* /* state */)
+{
+    return false;
+}
+
+
 std::shared_ptr<CollisionLinkPairList> SimulatorItem::getCollisions()
 {
     return std::make_shared<CollisionLinkPairList>();
@@ -2732,6 +3617,15 @@ void SimulatorItem::Impl::doPutProperties(PutPropertyFunction& putProperty)
 
     putProperty(_("Realtime sync"), realtimeSyncMode,
                 [&](int index){ return realtimeSyncMode.select(index); });
+    if(realtimeSyncMode.is(PreciseRealtimeSync)){
+        putProperty.min(0).max(99)(_("Realtime thread priority"), realtimeThreadPriority,
+                                   changeProperty(realtimeThreadPriority));
+        putProperty.reset();
+        putProperty(_("Realtime CPUs"), getCpuListString(realtimeCpus),
+                    [&](const string& s){ return parseCpuListString(s, realtimeCpus); });
+        putProperty(_("Realtime memory lock"), isRealtimeMemoryLockEnabled,
+                    changeProperty(isRealtimeMemoryLockEnabled));
+    }
     putProperty(_("Time range"), timeRangeMode,
                 [&](int index){ return timeRangeMode.select(index); });
     putProperty.min(0.0);
@@ -2747,6 +3641,11 @@ void SimulatorItem::Impl::doPutProperties(PutPropertyFunction& putProperty)
                 changeProperty(isDeviceStateOutputEnabled));
     putProperty(_("Record collision data"), isCollisionDataRecordingEnabled,
                 changeProperty(isCollisionDataRecordingEnabled));
+    putProperty.min(0.0)(_("Snapshot interval"), snapshotInterval,
+                         [&](double interval){ self->setSnapshotInterval(interval); return true; });
+    putProperty.min(1)(_("Max snapshots"), maxNumSnapshots,
+                       [&](int n){ self->setMaxNumSnapshots(n); return true; });
+    putProperty.reset();
     putProperty(_("Controller Threads"), useControllerThreadsProperty,
                 changeProperty(useControllerThreadsProperty));
     putProperty(_("Controller options"), controllerOptionString_,
@@ -2771,6 +3670,18 @@ bool SimulatorItem::Impl::store(Archive& archive)
         archive.write("frame_rate", frameRateProperty);
     }
     archive.write("realtime_sync_mode", realtimeSyncModeSymbols[realtimeSyncMode.which()]);
+    if(realtimeThreadPriority > 0){
+        archive.write("realtime_thread_priority", realtimeThreadPriority);
+    }
+    if(!realtimeCpus.empty()){
+        auto& cpus = *archive.createFlowStyleListing("realtime_cpus");
+        for(auto& cpu : realtimeCpus){
+            cpus.append(cpu);
+        }
+    }
+    if(isRealtimeMemoryLockEnabled){
+        archive.write("realtime_memory_lock", true);
+    }
     archive.write("recording", recordingMode.selectedSymbol());
     archive.write("time_range_mode", timeRangeModeSymbols[timeRangeMode.which()]);
     archive.write("time_length", timeLength);
@@ -2779,6 +3690,10 @@ bool SimulatorItem::Impl::store(Archive& archive)
     archive.write("output_device_states", isDeviceStateOutputEnabled);
     archive.write("use_controller_threads", useControllerThreadsProperty);
     archive.write("record_collision_data", isCollisionDataRecordingEnabled);
+    if(snapshotInterval > 0.0){
+        archive.write("snapshot_interval", snapshotInterval);
+    }
+    archive.write("max_num_snapshots", maxNumSnapshots);
     archive.write("controller_options", controllerOptionString_, DOUBLE_QUOTED);
     archive.write("block_scene_view_edit_mode", isSceneViewEditModeBlockedDuringSimulation);
     
@@ -2859,6 +3774,15 @@ bool SimulatorItem::Impl::restore(const Archive& archive)
         bool on = archive.get("realtimeSync", true);
         realtimeSyncMode.select(on ? CompensatoryRealtimeSync : NonRealtimeSync);
     }
+    archive.read("realtime_thread_priority", realtimeThreadPriority);
+    realtimeCpus.clear();
+    auto& cpus = *archive.findListing("realtime_cpus");
+    if(cpus.isValid()){
+        for(int i=0; i < cpus.size(); ++i){
+            realtimeCpus.push_back(cpus[i].toInt());
+        }
+    }
+    archive.read("realtime_memory_lock", isRealtimeMemoryLockEnabled);
 
     archive.read({ "time_length", "timeLength" }, timeLength);
 
@@ -2867,6 +3791,12 @@ bool SimulatorItem::Impl::restore(const Archive& archive)
     
     archive.read({ "output_device_states", "deviceStateOutput" }, isDeviceStateOutputEnabled);
     archive.read({ "record_collision_data", "recordCollisionData" }, isCollisionDataRecordingEnabled);
+    if(archive.read("snapshot_interval", snapshotInterval)){
+        self->setSnapshotInterval(snapshotInterval);
+    }
+    if(archive.read("max_num_snapshots", maxNumSnapshots)){
+        self->setMaxNumSnapshots(maxNumSnapshots);
+    }
     archive.read({ "use_controller_threads", "controllerThreads" }, useControllerThreadsProperty);
     archive.read({ "controller_options", "controllerOptions" }, controllerOptionString_);
     archive.read({ "block_scene_view_edit_mode", "scene_view_edit_mode_blocking" },
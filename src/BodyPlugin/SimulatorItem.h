@@ -64,6 +64,32 @@ private:
 typedef ref_ptr<SimulationBody> SimulationBodyPtr;
 
 
+/**
+   This class holds the state of a simulation at a frame, which consists of the state stored
+   by the simulator, the device states and the controller states. A snapshot can only be
+   restored to the simulation session where it is taken.
+*/
+class CNOID_EXPORT SimulationSnapshot : public Referenced
+{
+public:
+    ~SimulationSnapshot();
+
+    int frame() const;
+    double time() const;
+
+    class Impl;
+
+private:
+    SimulationSnapshot();
+
+    Impl* impl;
+
+    friend class SimulatorItem;
+};
+
+typedef ref_ptr<SimulationSnapshot> SimulationSnapshotPtr;
+
+
 class CNOID_EXPORT SimulatorItem : public Item
 {
 public:
@@ -148,18 +174,100 @@ public:
     void setActiveControlTimeRangeMode(bool on);
     bool isActiveControlTimeRangeMode() const;
 
+    /**
+       PreciseRealtimeSync waits for the absolute deadline of each frame with a high-resolution
+       sleep followed by a busy wait, and the frames whose computation is not finished by the
+       deadline are counted as the deadline misses. The realtime thread settings below are
+       applied in this mode.
+    */
     enum RealtimeSyncMode {
         NonRealtimeSync,
         CompensatoryRealtimeSync,
         ConservativeRealtimeSync,
+        PreciseRealtimeSync,
         NumRealtimeSyncModes
     };
 
     void setRealtimeSyncMode(int mode);
     int realtimeSyncMode() const;
 
+    /**
+       The simulation drives the ongoing time of the time bar when this is enabled, which is the
+       default. This should be disabled for all but one of the simulations executed concurrently.
+       The setting is applied when the simulation is started.
+    */
+    void setTimeBarSyncEnabled(bool on);
+    bool isTimeBarSyncEnabled() const;
+
+    /**
+       The SCHED_FIFO priority of the simulation thread and the controller threads in the precise
+       realtime sync mode. Zero means the default scheduling policy.
+    */
+    void setRealtimeThreadPriority(int priority);
+    int realtimeThreadPriority() const;
+
+    /**
+       The CPUs are assigned to the simulation thread and the controller threads in this order
+       in the precise realtime sync mode. The CPU affinity is not set if the list is empty.
+    */
+    void setRealtimeCpus(const std::vector<int>& cpus);
+    const std::vector<int>& realtimeCpus() const;
+
+    //! All the memory of the process is locked during the simulation in the precise realtime sync mode.
+    void setRealtimeMemoryLockEnabled(bool on);
+    bool isRealtimeMemoryLockEnabled() const;
+
+    struct DeadlineMissStatistics
+    {
+        static constexpr int NumHistogramBins = 6;
+        //! The upper bounds of the lateness of the histogram bins except the last one [s]
+        static const double HistogramBinUpperBounds[NumHistogramBins - 1];
+
+        int numFrames;
+        int numMisses;
+        double maxLateness;
+        int histogram[NumHistogramBins];
+    };
+
+    //! This function can be called from any thread.
+    DeadlineMissStatistics deadlineMissStatistics() const;
+
+    //! The signal is emitted in the main thread when the statistics are updated by a deadline miss.
+    SignalProxy<void()> sigDeadlineMissStatisticsUpdated();
+
     [[deprecated("Use setRealtimeSyncMode(int mode)")]]
     void setRealtimeSyncMode(bool on);
+
+    /**
+       The snapshots of the simulation are taken at the specified interval when the interval
+       is greater than zero, and the oldest one is removed when the number of the snapshots
+       exceeds the max number. The snapshots are cleared when a new simulation is started.
+       \note The snapshots are only available in the simulators that implement the
+       storeSimulationState and restoreSimulationState functions.
+    */
+    void setSnapshotInterval(double interval);
+    double snapshotInterval() const;
+    void setMaxNumSnapshots(int n);
+    int maxNumSnapshots() const;
+
+    //! This function can be called from any thread.
+    std::vector<SimulationSnapshotPtr> snapshots() const;
+
+    void clearSnapshots();
+
+    /**
+       This function takes a snapshot of the current state while the simulation is paused.
+       The snapshot is added to the snapshot list.
+       \return nullptr if the snapshot cannot be taken
+    */
+    SimulationSnapshot* takeSnapshot();
+
+    /**
+       This function restores the state of a snapshot while the simulation is paused.
+       The simulation is continued from the frame of the snapshot when it is resumed,
+       and the records and the snapshots after the frame are discarded.
+    */
+    bool restoreSnapshot(SimulationSnapshot* snapshot);
     
     void setSlowerThanRealtimeEnabled(bool on);
     
@@ -283,6 +391,22 @@ protected:
 
     virtual std::shared_ptr<CollisionLinkPairList> getCollisions();
 
+    /**
+       This function is called to take a snapshot of the simulation. The object containing the
+       simulator state that is not included in the device states and the controller states,
+       such as the states of the links, must be returned by out_state.
+       The default implementation returns false.
+       \note This function is called from the simulation thread, or from the main thread while
+       the simulation loop is paused.
+       \return false if the snapshot is not supported by the simulator
+    */
+    virtual bool storeSimulationState(ReferencedPtr& out_state);
+
+    /**
+       \note This function is called from the main thread while the simulation loop is paused.
+    */
+    virtual bool restoreSimulationState(Referenced* state);
+
     virtual void doPutProperties(PutPropertyFunction& putProperty) override;
     virtual bool store(Archive& archive) override;
     virtual bool restore(const Archive& archive) override;
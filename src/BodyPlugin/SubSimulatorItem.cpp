@@ -7,6 +7,7 @@
 #include <cnoid/ItemManager>
 #include <cnoid/PutPropertyFunction>
 #include <cnoid/Archive>
+#include <algorithm>
 #include "gettext.h"
 
 using namespace cnoid;
@@ -21,6 +22,8 @@ void SubSimulatorItem::initializeClass(ExtensionManager* ext)
 SubSimulatorItem::SubSimulatorItem()
 {
     isEnabled_ = true;
+    updateRate_ = 0.0;
+    updatePhaseOffset_ = 0.0;
 }
 
 
@@ -28,6 +31,8 @@ SubSimulatorItem::SubSimulatorItem(const SubSimulatorItem& org)
     : Item(org)
 {
     isEnabled_ = org.isEnabled_;
+    updateRate_ = org.updateRate_;
+    updatePhaseOffset_ = org.updatePhaseOffset_;
 }
 
 
@@ -56,15 +61,35 @@ void SubSimulatorItem::finalizeSimulation()
 }
 
 
+void SubSimulatorItem::setUpdateRate(double rate)
+{
+    updateRate_ = std::max(0.0, rate);
+}
+
+
+void SubSimulatorItem::setUpdatePhaseOffset(double offset)
+{
+    updatePhaseOffset_ = std::max(0.0, offset);
+}
+
+
 void SubSimulatorItem::doPutProperties(PutPropertyFunction& putProperty)
 {
     putProperty(_("Enabled"), isEnabled(), [&](bool on){ return setEnabled(on); });
+    putProperty.min(0.0);
+    putProperty(_("Update rate [Hz]"), updateRate_, changeProperty(updateRate_));
+    putProperty(_("Update phase offset [s]"), updatePhaseOffset_, changeProperty(updatePhaseOffset_));
+    putProperty.reset();
 }
 
 
 bool SubSimulatorItem::store(Archive& archive)
 {
     archive.write("enabled", isEnabled());
+    if(updateRate_ > 0.0){
+        archive.write("update_rate", updateRate_);
+        archive.write("update_phase_offset", updatePhaseOffset_);
+    }
     return true;
 }
 
@@ -75,5 +100,12 @@ bool SubSimulatorItem::restore(const Archive& archive)
     if(archive.read("enabled", on)){
         setEnabled(on);
     }
+    double value;
+    if(archive.read("update_rate", value)){
+        setUpdateRate(value);
+    }
+    if(archive.read("update_phase_offset", value)){
+        setUpdatePhaseOffset(value);
+    }
     return true;
 }
@@ -26,6 +26,18 @@ public:
     virtual bool initializeSimulation(SimulatorItem* simulatorItem);
     virtual void finalizeSimulation();
 
+    /**
+       The update rate [Hz] of the item. The functions that the item adds to the simulator item
+       in its initializeSimulation function are called only at the frames corresponding to this
+       rate, and the item holds its state between the updates. The update timing is shifted by
+       the phase offset [s]. Zero rate means that the functions are called at every time step
+       of the simulation world.
+    */
+    double updateRate() const { return updateRate_; }
+    void setUpdateRate(double rate);
+    double updatePhaseOffset() const { return updatePhaseOffset_; }
+    void setUpdatePhaseOffset(double offset);
+
 protected:
     virtual void doPutProperties(PutPropertyFunction& putProperty);
     virtual bool store(Archive& archive);
@@ -33,6 +45,8 @@ protected:
     
 private:
     bool isEnabled_;
+    double updateRate_;
+    double updatePhaseOffset_;
 };
 
 typedef ref_ptr<SubSimulatorItem> SubSimulatorItemPtr;
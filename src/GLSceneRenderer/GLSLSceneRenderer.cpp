@@ -10,6 +10,7 @@
 #include <cnoid/SceneCameras>
 #include <cnoid/SceneLights>
 #include <cnoid/SceneEffects>
+#include <cnoid/SceneRayPicker>
 #include <cnoid/EigenUtil>
 #include <cnoid/NullOut>
 #include <fmt/format.h>
@@ -85,11 +86,15 @@ class VertexResource : public GLResource
 public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
     
-    static const int MAX_NUM_BUFFERS = 4;
+    static const int MAX_NUM_BUFFERS = 5;
     GLuint vao;
     GLuint vbos[MAX_NUM_BUFFERS];
     GLsizei numVertices;
     int numBuffers;
+    // The element array buffer is used when indexType is not zero
+    GLenum indexType;
+    GLsizei numIndices;
+    size_t numBufferBytes;
     // Local transform is used with the short integer type vertex elements
     Matrix4* pLocalTransform;
     Matrix4 localTransform;
@@ -97,6 +102,17 @@ public:
     SgLineSetPtr normalVisualization;
     ScopedConnection connection;
 
+    // Buffers of the instance model matrices used in the instanced rendering
+    struct InstanceBuffer {
+        const SgMaterial* material;
+        const SgTexture* texture;
+        GLuint vbo;
+        GLsizei capacity;
+        unsigned int frameCounter;
+        vector<Matrix4f, Eigen::aligned_allocator<Matrix4f>> matrices;
+    };
+    vector<InstanceBuffer> instanceBuffers;
+
     VertexResource(const VertexResource&) = delete;
     VertexResource& operator=(const VertexResource&) = delete;
 
@@ -118,6 +134,10 @@ public:
         }
         numBuffers = 0;
         numVertices = 0;
+        indexType = 0;
+        numIndices = 0;
+        numBufferBytes = 0;
+        instanceBuffers.clear();
     }
 
     virtual void discard() override { clearHandles(); }
@@ -146,6 +166,9 @@ public:
             }
             numBuffers = 0;
         }
+        indexType = 0;
+        numIndices = 0;
+        numBufferBytes = 0;
     }
 
     GLuint vbo(int index) {
@@ -154,6 +177,9 @@ public:
 
     ~VertexResource() {
         deleteBuffers();
+        for(auto& buffer : instanceBuffers){
+            glDeleteBuffers(1, &buffer.vbo);
+        }
         if(vao){
             glDeleteVertexArrays(1, &vao);
         }
@@ -271,6 +297,59 @@ public:
 };
 
 
+/**
+   This resource caches whether the bounding box of a group covers everything rendered
+   in its sub tree so that the group can be skipped when the bounding box is out of view.
+   The cached value is only invalidated when a node is added or removed in the sub tree.
+   The bounding box itself is taken from the cache of the group node.
+*/
+class CullingResource : public GLResource
+{
+public:
+    bool isCullable;
+    bool isCullabilityChecked;
+    ScopedConnection connection;
+
+    CullingResource(SgGroup* group)
+    {
+        isCullable = false;
+        isCullabilityChecked = false;
+        connection =
+            group->sigUpdated().connect(
+                [this](const SgUpdate& update){
+                    if(update.hasAction(SgUpdate::Added | SgUpdate::Removed)){
+                        isCullabilityChecked = false;
+                    }
+                });
+    }
+
+    virtual void discard() override { isCullabilityChecked = false; }
+};
+
+typedef ref_ptr<CullingResource> CullingResourcePtr;
+
+
+struct InstanceBatchKey
+{
+    SgMesh* mesh;
+    SgMaterial* material;
+    SgTexture* texture;
+    bool operator==(const InstanceBatchKey& rhs) const {
+        return mesh == rhs.mesh && material == rhs.material && texture == rhs.texture;
+    }
+};
+
+struct InstanceBatchKeyHash
+{
+    std::size_t operator()(const InstanceBatchKey& key) const {
+        std::hash<void*> hash;
+        std::size_t h = hash(key.mesh);
+        h ^= hash(key.material) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        h ^= hash(key.texture) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
 class ScopedShaderProgramActivator
 {
     GLSLSceneRenderer::Impl* renderer;
@@ -352,6 +431,8 @@ public:
     bool isRenderingVisibleImage;
     bool isRenderingPickingImage;
     bool isPickingImageOutputEnabled;
+    bool isRayPickingEnabled;
+    unique_ptr<SceneRayPicker> rayPicker;
     bool isShadowCastingAvailable;
     bool isWorldLightShadowEnabled;
     bool isRenderingShadowMap;
@@ -360,6 +441,27 @@ public:
     bool isLowMemoryConsumptionRenderingBeingProcessed;
     bool isBoundingBoxRenderingMode;
     bool isBoundingBoxRenderingForLightweightRenderingGroupEnabled;
+    bool isViewFrustumCullingEnabled;
+    double smallFeatureCullingPixelSize;
+    Vector4 viewFrustumPlanes[6];
+    int numCulledNodes;
+    int numDrawnShapes;
+
+    bool isInstancingEnabled;
+    bool isCollectingInstances;
+    int minNumInstancesToBatch;
+    int numInstancedDrawCalls;
+    int numInstancedShapes;
+    unsigned int instancingFrameCounter;
+
+    struct InstanceBatch {
+        SgShape* shape;
+        SgTexture* texture;
+        Affine3Array modelTransforms;
+    };
+    vector<InstanceBatch> instanceBatches;
+    int numActiveInstanceBatches;
+    unordered_map<InstanceBatchKey, int, InstanceBatchKeyHash> instanceBatchIndexMap;
 
     Affine3Array modelMatrixStack; // stack of the model matrices
     Affine3Array modelMatrixBuffer; // Model matrices used later are stored in this buffer
@@ -413,6 +515,16 @@ public:
 
     vector<char> scaledImageBuf;
 
+    /**
+       When the vertices of a mesh are written with indices, each element of this array
+       is the face vertex index (the index in triangleVertices) that represents the
+       corresponding vertex in the vertex buffer objects.
+    */
+    vector<int> faceVertexIndicesOfIndexedVertices;
+    bool isWritingIndexedVertices;
+    size_t totalVertexBufferBytes;
+    size_t totalDeindexedVertexBufferBytes;
+
     bool isTextureEnabled;
     bool isTextureBeingRendered;
     bool isCurrentFogUpdated;
@@ -481,9 +593,17 @@ public:
     void doRender();
     void setupFullLightingRendering();
     bool doPick(int x, int y);
+    bool doRayPick(int x, int y, bool& out_isPicked);
     bool renderShadowMap(int lightIndex);
     bool renderShadowMap(SgLight* light, const Isometry3& T);
     void renderCamera(SgCamera* camera, const Isometry3& cameraPosition);
+    void updateViewFrustumPlanes();
+    bool isCullingEnabled() const {
+        return isViewFrustumCullingEnabled || smallFeatureCullingPixelSize > 0.0;
+    }
+    bool checkIfOutOfView(const BoundingBox& bbox, const Affine3& T);
+    bool checkIfGroupCulled(SgGroup* group);
+    bool isCullableGroup(SgGroup* group);
     void beginRendering();
     void endRendering();
     void setupNodeVisibilities();
@@ -518,6 +638,12 @@ public:
     void drawBoundingBox(VertexResource* resource, const BoundingBox& bbox);
     void renderShape(SgShape* shape);
     void renderShapeMain(SgShape* shape, const Affine3& modelTransform, int pickIndex);
+    void renderShapeAppearance(SgShape* shape);
+    bool checkIfInstanceCollectable();
+    void collectInstance(SgShape* shape);
+    void renderInstanceBatches();
+    void renderInstanceBatch(InstanceBatch& batch);
+    VertexResource::InstanceBuffer* updateInstanceBuffer(VertexResource* resource, InstanceBatch& batch);
     void applyCullingMode(SgMesh* mesh);
     void renderShapeVertices(SgShape* shape);
     void renderPlot(
@@ -544,6 +670,15 @@ public:
     bool renderTexture(SgTexture* texture);
     bool loadTextureImage(TextureResource* resource, const Image& image);
     void makeVertexBufferObjects(SgShape* shape, VertexResource* resource);
+    bool makeVertexIndices(SgMesh* mesh, bool hasNormals, bool hasTexCoords, vector<int>& out_indices);
+    void writeMeshIndices(VertexResource* resource, const vector<int>& indices);
+    int numVerticesToWrite(SgMesh* mesh) const {
+        return isWritingIndexedVertices ?
+            faceVertexIndicesOfIndexedVertices.size() : mesh->triangleVertices().size();
+    }
+    int faceVertexIndexOfVertexToWrite(int index) const {
+        return isWritingIndexedVertices ? faceVertexIndicesOfIndexedVertices[index] : index;
+    }
     void writeMeshVertices(SgMesh* mesh, VertexResource* resource, SgTexture* texResource);
     template<typename value_type, GLenum gltype, GLboolean normalized, class VertexArrayWrapper>
     void writeMeshVerticesSub(SgMesh* mesh, VertexResource* resource, VertexArrayWrapper& normals);
@@ -701,6 +836,11 @@ void GLSLSceneRenderer::Impl::initialize()
     isRenderingVisibleImage = false;
     isRenderingPickingImage = false;
     isPickingImageOutputEnabled = false;
+    isRayPickingEnabled = true;
+    char* CNOID_ENABLE_GLSL_RAY_PICKING = getenv("CNOID_ENABLE_GLSL_RAY_PICKING");
+    if(CNOID_ENABLE_GLSL_RAY_PICKING && (strcmp(CNOID_ENABLE_GLSL_RAY_PICKING, "0") == 0)){
+        isRayPickingEnabled = false;
+    }
     isShadowCastingAvailable = true;
     isWorldLightShadowEnabled = false;
     isRenderingShadowMap = false;
@@ -708,6 +848,27 @@ void GLSLSceneRenderer::Impl::initialize()
     isBoundingBoxRenderingMode = false;
     isBoundingBoxRenderingForLightweightRenderingGroupEnabled = false;
 
+    isViewFrustumCullingEnabled = true;
+    char* CNOID_ENABLE_GLSL_VIEW_FRUSTUM_CULLING = getenv("CNOID_ENABLE_GLSL_VIEW_FRUSTUM_CULLING");
+    if(CNOID_ENABLE_GLSL_VIEW_FRUSTUM_CULLING && (strcmp(CNOID_ENABLE_GLSL_VIEW_FRUSTUM_CULLING, "0") == 0)){
+        isViewFrustumCullingEnabled = false;
+    }
+    smallFeatureCullingPixelSize = 0.0;
+    numCulledNodes = 0;
+    numDrawnShapes = 0;
+
+    isInstancingEnabled = true;
+    char* CNOID_ENABLE_GLSL_INSTANCING = getenv("CNOID_ENABLE_GLSL_INSTANCING");
+    if(CNOID_ENABLE_GLSL_INSTANCING && (strcmp(CNOID_ENABLE_GLSL_INSTANCING, "0") == 0)){
+        isInstancingEnabled = false;
+    }
+    isCollectingInstances = false;
+    minNumInstancesToBatch = 4;
+    numInstancedDrawCalls = 0;
+    numInstancedShapes = 0;
+    instancingFrameCounter = 0;
+    numActiveInstanceBatches = 0;
+
     defaultFBO = 0;
     
     lightingMode = NormalLighting;
@@ -725,6 +886,10 @@ void GLSLSceneRenderer::Impl::initialize()
     minTransparency = 0.0f;
     isTextureEnabled = true;
 
+    isWritingIndexedVertices = false;
+    totalVertexBufferBytes = 0;
+    totalDeindexedVertexBufferBytes = 0;
+
     isNormalVisualizationEnabled = false;
     normalVisualizationLength = 0.0f;
     normalVisualizationMaterial = new SgMaterial;
@@ -1263,6 +1428,11 @@ void GLSLSceneRenderer::Impl::doRender()
 
     beginRendering();
 
+    numCulledNodes = 0;
+    numDrawnShapes = 0;
+    numInstancedDrawCalls = 0;
+    numInstancedShapes = 0;
+    ++instancingFrameCounter;
     isLightweightRenderingBeingProcessed = false;
     isLowMemoryConsumptionRenderingBeingProcessed = isLowMemoryConsumptionMode;
     isTextureBeingRendered = false;
@@ -1305,7 +1475,12 @@ void GLSLSceneRenderer::Impl::doRender()
 
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
+        isCollectingInstances = isInstancingEnabled && (currentProgram == fullLightingProgram.get());
         renderChildNodes(self->sceneRoot());
+        if(isCollectingInstances){
+            isCollectingInstances = false;
+            renderInstanceBatches();
+        }
         
         /*
           \todo Render transparent objects directly
@@ -1391,6 +1566,13 @@ bool GLSLSceneRenderer::doPick(int x, int y)
 
 bool GLSLSceneRenderer::Impl::doPick(int x, int y)
 {
+    if(isRayPickingEnabled && !isPickingImageOutputEnabled){
+        bool isPicked;
+        if(doRayPick(x, y, isPicked)){
+            return isPicked;
+        }
+    }
+    
     if(isGLCleared){
         initializeGLForRendering();
     }
@@ -1507,6 +1689,77 @@ bool GLSLSceneRenderer::Impl::doPick(int x, int y)
 }
 
 
+/**
+   The picking is done by casting a ray into the bounding volume hierarchies of the scene
+   meshes without rendering the picking image. The picking image is rendered only when
+   the ray may hit the nodes whose shapes are not evaluated by the ray picker, or when
+   the nodes rendered differently from the scene graph exist.
+   @return true if the picking is done by the ray. out_isPicked is set in that case.
+*/
+bool GLSLSceneRenderer::Impl::doRayPick(int x, int y, bool& out_isPicked)
+{
+    if(!invisibleNodeSet.empty() || !nodeDecorationInfoArrayMap.empty()){
+        return false;
+    }
+    auto camera = self->currentCamera();
+    if(!camera){
+        return false;
+    }
+    auto& vp = self->viewport();
+    if(vp.w <= 0 || vp.h <= 0){
+        return false;
+    }
+    
+    renderCamera(camera, self->currentCameraPosition());
+
+    // The ray passes the center of the pixel from the near clip plane to the far clip plane
+    const Matrix4 PVinv = PV.inverse();
+    Vector4 p;
+    p[0] = 2.0 * (x + 0.5 - vp.x) / vp.w - 1.0;
+    p[1] = 2.0 * (y + 0.5 - vp.y) / vp.h - 1.0;
+    p[2] = -1.0;
+    p[3] = 1.0;
+    Vector4 p0 = PVinv * p;
+    p[2] = 1.0;
+    Vector4 p1 = PVinv * p;
+    if(p0[3] == 0.0 || p1[3] == 0.0){
+        return false;
+    }
+    const Vector3 origin = p0.head<3>() / p0[3];
+    const Vector3 direction = p1.head<3>() / p1[3] - origin;
+    
+    if(!rayPicker){
+        rayPicker.reset(new SceneRayPicker);
+    }
+    rayPicker->setSceneRoot(self->sceneRoot());
+    bool isPicked = rayPicker->pick(origin, direction, direction.norm());
+    if(rayPicker->isPickingUncertain()){
+        return false;
+    }
+
+    pickedNodePath.clear();
+    if(isPicked){
+        pickedNodePath = rayPicker->pickedNodePath();
+        pickedPoint = rayPicker->pickedPoint();
+    }
+    out_isPicked = isPicked;
+    
+    return true;
+}
+
+
+void GLSLSceneRenderer::setRayPickingEnabled(bool on)
+{
+    impl->isRayPickingEnabled = on;
+}
+
+
+bool GLSLSceneRenderer::isRayPickingEnabled() const
+{
+    return impl->isRayPickingEnabled;
+}
+
+
 void GLSLSceneRenderer::setPickingImageOutputEnabled(bool on)
 {
     impl->isPickingImageOutputEnabled = on;
@@ -1597,6 +1850,7 @@ void GLSLSceneRenderer::Impl::renderCamera(SgCamera* camera, const Isometry3& ca
         viewTransform = cameraPosition.inverse(Eigen::Isometry);
     }
     PV = projectionMatrix * viewTransform.matrix();
+    updateViewFrustumPlanes();
 
     modelMatrixStack.clear();
     modelMatrixStack.push_back(Affine3::Identity());
@@ -1604,6 +1858,89 @@ void GLSLSceneRenderer::Impl::renderCamera(SgCamera* camera, const Isometry3& ca
 }
 
 
+/**
+   The planes are extracted from the view projection matrix so that a point p satisfies
+   plane.head<3>().dot(p) + plane[3] >= 0 for all the planes when it is in the view volume.
+*/
+void GLSLSceneRenderer::Impl::updateViewFrustumPlanes()
+{
+    for(int i=0; i < 3; ++i){
+        viewFrustumPlanes[i * 2] = PV.row(3).transpose() + PV.row(i).transpose();
+        viewFrustumPlanes[i * 2 + 1] = PV.row(3).transpose() - PV.row(i).transpose();
+    }
+}
+
+
+bool GLSLSceneRenderer::Impl::checkIfOutOfView(const BoundingBox& bbox, const Affine3& T)
+{
+    const Vector3 c = T * bbox.center();
+    const Vector3 e = T.linear().cwiseAbs() * (0.5 * bbox.size());
+
+    if(isViewFrustumCullingEnabled){
+        for(auto& plane : viewFrustumPlanes){
+            auto n = plane.head<3>();
+            if(n.dot(c) + plane[3] < -n.cwiseAbs().dot(e)){
+                return true;
+            }
+        }
+    }
+    if(smallFeatureCullingPixelSize > 0.0 && !isRenderingShadowMap){
+        double r = self->projectedPixelSizeRatio(c);
+        if(r > 0.0 && 2.0 * e.norm() * r < smallFeatureCullingPixelSize){
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool GLSLSceneRenderer::Impl::checkIfGroupCulled(SgGroup* group)
+{
+    auto& bbox = group->boundingBox();
+    if(bbox.empty() || !checkIfOutOfView(bbox, modelMatrixStack.back())){
+        return false;
+    }
+    if(!isCullableGroup(group)){
+        return false;
+    }
+    if(isRenderingVisibleImage){
+        ++numCulledNodes;
+    }
+    return true;
+}
+
+
+bool GLSLSceneRenderer::Impl::isCullableGroup(SgGroup* group)
+{
+    auto resource = getOrCreateGLResource<CullingResource>(group);
+
+    if(!resource->isCullabilityChecked){
+        bool isCullable = true;
+        if(dynamic_cast<SgOverlay*>(group) || dynamic_cast<SgFixedPixelSizeGroup*>(group)){
+            isCullable = false;
+        } else {
+            for(auto& child : *group){
+                if(child->hasAttribute(SgObject::Marker)){
+                    // Marker nodes are not included in the bounding box of the group
+                    isCullable = false;
+                } else if(child->isGroupNode()){
+                    isCullable = isCullableGroup(static_cast<SgGroup*>(child.get()));
+                } else if(!dynamic_cast<SgPreprocessed*>(child.get())){
+                    isCullable = !child->boundingBox().empty();
+                }
+                if(!isCullable){
+                    break;
+                }
+            }
+        }
+        resource->isCullable = isCullable;
+        resource->isCullabilityChecked = true;
+    }
+
+    return resource->isCullable;
+}
+
+
 void GLSLSceneRenderer::Impl::beginRendering()
 {
     ++renderingFrameId;
@@ -2073,6 +2410,9 @@ void GLSLSceneRenderer::Impl::renderChildNodesWithNodeDecorationCheck(SgGroup* g
 
 void GLSLSceneRenderer::Impl::renderGroup(SgGroup* group)
 {
+    if(isCullingEnabled() && checkIfGroupCulled(group)){
+        return;
+    }
     pushPickNode(group);
     renderChildNodes(group);
     popPickNode();
@@ -2106,6 +2446,9 @@ void GLSLSceneRenderer::Impl::renderUnpickableGroup(SgUnpickableGroup* group)
 void GLSLSceneRenderer::Impl::renderTransform(SgTransform* transform)
 {
     if(!transform->empty()){
+        if(isCullingEnabled() && checkIfGroupCulled(transform)){
+            return;
+        }
         Affine3 T;
         transform->getTransform(T);
         modelMatrixStack.push_back(modelMatrixStack.back() * T);
@@ -2178,7 +2521,11 @@ void GLSLSceneRenderer::Impl::drawVertexResource
 {
     currentProgram->setTransform(PV, viewTransform, modelTransform, resource->pLocalTransform);
     glBindVertexArray(resource->vao);
-    glDrawArrays(primitiveMode, 0, resource->numVertices);
+    if(resource->indexType){
+        glDrawElements(primitiveMode, resource->numIndices, resource->indexType, nullptr);
+    } else {
+        glDrawArrays(primitiveMode, 0, resource->numVertices);
+    }
 }
 
 
@@ -2221,6 +2568,15 @@ void GLSLSceneRenderer::Impl::renderShape(SgShape* shape)
 {
     SgMesh* mesh = shape->mesh();
     if(mesh && mesh->hasVertices()){
+        if(isCullingEnabled()){
+            auto& bbox = mesh->boundingBox();
+            if(!bbox.empty() && checkIfOutOfView(bbox, modelMatrixStack.back())){
+                if(isRenderingVisibleImage){
+                    ++numCulledNodes;
+                }
+                return;
+            }
+        }
         SgMaterial* material = shape->material();
         bool isTransparent = false;
         if(currentProgram->hasCapability(ShaderProgram::Transparency)){
@@ -2229,9 +2585,13 @@ void GLSLSceneRenderer::Impl::renderShape(SgShape* shape)
             }
         }
         if(!isTransparent){
-            auto pickIndex = pushPickEndNode(shape, false);
-            renderShapeMain(shape, modelMatrixStack.back(), pickIndex);
-            popPickNode();
+            if(checkIfInstanceCollectable()){
+                collectInstance(shape);
+            } else {
+                auto pickIndex = pushPickEndNode(shape, false);
+                renderShapeMain(shape, modelMatrixStack.back(), pickIndex);
+                popPickNode();
+            }
         } else {
             if(!isRenderingShadowMap){
                 SgShapePtr shapePtr = shape;
@@ -2255,20 +2615,7 @@ void GLSLSceneRenderer::Impl::renderShapeMain(SgShape* shape, const Affine3& mod
     if(isRenderingPickingImage){
         setPickColor(pickIndex);
     } else {
-        renderMaterial(shape->material());
-        if(mesh->hasColors()){
-            currentProgram->setVertexColorEnabled(true);
-        }
-
-        if(currentMaterialLightingProgram){
-            bool isTextureValid = false;
-            if(isTextureBeingRendered){
-                if(auto texture = shape->texture()){
-                    isTextureValid = renderTexture(texture);
-                }
-            }
-            currentMaterialLightingProgram->setTextureEnabled(isTextureValid);
-        }
+        renderShapeAppearance(shape);
     }
 
     VertexResource* resource = getOrCreateVertexResource(mesh);
@@ -2282,6 +2629,9 @@ void GLSLSceneRenderer::Impl::renderShapeMain(SgShape* shape, const Affine3& mod
             applyCullingMode(mesh);
         }
         drawVertexResource(resource, GL_TRIANGLES, modelTransform);
+        if(isRenderingVisibleImage){
+            ++numDrawnShapes;
+        }
 
         if(isNormalVisualizationEnabled && isRenderingVisibleImage && resource->normalVisualization){
             renderLineSet(resource->normalVisualization);
@@ -2290,6 +2640,199 @@ void GLSLSceneRenderer::Impl::renderShapeMain(SgShape* shape, const Affine3& mod
 }
 
 
+void GLSLSceneRenderer::Impl::renderShapeAppearance(SgShape* shape)
+{
+    renderMaterial(shape->material());
+    if(shape->mesh()->hasColors()){
+        currentProgram->setVertexColorEnabled(true);
+    }
+
+    if(currentMaterialLightingProgram){
+        bool isTextureValid = false;
+        if(isTextureBeingRendered){
+            if(auto texture = shape->texture()){
+                isTextureValid = renderTexture(texture);
+            }
+        }
+        currentMaterialLightingProgram->setTextureEnabled(isTextureValid);
+    }
+}
+
+
+/**
+   Opaque shapes rendered with the full lighting program in the usual state are not
+   rendered immediately but collected into the batches of the shapes sharing the same
+   mesh, material and texture. The batches are rendered after the scene graph traversal.
+*/
+bool GLSLSceneRenderer::Impl::checkIfInstanceCollectable()
+{
+    return isCollectingInstances &&
+        currentProgram == fullLightingProgram.get() &&
+        !fullLightingProgram->isWireframeEnabled() &&
+        !isBoundingBoxRenderingMode &&
+        !isLowMemoryConsumptionRenderingBeingProcessed &&
+        !isNormalVisualizationEnabled;
+}
+
+
+void GLSLSceneRenderer::Impl::collectInstance(SgShape* shape)
+{
+    SgTexture* texture = isTextureBeingRendered ? shape->texture() : nullptr;
+    InstanceBatchKey key { shape->mesh(), shape->material(), texture };
+    auto inserted = instanceBatchIndexMap.emplace(key, numActiveInstanceBatches);
+    if(inserted.second){
+        if(numActiveInstanceBatches == static_cast<int>(instanceBatches.size())){
+            instanceBatches.emplace_back();
+        }
+        auto& batch = instanceBatches[numActiveInstanceBatches++];
+        batch.shape = shape;
+        batch.texture = texture;
+    }
+    instanceBatches[inserted.first->second].modelTransforms.push_back(modelMatrixStack.back());
+}
+
+
+void GLSLSceneRenderer::Impl::renderInstanceBatches()
+{
+    for(int i=0; i < numActiveInstanceBatches; ++i){
+        auto& batch = instanceBatches[i];
+        renderInstanceBatch(batch);
+        batch.shape = nullptr;
+        batch.texture = nullptr;
+        batch.modelTransforms.clear();
+    }
+    numActiveInstanceBatches = 0;
+    instanceBatchIndexMap.clear();
+}
+
+
+void GLSLSceneRenderer::Impl::renderInstanceBatch(InstanceBatch& batch)
+{
+    auto shape = batch.shape;
+    auto& transforms = batch.modelTransforms;
+    const int numInstances = transforms.size();
+
+    VertexResource* resource = nullptr;
+    if(numInstances >= minNumInstancesToBatch){
+        resource = getOrCreateVertexResource(shape->mesh());
+        if(!resource->isValid()){
+            makeVertexBufferObjects(shape, resource);
+        }
+        if(resource->pLocalTransform){
+            resource = nullptr;
+        }
+    }
+    if(!resource){
+        for(auto& T : transforms){
+            renderShapeMain(shape, T, -1);
+        }
+        return;
+    }
+
+    renderShapeAppearance(shape);
+    applyCullingMode(shape->mesh());
+    updateInstanceBuffer(resource, batch);
+
+    fullLightingProgram->setInstancingEnabled(true);
+    fullLightingProgram->setTransform(PV, viewTransform, Affine3::Identity(), nullptr);
+    if(resource->indexType){
+        glDrawElementsInstanced(
+            GL_TRIANGLES, resource->numIndices, resource->indexType, nullptr, numInstances);
+    } else {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, resource->numVertices, numInstances);
+    }
+    fullLightingProgram->setInstancingEnabled(false);
+
+    ++numInstancedDrawCalls;
+    numInstancedShapes += numInstances;
+    numDrawnShapes += numInstances;
+}
+
+
+/**
+   The instance matrices are compared with the ones written in the previous frame and
+   only the range containing the changed matrices is written to the buffer. Since the
+   model matrices only change when the transform nodes are updated, the data transfer
+   is usually limited to the instances moved by the scene graph updates.
+*/
+VertexResource::InstanceBuffer* GLSLSceneRenderer::Impl::updateInstanceBuffer
+(VertexResource* resource, InstanceBatch& batch)
+{
+    const SgMaterial* material = batch.shape->material();
+    VertexResource::InstanceBuffer* buffer = nullptr;
+    VertexResource::InstanceBuffer* unusedBuffer = nullptr;
+    for(auto& instanceBuffer : resource->instanceBuffers){
+        if(instanceBuffer.material == material && instanceBuffer.texture == batch.texture){
+            buffer = &instanceBuffer;
+            break;
+        }
+        if(!unusedBuffer && (instancingFrameCounter - instanceBuffer.frameCounter > 1)){
+            unusedBuffer = &instanceBuffer;
+        }
+    }
+    if(!buffer){
+        if(unusedBuffer){
+            buffer = unusedBuffer;
+        } else {
+            resource->instanceBuffers.emplace_back();
+            buffer = &resource->instanceBuffers.back();
+            glGenBuffers(1, &buffer->vbo);
+            buffer->capacity = 0;
+        }
+        buffer->material = material;
+        buffer->texture = batch.texture;
+        buffer->matrices.clear();
+    }
+    buffer->frameCounter = instancingFrameCounter;
+
+    glBindVertexArray(resource->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer->vbo);
+
+    auto& transforms = batch.modelTransforms;
+    auto& matrices = buffer->matrices;
+    const int numInstances = transforms.size();
+    const int prevNumInstances = matrices.size();
+    matrices.resize(numInstances);
+    
+    if(numInstances > buffer->capacity){
+        for(int i=0; i < numInstances; ++i){
+            matrices[i] = transforms[i].matrix().cast<float>();
+        }
+        buffer->capacity = numInstances + numInstances / 2;
+        glBufferData(GL_ARRAY_BUFFER, buffer->capacity * sizeof(Matrix4f), nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, numInstances * sizeof(Matrix4f), matrices.data());
+    } else {
+        int first = numInstances;
+        int last = -1;
+        for(int i=0; i < numInstances; ++i){
+            const Matrix4f M = transforms[i].matrix().cast<float>();
+            if(i >= prevNumInstances || M != matrices[i]){
+                matrices[i] = M;
+                if(i < first){
+                    first = i;
+                }
+                last = i;
+            }
+        }
+        if(last >= first){
+            glBufferSubData(
+                GL_ARRAY_BUFFER, first * sizeof(Matrix4f), (last - first + 1) * sizeof(Matrix4f), &matrices[first]);
+        }
+    }
+
+    // The columns of the instance model matrix are given to the attribute locations from 4 to 7
+    for(int i=0; i < 4; ++i){
+        const GLuint location = 4 + i;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(
+            location, 4, GL_FLOAT, GL_FALSE, sizeof(Matrix4f), ((GLubyte*)NULL + (i * 4 * sizeof(float))));
+        glVertexAttribDivisor(location, 1);
+    }
+
+    return buffer;
+}
+
+
 void GLSLSceneRenderer::Impl::applyCullingMode(SgMesh* mesh)
 {
     if(!stateFlag[CULL_FACE]){
@@ -2428,6 +2971,12 @@ bool GLSLSceneRenderer::Impl::loadTextureImage(TextureResource* resource, const
 void GLSLSceneRenderer::Impl::makeVertexBufferObjects(SgShape* shape, VertexResource* resource)
 {
     auto mesh = shape->mesh();
+    auto texture = shape->texture();
+    const bool hasTexCoords = texture && mesh->hasTexCoords() && isTextureBeingRendered;
+
+    vector<int> indices;
+    isWritingIndexedVertices =
+        makeVertexIndices(mesh, defaultSmoothShading && mesh->normals(), hasTexCoords, indices);
 
     if(isLowMemoryConsumptionRenderingBeingProcessed){
         writeMeshVerticesNormalizedShort(mesh, resource);
@@ -2444,8 +2993,7 @@ void GLSLSceneRenderer::Impl::makeVertexBufferObjects(SgShape* shape, VertexReso
         writeMeshNormalsShort(mesh, resource);
     } 
 
-    auto texture = shape->texture();
-    if(texture && mesh->hasTexCoords() && isTextureBeingRendered){
+    if(hasTexCoords){
         if(isLowMemoryConsumptionRenderingBeingProcessed){
             writeMeshTexCoordsHalfFloat(mesh, texture, resource);
         } else {
@@ -2456,6 +3004,146 @@ void GLSLSceneRenderer::Impl::makeVertexBufferObjects(SgShape* shape, VertexReso
     if(mesh->hasColors()){
         writeMeshColors(mesh, resource);
     }
+
+    const size_t numFaceVertices = mesh->triangleVertices().size();
+    if(!isWritingIndexedVertices){
+        totalDeindexedVertexBufferBytes += resource->numBufferBytes;
+    } else {
+        totalDeindexedVertexBufferBytes +=
+            resource->numBufferBytes / resource->numVertices * numFaceVertices;
+        writeMeshIndices(resource, indices);
+        isWritingIndexedVertices = false;
+        faceVertexIndicesOfIndexedVertices.clear();
+    }
+    totalVertexBufferBytes += resource->numBufferBytes;
+}
+
+
+namespace {
+
+struct FaceVertexKey
+{
+    int vertexIndex;
+    int normalIndex;
+    int texCoordIndex;
+    int colorIndex;
+    bool operator==(const FaceVertexKey& rhs) const {
+        return vertexIndex == rhs.vertexIndex && normalIndex == rhs.normalIndex &&
+            texCoordIndex == rhs.texCoordIndex && colorIndex == rhs.colorIndex;
+    }
+};
+
+struct FaceVertexKeyHash
+{
+    std::size_t operator()(const FaceVertexKey& key) const {
+        std::size_t h = key.vertexIndex;
+        h = h * 31 + key.normalIndex;
+        h = h * 31 + key.texCoordIndex;
+        h = h * 31 + key.colorIndex;
+        return h;
+    }
+};
+
+}
+
+
+/**
+   This function gives the index of the vertex written to the vertex buffer objects
+   for each face vertex. When all the attributes share the vertex indices, a vertex
+   of the mesh is directly mapped to a vertex of the buffer objects. Otherwise face
+   vertices that have the same combination of the attribute indices are welded into
+   a single vertex.
+   @return false when the indices do not reduce the number of the vertices to write.
+   In that case the de-indexed vertices are written.
+*/
+bool GLSLSceneRenderer::Impl::makeVertexIndices
+(SgMesh* mesh, bool hasNormals, bool hasTexCoords, vector<int>& out_indices)
+{
+    // Flat shading gives a different normal to each face vertex
+    if(!defaultSmoothShading){
+        return false;
+    }
+
+    auto& triangleVertices = mesh->triangleVertices();
+    const int numFaceVertices = triangleVertices.size();
+    const SgIndexArray* normalIndices = nullptr;
+    const SgIndexArray* texCoordIndices = nullptr;
+    const SgIndexArray* colorIndices = nullptr;
+    if(hasNormals && !mesh->normalIndices().empty()){
+        normalIndices = &mesh->normalIndices();
+    }
+    if(hasTexCoords && !mesh->texCoordIndices().empty()){
+        texCoordIndices = &mesh->texCoordIndices();
+    }
+    if(mesh->hasColors() && !mesh->colorIndices().empty()){
+        colorIndices = &mesh->colorIndices();
+    }
+
+    auto& faceVertexIndices = faceVertexIndicesOfIndexedVertices;
+    faceVertexIndices.clear();
+    out_indices.resize(numFaceVertices);
+
+    if(!normalIndices && !texCoordIndices && !colorIndices){
+        vector<int> vertexMap(mesh->vertices()->size(), -1);
+        for(int i=0; i < numFaceVertices; ++i){
+            int& index = vertexMap[triangleVertices[i]];
+            if(index < 0){
+                index = faceVertexIndices.size();
+                faceVertexIndices.push_back(i);
+            }
+            out_indices[i] = index;
+        }
+    } else {
+        std::unordered_map<FaceVertexKey, int, FaceVertexKeyHash> vertexMap;
+        vertexMap.reserve(numFaceVertices);
+        for(int i=0; i < numFaceVertices; ++i){
+            FaceVertexKey key;
+            key.vertexIndex = triangleVertices[i];
+            key.normalIndex = normalIndices ? (*normalIndices)[i] : -1;
+            key.texCoordIndex = texCoordIndices ? (*texCoordIndices)[i] : -1;
+            key.colorIndex = colorIndices ? (*colorIndices)[i] : -1;
+            auto inserted = vertexMap.emplace(key, faceVertexIndices.size());
+            if(inserted.second){
+                faceVertexIndices.push_back(i);
+            }
+            out_indices[i] = inserted.first->second;
+        }
+    }
+
+    if(faceVertexIndices.size() >= static_cast<size_t>(numFaceVertices)){
+        faceVertexIndices.clear();
+        out_indices.clear();
+        return false;
+    }
+
+    return true;
+}
+
+
+void GLSLSceneRenderer::Impl::writeMeshIndices(VertexResource* resource, const vector<int>& indices)
+{
+    const size_t n = indices.size();
+    GLuint buffer;
+    {
+        LockVertexArrayAPI lock;
+        glBindVertexArray(resource->vao);
+        buffer = resource->newBuffer();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    }
+    size_t size;
+    if(resource->numVertices <= std::numeric_limits<GLushort>::max() + 1){
+        vector<GLushort> shortIndices(indices.begin(), indices.end());
+        size = n * sizeof(GLushort);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, shortIndices.data(), GL_STATIC_DRAW);
+        resource->indexType = GL_UNSIGNED_SHORT;
+    } else {
+        size = n * sizeof(GLuint);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices.data(), GL_STATIC_DRAW);
+        resource->indexType = GL_UNSIGNED_INT;
+    }
+    resource->numIndices = n;
+    resource->numBufferBytes += size;
+    totalVertexBufferBytes += size;
 }
 
 
@@ -2465,19 +3153,14 @@ void GLSLSceneRenderer::Impl::writeMeshVerticesSub
 {
     const auto& orgVertices = *mesh->vertices();
     auto& triangleVertices = mesh->triangleVertices();
-    const int totalNumVertices = triangleVertices.size();
-    const int numTriangles = mesh->numTriangles();
+    const int totalNumVertices = numVerticesToWrite(mesh);
     resource->numVertices = totalNumVertices;
 
-    int faceVertexIndex = 0;
-    
     vertices.array.reserve(totalNumVertices);
     
-    for(int i=0; i < numTriangles; ++i){
-        for(int j=0; j < 3; ++j){
-            const int orgVertexIndex = triangleVertices[faceVertexIndex++];
-            vertices.append(orgVertices[orgVertexIndex]);
-        }
+    for(int i=0; i < totalNumVertices; ++i){
+        const int orgVertexIndex = triangleVertices[faceVertexIndexOfVertexToWrite(i)];
+        vertices.append(orgVertices[orgVertexIndex]);
     }
 
     {
@@ -2488,6 +3171,7 @@ void GLSLSceneRenderer::Impl::writeMeshVerticesSub
     }
     auto size = vertices.array.size() * sizeof(value_type);
     glBufferData(GL_ARRAY_BUFFER, size, vertices.array.data(), GL_STATIC_DRAW);
+    resource->numBufferBytes += size;
     glEnableVertexAttribArray(0);
 }
 
@@ -2556,13 +3240,13 @@ bool GLSLSceneRenderer::Impl::writeMeshNormalsSub
     bool ready = false;
     
     auto& triangleVertices = mesh->triangleVertices();
-    const int totalNumVertices = triangleVertices.size();
+    const int totalNumVertices = numVerticesToWrite(mesh);
     const int numTriangles = mesh->numTriangles();
     
     normals.array.reserve(totalNumVertices);
 
     if(!defaultSmoothShading){
-        // flat shading
+        // flat shading, which is always written with the de-indexed vertices
         const auto& orgVertices = *mesh->vertices();
         for(int i=0; i < numTriangles; ++i){
             SgMesh::TriangleRef triangle = mesh->triangle(i);
@@ -2578,20 +3262,15 @@ bool GLSLSceneRenderer::Impl::writeMeshNormalsSub
     } else if(mesh->normals()){
         const auto& orgNormals = *mesh->normals();
         const auto& normalIndices = mesh->normalIndices();
-        int faceVertexIndex = 0;
         if(normalIndices.empty()){
-            for(int i=0; i < numTriangles; ++i){
-                for(int j=0; j < 3; ++j){
-                    const int orgVertexIndex = triangleVertices[faceVertexIndex++];
-                    normals.append(orgNormals[orgVertexIndex]);
-                }
+            for(int i=0; i < totalNumVertices; ++i){
+                const int orgVertexIndex = triangleVertices[faceVertexIndexOfVertexToWrite(i)];
+                normals.append(orgNormals[orgVertexIndex]);
             }
         } else {
-            for(int i=0; i < numTriangles; ++i){
-                for(int j=0; j < 3; ++j){
-                    const int normalIndex = normalIndices[faceVertexIndex++];
-                    normals.append(orgNormals[normalIndex]);
-                }
+            for(int i=0; i < totalNumVertices; ++i){
+                const int normalIndex = normalIndices[faceVertexIndexOfVertexToWrite(i)];
+                normals.append(orgNormals[normalIndex]);
             }
         }
         ready = true;
@@ -2603,7 +3282,9 @@ bool GLSLSceneRenderer::Impl::writeMeshNormalsSub
             glBindBuffer(GL_ARRAY_BUFFER, resource->newBuffer());
             glVertexAttribPointer((GLuint)1, glsize, gltype, normalized, 0, ((GLubyte*)NULL + (0)));
         }
-        glBufferData(GL_ARRAY_BUFFER, normals.array.size() * sizeof(value_type), normals.array.data(), GL_STATIC_DRAW);
+        auto size = normals.array.size() * sizeof(value_type);
+        glBufferData(GL_ARRAY_BUFFER, size, normals.array.data(), GL_STATIC_DRAW);
+        resource->numBufferBytes += size;
         glEnableVertexAttribArray(1);
     }
     
@@ -2611,16 +3292,12 @@ bool GLSLSceneRenderer::Impl::writeMeshNormalsSub
         auto lines = new SgLineSet;
         auto lineVertices = lines->getOrCreateVertices();
         const auto& orgVertices = *mesh->vertices();
-        int vertexIndex = 0;
-        for(int i=0; i < numTriangles; ++i){
-            for(int j=0; j < 3; ++j){
-                const int orgVertexIndex = triangleVertices[vertexIndex];
-                auto& v = orgVertices[orgVertexIndex];
-                lineVertices->push_back(v);
-                lineVertices->push_back(v + normals.get(vertexIndex) * normalVisualizationLength);
-                lines->addLine(vertexIndex * 2, vertexIndex * 2 + 1);
-                ++vertexIndex;
-            }
+        for(int i=0; i < totalNumVertices; ++i){
+            const int orgVertexIndex = triangleVertices[faceVertexIndexOfVertexToWrite(i)];
+            auto& v = orgVertices[orgVertexIndex];
+            lineVertices->push_back(v);
+            lineVertices->push_back(v + normals.get(i) * normalVisualizationLength);
+            lines->addLine(i * 2, i * 2 + 1);
         }
         lines->setMaterial(normalVisualizationMaterial);
         resource->normalVisualization = lines;
@@ -2721,7 +3398,7 @@ void GLSLSceneRenderer::Impl::writeMeshTexCoordsSub
 (SgMesh* mesh, SgTexture* texture, VertexResource* resource, TexCoordArrayWrapper& texCoords)
 {
     auto& triangleVertices = mesh->triangleVertices();
-    const int totalNumVertices = triangleVertices.size();
+    const int totalNumVertices = numVerticesToWrite(mesh);
     SgTexCoordArrayPtr pOrgTexCoords;
     const auto& texCoordIndices = mesh->texCoordIndices();
 
@@ -2746,22 +3423,16 @@ void GLSLSceneRenderer::Impl::writeMeshTexCoordsSub
     }
 
     texCoords.array.reserve(totalNumVertices);
-    const int numTriangles = mesh->numTriangles();
-    int faceVertexIndex = 0;
     
     if(texCoordIndices.empty()){
-        for(int i=0; i < numTriangles; ++i){
-            for(int j=0; j < 3; ++j){
-                const int orgVertexIndex = triangleVertices[faceVertexIndex++];
-                texCoords.append((*pOrgTexCoords)[orgVertexIndex]);
-            }
+        for(int i=0; i < totalNumVertices; ++i){
+            const int orgVertexIndex = triangleVertices[faceVertexIndexOfVertexToWrite(i)];
+            texCoords.append((*pOrgTexCoords)[orgVertexIndex]);
         }
     } else {
-        for(int i=0; i < numTriangles; ++i){
-            for(int j=0; j < 3; ++j){
-                const int texCoordIndex = texCoordIndices[faceVertexIndex++];
-                texCoords.append((*pOrgTexCoords)[texCoordIndex]);
-            }
+        for(int i=0; i < totalNumVertices; ++i){
+            const int texCoordIndex = texCoordIndices[faceVertexIndexOfVertexToWrite(i)];
+            texCoords.append((*pOrgTexCoords)[texCoordIndex]);
         }
     }
     {
@@ -2771,6 +3442,7 @@ void GLSLSceneRenderer::Impl::writeMeshTexCoordsSub
     }
     auto size = texCoords.array.size() * sizeof(value_type);
     glBufferData(GL_ARRAY_BUFFER, size, texCoords.array.data(), GL_STATIC_DRAW);
+    resource->numBufferBytes += size;
     glEnableVertexAttribArray(2);
 }
 
@@ -2854,7 +3526,7 @@ void GLSLSceneRenderer::Impl::writeMeshTexCoordsUnsignedShort
 void GLSLSceneRenderer::Impl::writeMeshColors(SgMesh* mesh, VertexResource* resource)
 {
     auto& triangleVertices = mesh->triangleVertices();
-    const int totalNumVertices = triangleVertices.size();
+    const int totalNumVertices = numVerticesToWrite(mesh);
     const auto& orgColors = *mesh->colors();
     const auto& colorIndices = mesh->colorIndices();
 
@@ -2862,24 +3534,17 @@ void GLSLSceneRenderer::Impl::writeMeshColors(SgMesh* mesh, VertexResource* reso
     vector<Color> colors;
     colors.reserve(totalNumVertices);
     
-    const int numTriangles = mesh->numTriangles();
-    int faceVertexIndex = 0;
-
     if(colorIndices.empty()){
-        for(int i=0; i < numTriangles; ++i){
-            for(int j=0; j < 3; ++j){
-                const int orgVertexIndex = triangleVertices[faceVertexIndex++];
-                Vector3f c = 255.0f * orgColors[orgVertexIndex];
-                colors.emplace_back(c[0], c[1], c[2]);
-            }
+        for(int i=0; i < totalNumVertices; ++i){
+            const int orgVertexIndex = triangleVertices[faceVertexIndexOfVertexToWrite(i)];
+            Vector3f c = 255.0f * orgColors[orgVertexIndex];
+            colors.emplace_back(c[0], c[1], c[2]);
         }
     } else {
-        for(int i=0; i < numTriangles; ++i){
-            for(int j=0; j < 3; ++j){
-                const int colorIndex = colorIndices[faceVertexIndex++];
-                Vector3f c = 255.0f * orgColors[colorIndex];
-                colors.emplace_back(c[0], c[1], c[2]);
-            }
+        for(int i=0; i < totalNumVertices; ++i){
+            const int colorIndex = colorIndices[faceVertexIndexOfVertexToWrite(i)];
+            Vector3f c = 255.0f * orgColors[colorIndex];
+            colors.emplace_back(c[0], c[1], c[2]);
         }
     }
 
@@ -2888,7 +3553,9 @@ void GLSLSceneRenderer::Impl::writeMeshColors(SgMesh* mesh, VertexResource* reso
         glBindBuffer(GL_ARRAY_BUFFER, resource->newBuffer());
         glVertexAttribPointer((GLuint)3, 3, GL_UNSIGNED_BYTE, GL_TRUE, 0, ((GLubyte*)NULL + (0)));
     }
-    glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(Color), colors.data(), GL_STATIC_DRAW);
+    auto size = colors.size() * sizeof(Color);
+    glBufferData(GL_ARRAY_BUFFER, size, colors.data(), GL_STATIC_DRAW);
+    resource->numBufferBytes += size;
     glEnableVertexAttribArray(3);
 }
     
@@ -3503,6 +4170,90 @@ void GLSLSceneRenderer::Impl::setGlLineWidth(float width)
 }
 
 
+void GLSLSceneRenderer::setViewFrustumCullingEnabled(bool on)
+{
+    impl->isViewFrustumCullingEnabled = on;
+}
+
+
+bool GLSLSceneRenderer::isViewFrustumCullingEnabled() const
+{
+    return impl->isViewFrustumCullingEnabled;
+}
+
+
+void GLSLSceneRenderer::setSmallFeatureCullingPixelSize(double size)
+{
+    impl->smallFeatureCullingPixelSize = size;
+}
+
+
+double GLSLSceneRenderer::smallFeatureCullingPixelSize() const
+{
+    return impl->smallFeatureCullingPixelSize;
+}
+
+
+int GLSLSceneRenderer::numCulledNodes() const
+{
+    return impl->numCulledNodes;
+}
+
+
+int GLSLSceneRenderer::numDrawnShapes() const
+{
+    return impl->numDrawnShapes;
+}
+
+
+void GLSLSceneRenderer::setInstancingEnabled(bool on)
+{
+    impl->isInstancingEnabled = on;
+}
+
+
+bool GLSLSceneRenderer::isInstancingEnabled() const
+{
+    return impl->isInstancingEnabled;
+}
+
+
+void GLSLSceneRenderer::setMinNumInstancesToBatch(int n)
+{
+    impl->minNumInstancesToBatch = std::max(n, 1);
+}
+
+
+int GLSLSceneRenderer::minNumInstancesToBatch() const
+{
+    return impl->minNumInstancesToBatch;
+}
+
+
+int GLSLSceneRenderer::numInstancedDrawCalls() const
+{
+    return impl->numInstancedDrawCalls;
+}
+
+
+int GLSLSceneRenderer::numInstancedShapes() const
+{
+    return impl->numInstancedShapes;
+}
+
+
+/**
+   The first value is the total size of the vertex buffer objects written for meshes so far,
+   including the element array buffers. The second value is the total size that the same
+   meshes would take if all their vertices were written without indices.
+*/
+void GLSLSceneRenderer::getMeshVertexBufferSizes(size_t& out_size, size_t& out_deindexedSize) const
+{
+    out_size = impl->totalVertexBufferBytes;
+    out_deindexedSize = impl->totalDeindexedVertexBufferBytes;
+}
+
+
 void GLSLSceneRenderer::setLightingMode(LightingMode mode)
 {
     if(mode != impl->lightingMode){
@@ -89,6 +89,50 @@ class CNOID_EXPORT GLSLSceneRenderer : public GLSceneRenderer
 
     void setLowMemoryConsumptionMode(bool on);
 
+    /**
+       View frustum culling skips the shapes and groups whose bounding boxes are
+       outside the view volume. It is enabled by default.
+    */
+    void setViewFrustumCullingEnabled(bool on);
+    bool isViewFrustumCullingEnabled() const;
+
+    /**
+       Shapes and groups whose projected sizes are smaller than the specified pixel size
+       are skipped when the size is positive. The default value is zero.
+    */
+    void setSmallFeatureCullingPixelSize(double size);
+    double smallFeatureCullingPixelSize() const;
+
+    //! The number of the nodes culled in the last rendering of the visible image
+    int numCulledNodes() const;
+    //! The number of the shapes drawn in the last rendering of the visible image
+    int numDrawnShapes() const;
+
+    /**
+       Opaque shapes sharing the same mesh, material and texture are rendered with
+       a single instanced draw call when their number is not less than the minimum
+       number of instances. This is enabled by default.
+    */
+    void setInstancingEnabled(bool on);
+    bool isInstancingEnabled() const;
+    void setMinNumInstancesToBatch(int n);
+    int minNumInstancesToBatch() const;
+
+    //! The number of the instanced draw calls in the last rendering of the visible image
+    int numInstancedDrawCalls() const;
+    //! The number of the shapes rendered by the instanced draw calls in the last rendering
+    int numInstancedShapes() const;
+
+    void getMeshVertexBufferSizes(size_t& out_size, size_t& out_deindexedSize) const;
+
+    /**
+       When the ray picking is enabled, the picking is done by SceneRayPicker and the
+       picking image is only rendered when the result of the ray picking is uncertain.
+       It is enabled by default.
+    */
+    void setRayPickingEnabled(bool on);
+    bool isRayPickingEnabled() const;
+
     virtual void setPickingImageOutputEnabled(bool on) override;
     virtual bool getPickingImage(Image& out_image) override;
 
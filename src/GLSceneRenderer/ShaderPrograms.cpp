@@ -209,6 +209,9 @@ public:
     bool isWireframeEnabled;
     Vector4f wireframeColor;
     float wireframeWidth;
+
+    GLint isInstancingEnabledLocation;
+    bool isInstancingEnabled;
     
     // For the shadow casting
     bool isShadowAntiAliasingEnabled;
@@ -1166,6 +1169,7 @@ FullLightingProgram::Impl::Impl(FullLightingProgram* self)
     isWireframeEnabled = false;
     wireframeColor << 0.4f, 0.4f, 0.4f, 0.8f;
     wireframeWidth = 0.5f;
+    isInstancingEnabled = false;
 
     isShadowAntiAliasingEnabled = false;
     shadowMapTextureTopIndex = 10;
@@ -1237,6 +1241,8 @@ void FullLightingProgram::Impl::initialize(GLSLProgram& glsl)
     isWireframeEnabledLocation = glsl.getUniformLocation("isWireframeEnabled");
     wireframeColorLocation = glsl.getUniformLocation("wireframeColor");
     wireframeWidthLocation = glsl.getUniformLocation("wireframeWidth");
+    isInstancingEnabledLocation = glsl.getUniformLocation("isInstancingEnabled");
+    isInstancingEnabled = false;
 
     numShadowsLocation = glsl.getUniformLocation("numShadows");
     shadowInfos.resize(maxNumShadows);
@@ -1418,6 +1424,21 @@ bool FullLightingProgram::isWireframeEnabled() const
 }
 
 
+void FullLightingProgram::setInstancingEnabled(bool on)
+{
+    if(on != impl->isInstancingEnabled){
+        impl->isInstancingEnabled = on;
+        glUniform1i(impl->isInstancingEnabledLocation, on);
+    }
+}
+
+
+bool FullLightingProgram::isInstancingEnabled() const
+{
+    return impl->isInstancingEnabled;
+}
+
+
 void FullLightingProgram::Impl::updateShaderWireframeState()
 {
     if(isWireframeEnabled && isViewportMatrixInvalidated){
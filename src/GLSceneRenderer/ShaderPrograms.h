@@ -327,6 +327,14 @@ public:
     void enableWireframe(const Vector4f& color, float width);
     void disableWireframe();
     bool isWireframeEnabled() const;
+
+    /**
+       When the instanced rendering is enabled, the model matrix of each instance is
+       given by the vertex attribute at location 4 and the model matrix given to
+       setTransform must be the identity matrix.
+    */
+    void setInstancingEnabled(bool on);
+    bool isInstancingEnabled() const;
     
     void activateShadowMapGenerationPass(int shadowIndex);
     void activateMainRenderingPass();
@@ -7,6 +7,9 @@ layout (location = 1) in vec3 vertexNormal;
 layout (location = 2) in vec2 vertexTexCoord;
 layout (location = 3) in vec3 vertexColor;
 
+// Model matrix of each instance used in the instanced rendering
+layout (location = 4) in mat4 instanceModelMatrix;
+
 out VertexData {
     vec3 position;
     vec3 normal;
@@ -36,17 +39,33 @@ uniform mat3 normalMatrix;
 uniform int numShadows;
 uniform mat4 shadowMatrices[MAX_NUM_SHADOWS];
 
+/*
+  When the instanced rendering is enabled, the matrices given as the uniform
+  variables do not contain the model matrix, which is given by instanceModelMatrix.
+*/
+uniform bool isInstancingEnabled = false;
+
 void main()
 {
-    outData.normal = normalize(normalMatrix * vertexNormal);
-    outData.position = vec3(modelViewMatrix * vertexPosition);
+    vec4 position;
+    vec3 normal;
+    if(isInstancingEnabled){
+        position = instanceModelMatrix * vertexPosition;
+        normal = mat3(instanceModelMatrix) * vertexNormal;
+    } else {
+        position = vertexPosition;
+        normal = vertexNormal;
+    }
+    
+    outData.normal = normalize(normalMatrix * normal);
+    outData.position = vec3(modelViewMatrix * position);
 
     outData.texCoord = vertexTexCoord;
     outData.colorV = vertexColor;
     
     for(int i=0; i < numShadows; ++i){
-        outData.shadowCoords[i] = shadowMatrices[i] * vertexPosition;
+        outData.shadowCoords[i] = shadowMatrices[i] * position;
     }
     
-    gl_Position = MVP * vertexPosition;
+    gl_Position = MVP * position;
 }
@@ -3,6 +3,7 @@
 #include "MprBasicStatements.h"
 #include "MprVariableList.h"
 #include "MprMultiVariableListItem.h"
+#include "MprProgramTrajectory.h"
 #include <cnoid/ItemManager>
 #include <cnoid/KinematicBodyItemSet>
 #include <cnoid/DigitalIoDevice>
@@ -10,15 +11,18 @@
 #include <cnoid/BodyItem>
 #include <cnoid/ControllerIO>
 #include <cnoid/MessageView>
+#include <cnoid/MessageOut>
 #include <cnoid/CloneMap>
 #include <cnoid/LazyCaller>
 #include <cnoid/PutPropertyFunction>
 #include <cnoid/Archive>
 #include <fmt/format.h>
 #include <unordered_map>
-#include <regex>
 #include <cctype>
 #include <algorithm>
+#include <climits>
+#include <cerrno>
+#include <cstdlib>
 #include "gettext.h"
 
 using namespace std;
@@ -70,6 +74,243 @@ public:
     }
 };
 
+enum ComparisonOperator { NoComparison, EQ, NE, LT, GT, LE, GE };
+
+typedef std::function<stdx::optional<MprVariable::Value>()> VariableValueFunction;
+
+struct CompiledTerm
+{
+    // The function is empty when the term is a constant
+    VariableValueFunction variableValue;
+    MprVariable::Value constant;
+    string text;
+};
+
+/**
+   The expression of a conditional statement or an assign statement compiled into the
+   terms and operators. The constants are converted into the values and the variables
+   are converted into the functions that refer to the variable objects.
+*/
+class CompiledExpression : public Referenced
+{
+public:
+    vector<CompiledTerm> terms;
+    // Binary operators between the terms of an assign expression
+    vector<char> operators;
+    ComparisonOperator comparisonOperator;
+    // The messages are output when the statement is executed if the expression is invalid
+    vector<string> errorMessages;
+    std::function<bool(MprVariable::Value value)> assignValue;
+
+    CompiledExpression() : comparisonOperator(NoComparison) { }
+    bool isValid() const { return errorMessages.empty(); }
+};
+
+typedef ref_ptr<CompiledExpression> CompiledExpressionPtr;
+
+inline bool isSpace(char c)
+{
+    return std::isspace(static_cast<unsigned char>(c));
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+void skipSpaces(string::const_iterator& pos, string::const_iterator end)
+{
+    while(pos != end && isSpace(*pos)){
+        ++pos;
+    }
+}
+
+bool matchCaseInsensitively(string::const_iterator pos, string::const_iterator end, const char* word)
+{
+    for(const char* p = word; *p; ++p){
+        if(pos == end || std::tolower(static_cast<unsigned char>(*pos)) != *p){
+            return false;
+        }
+        ++pos;
+    }
+    return true;
+}
+
+/**
+   The string constant continues to the last double quote in the line as the regular
+   expression "^\"(.*)\"" used to do.
+*/
+bool parseStringConstant(string::const_iterator& pos, string::const_iterator end, MprVariable::Value& out_value)
+{
+    if(pos == end || *pos != '"'){
+        return false;
+    }
+    auto lineEnd = std::find(pos + 1, end, '\n');
+    auto closing = lineEnd;
+    for(auto p = pos + 1; p != lineEnd; ++p){
+        if(*p == '"'){
+            closing = p;
+        }
+    }
+    if(closing == lineEnd){
+        return false;
+    }
+    out_value = string(pos + 1, closing);
+    pos = closing + 1;
+    return true;
+}
+
+bool parseFloatConstant(string::const_iterator& pos, string::const_iterator end, MprVariable::Value& out_value)
+{
+    auto p = pos;
+    if(p != end && (*p == '+' || *p == '-')){
+        ++p;
+    }
+    auto integerBegin = p;
+    while(p != end && isDigit(*p)){
+        ++p;
+    }
+    bool hasIntegerDigits = (p != integerBegin);
+    if(p == end || *p != '.'){
+        return false;
+    }
+    ++p;
+    auto fractionBegin = p;
+    while(p != end && isDigit(*p)){
+        ++p;
+    }
+    if(!hasIntegerDigits && p == fractionBegin){
+        return false;
+    }
+    out_value = std::stod(string(pos, p));
+    pos = p;
+    return true;
+}
+
+/**
+   \return 0 if the expression is not an integer, -1 if the integer is out of range, 1 if parsed
+*/
+int parseIntConstant
+(string::const_iterator& pos, string::const_iterator end, MprVariable::Value& out_value, string& out_text)
+{
+    auto p = pos;
+    if(p != end && (*p == '+' || *p == '-')){
+        ++p;
+    }
+    auto digitBegin = p;
+    while(p != end && isDigit(*p)){
+        ++p;
+    }
+    if(p == digitBegin){
+        return 0;
+    }
+    out_text.assign(pos, p);
+    errno = 0;
+    long number = strtol(out_text.c_str(), nullptr, 10);
+    if(errno == ERANGE || number < INT_MIN || number > INT_MAX){
+        return -1;
+    }
+    out_value = static_cast<int>(number);
+    pos = p;
+    return 1;
+}
+
+bool parseBoolConstant(string::const_iterator& pos, string::const_iterator end, MprVariable::Value& out_value)
+{
+    if(matchCaseInsensitively(pos, end, "true")){
+        out_value = true;
+        pos += 4;
+        return true;
+    } else if(matchCaseInsensitively(pos, end, "false")){
+        out_value = false;
+        pos += 5;
+        return true;
+    }
+    return false;
+}
+
+ComparisonOperator parseComparisonOperator(string::const_iterator& pos, string::const_iterator end)
+{
+    auto p = pos;
+    skipSpaces(p, end);
+    if(p == end){
+        return NoComparison;
+    }
+    ComparisonOperator op = NoComparison;
+    char c = *p++;
+    bool isFollowedByEqual = (p != end && *p == '=');
+    if(c == '='){
+        op = EQ;
+    } else if(c == '!' && isFollowedByEqual){
+        op = NE;
+        ++p;
+    } else if(c == '<'){
+        op = isFollowedByEqual ? LE : LT;
+        if(isFollowedByEqual) ++p;
+    } else if(c == '>'){
+        op = isFollowedByEqual ? GE : GT;
+        if(isFollowedByEqual) ++p;
+    }
+    if(op != NoComparison){
+        skipSpaces(p, end);
+        pos = p;
+    }
+    return op;
+}
+
+char parseBinaryOperator(string::const_iterator& pos, string::const_iterator end)
+{
+    auto p = pos;
+    skipSpaces(p, end);
+    if(p != end && (*p == '+' || *p == '-')){
+        char op = *p++;
+        skipSpaces(p, end);
+        pos = p;
+        return op;
+    }
+    return 0;
+}
+
+/**
+   \return The text of the invalid term for the error message
+*/
+string getInvalidTermText(string::const_iterator pos, string::const_iterator end)
+{
+    skipSpaces(pos, end);
+    auto lineEnd = std::find(pos, end, '\n');
+    return string(pos, lineEnd);
+}
+
+/**
+   This function parses the default variable expression syntax "var[id]".
+*/
+bool parseDefaultVariableExpression(string::const_iterator& pos, string::const_iterator end, GeneralId& out_id)
+{
+    if(end - pos < 3 || !std::equal(pos, pos + 3, "var")){
+        return false;
+    }
+    auto p = pos + 3;
+    if(p == end || *p != '['){
+        return false;
+    }
+    ++p;
+    auto digitBegin = p;
+    int id = 0;
+    while(p != end && isDigit(*p)){
+        if(id > (INT_MAX - 9) / 10){
+            return false;
+        }
+        id = id * 10 + (*p - '0');
+        ++p;
+    }
+    if(p == digitBegin || p == end || *p != ']'){
+        return false;
+    }
+    out_id = GeneralId(id);
+    pos = p + 1;
+    return true;
+}
+
 }
     
     
@@ -116,18 +357,17 @@ public:
     unordered_map<MprProgramPtr, shared_ptr<string>> topLevelProgramToSharedNameMap;
     bool isLogEnabled;
 
-    regex termPattern;
-    regex operatorPattern;
-    regex cmpOperatorPattern;
-    regex intPattern;
-    regex floatPattern;
-    regex boolPattern;
-    regex stringPattern;
-    regex variablePattern; // for the default variable expression syntax
+    unordered_map<MprStatement*, CompiledExpressionPtr> compiledExpressionMap;
+
+    bool isTrajectoryPrecompilationEnabled;
+    // The compiler is kept over the simulations to reuse the cached trajectories
+    MprProgramTrajectoryCompiler trajectoryCompiler;
+    unordered_map<MprProgram*, MprProgramTrajectoryPtr> trajectoryMap;
 
     Impl(MprControllerItemBase* self);
     bool initialize(ControllerIO* io);
     bool createKinematicBodySetForInternalUse();
+    void precompileTrajectory(MprProgram* orgProgram);
 
     // Default variable mappings
     bool initializeDefaultVariableMappings();
@@ -148,9 +388,14 @@ public:
     bool interpretIfStatement(MprIfStatement* statement);
     bool interpretWhileStatement(MprWhileStatement* statement);
     bool interpretCallStatement(MprCallStatement* statement);
-    stdx::optional<bool> evalConditionalExpression(const string& expression);
-    stdx::optional<MprVariable::Value> getTermValue(string::const_iterator& pos, string::const_iterator end);
-    stdx::optional<string> getComparisonOperator(string::const_iterator& pos, string::const_iterator end);
+    void compileProgramExpressions(MprProgram* program);
+    CompiledExpression* getCompiledExpression(MprStatement* statement);
+    CompiledExpressionPtr compileConditionalExpression(const string& expression);
+    CompiledExpressionPtr compileAssignExpression(MprAssignStatement* statement);
+    bool compileTerm(
+        string::const_iterator& pos, string::const_iterator end, CompiledTerm& out_term, CompiledExpression* compiled);
+    bool evalTerm(const CompiledTerm& term, MprVariable::Value& out_value);
+    stdx::optional<bool> evalConditionalExpression(MprConditionStatement* statement);
     bool interpretAssignStatement(MprAssignStatement* statement);
     bool applyBinaryOperation(MprVariable::Value& lhsValue, char op, const MprVariable::Value& rhsValue);
     bool interpretSetSignalStatement(MprSignalStatement* statement);
@@ -180,6 +425,7 @@ MprControllerItemBase::MprControllerItemBase(const MprControllerItemBase& org)
     impl = new Impl(this);
 
     impl->speedRatio = org.impl->speedRatio;
+    impl->isTrajectoryPrecompilationEnabled = org.impl->isTrajectoryPrecompilationEnabled;
 }
 
 
@@ -189,6 +435,7 @@ MprControllerItemBase::Impl::Impl(MprControllerItemBase* self)
     isEnabled = true;
     isActiveControlState = false;
     speedRatio = 1.0;
+    isTrajectoryPrecompilationEnabled = false;
     currentLog = new MprControllerLog;
 }
 
@@ -245,15 +492,6 @@ void MprControllerItemBase::registerBaseStatementInterpreters()
     registerStatementInterpreter<MprDelayStatement>(
         [impl_](MprDelayStatement* statement){
             return impl_->interpretDelayStatement(statement); });
-
-    impl->termPattern.assign("^\\s*(.+)\\s*");
-    impl->operatorPattern.assign("^\\s*([+-])\\s*");
-    impl->cmpOperatorPattern.assign("^\\s*(=|!=|<=|>=|<|>)\\s*");
-    impl->intPattern.assign("^[+-]?\\d+");
-    impl->floatPattern.assign("^[+-]?(\\d+\\.\\d*|\\.\\d+)");
-    impl->boolPattern.assign("^([Tt][Rr][Uu][Ee]|[Ff][Aa][Ll][Ss][Ee])");
-    impl->stringPattern.assign("^\"(.*)\"");
-    impl->variablePattern.assign("^var\\[(\\d+)\\]");
 }
 
 
@@ -347,6 +585,17 @@ bool MprControllerItemBase::Impl::initialize(ControllerIO* io)
         return false;
     }
 
+    compileProgramExpressions(startupProgram);
+    for(auto& kv : otherProgramMap){
+        compileProgramExpressions(kv.second);
+    }
+
+    if(isTrajectoryPrecompilationEnabled){
+        for(auto& item : programItems){
+            precompileTrajectory(item->program());
+        }
+    }
+
     iterator = currentProgram->begin();
 
     auto body = io->body();
@@ -372,6 +621,25 @@ bool MprControllerItemBase::Impl::createKinematicBodySetForInternalUse()
 }
 
 
+/**
+   The trajectory is compiled for the original program so that the cached trajectory can be
+   reused in the next initialization, and the statements of the clone used in the controller
+   are bound to a copy of the trajectory.
+*/
+void MprControllerItemBase::Impl::precompileTrajectory(MprProgram* orgProgram)
+{
+    auto kinematicsKit = kinematicBodySetForInternalUse->mainBodyPart();
+    auto trajectory = trajectoryCompiler.compile(orgProgram, kinematicsKit, MessageOut::master());
+    if(trajectory){
+        auto program = cloneMap.getClone(orgProgram);
+        MprProgramTrajectoryPtr boundTrajectory = new MprProgramTrajectory(*trajectory);
+        if(boundTrajectory->bindStatements(program)){
+            trajectoryMap[program] = boundTrajectory;
+        }
+    }
+}
+
+
 bool MprControllerItemBase::initializeVariables()
 {
     return impl->initializeDefaultVariableMappings();
@@ -491,10 +759,8 @@ MprVariable* MprControllerItemBase::Impl::findVariable(const GeneralId& id)
 stdx::optional<MprVariable::Value> MprControllerItemBase::evalExpressionAsVariableValue
 (std::string::const_iterator& io_expressionBegin, std::string::const_iterator expressionEnd)
 {
-    std::smatch match;
-    if(regex_search(io_expressionBegin, expressionEnd, match, impl->variablePattern)){
-        io_expressionBegin = match[0].second;
-        GeneralId id(std::stoi(match.str(1)));
+    GeneralId id;
+    if(parseDefaultVariableExpression(io_expressionBegin, expressionEnd, id)){
         if(auto variable = impl->findVariable(id)){
             return variable->value();
         }
@@ -504,12 +770,50 @@ stdx::optional<MprVariable::Value> MprControllerItemBase::evalExpressionAsVariab
 }
 
 
+std::function<stdx::optional<MprVariable::Value>()> MprControllerItemBase::compileExpressionAsVariableValue
+(std::string::const_iterator& io_expressionBegin, std::string::const_iterator expressionEnd)
+{
+    GeneralId id;
+    if(!parseDefaultVariableExpression(io_expressionBegin, expressionEnd, id)){
+        /*
+          The expression of the syntax customized with evalExpressionAsVariableValue is
+          evaluated through the function in the control. The extent of the expression is
+          determined by the position to which the function advances the iterator.
+        */
+        auto pos = io_expressionBegin;
+        evalExpressionAsVariableValue(pos, expressionEnd);
+        if(pos == io_expressionBegin){
+            return nullptr;
+        }
+        string expression(io_expressionBegin, pos);
+        io_expressionBegin = pos;
+        return [this, expression]() -> stdx::optional<MprVariable::Value> {
+            auto begin = expression.cbegin();
+            return evalExpressionAsVariableValue(begin, expression.cend());
+        };
+    }
+    // The variable is resolved when the value is evaluated first because it may be
+    // created by an assign statement executed before the evaluation.
+    MprVariablePtr variable;
+    return [this, id, variable]() mutable -> stdx::optional<MprVariable::Value> {
+        if(!variable){
+            variable = impl->findVariable(id);
+            if(!variable){
+                impl->io->os() << format(_("Variable {0} is not defined."), id.label()) << endl;
+                return stdx::nullopt;
+            }
+        }
+        return variable->value();
+    };
+}
+
+
 std::function<bool(MprVariable::Value value)> MprControllerItemBase::evalExpressionAsVariableToAssginValue
 (const std::string& expression)
 {
-    std::smatch match;
-    if(regex_search(expression, match, impl->variablePattern)){
-        GeneralId id(std::stoi(match.str(1)));
+    GeneralId id;
+    auto pos = expression.cbegin();
+    if(parseDefaultVariableExpression(pos, expression.cend(), id)){
         auto variable = impl->findVariable(id);
         if(!variable){
             auto list = impl->variableLists.front();
@@ -607,6 +911,16 @@ MprProgram* MprControllerItemBase::findProgram(const std::string& name)
 }
 
 
+MprProgramTrajectory* MprControllerItemBase::findPrecompiledTrajectory(MprProgram* program)
+{
+    auto iter = impl->trajectoryMap.find(program);
+    if(iter != impl->trajectoryMap.end()){
+        return iter->second;
+    }
+    return nullptr;
+}
+
+
 KinematicBodySet* MprControllerItemBase::kinematicBodySetForInternalUse()
 {
     return impl->kinematicBodySetForInternalUse;
@@ -813,6 +1127,8 @@ void MprControllerItemBase::Impl::clear()
     programStack.clear();
     processorStack.clear();
     topLevelProgramToSharedNameMap.clear();
+    compiledExpressionMap.clear();
+    trajectoryMap.clear();
 }
 
 
@@ -830,6 +1146,18 @@ void MprControllerItemBase::setSpeedRatio(double r)
 }
 
 
+void MprControllerItemBase::setTrajectoryPrecompilationEnabled(bool on)
+{
+    impl->isTrajectoryPrecompilationEnabled = on;
+}
+
+
+bool MprControllerItemBase::isTrajectoryPrecompilationEnabled() const
+{
+    return impl->isTrajectoryPrecompilationEnabled;
+}
+
+
 bool MprControllerItemBase::Impl::interpretCommentStatement(MprCommentStatement*)
 {
     ++iterator;
@@ -847,7 +1175,7 @@ bool MprControllerItemBase::Impl::interpretGroupStatement(MprGroupStatement* sta
 
 bool MprControllerItemBase::Impl::interpretIfStatement(MprIfStatement* statement)
 {
-    auto condition = evalConditionalExpression(statement->condition());
+    auto condition = evalConditionalExpression(statement);
 
     if(!condition){
         return false;
@@ -888,7 +1216,7 @@ bool MprControllerItemBase::Impl::interpretIfStatement(MprIfStatement* statement
 
 bool MprControllerItemBase::Impl::interpretWhileStatement(MprWhileStatement* statement)
 {
-    auto condition = evalConditionalExpression(statement->condition());
+    auto condition = evalConditionalExpression(statement);
 
     if(!condition){
         return false;
@@ -928,44 +1256,102 @@ bool MprControllerItemBase::Impl::interpretCallStatement(MprCallStatement* state
 
 
 template<class LhsType, class RhsType>
-static stdx::optional<bool> checkNumericalComparison(const string& op, LhsType lhs, RhsType rhs)
-{
-    if(op == "="){
-        return lhs == rhs;
-    } else if(op == "!="){
-        return lhs != rhs;
-    } else if(op == "<"){
-        return lhs < rhs;
-    } else if(op == ">"){
-        return lhs > rhs;
-    } else if(op == "<="){
-        return lhs <= rhs;
-    } else if(op == ">="){
-        return lhs >= rhs;
+static stdx::optional<bool> checkNumericalComparison(ComparisonOperator op, LhsType lhs, RhsType rhs)
+{
+    switch(op){
+    case EQ: return lhs == rhs;
+    case NE: return lhs != rhs;
+    case LT: return lhs < rhs;
+    case GT: return lhs > rhs;
+    case LE: return lhs <= rhs;
+    case GE: return lhs >= rhs;
+    default: break;
     }
     return stdx::nullopt;
 }
 
 
-stdx::optional<bool> MprControllerItemBase::Impl::evalConditionalExpression(const string& expression)
+/**
+   The expressions are compiled when the controller is initialized so that the expression
+   strings are not parsed in the control. Note that the programs used in the control are
+   the clones of the programs in the program items, and they are not edited during the control.
+*/
+void MprControllerItemBase::Impl::compileProgramExpressions(MprProgram* program)
 {
+    for(auto& statement : *program){
+        getCompiledExpression(statement.get());
+        if(auto lowerLevelProgram = statement->getLowerLevelProgram()){
+            compileProgramExpressions(lowerLevelProgram);
+        }
+    }
+}
+
+
+CompiledExpression* MprControllerItemBase::Impl::getCompiledExpression(MprStatement* statement)
+{
+    auto p = compiledExpressionMap.find(statement);
+    if(p != compiledExpressionMap.end()){
+        return p->second;
+    }
+    CompiledExpressionPtr compiled;
+    if(auto conditionStatement = dynamic_cast<MprConditionStatement*>(statement)){
+        compiled = compileConditionalExpression(conditionStatement->condition());
+    } else if(auto assignStatement = dynamic_cast<MprAssignStatement*>(statement)){
+        compiled = compileAssignExpression(assignStatement);
+    }
+    compiledExpressionMap[statement] = compiled;
+    return compiled;
+}
+
+
+bool MprControllerItemBase::Impl::compileTerm
+(string::const_iterator& pos, string::const_iterator end, CompiledTerm& out_term, CompiledExpression* compiled)
+{
+    auto pos0 = pos;
+    if(!parseStringConstant(pos, end, out_term.constant) &&
+       !parseFloatConstant(pos, end, out_term.constant)){
+
+        string text;
+        int result = parseIntConstant(pos, end, out_term.constant, text);
+        if(result < 0){
+            compiled->errorMessages.push_back(format(_("Integer value {0} is out of range."), text));
+            return false;
+        }
+        if(result == 0 && !parseBoolConstant(pos, end, out_term.constant)){
+            out_term.variableValue = self->compileExpressionAsVariableValue(pos, end);
+            if(!out_term.variableValue){
+                return false;
+            }
+        }
+    }
+    out_term.text.assign(pos0, pos);
+    return true;
+}
+
+
+CompiledExpressionPtr MprControllerItemBase::Impl::compileConditionalExpression(const string& expression)
+{
+    CompiledExpressionPtr compiled = new CompiledExpression;
+
     if(expression.empty()){
-        io->os() << _("Empty conditional expression.") << endl;
-        return stdx::nullopt;
+        compiled->errorMessages.push_back(_("Empty conditional expression."));
+        return compiled;
     }
     auto pos = expression.cbegin();
     auto end = expression.cend();
 
     bool isExpressionValid = false;
-    stdx::optional<string> pCmpOp;
-    stdx::optional<MprVariable::Value> pRhs;
-    stdx::optional<MprVariable::Value> pLhs = getTermValue(pos, end);
-    if(pLhs){
+    CompiledTerm lhs;
+    if(compileTerm(pos, end, lhs, compiled)){
+        compiled->terms.push_back(std::move(lhs));
         if(pos == end){
             isExpressionValid = true;
-        } else if((pCmpOp = getComparisonOperator(pos, end))){
-            if(pos != end){
-                if((pRhs = getTermValue(pos, end))){
+        } else {
+            compiled->comparisonOperator = parseComparisonOperator(pos, end);
+            if(compiled->comparisonOperator != NoComparison && pos != end){
+                CompiledTerm rhs;
+                if(compileTerm(pos, end, rhs, compiled)){
+                    compiled->terms.push_back(std::move(rhs));
                     if(pos == end){
                         isExpressionValid = true;
                     }
@@ -974,19 +1360,51 @@ stdx::optional<bool> MprControllerItemBase::Impl::evalConditionalExpression(cons
         }
     }
     if(!isExpressionValid){
-        io->os() << format(_("Conditional expression \"{0}\" is invalid."), expression) << endl;
+        compiled->errorMessages.push_back(format(_("Conditional expression \"{0}\" is invalid."), expression));
+    }
+
+    return compiled;
+}
+
+
+bool MprControllerItemBase::Impl::evalTerm(const CompiledTerm& term, MprVariable::Value& out_value)
+{
+    if(!term.variableValue){
+        out_value = term.constant;
+        return true;
+    }
+    if(auto value = term.variableValue()){
+        out_value = std::move(*value);
+        return true;
+    }
+    return false;
+}
+
+
+stdx::optional<bool> MprControllerItemBase::Impl::evalConditionalExpression(MprConditionStatement* statement)
+{
+    auto compiled = getCompiledExpression(statement);
+    if(!compiled->isValid()){
+        for(auto& message : compiled->errorMessages){
+            io->os() << message << endl;
+        }
         return stdx::nullopt;
     }
 
-    auto& lhs = *pLhs;
+    auto& terms = compiled->terms;
+    MprVariable::Value lhs;
+    MprVariable::Value rhs;
+    if(!evalTerm(terms[0], lhs) || (terms.size() > 1 && !evalTerm(terms[1], rhs))){
+        io->os() << format(_("Conditional expression \"{0}\" is invalid."), statement->condition()) << endl;
+        return stdx::nullopt;
+    }
 
-    if(!pRhs){
+    if(terms.size() == 1){
         return MprVariable::toBool(lhs);
     }
             
     stdx::optional<bool> pResult;
-    auto& rhs = *pRhs;
-    string& cmpOp = *pCmpOp;
+    auto cmpOp = compiled->comparisonOperator;
 
     int rhsValueType = MprVariable::valueType(rhs);
     switch(MprVariable::valueType(lhs)){
@@ -1011,14 +1429,14 @@ stdx::optional<bool> MprControllerItemBase::Impl::evalConditionalExpression(cons
         break;
     }
     case MprVariable::Bool:
-        if(rhsValueType == MprVariable::Bool && cmpOp == "="){
+        if(rhsValueType == MprVariable::Bool && cmpOp == EQ){
             pResult = checkNumericalComparison(
                 cmpOp, MprVariable::boolValue(lhs), MprVariable::boolValue(rhs));
         }
         break;
 
     case MprVariable::String:
-        if(rhsValueType == MprVariable::String && cmpOp == "="){
+        if(rhsValueType == MprVariable::String && cmpOp == EQ){
             pResult = checkNumericalComparison(
                 cmpOp, MprVariable::stringValue(lhs), MprVariable::stringValue(rhs));
         }
@@ -1031,151 +1449,99 @@ stdx::optional<bool> MprControllerItemBase::Impl::evalConditionalExpression(cons
 
     return pResult;
 }
-    
-    
-stdx::optional<MprVariable::Value> MprControllerItemBase::Impl::getTermValue
-(string::const_iterator& pos, string::const_iterator end)
-{
-    stdx::optional<MprVariable::Value> value;
-    std::smatch match;
-
-    if(regex_search(pos, end,  match, stringPattern)){
-        value = match.str(1);
-        pos = match[0].second;
-                
-    } else if(regex_search(pos, end, match, floatPattern)){
-        value = std::stod(match.str(0));
-        pos = match[0].second;
-            
-    } else if(regex_search(pos, end, match, intPattern)){
-        errno = 0;
-        long number = strtol(match.str(0).c_str(), nullptr, 10);
-        if(errno == ERANGE || number < INT_MIN || number > INT_MAX){
-            io->os() << format(_("Integer value {0} is out of range."), match.str(0)) << endl;
-        } else {
-            value = std::stoi(match.str(0));
-            pos = match[0].second;
-        }
-    } else if(regex_search(pos, end, match, boolPattern)){
-        auto label = match.str(1);
-        std::transform(label.begin(), label.end(), label.begin(), ::tolower);
-        value = (label == "true") ? true : false;
-        pos = match[0].second;
-                
-    } else {
-        value = self->evalExpressionAsVariableValue(pos, end);
-    }
-    
-    return value;
-}
 
 
-stdx::optional<string> MprControllerItemBase::Impl::getComparisonOperator
-(string::const_iterator& pos, string::const_iterator end)
+CompiledExpressionPtr MprControllerItemBase::Impl::compileAssignExpression(MprAssignStatement* statement)
 {
-    std::smatch match;
-    if(regex_search(pos, end,  match, cmpOperatorPattern)){
-        pos = match[0].second;
-        return match.str(1);
-    }
-    return stdx::nullopt;
-}
+    CompiledExpressionPtr compiled = new CompiledExpression;
 
-
-bool MprControllerItemBase::Impl::interpretAssignStatement(MprAssignStatement* statement)
-{
-    auto& expression = statement->valueExpression();
+    auto expression = statement->valueExpression();
     if(expression.empty()){
-        io->os() << format(_("Expression assigned to variable {0} is empty."),
-                           statement->variableExpression()) << endl;
-        return false;
+        compiled->errorMessages.push_back(
+            format(_("Expression assigned to variable {0} is empty."), statement->variableExpression()));
+        return compiled;
     }
 
-    vector<MprVariable::Value> termValues;
-    vector<char> operators;
-    vector<string> termStrings;
-    string invalidTerm;
     auto pos = expression.cbegin();
     auto end = expression.cend();
-    std::smatch match;
-    bool isValidExpression = true;
     bool isNextTermOperator = false;
         
     while(pos != end){
         if(!isNextTermOperator){
             auto pos0 = pos;
-            auto termValue = getTermValue(pos, end);
-            string termString(pos0, pos);
-            if(termValue){
-                termValues.push_back(*termValue);
-                termStrings.push_back(termString);
+            CompiledTerm term;
+            if(compileTerm(pos, end, term, compiled)){
+                compiled->terms.push_back(std::move(term));
                 isNextTermOperator = true;
             } else {
-                if(termString.empty()){
-                    termString = string(pos0, end);
-                }
-                if(regex_search(termString, match, termPattern)){
-                    invalidTerm = match.str(1);
-                } else {
-                    invalidTerm = termString;
-                }
-                isValidExpression = false;
+                compiled->errorMessages.push_back(
+                    format(_("Term \"{0}\" is invalid."), getInvalidTermText(pos0, end)));
+                break;
             }
         } else {
-            if(regex_search(pos, end, match, operatorPattern)){
-                char op = match.str(1)[0];
-                operators.push_back(op);
-                pos = match[0].second;
+            if(char op = parseBinaryOperator(pos, end)){
+                compiled->operators.push_back(op);
                 isNextTermOperator = false;
             } else {
-                invalidTerm = string(match[0].first, match[0].second);
-                isValidExpression = false;
+                compiled->errorMessages.push_back(
+                    format(_("Term \"{0}\" is invalid."), getInvalidTermText(pos, end)));
+                break;
             }
         }
-        if(!isValidExpression){
-            io->os() << format(_("Term \"{0}\" is invalid."), invalidTerm) << endl;
-            break;
-        }
     }
 
-    if(isValidExpression){
-        if(termValues.empty()){
-            isValidExpression = false;
-        } else if(!isNextTermOperator){
-            io->os() << format(_("Expression ends with operator {0}."), operators.back()) << endl;
-            isValidExpression = false;
-        }
+    if(compiled->isValid() && !isNextTermOperator){
+        compiled->errorMessages.push_back(
+            format(_("Expression ends with operator {0}."), compiled->operators.back()));
     }
-    if(!isValidExpression){
+
+    return compiled;
+}
+
+
+bool MprControllerItemBase::Impl::interpretAssignStatement(MprAssignStatement* statement)
+{
+    auto compiled = getCompiledExpression(statement);
+    if(!compiled->isValid()){
+        for(auto& message : compiled->errorMessages){
+            io->os() << message << endl;
+        }
         return false;
     }
 
-    size_t termIndex = 0;
-    size_t operatorIndex = 0;
-    MprVariable::Value value = termValues[termIndex++];
-    while(operatorIndex < operators.size()){
-        char op = operators[operatorIndex++];
-        if(!applyBinaryOperation(value, op, termValues[termIndex++])){
-            isValidExpression = false;
+    auto& terms = compiled->terms;
+    auto& operators = compiled->operators;
+    MprVariable::Value value;
+    MprVariable::Value rhs;
+
+    if(!evalTerm(terms[0], value)){
+        io->os() << format(_("Term \"{0}\" is invalid."), terms[0].text) << endl;
+        return false;
+    }
+    for(size_t i=0; i < operators.size(); ++i){
+        auto& term = terms[i + 1];
+        if(!evalTerm(term, rhs)){
+            io->os() << format(_("Term \"{0}\" is invalid."), term.text) << endl;
+            return false;
+        }
+        char op = operators[i];
+        if(!applyBinaryOperation(value, op, rhs)){
             io->os() << format(_("Type mismatch in expresion \"{0} {1} {2}\""),
-                               termStrings[termIndex-2],
-                               op,
-                               termStrings[termIndex-1]) << endl;
-            break;
+                               terms[i].text, op, term.text) << endl;
+            return false;
         }
     }
-    
-    bool assigned = false;
-    if(isValidExpression){
-        auto assignValue =
+
+    if(!compiled->assignValue){
+        compiled->assignValue =
             self->evalExpressionAsVariableToAssginValue(statement->variableExpression());
-        if(assignValue && assignValue(value)){
-            assigned = true;
-            ++iterator;
-        }
+    }
+    if(compiled->assignValue && compiled->assignValue(value)){
+        ++iterator;
+        return true;
     }
 
-    return assigned;
+    return false;
 }
 
 
@@ -1305,6 +1671,8 @@ void MprControllerItemBase::doPutProperties(PutPropertyFunction& putProperty)
 {
     ControllerItem::doPutProperties(putProperty);
     putProperty(_("Speed ratio"), impl->speedRatio, changeProperty(impl->speedRatio));
+    putProperty(_("Precompile trajectories"), impl->isTrajectoryPrecompilationEnabled,
+                changeProperty(impl->isTrajectoryPrecompilationEnabled));
 }
 
 
@@ -1315,6 +1683,7 @@ bool MprControllerItemBase::store(Archive& archive)
     }
     archive.write("enabled", impl->isEnabled);
     archive.write("speed_ratio", impl->speedRatio);
+    archive.write("precompile_trajectories", impl->isTrajectoryPrecompilationEnabled);
     return true;
 }
     
@@ -1326,6 +1695,7 @@ bool MprControllerItemBase::restore(const Archive& archive)
     }
     archive.read("enabled", impl->isEnabled);
     archive.read({ "speed_ratio", "speedRatio"}, impl->speedRatio);
+    archive.read("precompile_trajectories", impl->isTrajectoryPrecompilationEnabled);
     return true;
 }
 
@@ -16,6 +16,7 @@ class MprStatement;
 class KinematicBodyItemSet;
 class KinematicBodySet;
 class MprVariableSet;
+class MprProgramTrajectory;
 
 class CNOID_EXPORT MprControllerItemBase : public ControllerItem
 {
@@ -42,6 +43,15 @@ public:
     void setActiveControlState(bool on);
     bool isActiveControlState() const;
 
+    /**
+       When the trajectory precompilation is enabled, the joint displacements of the position
+       statements in the programs are computed when the controller is initialized so that the
+       statement interpreters can move the manipulator by the interpolation of the displacements.
+       The precompilation is disabled by default.
+    */
+    void setTrajectoryPrecompilationEnabled(bool on);
+    bool isTrajectoryPrecompilationEnabled() const;
+
     virtual bool initialize(ControllerIO* io) override final;
     virtual bool start() override final;
     virtual void input() override final;
@@ -82,6 +92,12 @@ protected:
 
     MprProgram* findProgram(const std::string& name);
 
+    /**
+       This function returns the precompiled trajectory of a program used in the controller.
+       \return nullptr if the trajectory precompilation is disabled or the trajectory is not available
+    */
+    MprProgramTrajectory* findPrecompiledTrajectory(MprProgram* program);
+
     KinematicBodySet* kinematicBodySetForInternalUse();
 
     void pushControlFunctions(
@@ -101,6 +117,19 @@ protected:
     virtual std::function<bool(MprVariable::Value value)> evalExpressionAsVariableToAssginValue(
         const std::string& expression);
 
+    /**
+       This function is used when the expressions of the program statements are compiled.
+       It parses the variable expression at io_expressionBegin, advances io_expressionBegin
+       to the end of the expression, and returns the function that evaluates the variable
+       value in the control. The default implementation supports the default variable
+       expression syntax, and the other expressions are delegated to evalExpressionAsVariableValue,
+       which is called in the control to evaluate them. This function can be overridden to
+       compile the customized syntax as well.
+       \return nullptr if the expression is not a variable expression
+    */
+    virtual std::function<stdx::optional<MprVariable::Value>()> compileExpressionAsVariableValue(
+        std::string::const_iterator& io_expressionBegin, std::string::const_iterator expressionEnd);
+
     virtual void onDisconnectedFromRoot() override;
     virtual void doPutProperties(PutPropertyFunction& putProperty) override;
     virtual bool store(Archive& archive) override;
@@ -20,6 +20,7 @@ public:
     unordered_map<GeneralId, MprPositionPtr, GeneralId::Hash> idToPositionMap;
     int idCounter;
     bool isStringIdEnabled;
+    unsigned int revision;
     Signal<void(int index)> sigPositionAdded;
     Signal<void(int index, MprPosition* position)> sigPositionRemoved;
     Signal<void(int index, int flags)> sigPositionUpdated;
@@ -45,6 +46,7 @@ MprPositionList::Impl::Impl(MprPositionList* self)
 {
     isStringIdEnabled = true;
     idCounter = 0;    
+    revision = 0;
 }
 
 
@@ -69,6 +71,7 @@ MprPositionList::Impl::Impl(MprPositionList* self, const Impl& org)
 {
     isStringIdEnabled = org.isStringIdEnabled;    
     idCounter = 0;    
+    revision = 0;
 }
 
 
@@ -174,6 +177,7 @@ bool MprPositionList::Impl::insert(int index, MprPosition* position, bool doNoti
         index = size;
     }
     positions.insert(positions.begin() + index, position);
+    ++revision;
 
     if(doNotify){
         sigPositionAdded(index);
@@ -223,6 +227,7 @@ bool MprPositionList::Impl::removeAt(int index, bool doNotify)
     position->ownerPositionList_.reset();
     idToPositionMap.erase(position->id());
     positions.erase(positions.begin() + index);
+    ++revision;
     if(doNotify){
         sigPositionRemoved(index, position);
     }
@@ -248,8 +253,15 @@ SignalProxy<void(int index, int flags)> MprPositionList::sigPositionUpdated()
 }
 
 
+unsigned int MprPositionList::revision() const
+{
+    return impl->revision;
+}
+
+
 void MprPositionList::notifyPositionUpdate(MprPosition* position, int flags)
 {
+    ++impl->revision;
     if(impl->sigPositionUpdated.hasConnections()){
         impl->sigPositionUpdated(indexOf(position), flags);
     }
@@ -269,6 +281,7 @@ bool MprPositionList::resetId(MprPosition* position, const GeneralId& newId)
             positionMap.erase(position->id());
             position->id_ = newId;
             positionMap[newId] = position;
+            ++impl->revision;
             changed = true;
         }
     }
@@ -44,6 +44,12 @@ public:
     SignalProxy<void(int index, MprPosition* position)> sigPositionRemoved();
     SignalProxy<void(int index, int flags)> sigPositionUpdated();
 
+    /**
+       The revision number is incremented when a position is added, removed or updated.
+       It can be used to check if the data computed from the positions is still valid.
+    */
+    unsigned int revision() const;
+
     /**
        @return true if the id is successfully changed. false if the id is not
        changed because anther coordinate frame with the same id is exists.
@@ -33,12 +33,14 @@ public:
     Signal<void(MprStatement* statement, MprProgram* program)> sigStatementRemoved;
     std::string name;
     std::function<PositionTagGroup*(const std::string& name)> positionTagGroupFinder;
+    unsigned int revision;
 
     Impl(MprProgram* self);
     Impl(MprProgram* self, const Impl& org, CloneMap* cloneMap);
     void notifyStatementInsertion(iterator iter);
     void notifyStatementRemoval(MprStatement* statement, MprProgram* program);
     void notifyStatementUpdate(MprStatement* statement) const;
+    void incrementRevision();
     bool read(const Mapping* archive);    
 };
 
@@ -56,7 +58,7 @@ MprProgram::MprProgram()
 MprProgram::Impl::Impl(MprProgram* self)
     : self(self)
 {
-
+    revision = 0;
 }
     
 
@@ -83,6 +85,8 @@ MprProgram::Impl::Impl(MprProgram* self, const Impl& org, CloneMap* cloneMap)
     : self(self),
       name(org.name)
 {
+    revision = 0;
+
     if(org.positionList){
         if(cloneMap){
             positionList = cloneMap->getClone(org.positionList);
@@ -125,6 +129,7 @@ MprProgram::iterator MprProgram::insert(iterator pos, MprStatement* statement, b
     }
     statement->holderProgram_ = this;
     auto iter = statements_.insert(pos, statement);
+    impl->incrementRevision();
 
     if(doNotify){
         impl->notifyStatementInsertion(iter);
@@ -159,6 +164,7 @@ MprProgram::iterator MprProgram::remove(iterator pos, bool doNotify)
     if(program == this){
         statement->holderProgram_.reset();
         auto iter = statements_.erase(pos);
+        impl->incrementRevision();
         if(doNotify){
             impl->notifyStatementRemoval(statement, this);
         }
@@ -213,6 +219,7 @@ void MprProgram::Impl::notifyStatementRemoval(MprStatement* statement, MprProgra
 
 void MprProgram::notifyStatementUpdate(MprStatement* statement) const
 {
+    ++impl->revision;
     impl->sigStatementUpdated(statement);
 
     if(auto hs = holderStatement()){
@@ -223,6 +230,24 @@ void MprProgram::notifyStatementUpdate(MprStatement* statement) const
 }
 
 
+void MprProgram::Impl::incrementRevision()
+{
+    ++revision;
+
+    if(auto hs = holderStatement.lock()){
+        if(auto hp = hs->holderProgram()){
+            hp->impl->incrementRevision();
+        }
+    }
+}
+
+
+unsigned int MprProgram::revision() const
+{
+    return impl->revision;
+}
+
+
 SignalProxy<void(MprProgram::iterator iter)> MprProgram::sigStatementInserted()
 {
     return impl->sigStatementInserted;
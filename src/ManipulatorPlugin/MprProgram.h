@@ -66,6 +66,12 @@ public:
     
     void notifyStatementUpdate(MprStatement* statement) const;
 
+    /**
+       The revision number is incremented when a statement is inserted, removed or updated
+       in the program or its sub programs.
+    */
+    unsigned int revision() const;
+
     MprStructuredStatement* holderStatement() const;
     bool isTopLevelProgram() const;
     bool isSubProgram() const;
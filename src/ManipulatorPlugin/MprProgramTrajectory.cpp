@@ -0,0 +1,535 @@
+#include "MprProgramTrajectory.h"
+#include "MprProgram.h"
+#include "MprPositionStatement.h"
+#include "MprTagTraceStatement.h"
+#include "MprPosition.h"
+#include "MprPositionList.h"
+#include <cnoid/Body>
+#include <cnoid/BodyKinematicsKit>
+#include <cnoid/LinkedJointHandler>
+#include <cnoid/JointTraverse>
+#include <cnoid/InverseKinematics>
+#include <cnoid/CloneMap>
+#include <cnoid/MessageOut>
+#include <fmt/format.h>
+#include <unordered_map>
+#include <algorithm>
+#include <thread>
+#include <cmath>
+#include "gettext.h"
+
+using namespace std;
+using namespace cnoid;
+using fmt::format;
+
+namespace {
+
+// The waypoints solved by a thread must be at least this number
+constexpr int MinNumWaypointsPerThread = 16;
+
+constexpr double DisplacementTolerance = 1.0e-6;
+
+struct Waypoint
+{
+    MprPositionStatement* statement;
+    MprPosition* position;
+};
+
+template<class ObjectType>
+struct RevisionRecord
+{
+    weak_ref_ptr<ObjectType> object;
+    unsigned int revision;
+
+    RevisionRecord(ObjectType* object) : object(object), revision(object->revision()) { }
+    bool isUpToDate() const {
+        auto p = object.lock();
+        return p && p->revision() == revision;
+    }
+};
+
+struct CacheEntry
+{
+    weak_ref_ptr<MprProgram> program;
+    unsigned int programRevision;
+    vector<RevisionRecord<MprPositionList>> positionListRevisions;
+    vector<RevisionRecord<PositionTagGroup>> tagGroupRevisions;
+    // The body is identified by the model name and the joints because the body may be a clone
+    string bodyModelName;
+    vector<int> jointIndices;
+    vector<double> initialDisplacements;
+    MprProgramTrajectoryPtr trajectory;
+};
+
+struct Solver
+{
+    CloneMap cloneMap;
+    BodyKinematicsKitPtr kinematicsKit;
+    vector<double> lastValidDisplacements;
+};
+
+void getJointIndices(BodyKinematicsKit* kinematicsKit, vector<int>& out_indices)
+{
+    const int n = kinematicsKit->numJoints();
+    out_indices.resize(n);
+    for(int i=0; i < n; ++i){
+        out_indices[i] = kinematicsKit->joint(i)->index();
+    }
+}
+
+void getJointDisplacements(BodyKinematicsKit* kinematicsKit, double* out_q)
+{
+    const int n = kinematicsKit->numJoints();
+    for(int i=0; i < n; ++i){
+        out_q[i] = kinematicsKit->joint(i)->q();
+    }
+}
+
+void setJointDisplacements(BodyKinematicsKit* kinematicsKit, const double* q)
+{
+    const int n = kinematicsKit->numJoints();
+    for(int i=0; i < n; ++i){
+        kinematicsKit->joint(i)->q() = q[i];
+    }
+    if(auto handler = kinematicsKit->linkedJointHandler()){
+        handler->updateLinkedJointDisplacements();
+    }
+    if(auto traverse = kinematicsKit->jointTraverse()){
+        traverse->calcForwardKinematics();
+    }
+}
+
+}
+
+namespace cnoid {
+
+class MprProgramTrajectoryCompiler::Impl
+{
+public:
+    int maxNumThreads;
+    unordered_map<MprProgram*, CacheEntry> cache;
+
+    Impl();
+    MprProgramTrajectory* compile(MprProgram* program, BodyKinematicsKit* kinematicsKit, MessageOut* mout);
+    bool isCacheValid(const CacheEntry& entry, BodyKinematicsKit* kinematicsKit, const vector<double>& q0);
+    void collectWaypoints(
+        MprProgram* program, vector<Waypoint>& out_waypoints, CacheEntry& entry);
+    void solveWaypoints(
+        Solver& solver, const vector<Waypoint>& waypoints, int begin, int end,
+        MprProgramTrajectory* trajectory, vector<char>& solved);
+    bool solveWaypoint(Solver& solver, const Waypoint& waypoint, double* out_q);
+    void checkFeasibility(
+        MprProgram* program, BodyKinematicsKit* kinematicsKit, const vector<char>& solved,
+        MprProgramTrajectory* trajectory, MessageOut* mout);
+};
+
+}
+
+
+MprProgramTrajectory::MprProgramTrajectory()
+{
+    numJoints_ = 0;
+    isFeasible_ = false;
+}
+
+
+int MprProgramTrajectory::findWaypointIndex(MprStatement* statement) const
+{
+    auto pos = std::find(statements_.begin(), statements_.end(), statement);
+    if(pos == statements_.end()){
+        return -1;
+    }
+    return pos - statements_.begin();
+}
+
+
+void MprProgramTrajectory::interpolate(int index, double ratio, double* out_q) const
+{
+    const double* q0 = waypoint(index);
+    if(index + 1 >= numWaypoints()){
+        std::copy(q0, q0 + numJoints_, out_q);
+    } else {
+        const double* q1 = waypoint(index + 1);
+        for(int i=0; i < numJoints_; ++i){
+            out_q[i] = q0[i] + ratio * (q1[i] - q0[i]);
+        }
+    }
+}
+
+
+bool MprProgramTrajectory::applyWaypoint(int index, BodyKinematicsKit* kinematicsKit) const
+{
+    if(kinematicsKit->numJoints() != numJoints_ || !validities_[index]){
+        return false;
+    }
+    setJointDisplacements(kinematicsKit, waypoint(index));
+    return true;
+}
+
+
+bool MprProgramTrajectory::bindStatements(MprProgram* program)
+{
+    vector<MprPositionStatement*> statements;
+    statements.reserve(statements_.size());
+    program->traverseStatements(
+        [&](MprStatement* statement){
+            if(auto ps = dynamic_cast<MprPositionStatement*>(statement)){
+                statements.push_back(ps);
+            }
+        });
+    if(statements.size() != statements_.size()){
+        return false;
+    }
+    statements_.swap(statements);
+    return true;
+}
+
+
+MprProgramTrajectoryCompiler::MprProgramTrajectoryCompiler()
+{
+    impl = new Impl;
+}
+
+
+MprProgramTrajectoryCompiler::Impl::Impl()
+{
+    maxNumThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+
+MprProgramTrajectoryCompiler::~MprProgramTrajectoryCompiler()
+{
+    delete impl;
+}
+
+
+void MprProgramTrajectoryCompiler::setMaxNumThreads(int n)
+{
+    impl->maxNumThreads = std::max(1, n);
+}
+
+
+int MprProgramTrajectoryCompiler::maxNumThreads() const
+{
+    return impl->maxNumThreads;
+}
+
+
+void MprProgramTrajectoryCompiler::clearCache()
+{
+    impl->cache.clear();
+}
+
+
+MprProgramTrajectory* MprProgramTrajectoryCompiler::compile
+(MprProgram* program, BodyKinematicsKit* kinematicsKit, MessageOut* mout)
+{
+    return impl->compile(program, kinematicsKit, mout);
+}
+
+
+MprProgramTrajectory* MprProgramTrajectoryCompiler::Impl::compile
+(MprProgram* program, BodyKinematicsKit* kinematicsKit, MessageOut* mout)
+{
+    const int numJoints = kinematicsKit->numJoints();
+    if(numJoints == 0){
+        if(mout){
+            mout->putErrorln(
+                format(_("The trajectory of program \"{0}\" cannot be compiled because the target "
+                         "manipulator has no joint."), program->name()));
+        }
+        return nullptr;
+    }
+
+    vector<double> q0(numJoints);
+    getJointDisplacements(kinematicsKit, q0.data());
+
+    auto p = cache.find(program);
+    if(p != cache.end()){
+        if(isCacheValid(p->second, kinematicsKit, q0)){
+            return p->second.trajectory;
+        }
+        cache.erase(p);
+    }
+
+    CacheEntry entry;
+    entry.program = program;
+    entry.programRevision = program->revision();
+    entry.bodyModelName = kinematicsKit->body()->modelName();
+    getJointIndices(kinematicsKit, entry.jointIndices);
+    entry.initialDisplacements = q0;
+
+    vector<Waypoint> waypoints;
+    collectWaypoints(program, waypoints, entry);
+    const int numWaypoints = waypoints.size();
+
+    MprProgramTrajectoryPtr trajectory = new MprProgramTrajectory;
+    trajectory->numJoints_ = numJoints;
+    trajectory->statements_.reserve(numWaypoints);
+    for(auto& waypoint : waypoints){
+        trajectory->statements_.push_back(waypoint.statement);
+    }
+    trajectory->displacements_.resize(numWaypoints * numJoints);
+    vector<char> solved(numWaypoints, false);
+
+    /*
+      Each solver solves a contiguous range of the waypoints with a clone of the body.
+      The solver does not clone the inverse kinematics object specified without a joint path,
+      so the waypoints are solved only with the original kit in that case.
+    */
+    int numSolvers = std::max(1, std::min(maxNumThreads, numWaypoints / MinNumWaypointsPerThread));
+    vector<Solver> solvers(numSolvers);
+    bool isOriginalKitUsed = false;
+    for(auto& solver : solvers){
+        solver.kinematicsKit = kinematicsKit->clone(&solver.cloneMap);
+        if(kinematicsKit->inverseKinematics() && !solver.kinematicsKit->inverseKinematics()){
+            isOriginalKitUsed = true;
+            break;
+        }
+        solver.lastValidDisplacements = q0;
+    }
+    if(isOriginalKitUsed){
+        solvers[0].kinematicsKit = kinematicsKit;
+        solvers[0].lastValidDisplacements = q0;
+        numSolvers = 1;
+    }
+
+    vector<int> rangeBegins(numSolvers + 1);
+    for(int i=0; i <= numSolvers; ++i){
+        rangeBegins[i] = static_cast<long>(numWaypoints) * i / numSolvers;
+    }
+
+    vector<std::thread> threads;
+    for(int i=1; i < numSolvers; ++i){
+        threads.emplace_back(
+            [&, i](){
+                solveWaypoints(solvers[i], waypoints, rangeBegins[i], rangeBegins[i + 1], trajectory, solved); });
+    }
+    solveWaypoints(solvers[0], waypoints, rangeBegins[0], rangeBegins[1], trajectory, solved);
+    for(auto& thread : threads){
+        thread.join();
+    }
+
+    /*
+      The waypoints at the beginning of each range were solved from the initial state instead of
+      the previous waypoint. They are solved again from the previous waypoint until the solution
+      matches the one in the first pass so that the result is the same as the sequential solution.
+    */
+    auto& solver = solvers[0];
+    vector<double> q(numJoints);
+    int repairedEnd = rangeBegins[1];
+    for(int i=1; i < numSolvers; ++i){
+        int index = std::max(rangeBegins[i], repairedEnd);
+        if(index >= numWaypoints){
+            break;
+        }
+        int prevValidIndex = index - 1;
+        while(prevValidIndex >= 0 && !solved[prevValidIndex]){
+            --prevValidIndex;
+        }
+        if(prevValidIndex >= 0){
+            const double* q_prev = trajectory->waypoint(prevValidIndex);
+            std::copy(q_prev, q_prev + numJoints, solver.lastValidDisplacements.begin());
+        } else {
+            solver.lastValidDisplacements = q0;
+        }
+        setJointDisplacements(solver.kinematicsKit, solver.lastValidDisplacements.data());
+        while(index < numWaypoints){
+            bool isSolved = solveWaypoint(solver, waypoints[index], q.data());
+            double* q_stored = &trajectory->displacements_[index * numJoints];
+            // The failed waypoints do not show the convergence because the next state depends on the seed
+            bool isSame = isSolved && solved[index];
+            if(isSame){
+                for(int j=0; j < numJoints; ++j){
+                    if(fabs(q[j] - q_stored[j]) > DisplacementTolerance){
+                        isSame = false;
+                        break;
+                    }
+                }
+            }
+            if(isSolved){
+                std::copy(q.begin(), q.end(), q_stored);
+            }
+            solved[index] = isSolved;
+            ++index;
+            if(isSame){
+                break;
+            }
+        }
+        repairedEnd = index;
+    }
+
+    if(isOriginalKitUsed){
+        setJointDisplacements(kinematicsKit, q0.data());
+    }
+
+    checkFeasibility(program, kinematicsKit, solved, trajectory, mout);
+
+    entry.trajectory = trajectory;
+    cache[program] = std::move(entry);
+
+    return trajectory;
+}
+
+
+bool MprProgramTrajectoryCompiler::Impl::isCacheValid
+(const CacheEntry& entry, BodyKinematicsKit* kinematicsKit, const vector<double>& q0)
+{
+    auto program = entry.program.lock();
+    if(!program || program->revision() != entry.programRevision){
+        return false;
+    }
+    if(kinematicsKit->body()->modelName() != entry.bodyModelName){
+        return false;
+    }
+    vector<int> jointIndices;
+    getJointIndices(kinematicsKit, jointIndices);
+    if(jointIndices != entry.jointIndices){
+        return false;
+    }
+    for(auto& record : entry.positionListRevisions){
+        if(!record.isUpToDate()){
+            return false;
+        }
+    }
+    for(auto& record : entry.tagGroupRevisions){
+        if(!record.isUpToDate()){
+            return false;
+        }
+    }
+    if(entry.initialDisplacements.size() != q0.size()){
+        return false;
+    }
+    for(size_t i=0; i < q0.size(); ++i){
+        if(fabs(entry.initialDisplacements[i] - q0[i]) > DisplacementTolerance){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void MprProgramTrajectoryCompiler::Impl::collectWaypoints
+(MprProgram* program, vector<Waypoint>& out_waypoints, CacheEntry& entry)
+{
+    // The position lists are resolved here because the lists may be created when they are accessed
+    vector<MprPositionList*> positionLists;
+
+    program->traverseStatements(
+        [&](MprStatement* statement){
+            if(auto ps = dynamic_cast<MprPositionStatement*>(statement)){
+                out_waypoints.push_back({ ps, ps->position() });
+                if(auto holder = ps->holderProgram()){
+                    auto positionList = holder->positionList();
+                    if(std::find(positionLists.begin(), positionLists.end(), positionList) == positionLists.end()){
+                        positionLists.push_back(positionList);
+                    }
+                }
+            } else if(auto ts = dynamic_cast<MprTagTraceStatement*>(statement)){
+                if(auto tagGroup = ts->tagGroup()){
+                    entry.tagGroupRevisions.emplace_back(tagGroup);
+                }
+            }
+        });
+
+    for(auto& positionList : positionLists){
+        entry.positionListRevisions.emplace_back(positionList);
+    }
+}
+
+
+void MprProgramTrajectoryCompiler::Impl::solveWaypoints
+(Solver& solver, const vector<Waypoint>& waypoints, int begin, int end,
+ MprProgramTrajectory* trajectory, vector<char>& solved)
+{
+    const int numJoints = trajectory->numJoints_;
+    for(int i = begin; i < end; ++i){
+        solved[i] = solveWaypoint(solver, waypoints[i], &trajectory->displacements_[i * numJoints]);
+    }
+}
+
+
+bool MprProgramTrajectoryCompiler::Impl::solveWaypoint
+(Solver& solver, const Waypoint& waypoint, double* out_q)
+{
+    auto kinematicsKit = solver.kinematicsKit.get();
+    /*
+      The inverse kinematics that has converged leaves the end link at the target position
+      instead of the position given by the joint displacements. The forward kinematics is
+      updated so that the solution only depends on the displacements of the previous waypoint,
+      which is required to make the result of the parallel solvers the same as the sequential one.
+    */
+    if(auto traverse = kinematicsKit->jointTraverse()){
+        traverse->calcForwardKinematics();
+    }
+    if(waypoint.position && waypoint.position->apply(kinematicsKit)){
+        getJointDisplacements(kinematicsKit, out_q);
+        std::copy(out_q, out_q + solver.lastValidDisplacements.size(), solver.lastValidDisplacements.begin());
+        return true;
+    }
+    // The next waypoint is solved from the last valid state
+    setJointDisplacements(kinematicsKit, solver.lastValidDisplacements.data());
+    return false;
+}
+
+
+void MprProgramTrajectoryCompiler::Impl::checkFeasibility
+(MprProgram* program, BodyKinematicsKit* kinematicsKit, const vector<char>& solved,
+ MprProgramTrajectory* trajectory, MessageOut* mout)
+{
+    const int numJoints = trajectory->numJoints_;
+    const int numWaypoints = trajectory->numWaypoints();
+    auto& validities = trajectory->validities_;
+    auto& segmentTimes = trajectory->minimumSegmentTimes_;
+    validities.resize(numWaypoints);
+    segmentTimes.resize(numWaypoints);
+    trajectory->isFeasible_ = true;
+
+    int prevValidIndex = -1;
+    for(int i=0; i < numWaypoints; ++i){
+        auto statement = trajectory->statements_[i];
+        const double* q = trajectory->waypoint(i);
+        bool isValid = solved[i];
+        if(!isValid){
+            if(mout){
+                mout->putErrorln(
+                    format(_("Position {0} of program \"{1}\" cannot be solved."),
+                           statement->positionLabel(), program->name()));
+            }
+        } else {
+            for(int j=0; j < numJoints; ++j){
+                auto joint = kinematicsKit->joint(j);
+                if(q[j] < joint->q_lower() - DisplacementTolerance ||
+                   q[j] > joint->q_upper() + DisplacementTolerance){
+                    if(mout){
+                        mout->putErrorln(
+                            format(_("The displacement of joint {0} at position {1} of program \"{2}\" "
+                                     "is out of its movable range."),
+                                   joint->jointName(), statement->positionLabel(), program->name()));
+                    }
+                    isValid = false;
+                    break;
+                }
+            }
+        }
+        validities[i] = isValid;
+
+        double minTime = 0.0;
+        if(isValid && prevValidIndex >= 0){
+            const double* q_prev = trajectory->waypoint(prevValidIndex);
+            for(int j=0; j < numJoints; ++j){
+                double dq_max = kinematicsKit->joint(j)->dq_upper();
+                if(dq_max > 0.0 && std::isfinite(dq_max)){
+                    minTime = std::max(minTime, fabs(q[j] - q_prev[j]) / dq_max);
+                }
+            }
+        }
+        segmentTimes[i] = minTime;
+
+        if(isValid){
+            prevValidIndex = i;
+        } else {
+            trajectory->isFeasible_ = false;
+        }
+    }
+}
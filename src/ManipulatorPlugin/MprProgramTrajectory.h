@@ -0,0 +1,117 @@
+#ifndef CNOID_MANIPULATOR_PLUGIN_MPR_PROGRAM_TRAJECTORY_H
+#define CNOID_MANIPULATOR_PLUGIN_MPR_PROGRAM_TRAJECTORY_H
+
+#include <cnoid/Referenced>
+#include <vector>
+#include "exportdecl.h"
+
+namespace cnoid {
+
+class MprProgram;
+class MprStatement;
+class MprPositionStatement;
+class BodyKinematicsKit;
+class MessageOut;
+
+/**
+   This class holds the joint displacements of the position statements in a program,
+   which are computed in advance by MprProgramTrajectoryCompiler. The waypoints are
+   stored in the order of the statement traversal, and the motion between the waypoints
+   can be computed by the interpolation without solving the inverse kinematics.
+*/
+class CNOID_EXPORT MprProgramTrajectory : public Referenced
+{
+public:
+    MprProgramTrajectory();
+    MprProgramTrajectory(const MprProgramTrajectory& org) = default;
+
+    int numJoints() const { return numJoints_; }
+    int numWaypoints() const { return statements_.size(); }
+
+    MprPositionStatement* waypointStatement(int index) const { return statements_[index]; }
+
+    //! \return -1 if the statement is not a waypoint of the trajectory
+    int findWaypointIndex(MprStatement* statement) const;
+
+    //! The joint displacements of the waypoint
+    const double* waypoint(int index) const { return &displacements_[index * numJoints_]; }
+
+    //! \return false if the position cannot be solved or the joints are out of the movable ranges
+    bool isWaypointValid(int index) const { return validities_[index]; }
+    bool isFeasible() const { return isFeasible_; }
+
+    /**
+       The minimum time to move to the waypoint from the previous waypoint within the joint
+       velocity limits. The value for the first waypoint is zero.
+    */
+    double minimumSegmentTime(int index) const { return minimumSegmentTimes_[index]; }
+
+    /**
+       This function linearly interpolates the joint displacements between the waypoint and
+       the next waypoint. The displacements of the waypoint are output when the ratio is zero.
+    */
+    void interpolate(int index, double ratio, double* out_q) const;
+
+    bool applyWaypoint(int index, BodyKinematicsKit* kinematicsKit) const;
+
+    /**
+       This function replaces the waypoint statements with the corresponding statements of
+       the program, which must have the same structure as the compiled program such as its clone.
+       \note The trajectory returned by MprProgramTrajectoryCompiler is shared with its cache,
+       so a copy of the trajectory should be used to bind the statements of another program.
+       \return false if the structure of the program does not match the trajectory
+    */
+    bool bindStatements(MprProgram* program);
+
+private:
+    std::vector<MprPositionStatement*> statements_;
+    std::vector<double> displacements_;
+    std::vector<bool> validities_;
+    std::vector<double> minimumSegmentTimes_;
+    int numJoints_;
+    bool isFeasible_;
+
+    friend class MprProgramTrajectoryCompiler;
+};
+
+typedef ref_ptr<MprProgramTrajectory> MprProgramTrajectoryPtr;
+
+
+/**
+   This class computes the joint space trajectory of a program by solving the inverse
+   kinematics of all the position statements including the ones expanded by the tag trace
+   statements. The positions are solved by multiple threads, each of which uses a clone of
+   the target body.
+
+   The compiled trajectory is cached for each program, and it is reused as long as the
+   program, its position lists, the tag groups of the tag trace statements, the target joints
+   and their initial displacements are not changed. The revision numbers of the program,
+   the position lists and the tag groups are used to detect the changes.
+*/
+class CNOID_EXPORT MprProgramTrajectoryCompiler
+{
+public:
+    MprProgramTrajectoryCompiler();
+    ~MprProgramTrajectoryCompiler();
+
+    //! The default value is the number of hardware threads.
+    void setMaxNumThreads(int n);
+    int maxNumThreads() const;
+
+    /**
+       \note The current joint displacements of the kinematics kit body are used as the initial
+       state of the inverse kinematics. The body state is not changed by this function.
+    */
+    MprProgramTrajectory* compile(
+        MprProgram* program, BodyKinematicsKit* kinematicsKit, MessageOut* mout = nullptr);
+
+    void clearCache();
+
+private:
+    class Impl;
+    Impl* impl;
+};
+
+}
+
+#endif
@@ -0,0 +1,308 @@
+/**
+   This program checks the trajectory of a tag trace program compiled by MprProgramTrajectoryCompiler.
+   The program is driven through the compiled trajectory as the statement interpreters of a
+   controller do, and the manipulator must reach the tag positions without solving the inverse
+   kinematics in the loop.
+*/
+
+#include "MprProgramTrajectory.h"
+#include "MprProgram.h"
+#include "MprPosition.h"
+#include "MprPositionList.h"
+#include "MprPositionStatement.h"
+#include "MprTagTraceStatement.h"
+#include <cnoid/Body>
+#include <cnoid/BodyKinematicsKit>
+#include <cnoid/PositionTag>
+#include <cnoid/CloneMap>
+#include <cnoid/EigenUtil>
+#include <iostream>
+#include <cmath>
+
+using namespace std;
+using namespace cnoid;
+
+namespace {
+
+constexpr int NumJoints = 6;
+constexpr int NumTags = 64;
+constexpr double PositionTolerance = 1.0e-6;
+// The numerical inverse kinematics regards the orientation error under about 1.4e-3 rad as zero
+constexpr double RotationTolerance = 2.0e-3;
+constexpr double DisplacementTolerance = 1.0e-5;
+
+int numFailures = 0;
+
+void check(bool condition, const string& message)
+{
+    if(!condition){
+        cerr << "FAILED: " << message << endl;
+        ++numFailures;
+    }
+}
+
+
+/*
+  The tag trace statement that moves the end effector to each tag in order as the
+  implementations of the derived plugins do.
+*/
+class TestTagTraceStatement : public MprTagTraceStatement
+{
+public:
+    TestTagTraceStatement() { }
+
+    virtual bool updateTagTraceProgram() override
+    {
+        auto program = lowerLevelProgram();
+        program->clearStatements();
+        auto positions = program->positionList();
+        positions->clear();
+        auto tags = tagGroup();
+        if(!tags){
+            return false;
+        }
+        for(int i=0; i < tags->numTags(); ++i){
+            MprIkPositionPtr position = new MprIkPosition(i);
+            position->setPosition(tagGroupPosition() * tags->tagAt(i)->position());
+            positions->append(position);
+            auto statement = new MprPositionStatement;
+            statement->setPositionId(i);
+            program->append(statement, false);
+        }
+        return true;
+    }
+
+protected:
+    TestTagTraceStatement(const TestTagTraceStatement& org, CloneMap* cloneMap)
+        : MprTagTraceStatement(org, cloneMap) { }
+
+    virtual Referenced* doClone(CloneMap* cloneMap) const override
+    {
+        return new TestTagTraceStatement(*this, cloneMap);
+    }
+};
+
+
+Body* createArm()
+{
+    auto body = new Body;
+    body->setModelName("arm");
+    auto root = body->createLink();
+    root->setName("BASE");
+    root->setJointType(Link::FixedJoint);
+    body->setRootLink(root);
+
+    const Vector3 axes[NumJoints] = {
+        Vector3::UnitZ(), Vector3::UnitY(), Vector3::UnitY(), Vector3::UnitX(), Vector3::UnitY(), Vector3::UnitX() };
+    const Vector3 offsets[NumJoints] = {
+        Vector3(0.0, 0.0, 0.2), Vector3::Zero(), Vector3(0.0, 0.0, 0.4),
+        Vector3(0.35, 0.0, 0.0), Vector3::Zero(), Vector3(0.0, 0.0, 0.1) };
+    Link* parent = root;
+    for(int i=0; i < NumJoints; ++i){
+        auto link = body->createLink();
+        link->setName("J" + to_string(i + 1));
+        link->setJointType(Link::RevoluteJoint);
+        link->setJointId(i);
+        link->setJointAxis(axes[i]);
+        link->setOffsetTranslation(offsets[i]);
+        link->setJointRange(-2.8, 2.8);
+        link->setJointVelocityRange(-3.0, 3.0);
+        parent->appendChild(link);
+        parent = link;
+    }
+    body->updateLinkTree();
+
+    for(int i=0; i < NumJoints; ++i){
+        body->joint(i)->q() = 0.3;
+    }
+    body->joint(2)->q() = 0.8;
+    body->calcForwardKinematics();
+
+    return body;
+}
+
+
+PositionTagGroup* createCircleTags(int numTags)
+{
+    auto tags = new PositionTagGroup;
+    tags->setName("Circle");
+    for(int i=0; i < numTags; ++i){
+        double t = 2.0 * M_PI * i / numTags;
+        Isometry3 T = Isometry3::Identity();
+        T.linear() = rotFromRpy(0.05 * sin(t), 0.05 * cos(t) - 0.05, 0.0);
+        T.translation() = Vector3(0.03 * sin(t), 0.04 * (1.0 - cos(t)), 0.02 * sin(2.0 * t));
+        tags->append(new PositionTag(T));
+    }
+    return tags;
+}
+
+
+bool isSamePosition(const Isometry3& T1, const Isometry3& T2)
+{
+    return (T1.translation() - T2.translation()).norm() < PositionTolerance &&
+        AngleAxis(T1.linear().transpose() * T2.linear()).angle() < RotationTolerance;
+}
+
+
+double maxDisplacementDifference(const double* q1, const double* q2)
+{
+    double maxDiff = 0.0;
+    for(int i=0; i < NumJoints; ++i){
+        maxDiff = std::max(maxDiff, fabs(q1[i] - q2[i]));
+    }
+    return maxDiff;
+}
+
+
+/*
+  Moves the manipulator along the trajectory from the first waypoint to the last one with
+  the interpolation and checks that the end effector reaches the target of each waypoint.
+*/
+void driveProgram(MprProgramTrajectory* trajectory, BodyKinematicsKit* kinematicsKit, const string& label)
+{
+    constexpr int NumSegmentSteps = 10;
+    double q[NumJoints];
+    auto body = kinematicsKit->body();
+
+    for(int i=0; i < trajectory->numWaypoints(); ++i){
+        check(trajectory->isWaypointValid(i), label + ": waypoint " + to_string(i) + " is not valid");
+
+        trajectory->interpolate(i, 0.0, q);
+        check(maxDisplacementDifference(q, trajectory->waypoint(i)) == 0.0,
+              label + ": interpolation at waypoint " + to_string(i));
+
+        for(int j=0; j < NumJoints; ++j){
+            body->joint(j)->q() = q[j];
+        }
+        body->calcForwardKinematics();
+        auto position = dynamic_cast<MprIkPosition*>(trajectory->waypointStatement(i)->position());
+        check(position && isSamePosition(kinematicsKit->endPosition(), position->position()),
+              label + ": end position at waypoint " + to_string(i));
+
+        if(i + 1 < trajectory->numWaypoints()){
+            auto q0 = trajectory->waypoint(i);
+            auto q1 = trajectory->waypoint(i + 1);
+            for(int k=1; k < NumSegmentSteps; ++k){
+                double r = static_cast<double>(k) / NumSegmentSteps;
+                trajectory->interpolate(i, r, q);
+                for(int j=0; j < NumJoints; ++j){
+                    if(q[j] < std::min(q0[j], q1[j]) - 1.0e-12 || q[j] > std::max(q0[j], q1[j]) + 1.0e-12){
+                        check(false, label + ": interpolation between waypoints " + to_string(i));
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+}
+
+
+int main()
+{
+    BodyPtr body = createArm();
+    BodyKinematicsKitPtr kinematicsKit = new BodyKinematicsKit;
+    kinematicsKit->setJointPath(body->rootLink(), body->link("J6"));
+
+    double initialDisplacements[NumJoints];
+    for(int i=0; i < NumJoints; ++i){
+        initialDisplacements[i] = body->joint(i)->q();
+    }
+    Isometry3 T_home = kinematicsKit->endPosition();
+
+    // The program moves the end effector to the home position and traces the tags around it
+    MprProgramPtr program = new MprProgram;
+    program->setName("TagTrace");
+    MprIkPositionPtr home = new MprIkPosition(0);
+    home->setPosition(T_home);
+    program->positionList()->append(home);
+    auto homeStatement = new MprPositionStatement;
+    homeStatement->setPositionId(0);
+    program->append(homeStatement, false);
+
+    PositionTagGroupPtr tags = createCircleTags(NumTags);
+    ref_ptr<TestTagTraceStatement> traceStatement = new TestTagTraceStatement;
+    traceStatement->setTagGroupPosition(T_home);
+    traceStatement->setTagGroup(tags, true, true, false);
+    program->append(traceStatement, false);
+
+    MprProgramTrajectoryCompiler compiler;
+    compiler.setMaxNumThreads(1);
+    MprProgramTrajectoryPtr trajectory = compiler.compile(program, kinematicsKit);
+    check(trajectory != nullptr, "compilation");
+    if(!trajectory){
+        cerr << numFailures << " check(s) failed." << endl;
+        return 1;
+    }
+    check(trajectory->numJoints() == NumJoints, "number of joints");
+    check(trajectory->numWaypoints() == NumTags + 1, "number of waypoints");
+    check(trajectory->isFeasible(), "feasibility");
+
+    bool isBodyStateUnchanged = true;
+    for(int i=0; i < NumJoints; ++i){
+        isBodyStateUnchanged &= (body->joint(i)->q() == initialDisplacements[i]);
+    }
+    check(isBodyStateUnchanged, "body state after the compilation");
+
+    // The trajectory compiled by multiple threads must be the same as the sequential one
+    MprProgramTrajectoryCompiler parallelCompiler;
+    parallelCompiler.setMaxNumThreads(4);
+    MprProgramTrajectoryPtr parallelTrajectory = parallelCompiler.compile(program, kinematicsKit);
+    check(parallelTrajectory && parallelTrajectory->numWaypoints() == trajectory->numWaypoints(),
+          "parallel compilation");
+    if(parallelTrajectory){
+        for(int i=0; i < trajectory->numWaypoints(); ++i){
+            if(maxDisplacementDifference(parallelTrajectory->waypoint(i), trajectory->waypoint(i)) > DisplacementTolerance){
+                check(false, "parallel compilation result at waypoint " + to_string(i));
+                break;
+            }
+        }
+    }
+
+    check(compiler.compile(program, kinematicsKit) == trajectory, "cached trajectory");
+
+    // The trajectory is bound to the clone of the program used in a controller
+    CloneMap cloneMap;
+    MprProgramPtr clonedProgram = program->clone(cloneMap);
+    MprProgramTrajectoryPtr boundTrajectory = new MprProgramTrajectory(*trajectory);
+    check(boundTrajectory->bindStatements(clonedProgram), "binding to the cloned program");
+    int waypointIndex = 0;
+    clonedProgram->traverseStatements(
+        [&](MprStatement* statement){
+            if(dynamic_cast<MprPositionStatement*>(statement)){
+                check(boundTrajectory->findWaypointIndex(statement) == waypointIndex,
+                      "waypoint index of cloned statement " + to_string(waypointIndex));
+                ++waypointIndex;
+            }
+        });
+    check(boundTrajectory->findWaypointIndex(traceStatement) < 0, "tag trace statement is not a waypoint");
+
+    driveProgram(boundTrajectory, kinematicsKit, "cloned program");
+
+    // Updating a tag position must invalidate the cached trajectory
+    for(int i=0; i < NumJoints; ++i){
+        body->joint(i)->q() = initialDisplacements[i];
+    }
+    body->calcForwardKinematics();
+    const int movedTagIndex = NumTags / 2;
+    auto movedTag = tags->tagAt(movedTagIndex);
+    movedTag->setTranslation(movedTag->translation() + Vector3(0.0, 0.0, 0.01));
+    tags->notifyTagPositionUpdate(movedTagIndex);
+
+    MprProgramTrajectoryPtr updatedTrajectory = compiler.compile(program, kinematicsKit);
+    check(updatedTrajectory && updatedTrajectory != trajectory, "recompilation after the tag position update");
+    if(updatedTrajectory){
+        check(maxDisplacementDifference(
+                  updatedTrajectory->waypoint(movedTagIndex + 1), trajectory->waypoint(movedTagIndex + 1))
+              > DisplacementTolerance, "waypoint of the moved tag");
+        driveProgram(updatedTrajectory, kinematicsKit, "updated program");
+    }
+
+    if(numFailures > 0){
+        cerr << numFailures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All checks passed." << endl;
+    return 0;
+}
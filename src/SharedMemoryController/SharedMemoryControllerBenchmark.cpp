@@ -0,0 +1,179 @@
+/**
+   This program measures the round-trip latency of the shared memory controller channel.
+   The parent process plays the role of SharedMemoryControllerItem and the child process
+   runs a PD controller with SharedMemoryControllerClient in the lockstep mode.
+*/
+
+#include "SharedMemoryControllerChannel.h"
+#include "SharedMemoryControllerClient.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace cnoid;
+
+namespace {
+
+int runClient(const string& name, int spinCount)
+{
+    SharedMemoryControllerClient client;
+    client.setSpinCount(spinCount);
+    if(!client.connect(name)){
+        cerr << "Client: " << client.errorMessage() << endl;
+        return 1;
+    }
+    const int n = client.numJoints();
+    while(client.waitForState()){
+        const double* q = client.q();
+        const double* dq = client.dq();
+        double* u = client.command();
+        for(int i=0; i < n; ++i){
+            u[i] = 100.0 * (0.1 - q[i]) - 1.0 * dq[i];
+        }
+        if(!client.sendCommand()){
+            break;
+        }
+    }
+    return 0;
+}
+
+
+void printUsage()
+{
+    cout << "Usage: cnoid-shm-controller-benchmark [--joints N] [--steps N] [--spin N]" << endl;
+}
+
+}
+
+
+int main(int argc, char* argv[])
+{
+    int numJoints = 30;
+    int numSteps = 100000;
+    int spinCount = SharedMemoryRing::defaultSpinCount();
+
+    for(int i=1; i < argc; ++i){
+        string option(argv[i]);
+        if(i + 1 < argc && option == "--joints"){
+            numJoints = atoi(argv[++i]);
+        } else if(i + 1 < argc && option == "--steps"){
+            numSteps = atoi(argv[++i]);
+        } else if(i + 1 < argc && option == "--spin"){
+            spinCount = atoi(argv[++i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if(numJoints < 1 || numSteps < 1){
+        printUsage();
+        return 1;
+    }
+
+    string name = string("cnoid-shm-controller-benchmark-") + to_string(getpid());
+
+    vector<SharedMemoryControllerJointInfo> joints(numJoints);
+    for(int i=0; i < numJoints; ++i){
+        auto& joint = joints[i];
+        memset(&joint, 0, sizeof(joint));
+        snprintf(joint.name, sizeof(joint.name), "J%d", i);
+        joint.actuationMode = 1 << 3; // Link::JointEffort
+    }
+
+    SharedMemoryControllerChannel channel;
+    if(!channel.create(name, joints, {}, 0.001, true)){
+        cerr << channel.errorMessage() << endl;
+        return 1;
+    }
+
+    pid_t pid = fork();
+    if(pid < 0){
+        cerr << "fork failed" << endl;
+        return 1;
+    }
+    if(pid == 0){
+        _exit(runClient(name, spinCount));
+    }
+
+    auto header = channel.header();
+    auto& stateRing = channel.stateRing();
+    auto& commandRing = channel.commandRing();
+    vector<double> q(numJoints, 0.0), dq(numJoints, 0.0), u(numJoints, 0.0);
+    vector<double> latencies;
+    latencies.reserve(numSteps);
+    const double dt = 0.001;
+    bool failed = false;
+
+    for(int frame=0; frame < numSteps; ++frame){
+        auto t0 = chrono::steady_clock::now();
+
+        auto stateFrame = static_cast<char*>(stateRing.frameToWrite());
+        auto frameHeader = reinterpret_cast<SharedMemoryControllerFrameHeader*>(stateFrame);
+        frameHeader->frameIndex = frame;
+        frameHeader->time = frame * dt;
+        memcpy(stateFrame + channel.stateQOffset(), q.data(), sizeof(double) * numJoints);
+        memcpy(stateFrame + channel.stateDqOffset(), dq.data(), sizeof(double) * numJoints);
+        memcpy(stateFrame + channel.stateUOffset(), u.data(), sizeof(double) * numJoints);
+        stateRing.push();
+
+        bool received = false;
+        while(commandRing.waitForFrame(10.0, spinCount, &header->isClientDetached)){
+            auto commandFrame = static_cast<const char*>(commandRing.frameToRead());
+            auto index = reinterpret_cast<const SharedMemoryControllerFrameHeader*>(commandFrame)->frameIndex;
+            if(index == static_cast<uint64_t>(frame)){
+                memcpy(u.data(), commandFrame + channel.commandOffset(), sizeof(double) * numJoints);
+                received = true;
+            }
+            commandRing.pop();
+            if(received){
+                break;
+            }
+        }
+        if(!received){
+            cerr << "The command for frame " << frame << " was not received." << endl;
+            failed = true;
+            break;
+        }
+
+        auto t1 = chrono::steady_clock::now();
+        latencies.push_back(chrono::duration<double, micro>(t1 - t0).count());
+
+        for(int i=0; i < numJoints; ++i){
+            dq[i] += u[i] * dt;
+            q[i] += dq[i] * dt;
+        }
+    }
+
+    channel.close();
+    int status;
+    waitpid(pid, &status, 0);
+
+    if(failed || latencies.empty()){
+        return 1;
+    }
+
+    sort(latencies.begin(), latencies.end());
+    double sum = 0.0;
+    for(auto& t : latencies){
+        sum += t;
+    }
+    auto percentile = [&](double p){ return latencies[std::min(latencies.size() - 1, size_t(p * latencies.size()))]; };
+
+    cout << "joints: " << numJoints << ", steps: " << latencies.size() << ", spin count: " << spinCount << "\n"
+         << "round trip [us]: mean " << sum / latencies.size()
+         << ", min " << latencies.front()
+         << ", median " << percentile(0.5)
+         << ", 99% " << percentile(0.99)
+         << ", 99.9% " << percentile(0.999)
+         << ", max " << latencies.back() << endl;
+    cout << "final q[0]: " << q[0] << endl;
+
+    return 0;
+}
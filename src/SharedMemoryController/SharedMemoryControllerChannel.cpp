@@ -0,0 +1,438 @@
+#include "SharedMemoryControllerChannel.h"
+#include <chrono>
+#include <thread>
+#include <new>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace cnoid;
+
+namespace {
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "The atomic word must be usable as a futex word.");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "The atomic word must be lock free.");
+
+constexpr int64_t maxSleepSliceNanoseconds = 50000000;
+
+inline size_t alignSize(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+inline void pause()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/*
+  The futex calls do not use FUTEX_PRIVATE_FLAG because the words are shared between
+  the processes.
+*/
+int futexWait(std::atomic<uint32_t>& word, uint32_t value, const struct timespec* timeout)
+{
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, value, timeout, nullptr, 0);
+}
+
+
+void futexWakeAll(std::atomic<uint32_t>& word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+
+inline void wakeUpWaiters(std::atomic<uint32_t>& word, std::atomic<uint32_t>& numWaiters)
+{
+    // The fence orders the preceding update of the word and the check of the waiters
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(numWaiters.load(std::memory_order_relaxed) > 0){
+        futexWakeAll(word);
+    }
+}
+
+
+/**
+   Waits until the condition becomes true. The word is used to sleep on the futex and it must
+   be updated (and the waiters must be woken up) when the condition may have been changed.
+*/
+template<class Condition>
+bool waitOnWord
+(std::atomic<uint32_t>& word, std::atomic<uint32_t>& numWaiters, Condition condition,
+ double timeout, int spinCount, const std::atomic<uint32_t>* abortFlag)
+{
+    for(int i=0; i < spinCount; ++i){
+        if(condition()){
+            return true;
+        }
+        if(abortFlag && abortFlag->load(std::memory_order_relaxed)){
+            return false;
+        }
+        pause();
+    }
+    if(condition()){
+        return true;
+    }
+    if(timeout == 0.0){
+        return false;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    const bool hasTimeLimit = (timeout > 0.0);
+    Clock::time_point deadline;
+    if(hasTimeLimit){
+        deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeout));
+    }
+
+    bool satisfied = false;
+    numWaiters.fetch_add(1, std::memory_order_seq_cst);
+    while(true){
+        uint32_t value = word.load(std::memory_order_seq_cst);
+        if(condition()){
+            satisfied = true;
+            break;
+        }
+        if(abortFlag && abortFlag->load(std::memory_order_seq_cst)){
+            break;
+        }
+        /*
+          The abort flag may be set just after it is checked above, and the wake-up for it
+          does not change the word. The sleep is divided into short slices in that case
+          so that the abort is detected without a long delay.
+        */
+        int64_t ns = -1;
+        if(hasTimeLimit){
+            auto remaining = deadline - Clock::now();
+            if(remaining <= Clock::duration::zero()){
+                break;
+            }
+            ns = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+        }
+        if(abortFlag && (ns < 0 || ns > maxSleepSliceNanoseconds)){
+            ns = maxSleepSliceNanoseconds;
+        }
+        struct timespec ts;
+        if(ns >= 0){
+            ts.tv_sec = ns / 1000000000;
+            ts.tv_nsec = ns % 1000000000;
+        }
+        futexWait(word, value, (ns >= 0) ? &ts : nullptr);
+    }
+    numWaiters.fetch_sub(1, std::memory_order_relaxed);
+
+    return satisfied;
+}
+
+}
+
+
+SharedMemoryRing::SharedMemoryRing()
+{
+    header = nullptr;
+    frames = nullptr;
+    capacity_ = 0;
+    frameSize_ = 0;
+    mask = 0;
+}
+
+
+size_t SharedMemoryRing::memorySize(uint32_t capacity, uint32_t frameSize)
+{
+    return alignSize(sizeof(SharedMemoryRingHeader), 64) + static_cast<size_t>(capacity) * frameSize;
+}
+
+
+int SharedMemoryRing::defaultSpinCount()
+{
+    static const int count = (std::thread::hardware_concurrency() > 1) ? 2000 : 0;
+    return count;
+}
+
+
+void SharedMemoryRing::attach(void* memory, uint32_t capacity, uint32_t frameSize)
+{
+    header = static_cast<SharedMemoryRingHeader*>(memory);
+    frames = static_cast<char*>(memory) + alignSize(sizeof(SharedMemoryRingHeader), 64);
+    capacity_ = capacity;
+    frameSize_ = frameSize;
+    mask = capacity - 1;
+}
+
+
+void SharedMemoryRing::reset()
+{
+    new(header) SharedMemoryRingHeader;
+    header->head.store(0, std::memory_order_relaxed);
+    header->numHeadWaiters.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_relaxed);
+    header->numTailWaiters.store(0, std::memory_order_relaxed);
+}
+
+
+void SharedMemoryRing::push()
+{
+    header->head.fetch_add(1, std::memory_order_release);
+    wakeUpWaiters(header->head, header->numHeadWaiters);
+}
+
+
+void SharedMemoryRing::pop()
+{
+    header->tail.fetch_add(1, std::memory_order_release);
+    wakeUpWaiters(header->tail, header->numTailWaiters);
+}
+
+
+bool SharedMemoryRing::waitForFrame(double timeout, int spinCount, const std::atomic<uint32_t>* abortFlag)
+{
+    return waitOnWord(
+        header->head, header->numHeadWaiters, [this](){ return !empty(); },
+        timeout, spinCount, abortFlag);
+}
+
+
+bool SharedMemoryRing::waitForSpace(double timeout, int spinCount, const std::atomic<uint32_t>* abortFlag)
+{
+    return waitOnWord(
+        header->tail, header->numTailWaiters, [this](){ return !full(); },
+        timeout, spinCount, abortFlag);
+}
+
+
+void SharedMemoryRing::wakeUpAll()
+{
+    if(header){
+        futexWakeAll(header->head);
+        futexWakeAll(header->tail);
+    }
+}
+
+
+SharedMemoryControllerChannel::SharedMemoryControllerChannel()
+{
+    header_ = nullptr;
+    segmentSize = 0;
+    jointInfos = nullptr;
+    deviceInfos = nullptr;
+    isServer_ = false;
+}
+
+
+SharedMemoryControllerChannel::~SharedMemoryControllerChannel()
+{
+    close();
+}
+
+
+std::string SharedMemoryControllerChannel::segmentName(const std::string& name)
+{
+    if(!name.empty() && name[0] == '/'){
+        return name;
+    }
+    return string("/") + name;
+}
+
+
+uint32_t SharedMemoryControllerChannel::stateFrameSize(int numJoints, int numDeviceStateElements)
+{
+    size_t size = sizeof(SharedMemoryControllerFrameHeader) + sizeof(double) * (numJoints * 3 + numDeviceStateElements);
+    return alignSize(size, 64);
+}
+
+
+uint32_t SharedMemoryControllerChannel::commandFrameSize(int numJoints, int numDevices, int numDeviceStateElements)
+{
+    size_t size = sizeof(SharedMemoryControllerFrameHeader) + sizeof(double) * (numJoints + numDeviceStateElements) + numDevices;
+    return alignSize(size, 64);
+}
+
+
+bool SharedMemoryControllerChannel::create
+(const std::string& name_,
+ const std::vector<SharedMemoryControllerJointInfo>& joints,
+ const std::vector<SharedMemoryControllerDeviceInfo>& devices,
+ double timeStep, bool isLockstepMode, uint32_t ringCapacity)
+{
+    close();
+
+    if(ringCapacity == 0 || (ringCapacity & (ringCapacity - 1)) != 0){
+        errorMessage_ = "The ring capacity must be a power of two.";
+        return false;
+    }
+
+    int numDeviceStateElements = 0;
+    for(auto& device : devices){
+        numDeviceStateElements = std::max(numDeviceStateElements, device.stateOffset + device.stateSize);
+    }
+    const uint32_t stateFrameSize_ = stateFrameSize(joints.size(), numDeviceStateElements);
+    const uint32_t commandFrameSize_ = commandFrameSize(joints.size(), devices.size(), numDeviceStateElements);
+
+    size_t jointInfoOffset = alignSize(sizeof(SharedMemoryControllerHeader), 64);
+    size_t deviceInfoOffset = alignSize(jointInfoOffset + sizeof(SharedMemoryControllerJointInfo) * joints.size(), 64);
+    size_t stateRingOffset = alignSize(deviceInfoOffset + sizeof(SharedMemoryControllerDeviceInfo) * devices.size(), 64);
+    size_t commandRingOffset = alignSize(stateRingOffset + SharedMemoryRing::memorySize(ringCapacity, stateFrameSize_), 64);
+    size_t size = commandRingOffset + SharedMemoryRing::memorySize(ringCapacity, commandFrameSize_);
+    if(commandRingOffset > UINT32_MAX){
+        errorMessage_ = "The shared memory segment is too large.";
+        return false;
+    }
+
+    name = segmentName(name_);
+
+    // Remove the segment left by the previous session so that the clients attached to it
+    // do not see the new session through the old mapping.
+    ::shm_unlink(name.c_str());
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(fd < 0){
+        errorMessage_ = string("shm_open failed: ") + strerror(errno);
+        return false;
+    }
+    if(::ftruncate(fd, size) != 0){
+        errorMessage_ = string("ftruncate failed: ") + strerror(errno);
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+    void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(memory == MAP_FAILED){
+        errorMessage_ = string("mmap failed: ") + strerror(errno);
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+
+    char* base = static_cast<char*>(memory);
+    header_ = new(memory) SharedMemoryControllerHeader;
+    segmentSize = size;
+    isServer_ = true;
+
+    header_->version = SharedMemoryControllerHeader::Version;
+    header_->sessionId =
+        (static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) << 16) ^ ::getpid();
+    header_->segmentSize = size;
+    header_->timeStep = timeStep;
+    header_->numJoints = joints.size();
+    header_->numDevices = devices.size();
+    header_->numDeviceStateElements = numDeviceStateElements;
+    header_->ringCapacity = ringCapacity;
+    header_->isLockstepMode = isLockstepMode ? 1 : 0;
+    header_->jointInfoOffset = jointInfoOffset;
+    header_->deviceInfoOffset = deviceInfoOffset;
+    header_->stateRingOffset = stateRingOffset;
+    header_->commandRingOffset = commandRingOffset;
+    header_->stateFrameSize = stateFrameSize_;
+    header_->commandFrameSize = commandFrameSize_;
+    header_->isServerClosed.store(0, std::memory_order_relaxed);
+    header_->isClientAttached.store(0, std::memory_order_relaxed);
+    header_->isClientDetached.store(0, std::memory_order_relaxed);
+
+    if(!joints.empty()){
+        memcpy(base + jointInfoOffset, joints.data(), sizeof(SharedMemoryControllerJointInfo) * joints.size());
+    }
+    if(!devices.empty()){
+        memcpy(base + deviceInfoOffset, devices.data(), sizeof(SharedMemoryControllerDeviceInfo) * devices.size());
+    }
+
+    attachRings();
+    stateRing_.reset();
+    commandRing_.reset();
+
+    header_->magic.store(SharedMemoryControllerHeader::Magic, std::memory_order_release);
+
+    return true;
+}
+
+
+bool SharedMemoryControllerChannel::open(const std::string& name_)
+{
+    close();
+
+    name = segmentName(name_);
+
+    int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if(fd < 0){
+        errorMessage_ = string("shm_open failed: ") + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SharedMemoryControllerHeader)){
+        errorMessage_ = "The shared memory segment is not ready.";
+        ::close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(memory == MAP_FAILED){
+        errorMessage_ = string("mmap failed: ") + strerror(errno);
+        return false;
+    }
+
+    auto header = static_cast<SharedMemoryControllerHeader*>(memory);
+    if(header->magic.load(std::memory_order_acquire) != SharedMemoryControllerHeader::Magic){
+        errorMessage_ = "The shared memory segment is not ready.";
+        ::munmap(memory, size);
+        return false;
+    }
+    if(header->version != SharedMemoryControllerHeader::Version){
+        errorMessage_ = "The version of the shared memory segment is not supported.";
+        ::munmap(memory, size);
+        return false;
+    }
+    if(header->segmentSize != size){
+        errorMessage_ = "The size of the shared memory segment is inconsistent.";
+        ::munmap(memory, size);
+        return false;
+    }
+
+    header_ = header;
+    segmentSize = size;
+    isServer_ = false;
+    attachRings();
+
+    return true;
+}
+
+
+void SharedMemoryControllerChannel::attachRings()
+{
+    char* base = reinterpret_cast<char*>(header_);
+    jointInfos = reinterpret_cast<const SharedMemoryControllerJointInfo*>(base + header_->jointInfoOffset);
+    deviceInfos = reinterpret_cast<const SharedMemoryControllerDeviceInfo*>(base + header_->deviceInfoOffset);
+    stateRing_.attach(base + header_->stateRingOffset, header_->ringCapacity, header_->stateFrameSize);
+    commandRing_.attach(base + header_->commandRingOffset, header_->ringCapacity, header_->commandFrameSize);
+}
+
+
+void SharedMemoryControllerChannel::close()
+{
+    if(header_){
+        if(isServer_){
+            header_->isServerClosed.store(1, std::memory_order_seq_cst);
+            stateRing_.wakeUpAll();
+            commandRing_.wakeUpAll();
+            ::shm_unlink(name.c_str());
+        }
+        ::munmap(header_, segmentSize);
+        header_ = nullptr;
+        segmentSize = 0;
+        jointInfos = nullptr;
+        deviceInfos = nullptr;
+        stateRing_ = SharedMemoryRing();
+        commandRing_ = SharedMemoryRing();
+    }
+}
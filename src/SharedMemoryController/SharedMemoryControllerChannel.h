@@ -0,0 +1,223 @@
+#ifndef CNOID_SHARED_MEMORY_CONTROLLER_SHARED_MEMORY_CONTROLLER_CHANNEL_H
+#define CNOID_SHARED_MEMORY_CONTROLLER_SHARED_MEMORY_CONTROLLER_CHANNEL_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "exportdecl.h"
+
+namespace cnoid {
+
+/**
+   The header placed at the beginning of a shared memory segment of the controller channel.
+   All the offsets are the byte offsets from the beginning of the segment, and the layout
+   is fixed by the server when the segment is created.
+*/
+struct SharedMemoryControllerHeader
+{
+    static constexpr uint32_t Magic = 0x4d534e43; // "CNSM"
+    static constexpr uint32_t Version = 1;
+
+    //! Written last by the server to publish the segment
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint64_t sessionId;
+    uint64_t segmentSize;
+    double timeStep;
+    uint32_t numJoints;
+    uint32_t numDevices;
+    uint32_t numDeviceStateElements;
+    uint32_t ringCapacity;
+    uint32_t isLockstepMode;
+    uint32_t jointInfoOffset;
+    uint32_t deviceInfoOffset;
+    uint32_t stateRingOffset;
+    uint32_t commandRingOffset;
+    uint32_t stateFrameSize;
+    uint32_t commandFrameSize;
+    std::atomic<uint32_t> isServerClosed;
+    std::atomic<uint32_t> isClientAttached;
+    std::atomic<uint32_t> isClientDetached;
+};
+
+struct SharedMemoryControllerJointInfo
+{
+    char name[64];
+    int32_t actuationMode;
+    int32_t reserved;
+};
+
+struct SharedMemoryControllerDeviceInfo
+{
+    char name[64];
+    char typeName[48];
+    //! Offset in the device state elements of a frame
+    int32_t stateOffset;
+    int32_t stateSize;
+    int32_t reserved[2];
+};
+
+/**
+   The header of a state or command frame. The frame index of a command frame is the index
+   of the state frame that the command was computed from.
+*/
+struct SharedMemoryControllerFrameHeader
+{
+    uint64_t frameIndex;
+    double time;
+};
+
+/**
+   The indices of a single-producer single-consumer ring. The head is only written by the
+   producer and the tail is only written by the consumer. Each of them is also used as a
+   futex word to wake up the other side.
+*/
+struct SharedMemoryRingHeader
+{
+    alignas(64) std::atomic<uint32_t> head;
+    std::atomic<uint32_t> numHeadWaiters;
+    alignas(64) std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> numTailWaiters;
+};
+
+/**
+   This class accesses a single-producer single-consumer ring of fixed size frames in a
+   shared memory segment. The capacity must be a power of two.
+*/
+class CNOID_EXPORT SharedMemoryRing
+{
+public:
+    SharedMemoryRing();
+
+    static size_t memorySize(uint32_t capacity, uint32_t frameSize);
+
+    //! The spin count is zero on a single processor system, where spinning only delays the other side.
+    static int defaultSpinCount();
+
+    void attach(void* memory, uint32_t capacity, uint32_t frameSize);
+    void reset();
+
+    uint32_t capacity() const { return capacity_; }
+    uint32_t frameSize() const { return frameSize_; }
+    uint32_t numFrames() const {
+        return header->head.load(std::memory_order_acquire) - header->tail.load(std::memory_order_acquire);
+    }
+    bool empty() const { return numFrames() == 0; }
+    bool full() const { return numFrames() >= capacity_; }
+
+    //! The producer writes the frame returned by this function and calls push when the ring is not full.
+    void* frameToWrite() {
+        return frames + static_cast<size_t>(header->head.load(std::memory_order_relaxed) & mask) * frameSize_;
+    }
+    void push();
+
+    //! The consumer reads the frame returned by this function and calls pop when the ring is not empty.
+    const void* frameToRead() const {
+        return frames + static_cast<size_t>(header->tail.load(std::memory_order_relaxed) & mask) * frameSize_;
+    }
+    void pop();
+
+    /**
+       The waiting functions spin the specified number of times before sleeping on the futex.
+       \param timeout Negative value means no time limit.
+       \param abortFlag The waiting is aborted when the flag becomes non-zero.
+       \return false when timed out or aborted
+    */
+    bool waitForFrame(double timeout, int spinCount, const std::atomic<uint32_t>* abortFlag = nullptr);
+    bool waitForSpace(double timeout, int spinCount, const std::atomic<uint32_t>* abortFlag = nullptr);
+
+    //! Wakes up both sides so that they can check their abort flags.
+    void wakeUpAll();
+
+private:
+    SharedMemoryRingHeader* header;
+    char* frames;
+    uint32_t capacity_;
+    uint32_t frameSize_;
+    uint32_t mask;
+};
+
+/**
+   This class creates or opens the shared memory segment used for the communication
+   between a controller item and an external controller process.
+   The server side (the controller item) creates the segment with the joint and device
+   information of the target body, and the client side opens it. The segment contains
+   the ring of the state frames sent from the server and the ring of the command frames
+   sent from the client.
+
+   A state frame consists of the frame header, the joint displacements, the joint
+   velocities, the joint efforts and the device state elements. A command frame consists
+   of the frame header, the joint commands, the device state elements and the flags of
+   the updated devices. The meaning of each joint command is given by the actuation mode
+   of the joint.
+*/
+class CNOID_EXPORT SharedMemoryControllerChannel
+{
+public:
+    SharedMemoryControllerChannel();
+    SharedMemoryControllerChannel(const SharedMemoryControllerChannel&) = delete;
+    ~SharedMemoryControllerChannel();
+
+    //! The leading slash is added to the name if it does not have it.
+    static std::string segmentName(const std::string& name);
+
+    bool create(
+        const std::string& name,
+        const std::vector<SharedMemoryControllerJointInfo>& joints,
+        const std::vector<SharedMemoryControllerDeviceInfo>& devices,
+        double timeStep, bool isLockstepMode, uint32_t ringCapacity = 4);
+
+    //! \return false when the segment does not exist or is not ready yet
+    bool open(const std::string& name);
+
+    void close();
+
+    bool isOpen() const { return header_ != nullptr; }
+    bool isServer() const { return isServer_; }
+    const std::string& errorMessage() const { return errorMessage_; }
+
+    SharedMemoryControllerHeader* header() { return header_; }
+    const SharedMemoryControllerHeader* header() const { return header_; }
+
+    int numJoints() const { return header_->numJoints; }
+    const SharedMemoryControllerJointInfo& jointInfo(int index) const { return jointInfos[index]; }
+    int numDevices() const { return header_->numDevices; }
+    const SharedMemoryControllerDeviceInfo& deviceInfo(int index) const { return deviceInfos[index]; }
+    int numDeviceStateElements() const { return header_->numDeviceStateElements; }
+
+    SharedMemoryRing& stateRing() { return stateRing_; }
+    SharedMemoryRing& commandRing() { return commandRing_; }
+
+    // Byte offsets of the elements in a frame
+    size_t stateQOffset() const { return sizeof(SharedMemoryControllerFrameHeader); }
+    size_t stateDqOffset() const { return stateQOffset() + sizeof(double) * numJoints(); }
+    size_t stateUOffset() const { return stateDqOffset() + sizeof(double) * numJoints(); }
+    size_t stateDeviceOffset() const { return stateUOffset() + sizeof(double) * numJoints(); }
+    size_t commandOffset() const { return sizeof(SharedMemoryControllerFrameHeader); }
+    size_t commandDeviceOffset() const { return commandOffset() + sizeof(double) * numJoints(); }
+    size_t commandDeviceFlagOffset() const {
+        return commandDeviceOffset() + sizeof(double) * numDeviceStateElements();
+    }
+
+    static uint32_t stateFrameSize(int numJoints, int numDeviceStateElements);
+    static uint32_t commandFrameSize(int numJoints, int numDevices, int numDeviceStateElements);
+
+private:
+    SharedMemoryControllerHeader* header_;
+    size_t segmentSize;
+    std::string name;
+    const SharedMemoryControllerJointInfo* jointInfos;
+    const SharedMemoryControllerDeviceInfo* deviceInfos;
+    SharedMemoryRing stateRing_;
+    SharedMemoryRing commandRing_;
+    bool isServer_;
+    std::string errorMessage_;
+
+    void attachRings();
+};
+
+}
+
+#endif
@@ -0,0 +1,364 @@
+#include "SharedMemoryControllerClient.h"
+#include "SharedMemoryControllerChannel.h"
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstring>
+
+using namespace std;
+using namespace cnoid;
+
+namespace cnoid {
+
+class SharedMemoryControllerClient::Impl
+{
+public:
+    SharedMemoryControllerChannel channel;
+    SharedMemoryControllerHeader* header;
+    int spinCount;
+    vector<char> stateBuf;
+    vector<char> commandBuf;
+    int64_t lastFrameIndex;
+    bool hasState;
+    string errorMessage;
+
+    Impl();
+    bool connect(const std::string& name, double timeout);
+    void disconnect();
+    bool waitForState(double timeout);
+    bool sendCommand(double timeout);
+
+    const double* stateArray(size_t offset) const {
+        return reinterpret_cast<const double*>(stateBuf.data() + offset);
+    }
+    double* commandArray(size_t offset) {
+        return reinterpret_cast<double*>(commandBuf.data() + offset);
+    }
+};
+
+}
+
+
+SharedMemoryControllerClient::SharedMemoryControllerClient()
+{
+    impl = new Impl;
+}
+
+
+SharedMemoryControllerClient::Impl::Impl()
+{
+    header = nullptr;
+    spinCount = SharedMemoryRing::defaultSpinCount();
+    lastFrameIndex = -1;
+    hasState = false;
+}
+
+
+SharedMemoryControllerClient::~SharedMemoryControllerClient()
+{
+    impl->disconnect();
+    delete impl;
+}
+
+
+bool SharedMemoryControllerClient::connect(const std::string& name, double timeout)
+{
+    return impl->connect(name, timeout);
+}
+
+
+bool SharedMemoryControllerClient::Impl::connect(const std::string& name, double timeout)
+{
+    disconnect();
+
+    typedef std::chrono::steady_clock Clock;
+    auto startTime = Clock::now();
+
+    while(true){
+        if(channel.open(name)){
+            header = channel.header();
+            if(!header->isServerClosed.load()){
+                uint32_t expected = 0;
+                if(header->isClientAttached.compare_exchange_strong(expected, 1)){
+                    break;
+                }
+                errorMessage = "Another client is already connected.";
+                channel.close();
+                header = nullptr;
+                return false;
+            }
+            channel.close();
+            header = nullptr;
+            errorMessage = "The controller has already been stopped.";
+        } else {
+            errorMessage = channel.errorMessage();
+        }
+        if(timeout >= 0.0 &&
+           std::chrono::duration<double>(Clock::now() - startTime).count() >= timeout){
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    header->isClientDetached.store(0);
+
+    stateBuf.assign(header->stateFrameSize, 0);
+    commandBuf.assign(header->commandFrameSize, 0);
+    lastFrameIndex = -1;
+    hasState = false;
+    errorMessage.clear();
+
+    return true;
+}
+
+
+void SharedMemoryControllerClient::disconnect()
+{
+    impl->disconnect();
+}
+
+
+void SharedMemoryControllerClient::Impl::disconnect()
+{
+    if(header){
+        header->isClientAttached.store(0);
+        header->isClientDetached.store(1);
+        channel.commandRing().wakeUpAll();
+        channel.close();
+        header = nullptr;
+    }
+}
+
+
+bool SharedMemoryControllerClient::isConnected() const
+{
+    return impl->header != nullptr;
+}
+
+
+void SharedMemoryControllerClient::setSpinCount(int n)
+{
+    impl->spinCount = n;
+}
+
+
+int SharedMemoryControllerClient::spinCount() const
+{
+    return impl->spinCount;
+}
+
+
+bool SharedMemoryControllerClient::isLockstepMode() const
+{
+    return impl->header->isLockstepMode;
+}
+
+
+double SharedMemoryControllerClient::timeStep() const
+{
+    return impl->header->timeStep;
+}
+
+
+int SharedMemoryControllerClient::numJoints() const
+{
+    return impl->channel.numJoints();
+}
+
+
+const char* SharedMemoryControllerClient::jointName(int index) const
+{
+    return impl->channel.jointInfo(index).name;
+}
+
+
+int SharedMemoryControllerClient::jointActuationMode(int index) const
+{
+    return impl->channel.jointInfo(index).actuationMode;
+}
+
+
+int SharedMemoryControllerClient::findJointIndex(const std::string& name) const
+{
+    for(int i=0; i < impl->channel.numJoints(); ++i){
+        if(name == impl->channel.jointInfo(i).name){
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+int SharedMemoryControllerClient::numDevices() const
+{
+    return impl->channel.numDevices();
+}
+
+
+const char* SharedMemoryControllerClient::deviceName(int index) const
+{
+    return impl->channel.deviceInfo(index).name;
+}
+
+
+const char* SharedMemoryControllerClient::deviceTypeName(int index) const
+{
+    return impl->channel.deviceInfo(index).typeName;
+}
+
+
+int SharedMemoryControllerClient::deviceStateSize(int index) const
+{
+    return impl->channel.deviceInfo(index).stateSize;
+}
+
+
+int SharedMemoryControllerClient::findDeviceIndex(const std::string& name) const
+{
+    for(int i=0; i < impl->channel.numDevices(); ++i){
+        if(name == impl->channel.deviceInfo(i).name){
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+bool SharedMemoryControllerClient::waitForState(double timeout)
+{
+    return impl->waitForState(timeout);
+}
+
+
+bool SharedMemoryControllerClient::Impl::waitForState(double timeout)
+{
+    if(!header){
+        errorMessage = "The client is not connected.";
+        return false;
+    }
+    auto& ring = channel.stateRing();
+    if(!ring.waitForFrame(timeout, spinCount, &header->isServerClosed)){
+        if(header->isServerClosed.load()){
+            errorMessage = "The simulation has been stopped.";
+        } else {
+            errorMessage = "Timeout in waiting for the state.";
+        }
+        return false;
+    }
+
+    // Skip the states that have not been read in time in the asynchronous mode
+    while(ring.numFrames() > 1){
+        ring.pop();
+    }
+    memcpy(stateBuf.data(), ring.frameToRead(), stateBuf.size());
+    ring.pop();
+
+    auto frameHeader = reinterpret_cast<const SharedMemoryControllerFrameHeader*>(stateBuf.data());
+    lastFrameIndex = frameHeader->frameIndex;
+
+    if(!hasState){
+        // The device states to output are initialized with the current states
+        int n = channel.numDeviceStateElements();
+        if(n > 0){
+            memcpy(commandArray(channel.commandDeviceOffset()),
+                   stateArray(channel.stateDeviceOffset()), sizeof(double) * n);
+        }
+        hasState = true;
+    }
+
+    return true;
+}
+
+
+int64_t SharedMemoryControllerClient::frameIndex() const
+{
+    return impl->lastFrameIndex;
+}
+
+
+double SharedMemoryControllerClient::time() const
+{
+    return reinterpret_cast<const SharedMemoryControllerFrameHeader*>(impl->stateBuf.data())->time;
+}
+
+
+const double* SharedMemoryControllerClient::q() const
+{
+    return impl->stateArray(impl->channel.stateQOffset());
+}
+
+
+const double* SharedMemoryControllerClient::dq() const
+{
+    return impl->stateArray(impl->channel.stateDqOffset());
+}
+
+
+const double* SharedMemoryControllerClient::u() const
+{
+    return impl->stateArray(impl->channel.stateUOffset());
+}
+
+
+const double* SharedMemoryControllerClient::deviceState(int index) const
+{
+    return impl->stateArray(impl->channel.stateDeviceOffset()) + impl->channel.deviceInfo(index).stateOffset;
+}
+
+
+double* SharedMemoryControllerClient::command()
+{
+    return impl->commandArray(impl->channel.commandOffset());
+}
+
+
+double* SharedMemoryControllerClient::deviceStateToOutput(int index)
+{
+    auto flags = reinterpret_cast<uint8_t*>(impl->commandBuf.data() + impl->channel.commandDeviceFlagOffset());
+    flags[index] = 1;
+    return impl->commandArray(impl->channel.commandDeviceOffset()) + impl->channel.deviceInfo(index).stateOffset;
+}
+
+
+bool SharedMemoryControllerClient::sendCommand(double timeout)
+{
+    return impl->sendCommand(timeout);
+}
+
+
+bool SharedMemoryControllerClient::Impl::sendCommand(double timeout)
+{
+    if(!header){
+        errorMessage = "The client is not connected.";
+        return false;
+    }
+    auto& ring = channel.commandRing();
+    if(!ring.waitForSpace(timeout, spinCount, &header->isServerClosed)){
+        if(header->isServerClosed.load()){
+            errorMessage = "The simulation has been stopped.";
+        } else {
+            errorMessage = "Timeout in waiting for the command ring to have space.";
+        }
+        return false;
+    }
+
+    auto frameHeader = reinterpret_cast<SharedMemoryControllerFrameHeader*>(commandBuf.data());
+    frameHeader->frameIndex = lastFrameIndex;
+    frameHeader->time = reinterpret_cast<const SharedMemoryControllerFrameHeader*>(stateBuf.data())->time;
+    memcpy(ring.frameToWrite(), commandBuf.data(), commandBuf.size());
+    ring.push();
+
+    // The device flags are cleared so that only the devices updated for the next command are output
+    int numDevices = channel.numDevices();
+    if(numDevices > 0){
+        memset(commandBuf.data() + channel.commandDeviceFlagOffset(), 0, numDevices);
+    }
+
+    return true;
+}
+
+
+const std::string& SharedMemoryControllerClient::errorMessage() const
+{
+    return impl->errorMessage;
+}
@@ -0,0 +1,113 @@
+#ifndef CNOID_SHARED_MEMORY_CONTROLLER_SHARED_MEMORY_CONTROLLER_CLIENT_H
+#define CNOID_SHARED_MEMORY_CONTROLLER_SHARED_MEMORY_CONTROLLER_CLIENT_H
+
+#include <string>
+#include <cstdint>
+#include "exportdecl.h"
+
+namespace cnoid {
+
+/**
+   This class is used in an external controller process to communicate with
+   SharedMemoryControllerItem in Choreonoid. The class only depends on the standard
+   library and the POSIX API, and the controller process does not have to link any
+   other Choreonoid library.
+
+   A typical control loop is as follows:
+
+   SharedMemoryControllerClient client;
+   client.connect("cnoid-SR1");
+   while(client.waitForState()){
+       const double* q = client.q();
+       double* u = client.command();
+       for(int i=0; i < client.numJoints(); ++i){
+           u[i] = ...;
+       }
+       client.sendCommand();
+   }
+
+   In the lockstep mode, the simulation waits for the command computed from each state,
+   so the results do not depend on the timing of the controller process. In the other
+   mode, the simulation uses the latest command received before each step and the client
+   skips the states which have not been read in time.
+*/
+class CNOID_EXPORT SharedMemoryControllerClient
+{
+public:
+    SharedMemoryControllerClient();
+    SharedMemoryControllerClient(const SharedMemoryControllerClient&) = delete;
+    ~SharedMemoryControllerClient();
+
+    /**
+       Connects to the shared memory segment created by the controller item.
+       The function waits for the segment to be created until the timeout.
+       \param timeout Negative value means no time limit.
+    */
+    bool connect(const std::string& name, double timeout = 10.0);
+    void disconnect();
+    bool isConnected() const;
+
+    //! The number of the busy-wait iterations before sleeping in the waiting functions
+    void setSpinCount(int n);
+    int spinCount() const;
+
+    bool isLockstepMode() const;
+    double timeStep() const;
+
+    int numJoints() const;
+    const char* jointName(int index) const;
+    //! The logical sum of the Link::StateFlag bits, which specifies the meaning of the joint command
+    int jointActuationMode(int index) const;
+    //! \return -1 if the joint is not found
+    int findJointIndex(const std::string& name) const;
+
+    int numDevices() const;
+    const char* deviceName(int index) const;
+    const char* deviceTypeName(int index) const;
+    //! The number of the elements given by Device::stateSize()
+    int deviceStateSize(int index) const;
+    //! \return -1 if the device is not found
+    int findDeviceIndex(const std::string& name) const;
+
+    /**
+       Waits for the next state frame and copies it to the state buffer of this object.
+       \param timeout Negative value means no time limit.
+       \return false when timed out or the simulation is stopped.
+    */
+    bool waitForState(double timeout = -1.0);
+
+    int64_t frameIndex() const;
+    double time() const;
+    const double* q() const;
+    const double* dq() const;
+    const double* u() const;
+    //! The state elements written by Device::writeState()
+    const double* deviceState(int index) const;
+
+    //! The command buffer of the joints
+    double* command();
+
+    /**
+       The state buffer of a device to output. The state written in the buffer is read by
+       Device::readState() in the simulation when the command is sent.
+       The buffer is initialized with the current state of the device.
+    */
+    double* deviceStateToOutput(int index);
+
+    /**
+       Sends the command for the state received last.
+       \param timeout The time to wait for the ring to have space. Negative value means no time limit.
+    */
+    bool sendCommand(double timeout = -1.0);
+
+    const std::string& errorMessage() const;
+
+    class Impl;
+
+private:
+    Impl* impl;
+};
+
+}
+
+#endif
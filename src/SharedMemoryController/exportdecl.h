@@ -0,0 +1,37 @@
+#ifndef CNOID_SHARED_MEMORY_CONTROLLER_EXPORTDECL_H_INCLUDED
+# define CNOID_SHARED_MEMORY_CONTROLLER_EXPORTDECL_H_INCLUDED
+
+# if defined _WIN32 || defined __CYGWIN__
+#  define CNOID_SHARED_MEMORY_CONTROLLER_DLLIMPORT __declspec(dllimport)
+#  define CNOID_SHARED_MEMORY_CONTROLLER_DLLEXPORT __declspec(dllexport)
+#  define CNOID_SHARED_MEMORY_CONTROLLER_DLLLOCAL
+# else
+#  if __GNUC__ >= 4
+#   define CNOID_SHARED_MEMORY_CONTROLLER_DLLIMPORT __attribute__ ((visibility("default")))
+#   define CNOID_SHARED_MEMORY_CONTROLLER_DLLEXPORT __attribute__ ((visibility("default")))
+#   define CNOID_SHARED_MEMORY_CONTROLLER_DLLLOCAL  __attribute__ ((visibility("hidden")))
+#  else
+#   define CNOID_SHARED_MEMORY_CONTROLLER_DLLIMPORT
+#   define CNOID_SHARED_MEMORY_CONTROLLER_DLLEXPORT
+#   define CNOID_SHARED_MEMORY_CONTROLLER_DLLLOCAL
+#  endif
+# endif
+
+# ifdef CNOID_SHARED_MEMORY_CONTROLLER_STATIC
+#  define CNOID_SHARED_MEMORY_CONTROLLER_DLLAPI
+#  define CNOID_SHARED_MEMORY_CONTROLLER_LOCAL
+# else
+#  ifdef CnoidSharedMemoryController_EXPORTS
+#   define CNOID_SHARED_MEMORY_CONTROLLER_DLLAPI CNOID_SHARED_MEMORY_CONTROLLER_DLLEXPORT
+#  else
+#   define CNOID_SHARED_MEMORY_CONTROLLER_DLLAPI CNOID_SHARED_MEMORY_CONTROLLER_DLLIMPORT
+#  endif
+#  define CNOID_SHARED_MEMORY_CONTROLLER_LOCAL CNOID_SHARED_MEMORY_CONTROLLER_DLLLOCAL
+# endif
+
+#endif
+
+#ifdef CNOID_EXPORT
+# undef CNOID_EXPORT
+#endif
+#define CNOID_EXPORT CNOID_SHARED_MEMORY_CONTROLLER_DLLAPI
@@ -0,0 +1,503 @@
+#include "SharedMemoryControllerItem.h"
+#include <cnoid/SharedMemoryControllerChannel>
+#include <cnoid/ItemManager>
+#include <cnoid/PutPropertyFunction>
+#include <cnoid/Archive>
+#include <cnoid/ControllerIO>
+#include <cnoid/Body>
+#include <cnoid/Device>
+#include <cnoid/Selection>
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstring>
+#include "gettext.h"
+
+using namespace std;
+using namespace cnoid;
+using fmt::format;
+
+namespace {
+
+enum CommandType { EffortCommand, DisplacementCommand, VelocityCommand, NumCommandTypes };
+
+void copyName(char* dest, size_t size, const std::string& src)
+{
+    size_t n = std::min(size - 1, src.size());
+    memcpy(dest, src.data(), n);
+    dest[n] = '\0';
+}
+
+}
+
+namespace cnoid {
+
+class SharedMemoryControllerItem::Impl
+{
+public:
+    SharedMemoryControllerItem* self;
+    ControllerIO* io;
+    BodyPtr body;
+    vector<Link*> joints;
+    vector<char> jointCommandTypes;
+    DeviceList<> devices;
+    SharedMemoryControllerChannel channel;
+    SharedMemoryControllerHeader* header;
+    vector<char> commandBuf;
+    uint64_t currentFrameIndex;
+    uint64_t nextFrameIndex;
+    bool hasCommand;
+    int numSkippedStates;
+
+    string sharedMemoryName;
+    bool isLockstepMode;
+    double timeout;
+    int spinCount;
+    Selection defaultCommandType;
+
+    Impl(SharedMemoryControllerItem* self);
+    Impl(SharedMemoryControllerItem* self, const Impl& org);
+    bool initialize(ControllerIO* io);
+    void input();
+    bool control();
+    bool receiveCommandInLockstepMode();
+    void receiveLatestCommand();
+    void output();
+    void stop();
+    void doPutProperties(PutPropertyFunction& putProperty);
+    bool store(Archive& archive);
+    bool restore(const Archive& archive);
+};
+
+}
+
+
+void SharedMemoryControllerItem::initializeClass(ExtensionManager* ext)
+{
+    auto& itemManager = ext->itemManager();
+    itemManager.registerClass<SharedMemoryControllerItem, ControllerItem>(N_("SharedMemoryControllerItem"));
+    itemManager.addCreationPanel<SharedMemoryControllerItem>();
+}
+
+
+SharedMemoryControllerItem::SharedMemoryControllerItem()
+{
+    impl = new Impl(this);
+    setNoDelayMode(true);
+}
+
+
+SharedMemoryControllerItem::Impl::Impl(SharedMemoryControllerItem* self)
+    : self(self),
+      defaultCommandType(NumCommandTypes, CNOID_GETTEXT_DOMAIN_NAME)
+{
+    io = nullptr;
+    header = nullptr;
+    currentFrameIndex = 0;
+    nextFrameIndex = 0;
+    hasCommand = false;
+    numSkippedStates = 0;
+    isLockstepMode = true;
+    timeout = 10.0;
+    spinCount = SharedMemoryRing::defaultSpinCount();
+
+    defaultCommandType.setSymbol(EffortCommand, N_("Effort"));
+    defaultCommandType.setSymbol(DisplacementCommand, N_("Displacement"));
+    defaultCommandType.setSymbol(VelocityCommand, N_("Velocity"));
+    defaultCommandType.select(EffortCommand);
+}
+
+
+SharedMemoryControllerItem::SharedMemoryControllerItem(const SharedMemoryControllerItem& org)
+    : ControllerItem(org)
+{
+    impl = new Impl(this, *org.impl);
+}
+
+
+SharedMemoryControllerItem::Impl::Impl(SharedMemoryControllerItem* self, const Impl& org)
+    : Impl(self)
+{
+    sharedMemoryName = org.sharedMemoryName;
+    isLockstepMode = org.isLockstepMode;
+    timeout = org.timeout;
+    spinCount = org.spinCount;
+    defaultCommandType = org.defaultCommandType;
+}
+
+
+SharedMemoryControllerItem::~SharedMemoryControllerItem()
+{
+    delete impl;
+}
+
+
+Item* SharedMemoryControllerItem::doCloneItem(CloneMap* /* cloneMap */) const
+{
+    return new SharedMemoryControllerItem(*this);
+}
+
+
+void SharedMemoryControllerItem::setSharedMemoryName(const std::string& name)
+{
+    impl->sharedMemoryName = name;
+}
+
+
+const std::string& SharedMemoryControllerItem::sharedMemoryName() const
+{
+    return impl->sharedMemoryName;
+}
+
+
+void SharedMemoryControllerItem::setLockstepMode(bool on)
+{
+    impl->isLockstepMode = on;
+}
+
+
+bool SharedMemoryControllerItem::isLockstepMode() const
+{
+    return impl->isLockstepMode;
+}
+
+
+void SharedMemoryControllerItem::setTimeout(double timeout)
+{
+    impl->timeout = timeout;
+}
+
+
+double SharedMemoryControllerItem::timeout() const
+{
+    return impl->timeout;
+}
+
+
+bool SharedMemoryControllerItem::initialize(ControllerIO* io)
+{
+    return impl->initialize(io);
+}
+
+
+bool SharedMemoryControllerItem::Impl::initialize(ControllerIO* io)
+{
+    this->io = io;
+    body = io->body();
+    if(!body){
+        io->os() << format(_("{0} does not have the target body."), self->displayName()) << endl;
+        return false;
+    }
+
+    string name = sharedMemoryName;
+    if(name.empty()){
+        name = string("cnoid-") + body->name();
+        std::replace(name.begin(), name.end(), '/', '-');
+    }
+
+    short defaultActuationMode;
+    switch(defaultCommandType.which()){
+    case DisplacementCommand:
+        defaultActuationMode = Link::JointDisplacement;
+        break;
+    case VelocityCommand:
+        defaultActuationMode = Link::JointVelocity;
+        break;
+    default:
+        defaultActuationMode = Link::JointEffort;
+        break;
+    }
+
+    const int numJoints = body->numJoints();
+    joints.resize(numJoints);
+    jointCommandTypes.resize(numJoints);
+    vector<SharedMemoryControllerJointInfo> jointInfos(numJoints);
+    for(int i=0; i < numJoints; ++i){
+        auto joint = body->joint(i);
+        if(joint->actuationMode() == Link::StateNone){
+            joint->setActuationMode(defaultActuationMode);
+        }
+        int mode = joint->actuationMode();
+        if(mode & Link::JointDisplacement){
+            jointCommandTypes[i] = DisplacementCommand;
+        } else if(mode & (Link::JointVelocity | Link::DeprecatedJointSurfaceVelocity)){
+            jointCommandTypes[i] = VelocityCommand;
+        } else {
+            jointCommandTypes[i] = EffortCommand;
+        }
+        joints[i] = joint;
+        auto& info = jointInfos[i];
+        memset(&info, 0, sizeof(info));
+        copyName(info.name, sizeof(info.name), joint->jointName());
+        info.actuationMode = mode;
+    }
+
+    devices = body->devices();
+    vector<SharedMemoryControllerDeviceInfo> deviceInfos(devices.size());
+    int stateOffset = 0;
+    for(size_t i=0; i < devices.size(); ++i){
+        auto device = devices[i];
+        auto& info = deviceInfos[i];
+        memset(&info, 0, sizeof(info));
+        copyName(info.name, sizeof(info.name), device->name());
+        copyName(info.typeName, sizeof(info.typeName), device->typeName());
+        info.stateOffset = stateOffset;
+        info.stateSize = device->stateSize();
+        stateOffset += info.stateSize;
+    }
+
+    if(!channel.create(name, jointInfos, deviceInfos, io->timeStep(), isLockstepMode)){
+        io->os() << format(_("Shared memory \"{0}\" for {1} cannot be created: {2}"),
+                           name, self->displayName(), channel.errorMessage()) << endl;
+        return false;
+    }
+    header = channel.header();
+    commandBuf.resize(header->commandFrameSize);
+
+    io->os() << format(_("{0} is waiting for the controller process on shared memory \"{1}\"."),
+                       self->displayName(), name) << endl;
+
+    return true;
+}
+
+
+bool SharedMemoryControllerItem::start()
+{
+    impl->currentFrameIndex = 0;
+    impl->nextFrameIndex = 0;
+    impl->hasCommand = false;
+    impl->numSkippedStates = 0;
+    return true;
+}
+
+
+void SharedMemoryControllerItem::input()
+{
+    impl->input();
+}
+
+
+void SharedMemoryControllerItem::Impl::input()
+{
+    currentFrameIndex = nextFrameIndex++;
+
+    auto& ring = channel.stateRing();
+    if(ring.full()){
+        // The controller process is not reading the states
+        ++numSkippedStates;
+        return;
+    }
+
+    char* frame = static_cast<char*>(ring.frameToWrite());
+    auto frameHeader = reinterpret_cast<SharedMemoryControllerFrameHeader*>(frame);
+    frameHeader->frameIndex = currentFrameIndex;
+    frameHeader->time = io->currentTime();
+
+    const int numJoints = joints.size();
+    auto q = reinterpret_cast<double*>(frame + channel.stateQOffset());
+    auto dq = reinterpret_cast<double*>(frame + channel.stateDqOffset());
+    auto u = reinterpret_cast<double*>(frame + channel.stateUOffset());
+    for(int i=0; i < numJoints; ++i){
+        auto joint = joints[i];
+        q[i] = joint->q();
+        dq[i] = joint->dq();
+        u[i] = joint->u();
+    }
+
+    if(!devices.empty()){
+        auto deviceStates = reinterpret_cast<double*>(frame + channel.stateDeviceOffset());
+        for(size_t i=0; i < devices.size(); ++i){
+            devices[i]->writeState(deviceStates + channel.deviceInfo(i).stateOffset);
+        }
+    }
+
+    ring.push();
+}
+
+
+bool SharedMemoryControllerItem::control()
+{
+    return impl->control();
+}
+
+
+bool SharedMemoryControllerItem::Impl::control()
+{
+    if(isLockstepMode){
+        return receiveCommandInLockstepMode();
+    }
+    receiveLatestCommand();
+    return true;
+}
+
+
+bool SharedMemoryControllerItem::Impl::receiveCommandInLockstepMode()
+{
+    auto& ring = channel.commandRing();
+
+    while(ring.waitForFrame(timeout, spinCount, &header->isClientDetached)){
+        auto frame = static_cast<const char*>(ring.frameToRead());
+        auto frameIndex = reinterpret_cast<const SharedMemoryControllerFrameHeader*>(frame)->frameIndex;
+        bool isCurrent = (frameIndex == currentFrameIndex);
+        if(isCurrent){
+            memcpy(commandBuf.data(), frame, commandBuf.size());
+        }
+        ring.pop();
+        if(isCurrent){
+            hasCommand = true;
+            return true;
+        }
+        // The command for an older state which was sent before the controller was reconnected is discarded
+    }
+
+    if(header->isClientDetached.load()){
+        io->os() << format(_("The controller process of {0} has been disconnected."),
+                           self->displayName()) << endl;
+    } else {
+        io->os() << format(_("The command of {0} for time {1:.3f} was not received within {2} seconds."),
+                           self->displayName(), io->currentTime(), timeout) << endl;
+    }
+    return false;
+}
+
+
+void SharedMemoryControllerItem::Impl::receiveLatestCommand()
+{
+    auto& ring = channel.commandRing();
+    while(!ring.empty()){
+        memcpy(commandBuf.data(), ring.frameToRead(), commandBuf.size());
+        ring.pop();
+        hasCommand = true;
+    }
+}
+
+
+void SharedMemoryControllerItem::output()
+{
+    impl->output();
+}
+
+
+void SharedMemoryControllerItem::Impl::output()
+{
+    if(!hasCommand){
+        return;
+    }
+
+    const int numJoints = joints.size();
+    auto command = reinterpret_cast<const double*>(commandBuf.data() + channel.commandOffset());
+    for(int i=0; i < numJoints; ++i){
+        auto joint = joints[i];
+        switch(jointCommandTypes[i]){
+        case DisplacementCommand:
+            joint->q_target() = command[i];
+            break;
+        case VelocityCommand:
+            joint->dq_target() = command[i];
+            break;
+        default:
+            joint->u() = command[i];
+            break;
+        }
+    }
+
+    if(!devices.empty()){
+        auto deviceStates = reinterpret_cast<const double*>(commandBuf.data() + channel.commandDeviceOffset());
+        auto flags = reinterpret_cast<uint8_t*>(commandBuf.data() + channel.commandDeviceFlagOffset());
+        for(size_t i=0; i < devices.size(); ++i){
+            if(flags[i]){
+                auto device = devices[i];
+                device->readState(deviceStates + channel.deviceInfo(i).stateOffset);
+                device->notifyStateChange();
+                // The device state is only output once for a command received in the asynchronous mode
+                flags[i] = 0;
+            }
+        }
+    }
+}
+
+
+void SharedMemoryControllerItem::stop()
+{
+    impl->stop();
+}
+
+
+void SharedMemoryControllerItem::Impl::stop()
+{
+    if(io && numSkippedStates > 0){
+        io->os() << format(_("{0} states of {1} were not sent because the controller process did not read them in time."),
+                           numSkippedStates, self->displayName()) << endl;
+    }
+    channel.close();
+    header = nullptr;
+    joints.clear();
+    devices.clear();
+    body.reset();
+    io = nullptr;
+}
+
+
+void SharedMemoryControllerItem::onDisconnectedFromRoot()
+{
+    impl->stop();
+}
+
+
+void SharedMemoryControllerItem::doPutProperties(PutPropertyFunction& putProperty)
+{
+    ControllerItem::doPutProperties(putProperty);
+    impl->doPutProperties(putProperty);
+}
+
+
+void SharedMemoryControllerItem::Impl::doPutProperties(PutPropertyFunction& putProperty)
+{
+    putProperty(_("Shared memory name"), sharedMemoryName, changeProperty(sharedMemoryName));
+    putProperty(_("Lockstep mode"), isLockstepMode, changeProperty(isLockstepMode));
+    putProperty.min(0.0)(_("Timeout"), timeout, changeProperty(timeout));
+    putProperty.min(0)(_("Spin count"), spinCount, changeProperty(spinCount));
+    putProperty(_("Default command type"), defaultCommandType, changeProperty(defaultCommandType));
+}
+
+
+bool SharedMemoryControllerItem::store(Archive& archive)
+{
+    if(!ControllerItem::store(archive)){
+        return false;
+    }
+    return impl->store(archive);
+}
+
+
+bool SharedMemoryControllerItem::Impl::store(Archive& archive)
+{
+    archive.write("shared_memory_name", sharedMemoryName, DOUBLE_QUOTED);
+    archive.write("lockstep_mode", isLockstepMode);
+    archive.write("timeout", timeout);
+    archive.write("spin_count", spinCount);
+    archive.write("default_command_type", defaultCommandType.selectedSymbol());
+    return true;
+}
+
+
+bool SharedMemoryControllerItem::restore(const Archive& archive)
+{
+    if(!ControllerItem::restore(archive)){
+        return false;
+    }
+    return impl->restore(archive);
+}
+
+
+bool SharedMemoryControllerItem::Impl::restore(const Archive& archive)
+{
+    archive.read("shared_memory_name", sharedMemoryName);
+    archive.read("lockstep_mode", isLockstepMode);
+    archive.read("timeout", timeout);
+    archive.read("spin_count", spinCount);
+    string symbol;
+    if(archive.read("default_command_type", symbol)){
+        defaultCommandType.select(symbol);
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+#ifndef CNOID_SHARED_MEMORY_CONTROLLER_PLUGIN_SHARED_MEMORY_CONTROLLER_ITEM_H
+#define CNOID_SHARED_MEMORY_CONTROLLER_PLUGIN_SHARED_MEMORY_CONTROLLER_ITEM_H
+
+#include <cnoid/ControllerItem>
+#include "exportdecl.h"
+
+namespace cnoid {
+
+/**
+   This item exchanges the joint states, the joint commands and the device states with an
+   external controller process through a POSIX shared memory segment. The controller process
+   uses SharedMemoryControllerClient to access the segment.
+
+   The states of all the joints and devices of the target body are sent to the controller
+   at each control step, and the joint commands are applied according to the actuation modes
+   of the joints. The joints whose actuation modes are not specified are driven with the
+   default command type of the item.
+*/
+class CNOID_EXPORT SharedMemoryControllerItem : public ControllerItem
+{
+public:
+    static void initializeClass(ExtensionManager* ext);
+
+    SharedMemoryControllerItem();
+    virtual ~SharedMemoryControllerItem();
+
+    //! The default name is "cnoid-" followed by the name of the target body.
+    void setSharedMemoryName(const std::string& name);
+    const std::string& sharedMemoryName() const;
+
+    /**
+       In the lockstep mode, each control step waits for the command computed from the state
+       of the step, which makes the simulation deterministic. Otherwise the latest command
+       received from the controller is used. The lockstep mode is enabled by default.
+    */
+    void setLockstepMode(bool on);
+    bool isLockstepMode() const;
+
+    //! The time to wait for the command in the lockstep mode
+    void setTimeout(double timeout);
+    double timeout() const;
+
+    virtual bool initialize(ControllerIO* io) override;
+    virtual bool start() override;
+    virtual void input() override;
+    virtual bool control() override;
+    virtual void output() override;
+    virtual void stop() override;
+
+    class Impl;
+
+protected:
+    SharedMemoryControllerItem(const SharedMemoryControllerItem& org);
+    virtual Item* doCloneItem(CloneMap* cloneMap) const override;
+    virtual void onDisconnectedFromRoot() override;
+    virtual void doPutProperties(PutPropertyFunction& putProperty) override;
+    virtual bool store(Archive& archive) override;
+    virtual bool restore(const Archive& archive) override;
+
+private:
+    Impl* impl;
+};
+
+typedef ref_ptr<SharedMemoryControllerItem> SharedMemoryControllerItemPtr;
+
+}
+
+#endif
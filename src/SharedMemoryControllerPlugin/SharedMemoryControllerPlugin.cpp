@@ -0,0 +1,25 @@
+#include "SharedMemoryControllerItem.h"
+#include <cnoid/Plugin>
+
+using namespace cnoid;
+
+namespace {
+
+class SharedMemoryControllerPlugin : public Plugin
+{
+public:
+    SharedMemoryControllerPlugin() : Plugin("SharedMemoryController")
+    {
+        require("Body");
+    }
+
+    virtual bool initialize() override
+    {
+        SharedMemoryControllerItem::initializeClass(this);
+        return true;
+    }
+};
+
+}
+
+CNOID_IMPLEMENT_PLUGIN_ENTRY(SharedMemoryControllerPlugin);
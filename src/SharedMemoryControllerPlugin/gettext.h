@@ -0,0 +1,3 @@
+#include <cnoid/Config>
+#define CNOID_GETTEXT_DOMAIN_NAME "CnoidSharedMemoryControllerPlugin-" CNOID_VERSION_STRING
+#include <cnoid/GettextUtil>
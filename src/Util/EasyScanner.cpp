@@ -6,6 +6,7 @@
 #include "EasyScanner.h"
 #include "UTF8.h"
 #include "strtofloat.h"
+#include <fast_float/fast_float.h>
 #include <cstdio>
 #include <cctype>
 #include <cstdlib>
@@ -14,12 +15,95 @@
 #include <iostream>
 #include <fmt/format.h>
 #include <errno.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #include "gettext.h"
 
 using namespace std;
 using namespace cnoid;
 using fmt::format;
 
+namespace {
+
+// Files smaller than this size are read into a heap buffer even in the memory mapped input mode
+constexpr size_t MinMemoryMappedFileSize = 64 * 1024;
+
+/**
+   The decimal integers are parsed directly. The other forms that are accepted by strtol
+   with base 0, such as the hexadecimal and octal ones, are parsed by strtol.
+*/
+inline bool parseInt(char*& text, int& out_value)
+{
+    const char* p = text;
+    bool isNegative = false;
+    if(*p == '-'){
+        isNegative = true;
+        ++p;
+    } else if(*p == '+'){
+        ++p;
+    }
+    if(*p >= '1' && *p <= '9'){
+        int value = 0;
+        int numDigits = 0;
+        do {
+            value = value * 10 + (*p++ - '0');
+            ++numDigits;
+        } while(*p >= '0' && *p <= '9' && numDigits < 9);
+
+        if(!(*p >= '0' && *p <= '9')){
+            out_value = isNegative ? -value : value;
+            text = const_cast<char*>(p);
+            return true;
+        }
+    } else if(*p == '0' && !(p[1] >= '0' && p[1] <= '9') && p[1] != 'x' && p[1] != 'X'){
+        out_value = 0;
+        text = const_cast<char*>(p + 1);
+        return true;
+    }
+    
+    char* tail;
+    out_value = strtol(text, &tail, 0);
+    if(tail != text){
+        text = tail;
+        return true;
+    }
+    return false;
+}
+
+/**
+   fast_float does not depend on the locale and it is much faster than strtod.
+   The forms that are not accepted by fast_float, such as the hexadecimal floats,
+   are parsed by strtod.
+*/
+template<typename T, typename StrToFloatFunc>
+inline bool parseFloat(char*& text, const char* end, T& out_value, StrToFloatFunc strtofloat)
+{
+    const char* p = text;
+    if(*p == '+' && p[1] != '-' && p[1] != '+'){
+        ++p;
+    }
+    if(!(p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))){
+        auto result = fast_float::from_chars(p, end, out_value);
+        if(result.ec == std::errc()){
+            text = const_cast<char*>(result.ptr);
+            return true;
+        }
+    }
+    char* tail;
+    out_value = strtofloat(text, &tail);
+    if(tail != text){
+        text = tail;
+        return true;
+    }
+    return false;
+}
+
+}
+
 
 std::string EasyScanner::Exception::getFullMessage() const
 {
@@ -58,6 +142,12 @@ void EasyScanner::init()
     textBuf = 0;
     size = 0;
     textBufEnd = 0;
+    mappedSize = 0;
+#ifndef _WIN32
+    isMemoryMappedInputEnabled_ = true;
+#else
+    isMemoryMappedInputEnabled_ = false;
+#endif
     lineNumber = 0;
     lineNumberOffset = 1;
     
@@ -81,6 +171,8 @@ void EasyScanner::init()
 EasyScanner::EasyScanner(const EasyScanner& org, bool copyText) :
     whiteSpaceChars(org.whiteSpaceChars)
 {
+    mappedSize = 0;
+    isMemoryMappedInputEnabled_ = org.isMemoryMappedInputEnabled_;
     commentChar = org.commentChar;
     quoteChar = org.quoteChar;
     isLineOriented = org.isLineOriented;
@@ -108,7 +200,7 @@ EasyScanner::EasyScanner(const EasyScanner& org, bool copyText) :
 /*! This function directly sets a text in the main memory */
 void EasyScanner::setText(const char* text, size_t len)
 {
-    if(textBuf) delete[] textBuf;
+    releaseTextBuf();
 
     size = len;
     textBuf = new char[size + 1];
@@ -123,7 +215,33 @@ void EasyScanner::setText(const char* text, size_t len)
 
 EasyScanner::~EasyScanner()
 {
-    if(textBuf) delete[] textBuf;
+    releaseTextBuf();
+}
+
+
+void EasyScanner::releaseTextBuf()
+{
+    if(textBuf){
+#ifndef _WIN32
+        if(mappedSize > 0){
+            munmap(textBuf, mappedSize);
+            mappedSize = 0;
+        } else {
+            delete[] textBuf;
+        }
+#else
+        delete[] textBuf;
+#endif
+        textBuf = 0;
+    }
+}
+
+
+void EasyScanner::setMemoryMappedInputEnabled(bool on)
+{
+#ifndef _WIN32
+    isMemoryMappedInputEnabled_ = on;
+#endif
 }
 
 
@@ -228,10 +346,13 @@ void EasyScanner::loadFile(const string& filename)
     fseek(file, 0, SEEK_END);
     size = ftell(file);
     rewind(file);
-    if(textBuf) delete[] textBuf;
-    textBuf = new char[size + 1];
-    size = fread(textBuf, sizeof(char), size, file);
-    textBuf[size] = 0;
+    releaseTextBuf();
+
+    if(!(isMemoryMappedInputEnabled_ && size >= MinMemoryMappedFileSize && mapFile(fileno(file), size))){
+        textBuf = new char[size + 1];
+        size = fread(textBuf, sizeof(char), size, file);
+        textBuf[size] = 0;
+    }
     fclose(file);
     text = textBuf;
     textBufEnd = textBuf + size;
@@ -239,6 +360,36 @@ void EasyScanner::loadFile(const string& filename)
 }
 
 
+/**
+   The file is mapped after an anonymous zero-filled region of one more byte than the file
+   is reserved so that the text is always terminated by the null character even if the
+   file size is a multiple of the page size.
+*/
+bool EasyScanner::mapFile(int fd, size_t fileSize)
+{
+#ifndef _WIN32
+    size_t regionSize = fileSize + 1;
+    void* region = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(region == MAP_FAILED){
+        return false;
+    }
+    void* mapped = mmap(region, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    if(mapped == MAP_FAILED){
+        munmap(region, regionSize);
+        return false;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(mapped, fileSize, MADV_SEQUENTIAL);
+#endif
+    textBuf = static_cast<char*>(mapped);
+    mappedSize = regionSize;
+    return true;
+#else
+    return false;
+#endif
+}
+
+
 /**
    move the current position to just before the end (LF or EOF) of a line
 */
@@ -321,15 +472,10 @@ int EasyScanner::readToken()
     skipSpace();
 
     if(isdigit((unsigned char)*text) || *text == '+' || *text == '-'){
-        char* tail;
-        intValue = strtol(text, &tail, 0);
-        if(tail != text){
-            text = tail;
+        if(parseInt(text, intValue)){
             return T_INTEGER;
         }
-        doubleValue = cnoid::strtod(text, &tail);
-        if(tail != text){
-            text = tail;
+        if(parseFloat(text, textEnd(), doubleValue, cnoid::strtod)){
             return T_DOUBLE;
         }
         charValue = *text;
@@ -413,53 +559,40 @@ bool EasyScanner::extractQuotedString()
 }
 
 
-bool EasyScanner::readFloat()
+/**
+   The end of the text is usually the end of the buffer, but the text pointer may be
+   moved to another null-terminated string by a user.
+*/
+const char* EasyScanner::textEnd() const
 {
-    char* tail;
-
-    if(checkLF()) return false;
+    if(text >= textBuf && text <= textBufEnd){
+        return textBufEnd;
+    }
+    return text + strlen(text);
+}
 
-    floatValue = cnoid::strtof(text, &tail);
 
-    if(tail != text){
-        text = tail;
-        return true;
-    }
+bool EasyScanner::readFloat()
+{
+    if(checkLF()) return false;
 
-    return false;
+    return parseFloat(text, textEnd(), floatValue, cnoid::strtof);
 }
 
 
 bool EasyScanner::readDouble()
 {
-    char* tail;
-
     if(checkLF()) return false;
 
-    doubleValue = cnoid::strtod(text, &tail);
-
-    if(tail != text){
-        text = tail;
-        return true;
-    }
-
-    return false;
+    return parseFloat(text, textEnd(), doubleValue, cnoid::strtod);
 }
 
 
 bool EasyScanner::readInt()
 {
-    char* tail;
-
     if(checkLF()) return false;
 
-    intValue = strtol(text, &tail, 0);
-    if(tail != text){
-        text = tail;
-        return true;
-    }
-
-    return false;
+    return parseInt(text, intValue);
 }
 
 
@@ -73,6 +73,14 @@ public:
 
     void loadFile(const std::string& filename);
 
+    /**
+       When this is enabled, a large file is mapped into memory in loadFile instead of
+       being read into a heap buffer. It is enabled by default on the platforms that
+       support the memory mapped file.
+    */
+    void setMemoryMappedInputEnabled(bool on);
+    bool isMemoryMappedInputEnabled() const { return isMemoryMappedInputEnabled_; }
+
     void setText(const char* text, size_t len);
 
     void setLineNumberOffset(int offset);
@@ -253,6 +261,9 @@ public:
 
 private:
     void init();
+    void releaseTextBuf();
+    const char* textEnd() const;
+    bool mapFile(int fd, size_t fileSize);
     bool extractQuotedString();
 
     bool readLF0();
@@ -262,6 +273,8 @@ private:
     char* textBuf;
     size_t size;
     char* textBufEnd;
+    size_t mappedSize;
+    bool isMemoryMappedInputEnabled_;
     int lineNumberOffset;
     int commentChar;
     int quoteChar;
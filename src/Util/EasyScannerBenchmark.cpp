@@ -0,0 +1,171 @@
+/**
+   This program measures the time to load and parse large text files with EasyScanner.
+   A VRML-style coordinate list and an OBJ-style mesh are generated in the temporary
+   directory and scanned with and without the memory mapped input, and the loading time
+   and the parsing time are reported separately.
+*/
+
+#include "EasyScanner.h"
+#include <cnoid/stdx/filesystem>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+using namespace cnoid;
+namespace filesystem = cnoid::stdx::filesystem;
+
+namespace {
+
+typedef chrono::steady_clock Clock;
+
+double milliseconds(Clock::duration d)
+{
+    return chrono::duration<double, std::milli>(d).count();
+}
+
+
+void writeCoordinateFile(const string& filename, int numPoints)
+{
+    ofstream out(filename);
+    out << "point [\n";
+    for(int i=0; i < numPoints; ++i){
+        out << (i * 0.001) << " " << (-i * 0.0025) << " " << (1.0 / (i + 1)) << ",\n";
+    }
+    out << "]\n";
+}
+
+
+void writeObjFile(const string& filename, int numVertices)
+{
+    ofstream out(filename);
+    for(int i=0; i < numVertices; ++i){
+        out << "v " << (i * 0.001) << " " << (-i * 0.0025) << " " << (1.0 / (i + 1)) << "\n";
+    }
+    for(int i=0; i < 2 * numVertices; ++i){
+        int v = i / 2;
+        out << "f " << (v % numVertices + 1) << " " << ((v + 1) % numVertices + 1) << " "
+            << ((v + 2) % numVertices + 1) << "\n";
+    }
+}
+
+
+void scanCoordinateFile(const string& filename, bool isMemoryMappedInputEnabled)
+{
+    auto t0 = Clock::now();
+    EasyScanner scanner;
+    scanner.setMemoryMappedInputEnabled(isMemoryMappedInputEnabled);
+    scanner.setLineOriented(false);
+    scanner.setWhiteSpaceChar(',');
+    scanner.loadFile(filename);
+    auto t1 = Clock::now();
+
+    scanner.readWordEx();
+    scanner.readCharEx('[');
+    double sum = 0.0;
+    int numValues = 0;
+    while(scanner.readDouble()){
+        sum += scanner.doubleValue;
+        ++numValues;
+    }
+    scanner.readCharEx(']');
+    auto t2 = Clock::now();
+
+    cout << "coordinates, " << (isMemoryMappedInputEnabled ? "on" : "off") << ", "
+         << milliseconds(t1 - t0) << ", " << milliseconds(t2 - t1) << ", "
+         << numValues << " values, sum " << sum << endl;
+}
+
+
+void scanObjFile(const string& filename, bool isMemoryMappedInputEnabled)
+{
+    auto t0 = Clock::now();
+    EasyScanner scanner;
+    scanner.setMemoryMappedInputEnabled(isMemoryMappedInputEnabled);
+    scanner.loadFile(filename);
+    auto t1 = Clock::now();
+
+    double sum = 0.0;
+    long indexSum = 0;
+    while(!scanner.isEOF()){
+        scanner.readWordEx();
+        if(scanner.stringValue == "v"){
+            for(int i=0; i < 3; ++i){
+                sum += scanner.readFloatEx();
+            }
+        } else {
+            for(int i=0; i < 3; ++i){
+                indexSum += scanner.readIntEx();
+            }
+        }
+        scanner.readLFEOFex();
+    }
+    auto t2 = Clock::now();
+
+    cout << "obj, " << (isMemoryMappedInputEnabled ? "on" : "off") << ", "
+         << milliseconds(t1 - t0) << ", " << milliseconds(t2 - t1) << ", "
+         << "sum " << sum << ", index sum " << indexSum << endl;
+}
+
+
+void printUsage()
+{
+    cout << "Usage: cnoid-easy-scanner-benchmark [--points N] [--vertices N] [--repeat N]" << endl;
+}
+
+}
+
+
+int main(int argc, char* argv[])
+{
+    int numPoints = 1000000;
+    int numVertices = 500000;
+    int numRepeats = 3;
+
+    for(int i=1; i < argc; ++i){
+        string option(argv[i]);
+        if(i + 1 < argc && option == "--points"){
+            numPoints = atoi(argv[++i]);
+        } else if(i + 1 < argc && option == "--vertices"){
+            numVertices = atoi(argv[++i]);
+        } else if(i + 1 < argc && option == "--repeat"){
+            numRepeats = atoi(argv[++i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if(numPoints < 1 || numVertices < 3 || numRepeats < 1){
+        printUsage();
+        return 1;
+    }
+
+    auto directory = filesystem::temp_directory_path();
+    string coordinateFile = (directory / "cnoid-easy-scanner-benchmark.wrl").string();
+    string objFile = (directory / "cnoid-easy-scanner-benchmark.obj").string();
+    writeCoordinateFile(coordinateFile, numPoints);
+    writeObjFile(objFile, numVertices);
+
+    cout << "file, memory mapped input, load [ms], parse [ms], result" << endl;
+    try {
+        for(int i=0; i < numRepeats; ++i){
+            for(bool on : { true, false }){
+                scanCoordinateFile(coordinateFile, on);
+                scanObjFile(objFile, on);
+            }
+        }
+    }
+    catch(const EasyScanner::Exception& ex){
+        cerr << ex.getFullMessage() << endl;
+        filesystem::remove(coordinateFile);
+        filesystem::remove(objFile);
+        return 1;
+    }
+
+    filesystem::remove(coordinateFile);
+    filesystem::remove(objFile);
+
+    return 0;
+}
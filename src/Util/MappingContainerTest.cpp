@@ -0,0 +1,145 @@
+/**
+   This program checks the elements of Mapping against std::map while the keys are inserted,
+   replaced and erased in a random order. The erased elements are kept in the container
+   until they are removed at once, so the iteration in the insertion order and the lookups
+   with the hash index must skip them in any state of the container.
+*/
+
+#include "ValueTree.h"
+#include <map>
+#include <algorithm>
+#include <random>
+#include <iostream>
+
+using namespace std;
+using namespace cnoid;
+
+namespace {
+
+int numFailures = 0;
+
+void check(bool condition, const string& message)
+{
+    if(!condition){
+        cerr << "FAILED: " << message << endl;
+        ++numFailures;
+    }
+}
+
+
+bool isSameContents(Mapping* mapping, const map<string, int>& expected, const vector<string>& order)
+{
+    if(mapping->size() != static_cast<int>(expected.size())){
+        return false;
+    }
+    // The keys must be iterated in the insertion order of the remaining keys
+    size_t orderIndex = 0;
+    for(auto& kv : *mapping){
+        while(orderIndex < order.size() && !expected.count(order[orderIndex])){
+            ++orderIndex;
+        }
+        if(orderIndex == order.size() || kv.first != order[orderIndex]){
+            return false;
+        }
+        ++orderIndex;
+        if(kv.second->toInt() != expected.at(kv.first)){
+            return false;
+        }
+    }
+    for(auto& kv : expected){
+        auto node = mapping->find(kv.first);
+        if(!node->isValid() || node->toInt() != kv.second){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void checkRandomOperations(int numKeys, int numOperations, int checkInterval, unsigned int seed)
+{
+    mt19937 random(seed);
+    uniform_int_distribution<int> keyDistribution(0, numKeys - 1);
+    uniform_int_distribution<int> operationDistribution(0, 2);
+
+    MappingPtr mapping = new Mapping;
+    map<string, int> expected;
+    vector<string> order;
+    const string label = to_string(numKeys) + " keys";
+
+    for(int i=0; i < numOperations; ++i){
+        string key = "key" + to_string(keyDistribution(random));
+        switch(operationDistribution(random)){
+        case 0:
+        case 1:
+            if(!expected.count(key)){
+                // A re-inserted key is placed at the end
+                auto p = std::find(order.begin(), order.end(), key);
+                if(p != order.end()){
+                    order.erase(p);
+                }
+                order.push_back(key);
+            }
+            mapping->write(key, i);
+            expected[key] = i;
+            break;
+        case 2:
+            check(mapping->remove(key) == (expected.erase(key) > 0), label + ": result of remove");
+            check(!mapping->find(key)->isValid(), label + ": removed key is found");
+            break;
+        }
+        if((i % checkInterval == 0 || i == numOperations - 1) && !isSameContents(mapping, expected, order)){
+            check(false, label + ": contents after operation " + to_string(i));
+            return;
+        }
+    }
+
+    // Erase all the remaining elements while iterating them as the loops over the container do
+    MappingContainer container;
+    container.insert(mapping->begin(), mapping->end());
+    vector<string> keys;
+    for(auto& kv : container){
+        keys.push_back(kv.first);
+    }
+    size_t numErased = 0;
+    for(auto p = container.begin(); p != container.end(); ){
+        if(p->first != keys[numErased]){
+            check(false, label + ": element in erasing with the iterator");
+            return;
+        }
+        p = container.erase(p);
+        ++numErased;
+        if(container.size() != keys.size() - numErased ||
+           (numErased < keys.size() && container.find(keys[numErased]) == container.end())){
+            check(false, label + ": contents in erasing with the iterator");
+            return;
+        }
+    }
+    check(numErased == keys.size() && container.empty() && container.begin() == container.end(),
+          label + ": empty after erasing all");
+
+    for(auto& key : keys){
+        mapping->remove(key);
+    }
+    mapping->write("again", 1);
+    check(mapping->size() == 1 && mapping->find("again")->toInt() == 1, label + ": insertion after erasing all");
+}
+
+}
+
+
+int main()
+{
+    // The elements are linearly searched in the small mappings and indexed in the large ones
+    checkRandomOperations(4, 500, 1, 1);
+    checkRandomOperations(12, 2000, 1, 2);
+    checkRandomOperations(100, 20000, 1, 3);
+    checkRandomOperations(2000, 100000, 50, 4);
+
+    if(numFailures > 0){
+        cerr << numFailures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All checks passed." << endl;
+    return 0;
+}
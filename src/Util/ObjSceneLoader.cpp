@@ -7,6 +7,10 @@
 #include "NullOut.h"
 #include <unordered_map>
 #include <algorithm>
+#include <fstream>
+#include <thread>
+#include <limits>
+#include <cstring>
 #include "gettext.h"
 
 using namespace std;
@@ -60,6 +64,53 @@ void readYUpVector3Ex(SimpleScanner& scanner, float scale, Vector3f& v)
     v.x() = scanner.readFloatEx() * scale;
 }
 
+// Files smaller than this size are parsed in a single thread
+constexpr size_t MinChunkSize = 4 * 1024 * 1024;
+constexpr size_t ReadBlockSize = 4 * 1024 * 1024;
+constexpr int NoIndex = std::numeric_limits<int>::min();
+
+/**
+   This class parses the lines that start in a byte range of an OBJ file.
+   The vertex data and the face indices are stored in the chunk, and the directives
+   that must be processed in the order of the file, such as usemtl, are recorded with
+   the positions in the face sequence so that they can be replayed in the merge.
+*/
+class ObjChunkParser
+{
+public:
+    enum DirectiveType { MaterialLibrary, UseMaterial, NewNode };
+    struct Directive {
+        DirectiveType type;
+        string name;
+        size_t faceIndex;
+    };
+
+    string filename;
+    size_t startOffset;
+    size_t endOffset;
+    float scale;
+    bool doCoordinateConversion;
+    AbstractSceneLoader::UpperAxisType upperAxis;
+
+    SimpleScanner scanner;
+    vector<Vector3f> vertices;
+    vector<Vector3f> normals;
+    vector<Vector2f> texCoords;
+    // Three indices (vertex, tex coord, normal) for each face element
+    vector<int> faceElements;
+    vector<int> faceSizes;
+    vector<Directive> directives;
+    string token;
+    bool isSuccessfullyParsed;
+    string errorMessage;
+    std::thread parserThread;
+
+    void parse();
+    void parseBlocks();
+    void parseLine(char* line, char* lineEnd);
+    void readFace();
+};
+
 };
 
 namespace cnoid {
@@ -113,10 +164,15 @@ public:
     filesystem::path directoryPath;
     string directory;
 
+    int maxNumThreads;
+
     Impl(ObjSceneLoader* self);
     void clearBufObjects();
     SgNode* load(const string& filename);
     SgNodePtr loadScene();
+    bool loadSceneConcurrently(const string& filename, size_t fileSize, int numThreads);
+    void mergeChunk(ObjChunkParser& chunk);
+    SgNodePtr completeScene();
     void createNewNode(const std::string& name);
     bool checkAndAddCurrentNode();
     void readVertex();
@@ -124,6 +180,7 @@ public:
     void readTextureCoordinate();
     void readFace();
     bool readFaceElement(int axis);
+    void triangulateLastPolygon(int numPolygonVertices);
     bool loadMaterialTemplateLibrary(std::string filename);
     void readMaterial(const std::string& name);
     void createNewMaterial(const string& name, const string& filename);
@@ -155,6 +212,7 @@ ObjSceneLoader::Impl::Impl(ObjSceneLoader* self)
 {
     imageIO.setUpsideDown(true);
     os_ = &nullout();
+    maxNumThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
 }
 
 
@@ -240,7 +298,19 @@ SgNode* ObjSceneLoader::Impl::load(const string& filename)
     }
     
     try {
-        scene = loadScene();
+        stdx::error_code ec;
+        size_t fileSize = filesystem::file_size(filePath, ec);
+        int numThreads = ec ? 1 : std::min(maxNumThreads, static_cast<int>(fileSize / MinChunkSize));
+        bool loaded = false;
+        if(numThreads >= 2){
+            loaded = loadSceneConcurrently(filename, fileSize, numThreads);
+            if(loaded){
+                scene = completeScene();
+            }
+        }
+        if(!loaded){
+            scene = loadScene();
+        }
     }
     catch(const std::exception& ex){
         os() << ex.what() << endl;
@@ -340,6 +410,12 @@ SgNodePtr ObjSceneLoader::Impl::loadScene()
         }
     }
 
+    return completeScene();
+}
+
+
+SgNodePtr ObjSceneLoader::Impl::completeScene()
+{
     checkAndAddCurrentNode();
 
     normalizeNormals();
@@ -485,48 +561,369 @@ void ObjSceneLoader::Impl::readFace()
         scanner.throwEx("The number of face elements is less than thrree");
 
     } else if(axis >= 4){
-        int index0 = currentVertexIndices->size() - axis;
-        polygon.resize(axis);
-        auto vpos = currentVertexIndices->begin() + index0;
-        std::copy(vpos, vpos + axis, polygon.begin());
-        int numTriangles = triangulator.apply(polygon);
-        const auto& triangles = triangulator.triangles();
-
-        bool needTofixNormalIndices =
-            currentVertexIndices->size() == currentNormalIndices->size();
-        bool needTofixTexCoordIndices =
-            currentVertexIndices->size() == currentTexCoordIndices->size();
-        
-        currentVertexIndices->resize(index0);
+        triangulateLastPolygon(axis);
+    }
+}
+
+
+void ObjSceneLoader::Impl::triangulateLastPolygon(int axis)
+{
+    int index0 = currentVertexIndices->size() - axis;
+    polygon.resize(axis);
+    auto vpos = currentVertexIndices->begin() + index0;
+    std::copy(vpos, vpos + axis, polygon.begin());
+    int numTriangles = triangulator.apply(polygon);
+    const auto& triangles = triangulator.triangles();
+
+    bool needTofixNormalIndices =
+        currentVertexIndices->size() == currentNormalIndices->size();
+    bool needTofixTexCoordIndices =
+        currentVertexIndices->size() == currentTexCoordIndices->size();
+    
+    currentVertexIndices->resize(index0);
+    int localIndex = 0;
+    for(int i=0; i < numTriangles; ++i){
+        for(int j=0; j < 3; ++j){
+            currentVertexIndices->push_back(polygon[triangles[localIndex++]]);
+        }
+    }
+    if(needTofixNormalIndices){
+        auto npos = currentNormalIndices->begin() + index0;
+        std::copy(npos, npos + axis, polygon.begin());
+        currentNormalIndices->resize(index0);
+        int localIndex = 0;
+        for(int i=0; i < numTriangles; ++i){
+            for(int j=0; j < 3; ++j){
+                currentNormalIndices->push_back(polygon[triangles[localIndex++]]);
+            }
+        }
+    }
+    if(needTofixTexCoordIndices){
+        auto npos = currentTexCoordIndices->begin() + index0;
+        std::copy(npos, npos + axis, polygon.begin());
+        currentTexCoordIndices->resize(index0);
         int localIndex = 0;
         for(int i=0; i < numTriangles; ++i){
             for(int j=0; j < 3; ++j){
-                currentVertexIndices->push_back(polygon[triangles[localIndex++]]);
+                currentTexCoordIndices->push_back(polygon[triangles[localIndex++]]);
             }
         }
-        if(needTofixNormalIndices){
-            auto npos = currentNormalIndices->begin() + index0;
-            std::copy(npos, npos + axis, polygon.begin());
-            currentNormalIndices->resize(index0);
-            int localIndex = 0;
-            for(int i=0; i < numTriangles; ++i){
-                for(int j=0; j < 3; ++j){
-                    currentNormalIndices->push_back(polygon[triangles[localIndex++]]);
+    }
+}
+
+
+/**
+   The file is divided into the byte ranges of the threads, and each thread parses the
+   lines starting in its range. The vertex data of the chunks are concatenated into the
+   shared arrays and the faces and directives of the chunks are then replayed in the
+   order of the file. When any chunk fails to be parsed, this function returns false
+   and the file is parsed again in the ordinary way to report the error exactly.
+*/
+bool ObjSceneLoader::Impl::loadSceneConcurrently(const string& filename, size_t fileSize, int numThreads)
+{
+    vector<ObjChunkParser> chunks(numThreads);
+    size_t chunkSize = fileSize / numThreads;
+    for(int i=0; i < numThreads; ++i){
+        auto& chunk = chunks[i];
+        chunk.filename = filename;
+        chunk.startOffset = i * chunkSize;
+        chunk.endOffset = (i == numThreads - 1) ? fileSize : (i + 1) * chunkSize;
+        chunk.scale = scale;
+        chunk.doCoordinateConversion = doCoordinateConversion;
+        chunk.upperAxis = upperAxis;
+        chunk.isSuccessfullyParsed = false;
+    }
+    for(int i=1; i < numThreads; ++i){
+        auto& chunk = chunks[i];
+        chunk.parserThread = std::thread([&chunk](){ chunk.parse(); });
+    }
+    chunks[0].parse();
+
+    bool isSuccessful = true;
+    for(auto& chunk : chunks){
+        if(chunk.parserThread.joinable()){
+            chunk.parserThread.join();
+        }
+        if(!chunk.isSuccessfullyParsed){
+            isSuccessful = false;
+        }
+    }
+    if(!isSuccessful){
+        return false;
+    }
+
+    size_t numVertices = 0;
+    size_t numNormals = 0;
+    size_t numTexCoords = 0;
+    for(auto& chunk : chunks){
+        numVertices += chunk.vertices.size();
+        numNormals += chunk.normals.size();
+        numTexCoords += chunk.texCoords.size();
+    }
+    vertices->reserve(numVertices);
+    normals->reserve(numNormals);
+    texCoords->reserve(numTexCoords);
+    for(auto& chunk : chunks){
+        for(auto& v : chunk.vertices){
+            vertices->push_back(v);
+        }
+        for(auto& n : chunk.normals){
+            normals->push_back(n);
+        }
+        for(auto& t : chunk.texCoords){
+            texCoords->push_back(t);
+        }
+        vector<Vector3f>().swap(chunk.vertices);
+        vector<Vector3f>().swap(chunk.normals);
+        vector<Vector2f>().swap(chunk.texCoords);
+    }
+
+    group = new SgGroup;
+    createNewNode(fileBaseName);
+    
+    for(auto& chunk : chunks){
+        mergeChunk(chunk);
+    }
+
+    return true;
+}
+
+
+void ObjSceneLoader::Impl::mergeChunk(ObjChunkParser& chunk)
+{
+    const int* element = chunk.faceElements.data();
+    size_t faceIndex = 0;
+    size_t directiveIndex = 0;
+    const size_t numFaces = chunk.faceSizes.size();
+    
+    while(true){
+        size_t nextFaceIndex = numFaces;
+        if(directiveIndex < chunk.directives.size()){
+            nextFaceIndex = chunk.directives[directiveIndex].faceIndex;
+        }
+        while(faceIndex < nextFaceIndex){
+            int numElements = chunk.faceSizes[faceIndex++];
+            for(int i=0; i < numElements; ++i){
+                currentVertexIndices->push_back(element[0]);
+                if(element[1] != NoIndex){
+                    currentTexCoordIndices->push_back(element[1]);
+                }
+                if(element[2] != NoIndex){
+                    currentNormalIndices->push_back(element[2]);
                 }
+                element += 3;
+            }
+            if(numElements >= 4){
+                triangulateLastPolygon(numElements);
+            }
+        }
+        if(directiveIndex >= chunk.directives.size()){
+            break;
+        }
+        auto& directive = chunk.directives[directiveIndex++];
+        switch(directive.type){
+        case ObjChunkParser::MaterialLibrary:
+            loadMaterialTemplateLibrary(directive.name);
+            break;
+        case ObjChunkParser::UseMaterial:
+            readMaterial(directive.name);
+            break;
+        case ObjChunkParser::NewNode:
+            createNewNode(directive.name);
+            break;
+        }
+    }
+}
+
+
+void ObjChunkParser::parse()
+{
+    scanner.filename = filename;
+    try {
+        parseBlocks();
+        isSuccessfullyParsed = true;
+    }
+    catch(const std::exception& ex){
+        errorMessage = ex.what();
+        isSuccessfullyParsed = false;
+    }
+}
+
+
+/**
+   The chunk parses the lines whose first characters are in the range from startOffset
+   to endOffset. The reading starts from the character just before the range and the
+   first line is skipped so that the line crossing the range border is parsed by the
+   previous chunk.
+*/
+void ObjChunkParser::parseBlocks()
+{
+    std::ifstream ifs(fromUTF8(filename), std::ios::in | std::ios::binary);
+    if(!ifs.is_open()){
+        throw std::runtime_error(format("Unable to open file \"{}\".", filename));
+    }
+    size_t bufOffset = (startOffset > 0) ? startOffset - 1 : 0;
+    ifs.seekg(bufOffset);
+    bool doSkipFirstLine = (startOffset > 0);
+
+    vector<char> buf;
+    size_t bufSize = 0;
+    bool isEof = false;
+    
+    while(true){
+        if(!isEof){
+            buf.resize(bufSize + ReadBlockSize + 1);
+            ifs.read(&buf[bufSize], ReadBlockSize);
+            size_t numReadBytes = ifs.gcount();
+            bufSize += numReadBytes;
+            if(numReadBytes < ReadBlockSize){
+                isEof = true;
             }
         }
-        if(needTofixTexCoordIndices){
-            auto npos = currentTexCoordIndices->begin() + index0;
-            std::copy(npos, npos + axis, polygon.begin());
-            currentTexCoordIndices->resize(index0);
-            int localIndex = 0;
-            for(int i=0; i < numTriangles; ++i){
-                for(int j=0; j < 3; ++j){
-                    currentTexCoordIndices->push_back(polygon[triangles[localIndex++]]);
+        char* bufTop = buf.data();
+        char* bufEnd = bufTop + bufSize;
+        char* line = bufTop;
+        while(line < bufEnd){
+            char* lineEnd = static_cast<char*>(memchr(line, '\n', bufEnd - line));
+            if(!lineEnd){
+                if(!isEof){
+                    break;
                 }
+                lineEnd = bufEnd;
+            }
+            if(bufOffset + (line - bufTop) >= endOffset){
+                return;
+            }
+            *lineEnd = '\0';
+            if(doSkipFirstLine){
+                doSkipFirstLine = false;
+            } else {
+                parseLine(line, lineEnd);
             }
+            line = lineEnd + 1;
         }
+        if(isEof){
+            break;
+        }
+        size_t numRemainingBytes = (line < bufEnd) ? (bufEnd - line) : 0;
+        if(numRemainingBytes > 0){
+            memmove(bufTop, line, numRemainingBytes);
+        }
+        bufOffset += bufSize - numRemainingBytes;
+        bufSize = numRemainingBytes;
+    }
+}
+
+
+void ObjChunkParser::parseLine(char* line, char* lineEnd)
+{
+    scanner.setLine(line, lineEnd);
+    
+    switch(scanner.peekChar()){
+            
+    case 'v':
+        scanner.moveForward();
+        if(scanner.peekChar() == ' '){
+            vertices.emplace_back();
+            if(!doCoordinateConversion){
+                readVector3Ex(scanner, vertices.back());
+            } else if(upperAxis == AbstractSceneLoader::Y_Upper){
+                readYUpVector3Ex(scanner, scale, vertices.back());
+            } else {
+                readVector3Ex(scanner, scale, vertices.back());
+            }
+        } else if(scanner.peekChar() == 'n'){
+            scanner.moveForward();
+            normals.emplace_back();
+            if(upperAxis == AbstractSceneLoader::Z_Upper){
+                readVector3Ex(scanner, normals.back());
+            } else {
+                readYUpVector3Ex(scanner, normals.back());
+            }
+        } else if(scanner.peekChar() == 't'){
+            scanner.moveForward();
+            texCoords.emplace_back();
+            readVector2Ex(scanner, texCoords.back());
+        } else {
+            scanner.throwEx("Unsupported directive");
+        }
+        break;
+            
+    case 'f':
+        scanner.moveForward();
+        readFace();
+        break;
+
+    case 'l':
+        break;
+            
+    case 'm':
+        if(scanner.checkStringAtCurrentPosition("mtllib ")){
+            scanner.readStringToEOL(token);
+            directives.push_back({ MaterialLibrary, token, faceSizes.size() });
+        } else {
+            scanner.readString(token);
+            scanner.throwEx(format("Unsupported directive '{0}'", token));
+        }
+        break;
+
+    case 'u':
+        if(scanner.checkStringAtCurrentPosition("usemtl")){
+            scanner.readStringToEOL(token);
+            directives.push_back({ UseMaterial, token, faceSizes.size() });
+        } else {
+            scanner.readString(token);
+            scanner.throwEx(format("Unsupported directive '{0}'", token));
+        }
+        break;
+
+    case 'o':
+    case 'g':
+        scanner.moveForward();
+        scanner.readString(token);
+        directives.push_back({ NewNode, token, faceSizes.size() });
+        break;
+
+    case 's':
+        break;
+            
+    case '#':
+        break;
+
+    default:
+        scanner.skipSpacesAndTabs();
+        if(!scanner.checkLF()){
+            scanner.throwEx("Unsupported directive");
+        }
+        break;
+    }
+}
+
+
+void ObjChunkParser::readFace()
+{
+    int numElements = 0;
+    int index;
+    while(scanner.readInt(index)){
+        faceElements.push_back(index - 1);
+        int texCoordIndex = NoIndex;
+        int normalIndex = NoIndex;
+        if(scanner.checkCharAtCurrentPosition('/')){
+            if(scanner.readInt(index)){
+                texCoordIndex = index - 1;
+            }
+            if(scanner.checkCharAtCurrentPosition('/')){
+                normalIndex = scanner.readIntEx() - 1;
+            }
+        }
+        faceElements.push_back(texCoordIndex);
+        faceElements.push_back(normalIndex);
+        ++numElements;
+    }
+    if(numElements <= 2){
+        scanner.throwEx("The number of face elements is less than thrree");
     }
+    faceSizes.push_back(numElements);
 }
 
 
@@ -21,6 +21,7 @@ public:
     Signal<void(int index, PositionTag* tag, bool isChaningOrder)> sigTagRemoved;
     Signal<void(int index)> sigTagPositionChanged;
     Signal<void(int index)> sigTagPositionUpdated;
+    unsigned int revision;
     
     Impl();
     Impl(const Impl& org);
@@ -37,7 +38,7 @@ PositionTagGroup::PositionTagGroup()
 
 PositionTagGroup::Impl::Impl()
 {
-
+    revision = 0;
 }
 
 
@@ -55,7 +56,7 @@ PositionTagGroup::PositionTagGroup(const PositionTagGroup& org)
 PositionTagGroup::Impl::Impl(const Impl& org)
     : name(org.name)
 {
-
+    revision = 0;
 }
 
 
@@ -98,6 +99,7 @@ void PositionTagGroup::insert(int index, PositionTag* tag)
         index = n;
     }
     tags_.insert(tags_.begin() + index, tag);
+    ++impl->revision;
 
     impl->sigTagAdded(index);
 }
@@ -112,6 +114,7 @@ void PositionTagGroup::insert(int index, PositionTagGroup* group)
     auto it = tags_.begin() + index;
     for(auto& tag : *group){
         it = tags_.insert(it, tag);
+        ++impl->revision;
         impl->sigTagAdded(index++);
         it++;
     }
@@ -131,6 +134,7 @@ bool PositionTagGroup::removeAt(int index)
     }
     PositionTagPtr tag = tags_[index];
     tags_.erase(tags_.begin() + index);
+    ++impl->revision;
     impl->sigTagRemoved(index, tag, false);
     return true;
 }
@@ -148,6 +152,7 @@ bool PositionTagGroup::changeOrder(int orgIndex, int newIndex)
 
     PositionTagPtr tag = tags_[orgIndex];
     tags_.erase(tags_.begin() + orgIndex);
+    ++impl->revision;
     impl->sigTagRemoved(orgIndex, tag, true);
     insert(newIndex, tag);
 
@@ -155,6 +160,12 @@ bool PositionTagGroup::changeOrder(int orgIndex, int newIndex)
 }
 
 
+unsigned int PositionTagGroup::revision() const
+{
+    return impl->revision;
+}
+
+
 SignalProxy<void(int index)> PositionTagGroup::sigTagAdded()
 {
     return impl->sigTagAdded;
@@ -182,6 +193,7 @@ SignalProxy<void(int index)> PositionTagGroup::sigTagPositionUpdated()
 void PositionTagGroup::notifyTagPositionChange(int index)
 {
     if(static_cast<size_t>(index) < tags_.size()){
+        ++impl->revision;
         impl->sigTagPositionChanged(index);
     }
 }
@@ -190,6 +202,7 @@ void PositionTagGroup::notifyTagPositionChange(int index)
 void PositionTagGroup::notifyTagPositionUpdate(int index, bool doNotifyPositionChange)
 {
     if(static_cast<size_t>(index) < tags_.size()){
+        ++impl->revision;
         if(doNotifyPositionChange){
             impl->sigTagPositionChanged(index);
         }
@@ -60,6 +60,12 @@ public:
     void notifyTagPositionChange(int index);
     void notifyTagPositionUpdate(int index, bool doNotifyPositionChange = true);
 
+    /**
+       The revision number is incremented when a tag is added, removed or moved.
+       The tag position changes are counted only when they are notified.
+    */
+    unsigned int revision() const;
+
     bool read(const Mapping* archive);
     bool write(Mapping* archive) const;
 
@@ -183,6 +183,11 @@ public:
         return px;
     }        
 
+    // The number of the references to the object as well as std::shared_ptr::use_count
+    int use_count() const {
+        return px ? px->refCount() : 0;
+    }
+
     T& operator*() const {
         assert(px != nullptr);
         return *px;
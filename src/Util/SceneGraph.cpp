@@ -162,6 +162,302 @@ bool SgObject::checkIfAncestorOf(SgObject* obj) const
 }
 
 
+namespace cnoid {
+
+class SgUpdateTransaction::Impl
+{
+public:
+    struct NodeInfo
+    {
+        SgObject* object;
+        int slot;
+        int firstChildIndex;
+        int frontIndex;
+        int parentIndexBegin;
+        int parentIndexEnd;
+        int numChildren;
+        int numPendingChildren;
+        int action;
+        bool isModified;
+        bool isExpanded;
+    };
+    vector<NodeInfo> nodeInfos;
+    // Open addressing hash table from the objects to the node indices, which avoids
+    // the allocation for each node in every commit
+    vector<int> nodeIndexSlots;
+    size_t slotMask;
+    vector<int> modifiedNodeIndices;
+    // The modified objects are kept alive until the commit
+    vector<SgObjectPtr> modifiedObjects;
+    vector<int> parentIndices;
+    vector<int> nodeIndexStack;
+    vector<SgObject*> pathBuf;
+    SgUpdate update;
+    int numNotifiedObjects;
+    bool isCommitting;
+
+    Impl();
+    static size_t hash(SgObject* object) {
+        return (reinterpret_cast<uintptr_t>(object) >> 4) * 0x9E3779B97F4A7C15ull;
+    }
+    void expandNodeIndexSlots();
+    int findOrAddNode(SgObject* object, bool& out_isNew);
+    void add(SgObject* object, int action);
+    void expandUpperNodes();
+    void commit();
+    void clear();
+};
+
+}
+
+
+SgUpdateTransaction::SgUpdateTransaction()
+{
+    impl = new Impl;
+}
+
+
+SgUpdateTransaction::Impl::Impl()
+{
+    update.setInitialPathCapacity(16);
+    nodeIndexSlots.resize(256, -1);
+    slotMask = nodeIndexSlots.size() - 1;
+    numNotifiedObjects = 0;
+    isCommitting = false;
+}
+
+
+SgUpdateTransaction::~SgUpdateTransaction()
+{
+    impl->commit();
+    delete impl;
+}
+
+
+void SgUpdateTransaction::Impl::expandNodeIndexSlots()
+{
+    nodeIndexSlots.assign(nodeIndexSlots.size() * 2, -1);
+    slotMask = nodeIndexSlots.size() - 1;
+    for(size_t i=0; i < nodeInfos.size(); ++i){
+        auto& info = nodeInfos[i];
+        size_t slot = hash(info.object) & slotMask;
+        while(nodeIndexSlots[slot] >= 0){
+            slot = (slot + 1) & slotMask;
+        }
+        nodeIndexSlots[slot] = i;
+        info.slot = slot;
+    }
+}
+
+
+int SgUpdateTransaction::Impl::findOrAddNode(SgObject* object, bool& out_isNew)
+{
+    if((nodeInfos.size() + 1) * 2 > nodeIndexSlots.size()){
+        expandNodeIndexSlots();
+    }
+    size_t slot = hash(object) & slotMask;
+    while(true){
+        int index = nodeIndexSlots[slot];
+        if(index < 0){
+            break;
+        }
+        if(nodeInfos[index].object == object){
+            out_isNew = false;
+            return index;
+        }
+        slot = (slot + 1) & slotMask;
+    }
+    out_isNew = true;
+    int index = nodeInfos.size();
+    nodeIndexSlots[slot] = index;
+    nodeInfos.emplace_back();
+    auto& info = nodeInfos.back();
+    info.object = object;
+    info.slot = slot;
+    info.firstChildIndex = -1;
+    info.frontIndex = -1;
+    info.parentIndexBegin = 0;
+    info.parentIndexEnd = 0;
+    info.numChildren = 0;
+    info.numPendingChildren = 0;
+    info.action = SgUpdate::None;
+    info.isModified = false;
+    info.isExpanded = false;
+    return index;
+}
+
+
+void SgUpdateTransaction::add(SgObject* object, int action)
+{
+    impl->add(object, action);
+}
+
+
+void SgUpdateTransaction::Impl::add(SgObject* object, int action)
+{
+    if(isCommitting || (action & (SgUpdate::Added | SgUpdate::Removed))){
+        object->notifyUpdate(action);
+        return;
+    }
+    bool isNew;
+    int index = findOrAddNode(object, isNew);
+    auto& info = nodeInfos[index];
+    info.action |= action;
+    if(!info.isModified){
+        info.isModified = true;
+        modifiedNodeIndices.push_back(index);
+        modifiedObjects.push_back(object);
+    }
+}
+
+
+void SgUpdateTransaction::commit()
+{
+    impl->commit();
+}
+
+
+/**
+   Each object is expanded only once, so the upper nodes shared by the modified
+   objects are visited only once.
+*/
+void SgUpdateTransaction::Impl::expandUpperNodes()
+{
+    for(auto& index : modifiedNodeIndices){
+        if(!nodeInfos[index].isExpanded){
+            nodeInfos[index].isExpanded = true;
+            nodeIndexStack.push_back(index);
+        }
+        while(!nodeIndexStack.empty()){
+            int childIndex = nodeIndexStack.back();
+            nodeIndexStack.pop_back();
+            SgObject* child = nodeInfos[childIndex].object;
+            nodeInfos[childIndex].parentIndexBegin = parentIndices.size();
+            for(auto p = child->parentBegin(); p != child->parentEnd(); ++p){
+                bool isNew;
+                int parentIndex = findOrAddNode(*p, isNew);
+                parentIndices.push_back(parentIndex);
+                auto& parentInfo = nodeInfos[parentIndex];
+                if(++parentInfo.numChildren == 1){
+                    parentInfo.firstChildIndex = childIndex;
+                }
+                if(!parentInfo.isExpanded){
+                    parentInfo.isExpanded = true;
+                    nodeIndexStack.push_back(parentIndex);
+                }
+            }
+            nodeInfos[childIndex].parentIndexEnd = parentIndices.size();
+        }
+    }
+}
+
+
+void SgUpdateTransaction::Impl::commit()
+{
+    numNotifiedObjects = 0;
+
+    if(modifiedNodeIndices.empty() || isCommitting){
+        return;
+    }
+    isCommitting = true;
+
+    expandUpperNodes();
+
+    // The objects without pending children are notified first to keep the order
+    // from the lower nodes to the upper nodes
+    for(size_t i=0; i < nodeInfos.size(); ++i){
+        auto& info = nodeInfos[i];
+        info.numPendingChildren = info.numChildren;
+        if(info.numChildren == 0){
+            nodeIndexStack.push_back(i);
+        }
+    }
+
+    while(!nodeIndexStack.empty()){
+        int index = nodeIndexStack.back();
+        nodeIndexStack.pop_back();
+        auto& info = nodeInfos[index];
+        SgObject* object = info.object;
+
+        if(info.isModified || info.numChildren >= 2){
+            info.frontIndex = index;
+        } else {
+            info.frontIndex = nodeInfos[info.firstChildIndex].frontIndex;
+        }
+
+        update.clearPath();
+        pathBuf.clear();
+        int pathIndex = index;
+        while(true){
+            auto& pathInfo = nodeInfos[pathIndex];
+            pathBuf.push_back(pathInfo.object);
+            if(pathIndex == info.frontIndex){
+                break;
+            }
+            pathIndex = pathInfo.firstChildIndex;
+        }
+        for(auto it = pathBuf.rbegin(); it != pathBuf.rend(); ++it){
+            update.pushNode(*it);
+        }
+        update.setAction(info.action);
+
+        if(info.action & SgUpdate::GeometryModified){
+            object->invalidateBoundingBox();
+        }
+        object->sigUpdated_(update);
+        ++numNotifiedObjects;
+
+        // The parents at the beginning of the commit are used even if the graph is
+        // modified by the slots connected to the signal
+        int action = info.action;
+        for(int i = info.parentIndexBegin; i < info.parentIndexEnd; ++i){
+            int parentIndex = parentIndices[i];
+            auto& parentInfo = nodeInfos[parentIndex];
+            parentInfo.action |= action;
+            if(--parentInfo.numPendingChildren == 0){
+                nodeIndexStack.push_back(parentIndex);
+            }
+        }
+    }
+
+    clear();
+    isCommitting = false;
+}
+
+
+void SgUpdateTransaction::clear()
+{
+    if(!impl->isCommitting){
+        impl->clear();
+    }
+}
+
+
+void SgUpdateTransaction::Impl::clear()
+{
+    for(auto& info : nodeInfos){
+        nodeIndexSlots[info.slot] = -1;
+    }
+    nodeInfos.clear();
+    modifiedNodeIndices.clear();
+    modifiedObjects.clear();
+    parentIndices.clear();
+    nodeIndexStack.clear();
+}
+
+
+bool SgUpdateTransaction::empty() const
+{
+    return impl->modifiedNodeIndices.empty();
+}
+
+
+int SgUpdateTransaction::numNotifiedObjectsInLastCommit() const
+{
+    return impl->numNotifiedObjects;
+}
+
+
 const std::string& SgObject::uri() const
 {
     if(!uriInfo){
@@ -178,11 +178,49 @@ private:
     mutable std::unique_ptr<UriInfo> uriInfo;
 
     SgObject* findObject_(std::function<bool(SgObject* object)>& pred);
+
+    friend class SgUpdateTransaction;
 };
 
 typedef ref_ptr<SgObject> SgObjectPtr;
 
 
+/**
+   This class collects the modifications of scene objects and notifies the upper nodes
+   of them at once when the transaction is committed. The sigUpdated signal of each
+   object on the paths from the modified objects to the roots is emitted only once per
+   commit, and the bounding box cache of each object is invalidated only once. The
+   front of the update path given to an object where the paths from multiple modified
+   objects merge is the object itself, and the action of the update is the union of
+   the actions of the modified objects below it.
+
+   The updates including the Added or Removed action are notified immediately because
+   their paths must start with the added or removed objects.
+*/
+class CNOID_EXPORT SgUpdateTransaction
+{
+public:
+    SgUpdateTransaction();
+    //! The uncommitted modifications are committed on the destruction
+    ~SgUpdateTransaction();
+
+    void add(SgObject* object, int action = SgUpdate::Modified);
+    void commit();
+    void clear();
+    bool empty() const;
+
+    //! The number of the objects whose sigUpdated signals were emitted by the last commit
+    int numNotifiedObjectsInLastCommit() const;
+
+private:
+    class Impl;
+    Impl* impl;
+
+    SgUpdateTransaction(const SgUpdateTransaction&) = delete;
+    SgUpdateTransaction& operator=(const SgUpdateTransaction&) = delete;
+};
+
+
 class CNOID_EXPORT SgNode : public SgObject
 {
 public:
@@ -0,0 +1,814 @@
+#include "SceneRayPicker.h"
+#include "SceneDrawables.h"
+#include "SceneEffects.h"
+#include "PolymorphicSceneNodeFunctionSet.h"
+#include <unordered_map>
+#include <algorithm>
+#include <memory>
+#include <limits>
+
+using namespace std;
+using namespace cnoid;
+
+namespace {
+
+// The bounding boxes of the nodes which cannot be evaluated are enlarged by this ratio
+// of the diagonal length so that the thick lines and points are covered
+constexpr double UnsupportedNodeBoxMarginRatio = 0.05;
+constexpr double MinUnsupportedNodeBoxMargin = 0.005;
+
+constexpr int MaxNumTrianglesInMeshBvhLeaf = 4;
+constexpr int MaxNumInstancesInSceneBvhLeaf = 2;
+
+struct BvhNode
+{
+    Vector3 min;
+    Vector3 max;
+    int first;
+    int count; // leaf node if this is positive
+    int right; // the left child is the next node
+};
+
+typedef vector<BvhNode, Eigen::aligned_allocator<BvhNode>> BvhNodeArray;
+
+struct MeshBvh
+{
+    SgMeshPtr mesh;
+    BvhNodeArray nodes;
+    vector<int> triangles;
+    bool isUsed;
+};
+
+typedef shared_ptr<MeshBvh> MeshBvhPtr;
+
+struct TransformEntry
+{
+    SgTransform* transform;
+    int parent;
+    Affine3 T;
+};
+
+struct Instance
+{
+    SgShape* shape;
+    SgMesh* mesh;
+    int transformIndex;
+    SgNodePath nodePath;
+    Vector3 min;
+    Vector3 max;
+    MeshBvhPtr bvh;
+};
+
+struct UnsupportedNode
+{
+    SgNode* node;
+    int transformIndex;
+    bool isOverlay;
+    bool isUnbounded;
+    Vector3 min;
+    Vector3 max;
+};
+
+bool intersectRayWithBox
+(const Vector3& origin, const Vector3& invDirection, const Vector3& min, const Vector3& max,
+ double maxDistance, double& out_distance)
+{
+    double tmin = 0.0;
+    double tmax = maxDistance;
+    for(int i=0; i < 3; ++i){
+        double t0 = (min[i] - origin[i]) * invDirection[i];
+        double t1 = (max[i] - origin[i]) * invDirection[i];
+        if(t0 > t1){
+            std::swap(t0, t1);
+        }
+        // The comparisons are written so that NaN values do not shrink the range
+        if(t0 > tmin){
+            tmin = t0;
+        }
+        if(t1 < tmax){
+            tmax = t1;
+        }
+        if(tmin > tmax){
+            return false;
+        }
+    }
+    out_distance = tmin;
+    return true;
+}
+
+Vector3 getInverseDirection(const Vector3& d)
+{
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    return Vector3(
+        d.x() != 0.0 ? 1.0 / d.x() : inf,
+        d.y() != 0.0 ? 1.0 / d.y() : inf,
+        d.z() != 0.0 ? 1.0 / d.z() : inf);
+}
+
+}
+
+namespace cnoid {
+
+class SceneRayPicker::Impl
+{
+public:
+    SgGroupPtr sceneRoot;
+    ScopedConnection sceneRootConnection;
+    PolymorphicSceneNodeFunctionSet functions;
+
+    vector<TransformEntry, Eigen::aligned_allocator<TransformEntry>> transformEntries;
+    vector<Instance, Eigen::aligned_allocator<Instance>> instances;
+    vector<UnsupportedNode, Eigen::aligned_allocator<UnsupportedNode>> unsupportedNodes;
+    BvhNodeArray sceneBvhNodes;
+    unordered_map<SgMesh*, MeshBvhPtr> meshBvhMap;
+
+    bool isStructureInvalidated;
+    bool isTransformInvalidated;
+
+    // Variables used in collecting the nodes
+    SgNodePath currentNodePath;
+    int currentTransformIndex;
+
+    SgNodePath pickedNodePath;
+    Vector3 pickedPoint;
+    double pickedDistance;
+    bool isPickingUncertain;
+
+    Impl();
+    void setSceneRoot(SgGroup* sceneRoot);
+    void invalidate();
+    void onSceneGraphUpdated(const SgUpdate& update);
+    void invalidateMeshBvh(SgMesh* mesh);
+    void update();
+    void collectNodes();
+    void visitGroup(SgGroup* group);
+    void visitTransform(SgTransform* transform);
+    void visitShape(SgShape* shape);
+    void addUnsupportedNode(SgNode* node, bool isOverlay, bool isUnbounded);
+    void updateTransformsAndBoundingBoxes();
+    void buildSceneBvh(vector<int>& order, int first, int count);
+    void refitSceneBvh();
+    MeshBvhPtr getOrCreateMeshBvh(SgMesh* mesh);
+    void buildMeshBvh(MeshBvh& bvh, const vector<Vector3f>& centroids, int first, int count);
+    bool pick(const Vector3& origin, const Vector3& direction, double maxDistance);
+    bool intersectRayWithInstance(
+        Instance& instance, const Vector3& origin, const Vector3& direction, double& io_distance);
+};
+
+}
+
+
+SceneRayPicker::SceneRayPicker()
+{
+    impl = new Impl;
+}
+
+
+SceneRayPicker::SceneRayPicker(SgGroup* sceneRoot)
+    : SceneRayPicker()
+{
+    impl->setSceneRoot(sceneRoot);
+}
+
+
+SceneRayPicker::Impl::Impl()
+{
+    functions.setFunction<SgNode>(
+        [&](SgNode* node){ addUnsupportedNode(node, false, false); });
+    // Lights, cameras and fog have no geometry to be picked
+    functions.setFunction<SgPreprocessed>(
+        [&](SgPreprocessed*){ });
+    functions.setFunction<SgGroup>(
+        [&](SgGroup* node){ visitGroup(node); });
+    functions.setFunction<SgTransform>(
+        [&](SgTransform* node){ visitTransform(node); });
+    functions.setFunction<SgSwitchableGroup>(
+        [&](SgSwitchableGroup* node){
+            if(node->isTurnedOn()){
+                visitGroup(node);
+            }
+        });
+    functions.setFunction<SgUnpickableGroup>(
+        [&](SgUnpickableGroup*){ });
+    functions.setFunction<SgFixedPixelSizeGroup>(
+        [&](SgFixedPixelSizeGroup* node){ addUnsupportedNode(node, false, true); });
+    functions.setFunction<SgOverlay>(
+        [&](SgOverlay* node){ addUnsupportedNode(node, true, false); });
+    functions.setFunction<SgViewportOverlay>(
+        [&](SgViewportOverlay* node){ addUnsupportedNode(node, true, true); });
+    functions.setFunction<SgLightweightRenderingGroup>(
+        [&](SgLightweightRenderingGroup* node){
+            // The group itself is not included in the node path as GLSLSceneRenderer does
+            for(auto& child : *node){
+                functions.dispatch(child);
+            }
+        });
+    functions.setFunction<SgShape>(
+        [&](SgShape* node){ visitShape(node); });
+    functions.updateDispatchTable();
+
+    isStructureInvalidated = true;
+    isTransformInvalidated = true;
+    currentTransformIndex = -1;
+    pickedPoint.setZero();
+    pickedDistance = 0.0;
+    isPickingUncertain = false;
+}
+
+
+SceneRayPicker::~SceneRayPicker()
+{
+    delete impl;
+}
+
+
+void SceneRayPicker::setSceneRoot(SgGroup* sceneRoot)
+{
+    impl->setSceneRoot(sceneRoot);
+}
+
+
+void SceneRayPicker::Impl::setSceneRoot(SgGroup* sceneRoot)
+{
+    if(sceneRoot != this->sceneRoot){
+        this->sceneRoot = sceneRoot;
+        if(sceneRoot){
+            sceneRootConnection =
+                sceneRoot->sigUpdated().connect(
+                    [this](const SgUpdate& update){ onSceneGraphUpdated(update); });
+        } else {
+            sceneRootConnection.disconnect();
+        }
+        invalidate();
+    }
+}
+
+
+SgGroup* SceneRayPicker::sceneRoot() const
+{
+    return impl->sceneRoot;
+}
+
+
+void SceneRayPicker::invalidate()
+{
+    impl->invalidate();
+}
+
+
+void SceneRayPicker::Impl::invalidate()
+{
+    meshBvhMap.clear();
+    for(auto& instance : instances){
+        instance.bvh.reset();
+    }
+    isStructureInvalidated = true;
+}
+
+
+void SceneRayPicker::Impl::onSceneGraphUpdated(const SgUpdate& update)
+{
+    auto& path = update.path();
+
+    if(update.hasAction(SgUpdate::GeometryModified)){
+        for(auto& object : path){
+            if(auto mesh = dynamic_cast<SgMesh*>(object)){
+                invalidateMeshBvh(mesh);
+                break;
+            }
+        }
+        isTransformInvalidated = true;
+    }
+
+    if(!isStructureInvalidated){
+        if(path.empty() || update.hasAction(SgUpdate::Added | SgUpdate::Removed)){
+            isStructureInvalidated = true;
+        } else {
+            auto object = path.front();
+            if(dynamic_cast<SgSwitch*>(object) || dynamic_cast<SgSwitchableGroup*>(object) ||
+               dynamic_cast<SgShape*>(object)){
+                // The set of the pickable shapes may be changed
+                isStructureInvalidated = true;
+            }
+        }
+    }
+}
+
+
+void SceneRayPicker::Impl::invalidateMeshBvh(SgMesh* mesh)
+{
+    auto p = meshBvhMap.find(mesh);
+    if(p != meshBvhMap.end()){
+        meshBvhMap.erase(p);
+        for(auto& instance : instances){
+            if(instance.mesh == mesh){
+                instance.bvh.reset();
+            }
+        }
+    }
+}
+
+
+void SceneRayPicker::Impl::update()
+{
+    if(isStructureInvalidated){
+        collectNodes();
+        updateTransformsAndBoundingBoxes();
+        vector<int> order(instances.size());
+        for(size_t i=0; i < order.size(); ++i){
+            order[i] = i;
+        }
+        sceneBvhNodes.clear();
+        if(!instances.empty()){
+            buildSceneBvh(order, 0, order.size());
+        }
+        decltype(instances) sortedInstances;
+        sortedInstances.reserve(instances.size());
+        for(auto& index : order){
+            sortedInstances.push_back(std::move(instances[index]));
+        }
+        instances.swap(sortedInstances);
+        isStructureInvalidated = false;
+        isTransformInvalidated = false;
+
+    } else if(isTransformInvalidated){
+        updateTransformsAndBoundingBoxes();
+        refitSceneBvh();
+        isTransformInvalidated = false;
+    }
+}
+
+
+void SceneRayPicker::Impl::collectNodes()
+{
+    transformEntries.clear();
+    instances.clear();
+    unsupportedNodes.clear();
+    currentNodePath.clear();
+    currentTransformIndex = -1;
+
+    for(auto& kv : meshBvhMap){
+        kv.second->isUsed = false;
+    }
+
+    if(sceneRoot){
+        for(auto& node : *sceneRoot){
+            functions.dispatch(node);
+        }
+    }
+
+    // Remove the caches of the meshes which are not used any more
+    auto p = meshBvhMap.begin();
+    while(p != meshBvhMap.end()){
+        if(p->second->isUsed){
+            ++p;
+        } else {
+            p = meshBvhMap.erase(p);
+        }
+    }
+}
+
+
+void SceneRayPicker::Impl::visitGroup(SgGroup* group)
+{
+    currentNodePath.push_back(group);
+    for(auto& child : *group){
+        functions.dispatch(child);
+    }
+    currentNodePath.pop_back();
+}
+
+
+void SceneRayPicker::Impl::visitTransform(SgTransform* transform)
+{
+    if(transform->empty()){
+        return;
+    }
+    int parentIndex = currentTransformIndex;
+    currentTransformIndex = transformEntries.size();
+    transformEntries.emplace_back();
+    auto& entry = transformEntries.back();
+    entry.transform = transform;
+    entry.parent = parentIndex;
+
+    visitGroup(transform);
+
+    currentTransformIndex = parentIndex;
+}
+
+
+void SceneRayPicker::Impl::visitShape(SgShape* shape)
+{
+    auto mesh = shape->mesh();
+    if(!mesh || !mesh->hasTriangles() || !mesh->hasVertices()){
+        return;
+    }
+    instances.emplace_back();
+    auto& instance = instances.back();
+    instance.shape = shape;
+    instance.mesh = mesh;
+    instance.transformIndex = currentTransformIndex;
+    instance.nodePath = currentNodePath;
+    instance.nodePath.push_back(shape);
+
+    auto p = meshBvhMap.find(mesh);
+    if(p != meshBvhMap.end()){
+        p->second->isUsed = true;
+        instance.bvh = p->second;
+    }
+}
+
+
+void SceneRayPicker::Impl::addUnsupportedNode(SgNode* node, bool isOverlay, bool isUnbounded)
+{
+    unsupportedNodes.emplace_back();
+    auto& unsupported = unsupportedNodes.back();
+    unsupported.node = node;
+    unsupported.transformIndex = currentTransformIndex;
+    unsupported.isOverlay = isOverlay;
+    unsupported.isUnbounded = isUnbounded;
+}
+
+
+void SceneRayPicker::Impl::updateTransformsAndBoundingBoxes()
+{
+    // The parent entry always precedes its child entries
+    for(auto& entry : transformEntries){
+        Affine3 T;
+        entry.transform->getTransform(T);
+        if(entry.parent >= 0){
+            entry.T = transformEntries[entry.parent].T * T;
+        } else {
+            entry.T = T;
+        }
+    }
+
+    for(auto& instance : instances){
+        BoundingBox bbox = instance.mesh->boundingBox();
+        if(instance.transformIndex >= 0){
+            bbox.transform(transformEntries[instance.transformIndex].T);
+        }
+        if(bbox.empty()){
+            instance.min.setConstant(std::numeric_limits<double>::max());
+            instance.max.setConstant(std::numeric_limits<double>::lowest());
+        } else {
+            instance.min = bbox.min();
+            instance.max = bbox.max();
+        }
+    }
+
+    for(auto& unsupported : unsupportedNodes){
+        if(!unsupported.isUnbounded){
+            BoundingBox bbox = unsupported.node->boundingBox();
+            if(bbox.empty()){
+                unsupported.isUnbounded = true;
+            } else {
+                if(unsupported.transformIndex >= 0){
+                    bbox.transform(transformEntries[unsupported.transformIndex].T);
+                }
+                double margin = std::max(
+                    UnsupportedNodeBoxMarginRatio * bbox.size().norm(), MinUnsupportedNodeBoxMargin);
+                unsupported.min = bbox.min().array() - margin;
+                unsupported.max = bbox.max().array() + margin;
+            }
+        }
+    }
+}
+
+
+void SceneRayPicker::Impl::buildSceneBvh(vector<int>& order, int first, int count)
+{
+    int nodeIndex = sceneBvhNodes.size();
+    sceneBvhNodes.emplace_back();
+    {
+        auto& node = sceneBvhNodes.back();
+        node.min.setConstant(std::numeric_limits<double>::max());
+        node.max.setConstant(std::numeric_limits<double>::lowest());
+        for(int i = first; i < first + count; ++i){
+            auto& instance = instances[order[i]];
+            node.min = node.min.cwiseMin(instance.min);
+            node.max = node.max.cwiseMax(instance.max);
+        }
+        node.first = first;
+        node.count = count;
+        node.right = -1;
+    }
+    if(count <= MaxNumInstancesInSceneBvhLeaf){
+        return;
+    }
+
+    Vector3 cmin = Vector3::Constant(std::numeric_limits<double>::max());
+    Vector3 cmax = Vector3::Constant(std::numeric_limits<double>::lowest());
+    for(int i = first; i < first + count; ++i){
+        auto& instance = instances[order[i]];
+        Vector3 c = (instance.min + instance.max) / 2.0;
+        cmin = cmin.cwiseMin(c);
+        cmax = cmax.cwiseMax(c);
+    }
+    int axis;
+    (cmax - cmin).maxCoeff(&axis);
+    int half = count / 2;
+    std::nth_element(
+        order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+        [&](int a, int b){
+            return (instances[a].min[axis] + instances[a].max[axis]) <
+                (instances[b].min[axis] + instances[b].max[axis]); });
+
+    sceneBvhNodes[nodeIndex].count = 0;
+    buildSceneBvh(order, first, half);
+    sceneBvhNodes[nodeIndex].right = sceneBvhNodes.size();
+    buildSceneBvh(order, first + half, count - half);
+}
+
+
+/**
+   The topology of the hierarchy is kept and only the bounding boxes are recalculated
+   when the transforms are changed. Since the child nodes always follow the parent node,
+   the nodes can be updated in the reverse order.
+*/
+void SceneRayPicker::Impl::refitSceneBvh()
+{
+    for(int i = sceneBvhNodes.size() - 1; i >= 0; --i){
+        auto& node = sceneBvhNodes[i];
+        if(node.count > 0){
+            node.min.setConstant(std::numeric_limits<double>::max());
+            node.max.setConstant(std::numeric_limits<double>::lowest());
+            for(int j = node.first; j < node.first + node.count; ++j){
+                node.min = node.min.cwiseMin(instances[j].min);
+                node.max = node.max.cwiseMax(instances[j].max);
+            }
+        } else {
+            auto& left = sceneBvhNodes[i + 1];
+            auto& right = sceneBvhNodes[node.right];
+            node.min = left.min.cwiseMin(right.min);
+            node.max = left.max.cwiseMax(right.max);
+        }
+    }
+}
+
+
+MeshBvhPtr SceneRayPicker::Impl::getOrCreateMeshBvh(SgMesh* mesh)
+{
+    auto& bvh = meshBvhMap[mesh];
+    if(!bvh){
+        bvh = make_shared<MeshBvh>();
+        bvh->mesh = mesh;
+        bvh->isUsed = true;
+        const auto& vertices = *mesh->vertices();
+        const auto& triangleVertices = mesh->triangleVertices();
+        const int numTriangles = mesh->numTriangles();
+        vector<Vector3f> centroids(numTriangles);
+        bvh->triangles.resize(numTriangles);
+        for(int i=0; i < numTriangles; ++i){
+            centroids[i] =
+                (vertices[triangleVertices[i * 3]] +
+                 vertices[triangleVertices[i * 3 + 1]] +
+                 vertices[triangleVertices[i * 3 + 2]]) / 3.0f;
+            bvh->triangles[i] = i;
+        }
+        if(numTriangles > 0){
+            buildMeshBvh(*bvh, centroids, 0, numTriangles);
+        }
+    }
+    return bvh;
+}
+
+
+void SceneRayPicker::Impl::buildMeshBvh(MeshBvh& bvh, const vector<Vector3f>& centroids, int first, int count)
+{
+    const auto& vertices = *bvh.mesh->vertices();
+    const auto& triangleVertices = bvh.mesh->triangleVertices();
+
+    int nodeIndex = bvh.nodes.size();
+    bvh.nodes.emplace_back();
+    Vector3f vmin = Vector3f::Constant(std::numeric_limits<float>::max());
+    Vector3f vmax = Vector3f::Constant(std::numeric_limits<float>::lowest());
+    Vector3f cmin = vmin;
+    Vector3f cmax = vmax;
+    for(int i = first; i < first + count; ++i){
+        int triangle = bvh.triangles[i];
+        for(int j=0; j < 3; ++j){
+            const Vector3f& v = vertices[triangleVertices[triangle * 3 + j]];
+            vmin = vmin.cwiseMin(v);
+            vmax = vmax.cwiseMax(v);
+        }
+        cmin = cmin.cwiseMin(centroids[triangle]);
+        cmax = cmax.cwiseMax(centroids[triangle]);
+    }
+    auto& node = bvh.nodes.back();
+    node.min = vmin.cast<double>();
+    node.max = vmax.cast<double>();
+    node.first = first;
+    node.count = count;
+    node.right = -1;
+
+    if(count <= MaxNumTrianglesInMeshBvhLeaf){
+        return;
+    }
+
+    int axis;
+    (cmax - cmin).maxCoeff(&axis);
+    int half = count / 2;
+    std::nth_element(
+        bvh.triangles.begin() + first, bvh.triangles.begin() + first + half, bvh.triangles.begin() + first + count,
+        [&](int a, int b){ return centroids[a][axis] < centroids[b][axis]; });
+
+    bvh.nodes[nodeIndex].count = 0;
+    buildMeshBvh(bvh, centroids, first, half);
+    bvh.nodes[nodeIndex].right = bvh.nodes.size();
+    buildMeshBvh(bvh, centroids, first + half, count - half);
+}
+
+
+bool SceneRayPicker::pick(const Vector3& origin, const Vector3& direction, double maxDistance)
+{
+    return impl->pick(origin, direction, maxDistance);
+}
+
+
+bool SceneRayPicker::Impl::pick(const Vector3& origin, const Vector3& direction, double maxDistance)
+{
+    pickedNodePath.clear();
+    isPickingUncertain = false;
+
+    double norm = direction.norm();
+    if(norm == 0.0){
+        return false;
+    }
+    const Vector3 d = direction / norm;
+    const Vector3 invDirection = getInverseDirection(d);
+
+    update();
+
+    double distance = maxDistance;
+    int pickedInstanceIndex = -1;
+
+    if(!sceneBvhNodes.empty()){
+        // The depth of the hierarchy built by the median split does not exceed the stack size
+        int stack[64];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+        while(stackSize > 0){
+            int nodeIndex = stack[--stackSize];
+            auto& node = sceneBvhNodes[nodeIndex];
+            double t;
+            if(!intersectRayWithBox(origin, invDirection, node.min, node.max, distance, t)){
+                continue;
+            }
+            if(node.count > 0){
+                for(int i = node.first; i < node.first + node.count; ++i){
+                    auto& instance = instances[i];
+                    if(intersectRayWithBox(origin, invDirection, instance.min, instance.max, distance, t)){
+                        if(intersectRayWithInstance(instance, origin, d, distance)){
+                            pickedInstanceIndex = i;
+                        }
+                    }
+                }
+            } else {
+                stack[stackSize++] = node.right;
+                stack[stackSize++] = nodeIndex + 1;
+            }
+        }
+    }
+
+    for(auto& unsupported : unsupportedNodes){
+        if(unsupported.isUnbounded){
+            isPickingUncertain = true;
+            break;
+        }
+        double t;
+        double limit = unsupported.isOverlay ? maxDistance : distance;
+        if(intersectRayWithBox(origin, invDirection, unsupported.min, unsupported.max, limit, t)){
+            isPickingUncertain = true;
+            break;
+        }
+    }
+
+    if(pickedInstanceIndex < 0){
+        return false;
+    }
+
+    pickedNodePath = instances[pickedInstanceIndex].nodePath;
+    pickedPoint = origin + distance * d;
+    pickedDistance = distance;
+
+    return true;
+}
+
+
+/**
+   The ray is transformed into the local coordinate of the mesh so that the distance
+   parameter of the ray is same in both the coordinates.
+*/
+bool SceneRayPicker::Impl::intersectRayWithInstance
+(Instance& instance, const Vector3& origin, const Vector3& direction, double& io_distance)
+{
+    if(!instance.bvh){
+        instance.bvh = getOrCreateMeshBvh(instance.mesh);
+    }
+    auto& bvh = *instance.bvh;
+    if(bvh.nodes.empty()){
+        return false;
+    }
+
+    Vector3 o = origin;
+    Vector3 d = direction;
+    bool isMirrored = false;
+    if(instance.transformIndex >= 0){
+        const Affine3& T = transformEntries[instance.transformIndex].T;
+        const Affine3 Tinv = T.inverse();
+        o = Tinv * origin;
+        d = Tinv.linear() * direction;
+        isMirrored = T.linear().determinant() < 0.0;
+    }
+    const Vector3 invDirection = getInverseDirection(d);
+    const bool doCullBackFaces = instance.mesh->isSolid();
+
+    const auto& vertices = *instance.mesh->vertices();
+    const auto& triangleVertices = instance.mesh->triangleVertices();
+
+    bool hit = false;
+    int stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while(stackSize > 0){
+        int nodeIndex = stack[--stackSize];
+        auto& node = bvh.nodes[nodeIndex];
+        double t;
+        if(!intersectRayWithBox(o, invDirection, node.min, node.max, io_distance, t)){
+            continue;
+        }
+        if(node.count == 0){
+            stack[stackSize++] = node.right;
+            stack[stackSize++] = nodeIndex + 1;
+            continue;
+        }
+        for(int i = node.first; i < node.first + node.count; ++i){
+            const int triangle = bvh.triangles[i];
+            const Vector3 v0 = vertices[triangleVertices[triangle * 3]].cast<double>();
+            const Vector3 e1 = vertices[triangleVertices[triangle * 3 + 1]].cast<double>() - v0;
+            const Vector3 e2 = vertices[triangleVertices[triangle * 3 + 2]].cast<double>() - v0;
+
+            // Moller-Trumbore algorithm
+            const Vector3 p = d.cross(e2);
+            const double det = e1.dot(p);
+            if(doCullBackFaces){
+                if(isMirrored ? (det >= 0.0) : (det <= 0.0)){
+                    continue;
+                }
+            } else if(det == 0.0){
+                continue;
+            }
+            const double invDet = 1.0 / det;
+            const Vector3 s = o - v0;
+            const double u = s.dot(p) * invDet;
+            if(u < 0.0 || u > 1.0){
+                continue;
+            }
+            const Vector3 q = s.cross(e1);
+            const double v = d.dot(q) * invDet;
+            if(v < 0.0 || u + v > 1.0){
+                continue;
+            }
+            const double distance = e2.dot(q) * invDet;
+            if(distance >= 0.0 && distance < io_distance){
+                io_distance = distance;
+                hit = true;
+            }
+        }
+    }
+
+    return hit;
+}
+
+
+const SgNodePath& SceneRayPicker::pickedNodePath() const
+{
+    return impl->pickedNodePath;
+}
+
+
+const Vector3& SceneRayPicker::pickedPoint() const
+{
+    return impl->pickedPoint;
+}
+
+
+double SceneRayPicker::pickedDistance() const
+{
+    return impl->pickedDistance;
+}
+
+
+bool SceneRayPicker::isPickingUncertain() const
+{
+    return impl->isPickingUncertain;
+}
+
+
+int SceneRayPicker::numPickableShapes()
+{
+    impl->update();
+    return impl->instances.size();
+}
@@ -0,0 +1,60 @@
+#ifndef CNOID_UTIL_SCENE_RAY_PICKER_H
+#define CNOID_UTIL_SCENE_RAY_PICKER_H
+
+#include "SceneGraph.h"
+#include "exportdecl.h"
+
+namespace cnoid {
+
+/**
+   This class picks the shape hit by a ray without rendering the scene. The world space
+   bounding volume hierarchy of the shapes and the bounding volume hierarchy of each mesh
+   are built lazily at the first picking, and they are updated incrementally according to
+   the updates of the scene graph. The node path of a picked shape is the same as the
+   one given by the picking of GLSLSceneRenderer, which does not contain the root node.
+   This class does not require OpenGL and can be used in the headless mode.
+*/
+class CNOID_EXPORT SceneRayPicker
+{
+public:
+    SceneRayPicker();
+    SceneRayPicker(SgGroup* sceneRoot);
+    ~SceneRayPicker();
+
+    void setSceneRoot(SgGroup* sceneRoot);
+    SgGroup* sceneRoot() const;
+
+    /**
+       @param origin The origin of the ray in the world coordinate
+       @param direction The direction of the ray in the world coordinate
+       @param maxDistance The hits beyond this distance from the origin are ignored
+       @return true if a shape is picked
+    */
+    bool pick(const Vector3& origin, const Vector3& direction, double maxDistance = 1.0e10);
+
+    const SgNodePath& pickedNodePath() const;
+    const Vector3& pickedPoint() const;
+    double pickedDistance() const;
+
+    /**
+       This function returns true when the ray of the last picking may hit the nodes
+       which cannot be handled by this class, such as overlays, point sets, line sets,
+       texts and fixed pixel size groups. The result of the picking by rendering may be
+       different from that of this class in that case.
+    */
+    bool isPickingUncertain() const;
+
+    //! Invalidate all the bounding volume hierarchies built so far
+    void invalidate();
+
+    int numPickableShapes();
+
+    class Impl;
+
+private:
+    Impl* impl;
+};
+
+}
+
+#endif
@@ -0,0 +1,128 @@
+/**
+   This program measures the cost of notifying the position updates of the links of many
+   bodies to the root of a scene graph. The updates are notified for each link with
+   SgObject::notifyUpdate and at once with SgUpdateTransaction, and the computation time
+   per frame and the number of the signals received by the root per frame are reported.
+   The work done by an observer of the root such as a renderer is emulated by a loop in the
+   slot connected to the root.
+*/
+
+#include "SceneGraph.h"
+#include <chrono>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+using namespace cnoid;
+
+namespace {
+
+void printUsage()
+{
+    cout << "Usage: cnoid-sg-update-transaction-benchmark [--bodies N] [--links N] [--frames N] [--slot-cost N]" << endl;
+}
+
+}
+
+
+int main(int argc, char* argv[])
+{
+    int numBodies = 50;
+    int numLinks = 40;
+    int numFrames = 200;
+    int slotCost = 100;
+
+    for(int i=1; i < argc; ++i){
+        string option(argv[i]);
+        if(i + 1 < argc && option == "--bodies"){
+            numBodies = atoi(argv[++i]);
+        } else if(i + 1 < argc && option == "--links"){
+            numLinks = atoi(argv[++i]);
+        } else if(i + 1 < argc && option == "--frames"){
+            numFrames = atoi(argv[++i]);
+        } else if(i + 1 < argc && option == "--slot-cost"){
+            slotCost = atoi(argv[++i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if(numBodies < 1 || numLinks < 1 || numFrames < 1 || slotCost < 0){
+        printUsage();
+        return 1;
+    }
+
+    // The same structure as the scene bodies: a body transform, a group and the link transforms
+    SgGroupPtr root = new SgGroup;
+    vector<SgPosTransformPtr> links;
+    for(int i=0; i < numBodies; ++i){
+        auto body = new SgPosTransform;
+        root->addChild(body);
+        auto group = new SgGroup;
+        body->addChild(group);
+        for(int j=0; j < numLinks; ++j){
+            auto link = new SgPosTransform;
+            group->addChild(link);
+            links.push_back(link);
+        }
+    }
+
+    int numRootSignals = 0;
+    volatile double sink = 0.0;
+    root->sigUpdated().connect(
+        [&](const SgUpdate& update){
+            ++numRootSignals;
+            for(int i=0; i < slotCost; ++i){
+                sink = sink + update.path().size();
+            }
+        });
+
+    auto moveLinks = [&](int frame){
+        for(auto& link : links){
+            link->setTranslation(Vector3(0.001 * frame, 0.0, 0.0));
+        }
+    };
+
+    SgUpdate update;
+    auto t0 = chrono::steady_clock::now();
+    for(int i=0; i < numFrames; ++i){
+        moveLinks(i);
+        for(auto& link : links){
+            link->notifyUpdate(update);
+        }
+        root->boundingBox();
+    }
+    auto t1 = chrono::steady_clock::now();
+    int numRootSignalsOfEachLink = numRootSignals;
+
+    numRootSignals = 0;
+    SgUpdateTransaction transaction;
+    int numNotifiedObjects = 0;
+    auto t2 = chrono::steady_clock::now();
+    for(int i=0; i < numFrames; ++i){
+        moveLinks(i);
+        for(auto& link : links){
+            transaction.add(link);
+        }
+        transaction.commit();
+        numNotifiedObjects += transaction.numNotifiedObjectsInLastCommit();
+        root->boundingBox();
+    }
+    auto t3 = chrono::steady_clock::now();
+
+    auto timePerFrame = [numFrames](chrono::steady_clock::duration d){
+        return chrono::duration<double, std::micro>(d).count() / numFrames;
+    };
+
+    cout << "bodies: " << numBodies << ", links: " << numLinks << ", frames: " << numFrames
+         << ", slot cost: " << slotCost << "\n"
+         << "mode, time per frame [us], root signals per frame, notified objects per frame\n"
+         << "each link, " << timePerFrame(t1 - t0) << ", "
+         << numRootSignalsOfEachLink / numFrames << ", -\n"
+         << "transaction, " << timePerFrame(t3 - t2) << ", "
+         << numRootSignals / numFrames << ", " << numNotifiedObjects / numFrames << endl;
+
+    return 0;
+}
@@ -115,6 +115,19 @@ public:
         return !ifs.eof();
     }
 
+    /**
+       This function sets a line stored in an external buffer as the current line
+       instead of reading a line from the file. The line must be terminated by the
+       null character.
+    */
+    void setLine(char* line, char* lineEnd)
+    {
+        buf = line;
+        pos = line;
+        bufEndPos = lineEnd;
+        ++lineNumber;
+    }
+
     const std::string& currentLine()
     {
         char* end = buf;
@@ -13,14 +13,23 @@
 #include <boost/algorithm/string/predicate.hpp>
 #include <list>
 #include <cmath>
+#include <cstring>
 #include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
 
 using namespace std;
 using namespace cnoid;
 
 namespace {
 
+class InlineLoadingJob;
+class ConcurrentInlineLoader;
+
 string removeURLScheme(string url)
 {
     static const string fileProtocolHeader1("file://");
@@ -348,10 +357,17 @@ public:
     TProtoMap protoMap;
     TDefNodeMap defNodeMap;
 
+    bool isConcurrentInlineLoadingEnabled;
+    shared_ptr<ConcurrentInlineLoader> concurrentInlineLoaderInstance;
+    ConcurrentInlineLoader* concurrentInlineLoader;
+    InlineLoadingJob* currentInlineLoadingJob;
+
     void load(const string& filename, bool doClearAncestorPathsList);
+    void requestConcurrentInlineLoading();
     VRMLNodePtr readSpecificNode(VRMLNodeCategory nodeCategory, int symbol, const std::string& symbolString);
     VRMLNodePtr readInlineNode(VRMLNodeCategory nodeCategory);
     VRMLNodePtr newInlineSource(string& io_filename);
+    VRMLNodePtr readInlineSource(const string& filename);
     VRMLProtoPtr defineProto();
 
     void checkEOF();
@@ -440,7 +456,208 @@ private:
     void init();
     list<string> ancestorPathsList;
     string getRealPath(string url);
+
+    friend class ::ConcurrentInlineLoader;
+};
+
+}
+
+namespace {
+
+/**
+   The job to parse an inline source file. The job is executed by a worker thread of
+   ConcurrentInlineLoader or by the thread which requires the result when the job has
+   not been started yet.
+*/
+class InlineLoadingJob
+{
+public:
+    enum State { Queued, Running, Done };
+    string filename;
+    State state;
+    // The job whose result is waited for by the thread executing this job
+    InlineLoadingJob* waitingJob;
+    VRMLNodePtr node;
+    bool isFailed;
+    EasyScanner::Exception exception;
+
+    InlineLoadingJob(const string& filename)
+        : filename(filename), state(Queued), waitingJob(nullptr), isFailed(false) { }
+};
+
+/**
+   This class parses the inline source files referenced in a VRML file concurrently.
+   Each source file is parsed only once and the parsed node is shared by all the Inline
+   nodes referencing the file. The order of the nodes in the resulting tree is the same
+   as that of the sequential parsing because each Inline node is constructed by the
+   parser of the referencing file when it reads the node.
+*/
+class ConcurrentInlineLoader
+{
+public:
+    mutex jobMutex;
+    condition_variable jobCondition;
+    unordered_map<string, unique_ptr<InlineLoadingJob>> jobs;
+    deque<InlineLoadingJob*> jobQueue;
+    vector<std::thread> workers;
+    size_t maxNumWorkers;
+    bool isTerminating;
+
+    ConcurrentInlineLoader();
+    ~ConcurrentInlineLoader();
+    void request(const string& filename);
+    VRMLNodePtr getInlineSource(const string& filename, VRMLParserImpl* requester);
+    void run();
+    void executeJob(InlineLoadingJob* job, const list<string>& ancestorPathsList);
 };
+
+}
+
+
+ConcurrentInlineLoader::ConcurrentInlineLoader()
+{
+    maxNumWorkers = std::max(1u, std::thread::hardware_concurrency());
+    isTerminating = false;
+}
+
+
+ConcurrentInlineLoader::~ConcurrentInlineLoader()
+{
+    {
+        lock_guard<mutex> lock(jobMutex);
+        isTerminating = true;
+        jobQueue.clear();
+    }
+    jobCondition.notify_all();
+    for(auto& worker : workers){
+        worker.join();
+    }
+}
+
+
+void ConcurrentInlineLoader::request(const string& filename)
+{
+    {
+        lock_guard<mutex> lock(jobMutex);
+        if(isTerminating){
+            return;
+        }
+        auto& job = jobs[filename];
+        if(job){
+            return;
+        }
+        job.reset(new InlineLoadingJob(filename));
+        jobQueue.push_back(job.get());
+        if(workers.size() < maxNumWorkers && workers.size() < jobQueue.size()){
+            workers.emplace_back([this](){ run(); });
+        }
+    }
+    jobCondition.notify_all();
+}
+
+
+void ConcurrentInlineLoader::run()
+{
+    unique_lock<mutex> lock(jobMutex);
+    while(true){
+        jobCondition.wait(lock, [&](){ return isTerminating || !jobQueue.empty(); });
+        if(isTerminating){
+            break;
+        }
+        auto job = jobQueue.front();
+        jobQueue.pop_front();
+        if(job->state == InlineLoadingJob::Queued){
+            job->state = InlineLoadingJob::Running;
+            lock.unlock();
+            executeJob(job, list<string>());
+            lock.lock();
+        }
+    }
+}
+
+
+void ConcurrentInlineLoader::executeJob(InlineLoadingJob* job, const list<string>& ancestorPathsList)
+{
+    VRMLNodePtr node;
+    bool isFailed = false;
+    EasyScanner::Exception exception;
+    
+    try {
+        VRMLParserImpl parser(nullptr);
+        parser.concurrentInlineLoader = this;
+        parser.currentInlineLoadingJob = job;
+        parser.ancestorPathsList = ancestorPathsList;
+        node = parser.readInlineSource(job->filename);
+    }
+    catch(const EasyScanner::Exception& ex){
+        exception = ex;
+        isFailed = true;
+    }
+    catch(const std::exception& ex){
+        exception.message = ex.what();
+        exception.filename = job->filename;
+        exception.lineNumber = -1;
+        isFailed = true;
+    }
+
+    {
+        lock_guard<mutex> lock(jobMutex);
+        job->node = node;
+        job->isFailed = isFailed;
+        job->exception = exception;
+        job->state = InlineLoadingJob::Done;
+    }
+    jobCondition.notify_all();
+}
+
+
+/**
+   This function returns the node of the inline source. When the job of the source is
+   still queued, it is executed in the current thread. An exception is thrown when the
+   job fails or waiting for the job causes a circular dependency between the jobs.
+*/
+VRMLNodePtr ConcurrentInlineLoader::getInlineSource(const string& filename, VRMLParserImpl* requester)
+{
+    unique_lock<mutex> lock(jobMutex);
+
+    auto& jobEntry = jobs[filename];
+    if(!jobEntry){
+        jobEntry.reset(new InlineLoadingJob(filename));
+    }
+    InlineLoadingJob* job = jobEntry.get();
+    InlineLoadingJob* currentJob = requester->currentInlineLoadingJob;
+    
+    while(job->state != InlineLoadingJob::Done){
+        if(job->state == InlineLoadingJob::Queued){
+            job->state = InlineLoadingJob::Running;
+            if(currentJob){
+                currentJob->waitingJob = job;
+            }
+            lock.unlock();
+            executeJob(job, requester->ancestorPathsList);
+            lock.lock();
+        } else {
+            for(auto p = job; p; p = p->waitingJob){
+                if(p == currentJob){
+                    lock.unlock();
+                    requester->scanner->throwException(
+                        "Infinity loop ! " + filename + " is included ancestor list");
+                }
+            }
+            if(currentJob){
+                currentJob->waitingJob = job;
+            }
+            jobCondition.wait(lock, [job](){ return job->state == InlineLoadingJob::Done; });
+        }
+        if(currentJob){
+            currentJob->waitingJob = nullptr;
+        }
+    }
+
+    if(job->isFailed){
+        throw job->exception;
+    }
+    return job->node;
 }
 
 
@@ -496,11 +713,30 @@ void VRMLParser::setProtoInstanceActualNodeExtractionMode(bool isOn)
 }
 
 
+void VRMLParser::setConcurrentInlineLoadingEnabled(bool on)
+{
+    impl->isConcurrentInlineLoadingEnabled = on;
+}
+
+
+bool VRMLParser::isConcurrentInlineLoadingEnabled() const
+{
+    return impl->isConcurrentInlineLoadingEnabled;
+}
+
+
 /**
    This function throws EasyScanner::Exception when an error occurs.
 */
 void VRMLParser::load(const string& filename)
 {
+    // The parsed inline sources are not reused in loading another file
+    impl->concurrentInlineLoaderInstance.reset();
+    impl->concurrentInlineLoader = nullptr;
+    if(impl->isConcurrentInlineLoadingEnabled){
+        impl->concurrentInlineLoaderInstance = make_shared<ConcurrentInlineLoader>();
+        impl->concurrentInlineLoader = impl->concurrentInlineLoaderInstance.get();
+    }
     impl->load(filename, true);
 }
 
@@ -532,6 +768,91 @@ void VRMLParserImpl::load(const string& filename, bool doClearAncestorPathsList)
     scanner->setQuoteChar('"');
     scanner->setWhiteSpaceChar(',');
     scanner->setLineOriented(false);
+
+    if(concurrentInlineLoader){
+        requestConcurrentInlineLoading();
+    }
+}
+
+
+static bool isIdentifierChar(char c)
+{
+    return isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+
+static const char* skipSpaces(const char* p)
+{
+    while(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ','){
+        ++p;
+    }
+    return p;
+}
+
+
+/**
+   This function scans the text for the url fields of the Inline nodes and requests
+   the concurrent loading of the VRML source files specified in them.
+*/
+void VRMLParserImpl::requestConcurrentInlineLoading()
+{
+    const char* top = scanner->text;
+    const char* p = top;
+    string url;
+    
+    while(*p){
+        if(*p == '#'){
+            while(*p && *p != '\n'){
+                ++p;
+            }
+        } else if(*p == '"'){
+            ++p;
+            while(*p && *p != '"'){
+                ++p;
+            }
+            if(*p){
+                ++p;
+            }
+        } else if(*p == 'I' && strncmp(p, "Inline", 6) == 0 &&
+                  (p == top || !isIdentifierChar(p[-1])) && !isIdentifierChar(p[6])){
+            p = skipSpaces(p + 6);
+            if(*p != '{'){
+                continue;
+            }
+            p = skipSpaces(p + 1);
+            if(strncmp(p, "url", 3) != 0 || isIdentifierChar(p[3])){
+                continue;
+            }
+            p = skipSpaces(p + 3);
+            bool isList = (*p == '[');
+            if(isList){
+                p = skipSpaces(p + 1);
+            }
+            while(*p == '"'){
+                const char* urlTop = ++p;
+                while(*p && *p != '"'){
+                    ++p;
+                }
+                url.assign(urlTop, p - urlTop);
+                url = fromUTF8(url);
+                if(boost::algorithm::iends_with(url, "wrl")){
+                    string realPath = getRealPath(url);
+                    if(find(ancestorPathsList.begin(), ancestorPathsList.end(), realPath) == ancestorPathsList.end()){
+                        concurrentInlineLoader->request(realPath);
+                    }
+                }
+                if(*p){
+                    ++p;
+                }
+                if(!isList){
+                    break;
+                }
+                p = skipSpaces(p);
+            }
+        } else {
+            ++p;
+        }
+    }
 }
 
 
@@ -858,19 +1179,28 @@ VRMLNodePtr VRMLParserImpl::newInlineSource(string& io_filename)
             scanner->throwException("Infinity loop ! " + chkFile + " is included ancestor list");
         }
     }
+    io_filename = chkFile;
+
+    if(concurrentInlineLoader){
+        return concurrentInlineLoader->getInlineSource(chkFile, this);
+    }
 
     VRMLParserImpl inlineParser(*this, ancestorPathsList);
+    return inlineParser.readInlineSource(chkFile);
+}
 
-    inlineParser.load(chkFile, false);
-    io_filename = chkFile;
+
+VRMLNodePtr VRMLParserImpl::readInlineSource(const string& filename)
+{
+    load(filename, false);
 
     VRMLGroupPtr group = new VRMLGroup();
-    while(VRMLNodePtr node = inlineParser.readNode(TOP_NODE)){
+    while(VRMLNodePtr node = readNode(TOP_NODE)){
         if(node->isCategoryOf(CHILD_NODE)){
             group->children.push_back(node);
         }
     }
-    inlineParser.checkEOF();
+    checkEOF();
 
     if(group->children.size() == 1){
         return group->children.front();
@@ -2474,6 +2804,9 @@ void VRMLParserImpl::init()
     os_ = &nullout();
     currentProtoInstance = 0;
     protoInstanceActualNodeExtractionMode = true;
+    isConcurrentInlineLoadingEnabled = false;
+    concurrentInlineLoader = nullptr;
+    currentInlineLoadingJob = nullptr;
 
     topScanner = std::make_shared<EasyScanner>();
     scanner = topScanner.get();
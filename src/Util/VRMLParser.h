@@ -34,6 +34,15 @@ public:
 
     void setMessageSink(std::ostream& os);
     void setProtoInstanceActualNodeExtractionMode(bool isOn);
+
+    /**
+       When this mode is enabled, the VRML source files of the Inline nodes are parsed
+       concurrently by worker threads. Each source file is parsed only once in loading
+       a file and the parsed node is shared by the Inline nodes referencing the file.
+    */
+    void setConcurrentInlineLoadingEnabled(bool on);
+    bool isConcurrentInlineLoadingEnabled() const;
+    
     void load(const std::string& filename);
 
     /**
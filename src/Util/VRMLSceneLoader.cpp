@@ -53,6 +53,7 @@ VRMLSceneLoader::VRMLSceneLoader()
 VRMLSceneLoader::Impl::Impl()
 {
     os_ = &nullout();
+    parser.setConcurrentInlineLoadingEnabled(true);
 }
 
 
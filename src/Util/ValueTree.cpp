@@ -46,8 +46,28 @@ ListingPtr invalidListing;
 constexpr double PI = 3.141592653589793238462643383279502884;
 constexpr double TO_RADIAN = PI / 180.0;
 
+// The elements are linearly searched when the number of elements is not greater than this
+constexpr size_t MaxNumElementsWithoutHashIndex = 8;
+constexpr uint64_t ElementIndexMask = 0xffffffff;
+
+inline uint64_t hashKey(const char* key, size_t length)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for(size_t i=0; i < length; ++i){
+        hash ^= static_cast<unsigned char>(key[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline bool isSameKey(const string& key1, const char* key2, size_t length2)
+{
+    return key1.size() == length2 && memcmp(key1.data(), key2, length2) == 0;
 }
 
+}
+
+
 ValueNode::Initializer ValueNode::initializer;
 
 ValueNode::Initializer::Initializer()
@@ -487,6 +507,223 @@ ValueNode* ScalarNode::clone() const
 }
 
 
+void MappingContainer::clear()
+{
+    elements.clear();
+    numErasedElements = 0;
+    slots.clear();
+}
+
+
+size_t MappingContainer::findIndex(const char* key, size_t length) const
+{
+    if(slots.empty()){
+        const size_t n = elements.size();
+        for(size_t i=0; i < n; ++i){
+            auto& element = elements[i];
+            if(!element.isErased && isSameKey(element.first, key, length)){
+                return i;
+            }
+        }
+        return n;
+    }
+    return findIndex(key, length, hashKey(key, length));
+}
+
+
+size_t MappingContainer::findIndex(const char* key, size_t length, uint64_t hash) const
+{
+    const uint64_t tag = hash & ~ElementIndexMask;
+    const size_t mask = slots.size() - 1;
+    size_t pos = hash & mask;
+    while(true){
+        const uint64_t slot = slots[pos];
+        if(!slot){
+            break;
+        }
+        if((slot & ~ElementIndexMask) == tag){
+            size_t index = (slot & ElementIndexMask) - 1;
+            if(isSameKey(elements[index].first, key, length)){
+                return index;
+            }
+        }
+        pos = (pos + 1) & mask;
+    }
+    return elements.size();
+}
+
+
+size_t MappingContainer::appendElement(const std::string& key, ValueNode* node, uint64_t hash)
+{
+    size_t index = elements.size();
+    elements.emplace_back(key, node);
+
+    if(!slots.empty()){
+        if(elements.size() * 2 > slots.size()){
+            rebuildHashIndex();
+        } else {
+            const size_t mask = slots.size() - 1;
+            size_t pos = hash & mask;
+            while(slots[pos]){
+                pos = (pos + 1) & mask;
+            }
+            slots[pos] = (hash & ~ElementIndexMask) | (index + 1);
+        }
+    } else if(elements.size() > MaxNumElementsWithoutHashIndex){
+        rebuildHashIndex();
+    }
+        
+    return index;
+}
+
+
+void MappingContainer::rebuildHashIndex()
+{
+    const size_t n = elements.size();
+    if(n <= MaxNumElementsWithoutHashIndex){
+        slots.clear();
+        return;
+    }
+    size_t numSlots = 32;
+    while(numSlots < n * 4){
+        numSlots *= 2;
+    }
+    slots.assign(numSlots, 0);
+    const size_t mask = numSlots - 1;
+    for(size_t i=0; i < n; ++i){
+        auto& element = elements[i];
+        if(element.isErased){
+            continue;
+        }
+        uint64_t hash = hashKey(element.first.data(), element.first.size());
+        size_t pos = hash & mask;
+        while(slots[pos]){
+            pos = (pos + 1) & mask;
+        }
+        slots[pos] = (hash & ~ElementIndexMask) | (i + 1);
+    }
+}
+
+
+/**
+   The slot of the element is removed with the backward shift deletion of the linear
+   probing so that no tombstone is left in the hash index.
+*/
+void MappingContainer::removeHashSlot(size_t index, uint64_t hash)
+{
+    const size_t mask = slots.size() - 1;
+    const uint64_t target = (hash & ~ElementIndexMask) | (index + 1);
+    size_t pos = hash & mask;
+    while(slots[pos] != target){
+        pos = (pos + 1) & mask;
+    }
+    size_t next = (pos + 1) & mask;
+    while(slots[next]){
+        auto& key = elements[(slots[next] & ElementIndexMask) - 1].first;
+        size_t home = hashKey(key.data(), key.size()) & mask;
+        // The slot can be moved to the hole when its home position is not in (pos, next]
+        if(((next - home) & mask) >= ((next - pos) & mask)){
+            slots[pos] = slots[next];
+            pos = next;
+        }
+        next = (next + 1) & mask;
+    }
+    slots[pos] = 0;
+}
+
+
+/**
+   @return The index of the first remaining element at or after the specified index
+*/
+size_t MappingContainer::removeErasedElements(size_t index)
+{
+    size_t newIndex = 0;
+    size_t numRemaining = 0;
+    const size_t n = elements.size();
+    for(size_t i=0; i < n; ++i){
+        if(i == index){
+            newIndex = numRemaining;
+        }
+        if(!elements[i].isErased){
+            if(i != numRemaining){
+                elements[numRemaining] = std::move(elements[i]);
+            }
+            ++numRemaining;
+        }
+    }
+    if(index >= n){
+        newIndex = numRemaining;
+    }
+    elements.erase(elements.begin() + numRemaining, elements.end());
+    numErasedElements = 0;
+    rebuildHashIndex();
+    return newIndex;
+}
+
+
+ValueNodePtr& MappingContainer::operator[](const std::string& key)
+{
+    size_t index;
+    if(slots.empty()){
+        index = findIndex(key.data(), key.size());
+        if(index == elements.size()){
+            index = appendElement(key, nullptr, hashKey(key.data(), key.size()));
+        }
+    } else {
+        uint64_t hash = hashKey(key.data(), key.size());
+        index = findIndex(key.data(), key.size(), hash);
+        if(index == elements.size()){
+            index = appendElement(key, nullptr, hash);
+        }
+    }
+    return elements[index].second;
+}
+
+
+std::pair<MappingContainer::iterator, bool> MappingContainer::insert(const value_type& element)
+{
+    auto& key = element.first;
+    uint64_t hash = hashKey(key.data(), key.size());
+    size_t index = slots.empty() ? findIndex(key.data(), key.size()) : findIndex(key.data(), key.size(), hash);
+    if(index < elements.size()){
+        return std::make_pair(iteratorAt(index), false);
+    }
+    index = appendElement(key, element.second, hash);
+    return std::make_pair(iteratorAt(index), true);
+}
+
+
+MappingContainer::iterator MappingContainer::erase(iterator pos)
+{
+    size_t index = pos.p - elements.data();
+    auto& element = elements[index];
+    if(!slots.empty()){
+        removeHashSlot(index, hashKey(element.first.data(), element.first.size()));
+    }
+    element.isErased = true;
+    std::string().swap(element.first);
+    element.second.reset();
+    ++numErasedElements;
+
+    size_t next = index + 1;
+    if(numErasedElements > MaxNumElementsWithoutHashIndex && numErasedElements * 2 > elements.size()){
+        next = removeErasedElements(next);
+    }
+    return iteratorAt(next);
+}
+
+
+size_t MappingContainer::erase(const std::string& key)
+{
+    auto p = find(key);
+    if(p == end()){
+        return 0;
+    }
+    erase(p);
+    return 1;
+}
+
+
 Mapping::Mapping()
 {
     typeBits = MAPPING;
@@ -10,6 +10,9 @@
 #include <vector>
 #include <string>
 #include <initializer_list>
+#include <iterator>
+#include <cstring>
+#include <cstdint>
 #include "exportdecl.h"
 
 namespace cnoid {
@@ -245,6 +248,128 @@ private:
 typedef ref_ptr<ScalarNode> ScalarNodePtr;
 
 
+/**
+   The container of the elements of a mapping. The elements are stored in the insertion
+   order, and the keys are indexed by an open-addressing hash table when the number of
+   elements exceeds a small threshold. An erased element is only marked as erased and
+   skipped by the iterators so that the other elements are not moved and their indices in
+   the hash index stay valid.
+   The erased elements are removed at once when they exceed half of the elements.
+*/
+class CNOID_EXPORT MappingContainer
+{
+public:
+    typedef std::pair<std::string, ValueNodePtr> value_type;
+
+private:
+    struct Element : public value_type
+    {
+        Element(const std::string& key, ValueNode* node) : value_type(key, node), isErased(false) { }
+        bool isErased;
+    };
+
+public:
+    template<class ValueType, class ElementType>
+    class IteratorBase
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef MappingContainer::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef ValueType* pointer;
+        typedef ValueType& reference;
+
+        IteratorBase() : p(nullptr), end_(nullptr) { }
+        IteratorBase(ElementType* p, ElementType* end) : p(p), end_(end) { skipErasedElements(); }
+        //! Conversion from iterator to const_iterator
+        template<class V, class E> IteratorBase(const IteratorBase<V, E>& org) : p(org.p), end_(org.end_) { }
+        
+        reference operator*() const { return *p; }
+        pointer operator->() const { return p; }
+        IteratorBase& operator++() { ++p; skipErasedElements(); return *this; }
+        IteratorBase operator++(int) { IteratorBase org(*this); ++(*this); return org; }
+        template<class V, class E> bool operator==(const IteratorBase<V, E>& rhs) const { return p == rhs.p; }
+        template<class V, class E> bool operator!=(const IteratorBase<V, E>& rhs) const { return p != rhs.p; }
+
+    private:
+        ElementType* p;
+        ElementType* end_;
+
+        void skipErasedElements() {
+            while(p != end_ && p->isErased){
+                ++p;
+            }
+        }
+
+        template<class V, class E> friend class IteratorBase;
+        friend class MappingContainer;
+    };
+
+    typedef IteratorBase<value_type, Element> iterator;
+    typedef IteratorBase<const value_type, const Element> const_iterator;
+
+    MappingContainer() : numErasedElements(0) { }
+
+    bool empty() const { return elements.size() == numErasedElements; }
+    size_t size() const { return elements.size() - numErasedElements; }
+    void clear();
+    void reserve(size_t size) { elements.reserve(size); }
+
+    iterator begin() { return iteratorAt(0); }
+    iterator end() { return iteratorAt(elements.size()); }
+    const_iterator begin() const { return iteratorAt(0); }
+    const_iterator end() const { return iteratorAt(elements.size()); }
+
+    iterator find(const std::string& key) {
+        return iteratorAt(findIndex(key.data(), key.size()));
+    }
+    const_iterator find(const std::string& key) const {
+        return iteratorAt(findIndex(key.data(), key.size()));
+    }
+    iterator find(const char* key) {
+        return iteratorAt(findIndex(key, strlen(key)));
+    }
+    const_iterator find(const char* key) const {
+        return iteratorAt(findIndex(key, strlen(key)));
+    }
+
+    ValueNodePtr& operator[](const std::string& key);
+    
+    //! The element is not inserted when an element with the same key exists.
+    std::pair<iterator, bool> insert(const value_type& element);
+
+    template<class InputIterator> void insert(InputIterator first, InputIterator last) {
+        for(auto p = first; p != last; ++p){
+            insert(*p);
+        }
+    }
+
+    iterator erase(iterator pos);
+    size_t erase(const std::string& key);
+
+private:
+    std::vector<Element> elements;
+    size_t numErasedElements;
+    // Each slot has the upper bits of the hash value and the element index plus one
+    std::vector<uint64_t> slots;
+
+    iterator iteratorAt(size_t index) {
+        Element* top = elements.data();
+        return iterator(top + index, top + elements.size());
+    }
+    const_iterator iteratorAt(size_t index) const {
+        const Element* top = elements.data();
+        return const_iterator(top + index, top + elements.size());
+    }
+    size_t findIndex(const char* key, size_t length) const;
+    size_t findIndex(const char* key, size_t length, uint64_t hash) const;
+    size_t appendElement(const std::string& key, ValueNode* node, uint64_t hash);
+    void rebuildHashIndex();
+    void removeHashSlot(size_t index, uint64_t hash);
+    size_t removeErasedElements(size_t index);
+};
+
+
 inline const std::string& ValueNode::toString() const
 {
     if(!isScalar()){
@@ -256,7 +381,7 @@ inline const std::string& ValueNode::toString() const
 
 class CNOID_EXPORT Mapping : public ValueNode
 {
-    typedef std::map<std::string, ValueNodePtr> Container;
+    typedef MappingContainer Container;
         
 public:
 
@@ -0,0 +1,178 @@
+/**
+   This program measures the performance of the value tree. A body file with many links is
+   generated in the temporary directory and loaded with YAMLReader, and all the mappings of
+   the document are walked with key lookups. The time to erase all the keys of a large
+   mapping one by one is also measured. The peak memory usage of the process is reported
+   on the platforms that provide it.
+*/
+
+#include "YAMLReader.h"
+#include "ValueTree.h"
+#include <cnoid/stdx/filesystem>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+using namespace cnoid;
+namespace filesystem = cnoid::stdx::filesystem;
+
+namespace {
+
+typedef chrono::steady_clock Clock;
+
+const char* lookupKeys[] = {
+    "name", "parent", "joint_type", "mass", "elements", "translation", "type", "nonexistent" };
+
+double milliseconds(Clock::duration d)
+{
+    return chrono::duration<double, std::milli>(d).count();
+}
+
+
+void writeBodyFile(const string& filename, int numLinks)
+{
+    ofstream out(filename);
+    out << "format: ChoreonoidBody\n"
+        << "format_version: 2.0\n"
+        << "name: Benchmark\n"
+        << "links:\n";
+    for(int i=0; i < numLinks; ++i){
+        out << "  -\n"
+            << "    name: LINK" << i << "\n";
+        if(i > 0){
+            out << "    parent: LINK" << (i - 1) << "\n"
+                << "    joint_type: revolute\n"
+                << "    joint_axis: [ 0, 0, 1 ]\n"
+                << "    joint_id: " << (i - 1) << "\n";
+        }
+        out << "    translation: [ 0, 0, " << (0.01 * i) << " ]\n"
+            << "    mass: " << (1.0 + 0.001 * i) << "\n"
+            << "    center_of_mass: [ 0, 0, 0.005 ]\n"
+            << "    inertia: [ 0.001, 0, 0, 0, 0.001, 0, 0, 0, 0.001 ]\n"
+            << "    elements:\n"
+            << "      -\n"
+            << "        type: Shape\n"
+            << "        geometry: { type: Box, size: [ 0.1, 0.1, 0.01 ] }\n"
+            << "        appearance: { material: { diffuse_color: [ 0.5, 0.5, 0.5 ] } }\n";
+    }
+}
+
+
+long walk(ValueNode* node)
+{
+    long numFoundKeys = 0;
+    if(node->isMapping()){
+        auto mapping = node->toMapping();
+        for(auto key : lookupKeys){
+            if(mapping->find(key)->isValid()){
+                ++numFoundKeys;
+            }
+        }
+        for(auto& kv : *mapping){
+            numFoundKeys += walk(kv.second);
+        }
+    } else if(node->isListing()){
+        for(auto& element : *node->toListing()){
+            numFoundKeys += walk(element);
+        }
+    }
+    return numFoundKeys;
+}
+
+
+long peakMemoryUsageInMegaBytes()
+{
+#ifndef _WIN32
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0){
+        return usage.ru_maxrss / 1024;
+    }
+#endif
+    return -1;
+}
+
+
+void printUsage()
+{
+    cout << "Usage: cnoid-value-tree-benchmark [--links N] [--keys N] [--repeat N]" << endl;
+}
+
+}
+
+
+int main(int argc, char* argv[])
+{
+    int numLinks = 20000;
+    int numKeys = 100000;
+    int numRepeats = 5;
+
+    for(int i=1; i < argc; ++i){
+        string option(argv[i]);
+        if(i + 1 < argc && option == "--links"){
+            numLinks = atoi(argv[++i]);
+        } else if(i + 1 < argc && option == "--keys"){
+            numKeys = atoi(argv[++i]);
+        } else if(i + 1 < argc && option == "--repeat"){
+            numRepeats = atoi(argv[++i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if(numLinks < 1 || numKeys < 1 || numRepeats < 1){
+        printUsage();
+        return 1;
+    }
+
+    string filename = (filesystem::temp_directory_path() / "cnoid-value-tree-benchmark.body").string();
+    writeBodyFile(filename, numLinks);
+
+    double loadTime = 0.0;
+    double lookupTime = 0.0;
+    long numFoundKeys = 0;
+    try {
+        for(int i=0; i < numRepeats; ++i){
+            YAMLReader reader;
+            auto t0 = Clock::now();
+            reader.load(filename);
+            auto t1 = Clock::now();
+            numFoundKeys = walk(reader.document());
+            auto t2 = Clock::now();
+            loadTime += milliseconds(t1 - t0);
+            lookupTime += milliseconds(t2 - t1);
+        }
+    }
+    catch(const ValueNode::Exception& ex){
+        cerr << ex.message() << endl;
+        filesystem::remove(filename);
+        return 1;
+    }
+    filesystem::remove(filename);
+
+    double eraseTime = 0.0;
+    for(int i=0; i < numRepeats; ++i){
+        MappingPtr mapping = new Mapping;
+        for(int j=0; j < numKeys; ++j){
+            mapping->write("key" + to_string(j), j);
+        }
+        auto t0 = Clock::now();
+        for(int j=0; j < numKeys; ++j){
+            mapping->remove("key" + to_string(j));
+        }
+        eraseTime += milliseconds(Clock::now() - t0);
+    }
+
+    cout << "links: " << numLinks << ", found keys: " << numFoundKeys << "\n"
+         << "load: " << loadTime / numRepeats << " ms\n"
+         << "lookup: " << lookupTime / numRepeats << " ms\n"
+         << "erase " << numKeys << " keys: " << eraseTime / numRepeats << " ms\n"
+         << "peak memory usage: " << peakMemoryUsageInMegaBytes() << " MB" << endl;
+
+    return 0;
+}
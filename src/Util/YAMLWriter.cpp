@@ -71,6 +71,7 @@ public:
     void endMapping();
     void startListingSub(bool isFlowStyle);
     void endListing();
+    void getSortedMappingElements(const Mapping* mapping, vector<Mapping::const_iterator>& out_iters);
     void scanSharedNodes(const ValueNode* node);
     void scanSharedNodesIter(const ValueNode* node);
     void putNodeMain(const ValueNode* node, bool doCheckLF);
@@ -704,6 +705,33 @@ void YAMLWriter::putNode(const ValueNode* node)
 }
 
 
+/**
+   The elements of a mapping are put in the order of the keys or in the order of the
+   element indices when the key order preservation mode is enabled. The elements are
+   sorted by the keys first in both cases so that the elements with the same index are
+   put in the same order as the previous implementation based on std::map.
+*/
+void YAMLWriter::Impl::getSortedMappingElements(const Mapping* mapping, vector<Mapping::const_iterator>& out_iters)
+{
+    out_iters.clear();
+    out_iters.reserve(mapping->size());
+    for(auto it = mapping->begin(); it != mapping->end(); ++it){
+        out_iters.push_back(it);
+    }
+    std::sort(
+        out_iters.begin(), out_iters.end(),
+        [](const Mapping::const_iterator& it1, const Mapping::const_iterator& it2){
+            return (it1->first < it2->first); });
+
+    if(isKeyOrderPreservationMode){
+        std::sort(
+            out_iters.begin(), out_iters.end(),
+            [](const Mapping::const_iterator& it1, const Mapping::const_iterator& it2){
+                return (it1->second->indexInMapping() < it2->second->indexInMapping()); });
+    }
+}
+
+
 void YAMLWriter::Impl::scanSharedNodes(const ValueNode* node)
 {
     nodeSet.clear();
@@ -728,27 +756,10 @@ void YAMLWriter::Impl::scanSharedNodesIter(const ValueNode* node)
     }
 
     if(node->isMapping()){
-        auto mapping = node->toMapping();
-        if(!isKeyOrderPreservationMode){
-            for(auto& kv : *mapping){
-                scanSharedNodesIter(kv.second);
-            }
-        } else {
-            const int n(mapping->size());
-            vector<Mapping::const_iterator> iters(n);
-            int index = 0;
-            for(auto it = mapping->begin(); it != mapping->end(); ++it){
-                iters[index++] = it;
-            }
-            struct KeyOrderCmpFunc {
-                bool operator()(const Mapping::const_iterator& it1, const Mapping::const_iterator& it2) const {
-                    return (it1->second->indexInMapping() < it2->second->indexInMapping());
-                }
-            };
-            std::sort(iters.begin(), iters.end(), KeyOrderCmpFunc());
-            for(auto& it : iters){
-                scanSharedNodesIter(it->second);
-            }
+        vector<Mapping::const_iterator> iters;
+        getSortedMappingElements(node->toMapping(), iters);
+        for(auto& it : iters){
+            scanSharedNodesIter(it->second);
         }
     } else if(node->isListing()){
         for(auto& element : *node->toListing()){
@@ -857,39 +868,14 @@ void YAMLWriter::Impl::putMappingNode(const Mapping* mapping)
     
     startMappingSub(mapping->isFlowStyle());
 
-    if(isKeyOrderPreservationMode){
-        const int n(mapping->size());
-        vector<Mapping::const_iterator> iters(n);
-        int index = 0;
-        for(Mapping::const_iterator it = mapping->begin(); it != mapping->end(); ++it){
-            iters[index++] = it;
-        }
-
-        struct KeyOrderCmpFunc {
-            bool operator()(const Mapping::const_iterator& it1, const Mapping::const_iterator& it2) const {
-                return (it1->second->indexInMapping() < it2->second->indexInMapping());
-            }
-        };
-
-        std::sort(iters.begin(), iters.end(), KeyOrderCmpFunc());
-
-        for(int i=0; i < n; ++i){
-            Mapping::const_iterator& it = iters[i];
-            const string& key = it->first;
-            if(!key.empty()){
-                putKey(key, mapping->keyStringStyle());
-                const ValueNodePtr& node = it->second;
-                putNodeMain(node, false);
-            }
-        }        
-    } else {
-        for(Mapping::const_iterator it = mapping->begin(); it != mapping->end(); ++it){
-            const string& key = it->first;
-            if(!key.empty()){
-                putKey(key, mapping->keyStringStyle());
-                const ValueNodePtr& node = it->second;
-                putNodeMain(node, false);
-            }
+    vector<Mapping::const_iterator> iters;
+    getSortedMappingElements(mapping, iters);
+    for(auto& it : iters){
+        const string& key = it->first;
+        if(!key.empty()){
+            putKey(key, mapping->keyStringStyle());
+            const ValueNodePtr& node = it->second;
+            putNodeMain(node, false);
         }
     }
 
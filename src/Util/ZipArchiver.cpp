@@ -3,7 +3,18 @@
 #include <cnoid/UTF8>
 #include <cnoid/stdx/filesystem>
 #include <zip.h>
+#include <zlib.h>
 #include <fmt/format.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <set>
+#include <algorithm>
+#include <cstdio>
+#include <cerrno>
+#include <cctype>
 #include "gettext.h"
 
 using namespace std;
@@ -11,6 +22,72 @@ using namespace cnoid;
 using fmt::format;
 namespace fs = stdx::filesystem;
 
+namespace {
+
+constexpr size_t ReadBlockSize = 1024 * 1024;
+
+/*
+  Files larger than this size are compressed by libzip in the thread writing the zip file
+  so that the whole compressed data of a huge file is not kept in memory.
+*/
+constexpr uintmax_t MaxConcurrentCompressionFileSize = 64 * 1024 * 1024;
+
+//! The total size of the files being compressed or waiting to be written
+constexpr uintmax_t MaxBufferedDataSize = 256 * 1024 * 1024;
+
+class ConcurrentCompressor;
+
+struct CompressionJob
+{
+    ConcurrentCompressor* compressor;
+    fs::path sourcePath;
+    uintmax_t fileSize;
+    time_t modificationTime;
+    enum State { Queued, Running, Done } state;
+    bool isReleased;
+    int errorCode;
+    zip_error_t error;
+    vector<unsigned char> data;
+    zip_uint64_t uncompressedSize;
+    zip_uint64_t compressedSize;
+    uLong crc;
+    size_t readPosition;
+};
+
+
+/**
+   This class compresses the files in worker threads with the raw deflate format of zlib.
+   Each file is added to the zip file as a custom source reporting the deflated data,
+   which libzip writes into the archive as it is without recompressing it. The writing is
+   done in the entry order when the zip file is closed, and the source of each entry waits
+   for the completion of the corresponding job.
+*/
+class ConcurrentCompressor
+{
+public:
+    ConcurrentCompressor(int numThreads);
+    ~ConcurrentCompressor();
+    zip_source_t* createSource(zip_t* zip, const fs::path& path, uintmax_t fileSize, time_t modificationTime);
+
+private:
+    int maxNumThreads;
+    vector<std::unique_ptr<CompressionJob>> jobs;
+    size_t nextJobIndex;
+    uintmax_t bufferedDataSize;
+    bool isStopping;
+    vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    void run();
+    bool compress(CompressionJob* job);
+    bool waitForJob(CompressionJob* job);
+    void releaseJob(CompressionJob* job);
+    static zip_int64_t sourceFunction(void* userdata, void* data, zip_uint64_t len, zip_source_cmd_t cmd);
+};
+
+}
+
 namespace cnoid {
 
 class ZipArchiver::Impl
@@ -20,13 +97,36 @@ public:
     std::string systemErrorMessage;
     std::string errorMessage;
     std::vector<std::string> extractedFiles;
+    int maxNumThreads;
+    std::vector<std::string> storedFileExtensions;
+    bool isStoreOnlyModeEnabled;
+    std::unique_ptr<ConcurrentCompressor> compressor;
+    std::vector<std::pair<std::string, std::string>> externalSources;
+    // The entry names added to the zip file being created
+    std::set<std::string> addedEntryNames;
+
+    struct FileEntry
+    {
+        int index;
+        string name;
+        fs::path path;
+        zip_uint64_t size;
+        bool isCreated;
+        bool isFailed;
+    };
 
     Impl();
     bool createZipFile(const std::string& zipFilename, const std::string& directory);
     bool addDirectoryToZip(zip_t* zip, fs::path dirPath, const fs::path& srcTopDirPath, const fs::path& zipTopDirPath);
+    bool addDirectoryEntryToZip(zip_t* zip, const fs::path& localDirPath);
+    bool addFileToZip(zip_t* zip, const fs::path& srcPath, const fs::path& localPath);
+    bool addExternalSourceToZip(zip_t* zip, const fs::path& srcPath, const fs::path& localPath);
+    bool isStoredFile(const fs::path& path) const;
     bool extractZipFile(const std::string& zipFilename, const std::string& directory);
     bool extractFilesFromZipFile(
         zip_t* zip, const string& zipFilename, const fs::path&  zipFilePath, const fs::path& topDirPath);
+    void extractFilesConcurrently(zip_t* zip, const fs::path& zipFilePath, vector<FileEntry>& fileEntries);
+    void extractFile(zip_t* zip, FileEntry& entry, vector<unsigned char>& buf);
 };
 
 }
@@ -41,6 +141,10 @@ ZipArchiver::ZipArchiver()
 ZipArchiver::Impl::Impl()
 {
     errorType = NoError;
+    maxNumThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    storedFileExtensions = {
+        "png", "jpg", "jpeg", "gif", "zip", "gz", "tgz", "bz2", "xz", "7z", "mp3", "mp4", "log" };
+    isStoreOnlyModeEnabled = false;
 }
 
 
@@ -68,6 +172,60 @@ const std::string& ZipArchiver::errorMessage() const
 }
 
 
+void ZipArchiver::setMaxNumThreads(int n)
+{
+    impl->maxNumThreads = std::max(1, n);
+}
+
+
+int ZipArchiver::maxNumThreads() const
+{
+    return impl->maxNumThreads;
+}
+
+
+void ZipArchiver::setStoredFileExtensions(const std::vector<std::string>& extensions)
+{
+    auto& stored = impl->storedFileExtensions;
+    stored.clear();
+    for(auto& extension : extensions){
+        string lowered(extension);
+        std::transform(lowered.begin(), lowered.end(), lowered.begin(), ::tolower);
+        stored.push_back(lowered);
+    }
+}
+
+
+const std::vector<std::string>& ZipArchiver::storedFileExtensions() const
+{
+    return impl->storedFileExtensions;
+}
+
+
+void ZipArchiver::setStoreOnlyModeEnabled(bool on)
+{
+    impl->isStoreOnlyModeEnabled = on;
+}
+
+
+bool ZipArchiver::isStoreOnlyModeEnabled() const
+{
+    return impl->isStoreOnlyModeEnabled;
+}
+
+
+void ZipArchiver::addExternalSource(const std::string& entryPath, const std::string& sourcePath)
+{
+    impl->externalSources.emplace_back(entryPath, sourcePath);
+}
+
+
+void ZipArchiver::clearExternalSources()
+{
+    impl->externalSources.clear();
+}
+
+
 bool ZipArchiver::createZipFile(const std::string& zipFilename, const std::string& directory)
 {
     return impl->createZipFile(zipFilename, directory);
@@ -104,10 +262,34 @@ bool ZipArchiver::Impl::createZipFile(const std::string& zipFilename, const std:
         return false;
     }
 
+    if(maxNumThreads >= 2 && !isStoreOnlyModeEnabled){
+        compressor.reset(new ConcurrentCompressor(maxNumThreads));
+    }
+
     fs::path zipTopDirPath(zipFilePath.stem());
     fs::path dirPath(fromUTF8(directory));
+    addedEntryNames.clear();
     bool zipped = addDirectoryToZip(zip, dirPath, dirPath, zipTopDirPath);
-    zip_close(zip);
+    for(auto& source : externalSources){
+        if(!zipped){
+            break;
+        }
+        zipped = addExternalSourceToZip(
+            zip, fromUTF8(source.second), zipTopDirPath / fs::path(fromUTF8(source.first)).lexically_normal());
+    }
+    addedEntryNames.clear();
+
+    if(!zipped){
+        zip_discard(zip);
+    } else if(zip_close(zip) < 0){
+        zipped = false;
+        errorType = FileAdditionError;
+        systemErrorMessage = zip_strerror(zip);
+        errorMessage =
+            format(_("Failed to write the zip file \"{0}\": {1}"), zipFilename, systemErrorMessage);
+        zip_discard(zip);
+    }
+    compressor.reset();
 
     if(zipped){
         errorType = NoError;
@@ -128,14 +310,7 @@ bool ZipArchiver::Impl::addDirectoryToZip
 (zip_t* zip, fs::path currentSrcDirPath, const fs::path& srcTopDirPath, const fs::path& zipTopDirPath)
 {
     auto relativePath = getRelativePath(currentSrcDirPath, srcTopDirPath);
-    auto localDirPath = zipTopDirPath / relativePath->lexically_normal();
-    auto localDirStr = toUTF8(localDirPath.generic_string());
-    int index = zip_dir_add(zip, localDirStr.c_str(), ZIP_FL_ENC_UTF_8);
-    if(index < 0){
-        errorType = DirectoryAdditionError;
-        systemErrorMessage = zip_strerror(zip);
-        errorMessage =
-            format(_("Failed to add directory \"{0}\" to the zip file: {1}"), localDirStr, systemErrorMessage);
+    if(!addDirectoryEntryToZip(zip, zipTopDirPath / relativePath->lexically_normal())){
         return false;
     }
 
@@ -146,38 +321,9 @@ bool ZipArchiver::Impl::addDirectoryToZip
                 return false;
             }
         } else {
-            auto localPath = zipTopDirPath / (*getRelativePath(entryPath, srcTopDirPath));
-            auto localPathStr = toUTF8(localPath.generic_string());
-            auto sourcePath = toUTF8(entryPath.make_preferred().string());
-            zip_source_t* source = zip_source_file(zip, sourcePath.c_str(), 0, 0);
-            if(!source){
-                errorType = FileAdditionError;
-                systemErrorMessage = zip_strerror(zip);
-                errorMessage =
-                    format(_("Failed to add file \"{0}\" to the zip file: {1}"),
-                           localPathStr, systemErrorMessage);
-                return false;
-            }
-            int index = zip_file_add(zip, localPathStr.c_str(), source, ZIP_FL_ENC_UTF_8);
-            if(index < 0){
-                zip_source_free(source);
-                errorType = FileAdditionError;
-                systemErrorMessage = zip_strerror(zip);
-                errorMessage =
-                    format(_("Failed to add file \"{0}\" to the zip file: {1}"),
-                           localPathStr, systemErrorMessage);
+            if(!addFileToZip(zip, entryPath, zipTopDirPath / (*getRelativePath(entryPath, srcTopDirPath)))){
                 return false;
             }
-            // The deflate compression is applied by default. The following code is not necessary.
-            /*
-            if(zip_set_file_compression(zip, index, ZIP_CM_DEFLATE, 0) < 0){
-                zip_source_free(source);
-                mout->putErrorln(
-                    format(_("Failed to compress file \"{0}\": {1}"),
-                           localPathStr, zip_strerror(zip)));
-                return false;
-            }
-            */
         }
     }
 
@@ -185,6 +331,116 @@ bool ZipArchiver::Impl::addDirectoryToZip
 }
 
 
+bool ZipArchiver::Impl::addDirectoryEntryToZip(zip_t* zip, const fs::path& localDirPath)
+{
+    auto localDirStr = toUTF8(localDirPath.generic_string());
+    if(!localDirStr.empty() && localDirStr.back() == '/'){
+        localDirStr.pop_back();
+    }
+    if(!addedEntryNames.insert(localDirStr + "/").second){
+        return true;
+    }
+    int index = zip_dir_add(zip, localDirStr.c_str(), ZIP_FL_ENC_UTF_8);
+    if(index < 0){
+        errorType = DirectoryAdditionError;
+        systemErrorMessage = zip_strerror(zip);
+        errorMessage =
+            format(_("Failed to add directory \"{0}\" to the zip file: {1}"), localDirStr, systemErrorMessage);
+        return false;
+    }
+    return true;
+}
+
+
+bool ZipArchiver::Impl::addFileToZip(zip_t* zip, const fs::path& srcPath, const fs::path& localPath)
+{
+    auto localPathStr = toUTF8(localPath.generic_string());
+    if(!addedEntryNames.insert(localPathStr).second){
+        return true; // The file in the directory takes precedence over the external source
+    }
+    bool isStored = isStoreOnlyModeEnabled || isStoredFile(srcPath);
+    zip_source_t* source = nullptr;
+    stdx::error_code ec;
+    auto fileSize = fs::file_size(srcPath, ec);
+    if(compressor && !isStored && !ec && fileSize > 0 && fileSize <= MaxConcurrentCompressionFileSize){
+        source = compressor->createSource(
+            zip, srcPath, fileSize, fs::last_write_time_to_time_t(srcPath));
+    } else {
+        auto sourcePath = toUTF8(fs::path(srcPath).make_preferred().string());
+        source = zip_source_file(zip, sourcePath.c_str(), 0, 0);
+    }
+    if(!source){
+        errorType = FileAdditionError;
+        systemErrorMessage = zip_strerror(zip);
+        errorMessage =
+            format(_("Failed to add file \"{0}\" to the zip file: {1}"),
+                   localPathStr, systemErrorMessage);
+        return false;
+    }
+    int index = zip_file_add(zip, localPathStr.c_str(), source, ZIP_FL_ENC_UTF_8);
+    if(index < 0){
+        zip_source_free(source);
+        errorType = FileAdditionError;
+        systemErrorMessage = zip_strerror(zip);
+        errorMessage =
+            format(_("Failed to add file \"{0}\" to the zip file: {1}"),
+                   localPathStr, systemErrorMessage);
+        return false;
+    }
+    // The deflate compression is applied by default to the other files
+    if(isStored){
+        if(zip_set_file_compression(zip, index, ZIP_CM_STORE, 0) < 0){
+            errorType = FileAdditionError;
+            systemErrorMessage = zip_strerror(zip);
+            errorMessage =
+                format(_("Failed to add file \"{0}\" to the zip file: {1}"),
+                       localPathStr, systemErrorMessage);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+   The parent directories of an external source may not exist in the directory of the zip
+   file, so they are added first.
+*/
+bool ZipArchiver::Impl::addExternalSourceToZip(zip_t* zip, const fs::path& srcPath, const fs::path& localPath)
+{
+    fs::path localDirPath;
+    for(auto it = localPath.begin(); it != localPath.end(); ++it){
+        if(std::next(it) == localPath.end()){
+            break;
+        }
+        localDirPath /= *it;
+        if(!addDirectoryEntryToZip(zip, localDirPath)){
+            return false;
+        }
+    }
+    if(fs::is_directory(srcPath)){
+        return addDirectoryToZip(zip, srcPath, srcPath, localPath);
+    }
+    return addFileToZip(zip, srcPath, localPath);
+}
+
+
+bool ZipArchiver::Impl::isStoredFile(const fs::path& path) const
+{
+    string extension = path.extension().string();
+    if(extension.size() >= 2){
+        extension.erase(0, 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        for(auto& stored : storedFileExtensions){
+            if(extension == stored){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
 bool ZipArchiver::extractZipFile(const std::string& zipFilename, const std::string& directory)
 {
     return impl->extractZipFile(zipFilename, directory);
@@ -227,8 +483,8 @@ bool ZipArchiver::Impl::extractZipFile(const std::string& zipFilename, const std
 bool ZipArchiver::Impl::extractFilesFromZipFile
 (zip_t* zip, const string& zipFilename, const fs::path& zipFilePath, const fs::path& topDirPath)
 {
-    vector<unsigned char> buf(1024 * 1024);
     stdx::error_code ec;
+    vector<FileEntry> fileEntries;
     
     int numEntries = zip_get_num_entries(zip, 0);
     
@@ -265,52 +521,382 @@ bool ZipArchiver::Impl::extractFilesFromZipFile
                     return false;
                 }
             } else {
-                bool failed = false;
-                zip_file_t* zf = zip_fopen_index(zip, i, 0);
-                if(!zf){
-                    failed = true;
-                } else {
-                    FILE* file = fopen(entryPath.make_preferred().string().c_str(), "wb");
-                    if(!file){
-                        failed = true;
-                    } else {
-                        long long sum = 0;
-                        while(sum < stat.size){
-                            int len = zip_fread(zf, buf.data(), buf.size());
-                            if(len < 0){
-                                failed = true;
-                            } else {
-                                if(fwrite(buf.data(), sizeof(unsigned char), len, file) < len){
-                                    failed = true;
-                                    break;
-                                }
-                                sum += len;
-                            }
-                        }
-                        fclose(file);
-
-                        extractedFiles.push_back(toUTF8(entryPath.generic_string()));
-                    }
-                }
-                if(failed){
-                    errorType = FileExtractionError;
-                    systemErrorMessage.clear();
-                    errorMessage = 
-                        format(_("File \"{0}\" in the zip file \"{1}\" cannot be extracted."),
-                               name, zipFilename);
-                    return false;
-                }
-                    
-                zip_fclose(zf);
+                fileEntries.push_back({ i, name, entryPath, stat.size, false, false });
+            }
+        }
+    }
+
+    /*
+      The files are extracted after all the directories are created because a directory
+      entry removes the existing directory including the files extracted into it.
+    */
+    if(maxNumThreads >= 2 && fileEntries.size() >= 2){
+        extractFilesConcurrently(zip, zipFilePath, fileEntries);
+    } else {
+        vector<unsigned char> buf(ReadBlockSize);
+        for(auto& entry : fileEntries){
+            extractFile(zip, entry, buf);
+            if(entry.isFailed){
+                break;
             }
         }
     }
 
+    for(auto& entry : fileEntries){
+        if(entry.isCreated){
+            extractedFiles.push_back(toUTF8(entry.path.generic_string()));
+        }
+        if(entry.isFailed){
+            errorType = FileExtractionError;
+            systemErrorMessage.clear();
+            errorMessage = 
+                format(_("File \"{0}\" in the zip file \"{1}\" cannot be extracted."),
+                       entry.name, zipFilename);
+            return false;
+        }
+    }
+
     return true;
 }
 
 
+/**
+   libzip does not allow a zip_t object to be accessed from multiple threads,
+   so each worker thread except the calling thread opens the zip file by itself.
+*/
+void ZipArchiver::Impl::extractFilesConcurrently
+(zip_t* zip, const fs::path& zipFilePath, vector<FileEntry>& fileEntries)
+{
+    std::atomic<size_t> nextEntryIndex(0);
+    std::atomic<bool> isFailed(false);
+
+    auto extract = [&](zip_t* zip){
+        vector<unsigned char> buf(ReadBlockSize);
+        while(!isFailed){
+            size_t index = nextEntryIndex++;
+            if(index >= fileEntries.size()){
+                break;
+            }
+            auto& entry = fileEntries[index];
+            extractFile(zip, entry, buf);
+            if(entry.isFailed){
+                isFailed = true;
+            }
+        }
+    };
+
+    auto zipFile = fs::path(zipFilePath).make_preferred().string();
+    int numThreads = std::min(maxNumThreads, static_cast<int>(fileEntries.size()));
+    vector<std::thread> workers;
+    for(int i = 1; i < numThreads; ++i){
+        workers.emplace_back(
+            [&, zipFile](){
+                int errorp;
+                if(zip_t* workerZip = zip_open(zipFile.c_str(), ZIP_RDONLY, &errorp)){
+                    extract(workerZip);
+                    zip_discard(workerZip);
+                }
+            });
+    }
+    extract(zip);
+    for(auto& worker : workers){
+        worker.join();
+    }
+}
+
+
+void ZipArchiver::Impl::extractFile(zip_t* zip, FileEntry& entry, vector<unsigned char>& buf)
+{
+    zip_file_t* zf = zip_fopen_index(zip, entry.index, 0);
+    if(!zf){
+        entry.isFailed = true;
+        return;
+    }
+    FILE* file = fopen(fs::path(entry.path).make_preferred().string().c_str(), "wb");
+    if(!file){
+        entry.isFailed = true;
+    } else {
+        entry.isCreated = true;
+        zip_uint64_t sum = 0;
+        while(sum < entry.size){
+            auto len = zip_fread(zf, buf.data(), buf.size());
+            if(len <= 0){
+                entry.isFailed = true;
+                break;
+            }
+            if(fwrite(buf.data(), sizeof(unsigned char), len, file) < static_cast<size_t>(len)){
+                entry.isFailed = true;
+                break;
+            }
+            sum += len;
+        }
+        fclose(file);
+    }
+    zip_fclose(zf);
+}
+
+
 const std::vector<std::string>& ZipArchiver::extractedFiles() const
 {
     return impl->extractedFiles;
 }
+
+
+ConcurrentCompressor::ConcurrentCompressor(int numThreads)
+    : maxNumThreads(numThreads)
+{
+    nextJobIndex = 0;
+    bufferedDataSize = 0;
+    isStopping = false;
+}
+
+
+ConcurrentCompressor::~ConcurrentCompressor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+    condition.notify_all();
+    for(auto& worker : workers){
+        worker.join();
+    }
+}
+
+
+zip_source_t* ConcurrentCompressor::createSource
+(zip_t* zip, const fs::path& path, uintmax_t fileSize, time_t modificationTime)
+{
+    auto job = new CompressionJob;
+    job->compressor = this;
+    job->sourcePath = path;
+    job->fileSize = fileSize;
+    job->modificationTime = modificationTime;
+    job->state = CompressionJob::Queued;
+    job->isReleased = false;
+    job->errorCode = 0;
+    zip_error_init(&job->error);
+    job->uncompressedSize = 0;
+    job->compressedSize = 0;
+    job->crc = 0;
+    job->readPosition = 0;
+
+    zip_source_t* source = zip_source_function(zip, sourceFunction, job);
+    if(!source){
+        zip_error_fini(&job->error);
+        delete job;
+        return nullptr;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.emplace_back(job);
+        if(static_cast<int>(workers.size()) < maxNumThreads && workers.size() < jobs.size()){
+            workers.emplace_back([this](){ run(); });
+        }
+    }
+    condition.notify_all();
+
+    return source;
+}
+
+
+void ConcurrentCompressor::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while(true){
+        CompressionJob* job = nullptr;
+        condition.wait(lock, [&](){
+            if(isStopping){
+                return true;
+            }
+            if(nextJobIndex < jobs.size()){
+                // The memory used for the data waiting to be written is limited
+                auto size = jobs[nextJobIndex]->fileSize;
+                return (bufferedDataSize == 0 || bufferedDataSize + size <= MaxBufferedDataSize);
+            }
+            return false;
+        });
+        if(isStopping){
+            break;
+        }
+        job = jobs[nextJobIndex++].get();
+        if(job->isReleased){
+            job->state = CompressionJob::Done;
+            continue;
+        }
+        job->state = CompressionJob::Running;
+        bufferedDataSize += job->fileSize;
+
+        lock.unlock();
+        compress(job);
+        lock.lock();
+
+        job->state = CompressionJob::Done;
+        if(job->isReleased){
+            // The source has been freed without being written
+            bufferedDataSize -= job->fileSize;
+            vector<unsigned char>().swap(job->data);
+        }
+        condition.notify_all();
+    }
+}
+
+
+bool ConcurrentCompressor::compress(CompressionJob* job)
+{
+    FILE* file = fopen(fs::path(job->sourcePath).make_preferred().string().c_str(), "rb");
+    if(!file){
+        job->errorCode = errno;
+        return false;
+    }
+    
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    // The parameters are the same as the ones used by libzip by default
+    if(deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK){
+        fclose(file);
+        job->errorCode = ENOMEM;
+        return false;
+    }
+
+    auto& data = job->data;
+    data.resize(deflateBound(&stream, job->fileSize));
+    vector<unsigned char> buf(std::min(static_cast<uintmax_t>(ReadBlockSize), job->fileSize + 1));
+    uLong crc = crc32(0, Z_NULL, 0);
+    zip_uint64_t size = 0;
+    bool failed = false;
+    int flush;
+
+    do {
+        size_t len = fread(buf.data(), 1, buf.size(), file);
+        if(ferror(file)){
+            job->errorCode = errno;
+            failed = true;
+            break;
+        }
+        flush = feof(file) ? Z_FINISH : Z_NO_FLUSH;
+        crc = crc32(crc, buf.data(), len);
+        size += len;
+        stream.next_in = buf.data();
+        stream.avail_in = len;
+        do {
+            if(stream.total_out == data.size()){
+                // The file has grown after its size was obtained
+                data.resize(data.size() * 2);
+            }
+            stream.next_out = data.data() + stream.total_out;
+            stream.avail_out = data.size() - stream.total_out;
+            deflate(&stream, flush);
+        } while(stream.avail_out == 0);
+        
+    } while(flush != Z_FINISH);
+
+    data.resize(failed ? 0 : stream.total_out);
+    deflateEnd(&stream);
+    fclose(file);
+
+    job->crc = crc;
+    job->uncompressedSize = size;
+    job->compressedSize = data.size();
+
+    return !failed;
+}
+
+
+bool ConcurrentCompressor::waitForJob(CompressionJob* job)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [job](){ return job->state == CompressionJob::Done; });
+    if(job->errorCode){
+        zip_error_set(&job->error, ZIP_ER_READ, job->errorCode);
+        return false;
+    }
+    return true;
+}
+
+
+void ConcurrentCompressor::releaseJob(CompressionJob* job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(job->isReleased){
+            return;
+        }
+        job->isReleased = true;
+        if(job->state != CompressionJob::Done){
+            return; // The data is released by the worker thread
+        }
+        bufferedDataSize -= job->fileSize;
+        vector<unsigned char>().swap(job->data);
+    }
+    condition.notify_all();
+}
+
+
+zip_int64_t ConcurrentCompressor::sourceFunction
+(void* userdata, void* data, zip_uint64_t len, zip_source_cmd_t cmd)
+{
+    auto job = static_cast<CompressionJob*>(userdata);
+    auto compressor = job->compressor;
+    
+    switch(cmd){
+
+    case ZIP_SOURCE_OPEN:
+        if(!compressor->waitForJob(job)){
+            return -1;
+        }
+        job->readPosition = 0;
+        return 0;
+
+    case ZIP_SOURCE_READ:
+    {
+        size_t n = std::min(static_cast<size_t>(len), job->data.size() - job->readPosition);
+        std::copy_n(job->data.data() + job->readPosition, n, static_cast<unsigned char*>(data));
+        job->readPosition += n;
+        return n;
+    }
+    case ZIP_SOURCE_CLOSE:
+        // The compressed data is not necessary any more after it is written
+        compressor->releaseJob(job);
+        return 0;
+
+    case ZIP_SOURCE_STAT:
+    {
+        if(len < sizeof(zip_stat_t)){
+            zip_error_set(&job->error, ZIP_ER_INVAL, 0);
+            return -1;
+        }
+        if(!compressor->waitForJob(job)){
+            return -1;
+        }
+        auto st = static_cast<zip_stat_t*>(data);
+        zip_stat_init(st);
+        st->valid = ZIP_STAT_SIZE | ZIP_STAT_COMP_SIZE | ZIP_STAT_CRC | ZIP_STAT_COMP_METHOD | ZIP_STAT_MTIME;
+        st->size = job->uncompressedSize;
+        st->comp_size = job->compressedSize;
+        st->crc = job->crc;
+        st->comp_method = ZIP_CM_DEFLATE;
+        st->mtime = job->modificationTime;
+        return sizeof(zip_stat_t);
+    }
+    case ZIP_SOURCE_ERROR:
+        return zip_error_to_data(&job->error, data, len);
+
+    case ZIP_SOURCE_FREE:
+        compressor->releaseJob(job);
+        zip_error_fini(&job->error);
+        return 0;
+
+    case ZIP_SOURCE_SUPPORTS:
+        return zip_source_make_command_bitmap(
+            ZIP_SOURCE_OPEN, ZIP_SOURCE_READ, ZIP_SOURCE_CLOSE, ZIP_SOURCE_STAT,
+            ZIP_SOURCE_ERROR, ZIP_SOURCE_FREE, -1);
+
+    default:
+        return -1;
+    }
+}
@@ -13,6 +13,35 @@ public:
     ZipArchiver();
     virtual ~ZipArchiver();
 
+    /**
+       The files are compressed and extracted by multiple threads when the maximum number
+       of threads is more than one. The default value is the number of hardware threads.
+    */
+    void setMaxNumThreads(int n);
+    int maxNumThreads() const;
+
+    /**
+       The files with the extensions specified by this function are stored in the zip file
+       without compression because their data is already compressed or hardly compressible.
+       The default extensions are png, jpg, jpeg, gif, zip, gz, tgz, bz2, xz, 7z, mp3, mp4 and log.
+       The extensions are specified without the leading dot and compared case-insensitively.
+    */
+    void setStoredFileExtensions(const std::vector<std::string>& extensions);
+    const std::vector<std::string>& storedFileExtensions() const;
+
+    //! All the files are stored without compression when this mode is enabled.
+    void setStoreOnlyModeEnabled(bool on);
+    bool isStoreOnlyModeEnabled() const;
+
+    /**
+       The file or the directory of the source path is archived by the next call of
+       createZipFile as the entry of the specified path relative to the directory given to
+       the function, without being copied into the directory. When the directory has a file
+       with the same entry path, the file in the directory is archived.
+    */
+    void addExternalSource(const std::string& entryPath, const std::string& sourcePath);
+    void clearExternalSources();
+
     bool createZipFile(const std::string& zipFilename, const std::string& directory);
     bool extractZipFile(const std::string& zipFilename, const std::string& directory);
     const std::vector<std::string>& extractedFiles() const;